@@ -14,41 +14,98 @@ struct Material {
 
 in vec3 normalCamera;
 in vec3 eyeDirection;
-in vec3 shadowMapProj;
+#ifdef SHADOW
+in vec3 shadowMapProj[4];
+#endif
+#ifdef TEXTURED
 in vec2 texUV;
-flat in int flags;
+#endif
+flat in vec4 matColor;
+flat in vec3 matMRAO;
 
 uniform DirectionalLight dirLight;
-uniform Material mat;
-uniform sampler2D shadowMap;
+#ifdef SHADOW
+uniform sampler2DArrayShadow shadowMap;
+uniform int cascadeCount;
+#endif
 
 out vec3 fragColor;
 
 
+#ifdef SHADOW
+// Taps of the shadow filter chosen when the program is compiled. Each tap
+// is a bilinear comparison of 4 texels.
+#ifndef SHADOW_TAPS
+#define SHADOW_TAPS 9
+#endif
+
+#if SHADOW_TAPS == 4
+#define SHADOW_RADIUS 1.0f // Scale of the taps in texels
+const vec2 shadowTaps[4] = vec2[](
+    vec2(-1, -1), vec2(1, -1), vec2(-1, 1), vec2(1, 1)
+);
+#elif SHADOW_TAPS == 9
+#define SHADOW_RADIUS 2.0f
+const vec2 shadowTaps[9] = vec2[](
+    vec2( 0.0000,  0.0000), vec2( 0.5537,  0.6230), vec2(-0.8208,  0.1406),
+    vec2(-0.1760, -0.8148), vec2( 0.7577, -0.3477), vec2(-0.2767,  0.7903),
+    vec2(-0.7311, -0.5061), vec2( 0.4305, -0.8435), vec2( 0.9500,  0.2051)
+);
+#elif SHADOW_TAPS == 16
+#define SHADOW_RADIUS 2.0f
+const vec2 shadowTaps[16] = vec2[](
+    vec2(-0.9420, -0.3991), vec2( 0.9456, -0.7689), vec2(-0.0942, -0.9294),
+    vec2( 0.3450,  0.2939), vec2(-0.9159,  0.4577), vec2(-0.8154, -0.8791),
+    vec2(-0.3828,  0.2768), vec2( 0.9748,  0.7565), vec2( 0.4432, -0.9751),
+    vec2( 0.5374, -0.4737), vec2(-0.2650, -0.4189), vec2( 0.7920,  0.1909),
+    vec2(-0.2419,  0.9971), vec2(-0.8141,  0.9144), vec2( 0.1998,  0.7864),
+    vec2( 0.1438, -0.1410)
+);
+#endif
+
+
 float calculateShadow() {
-    vec3 projCoord = 0.5f*shadowMapProj + vec3(0.5f);
-    if(projCoord.x < 0.005f || projCoord.x > 0.995f ||
-       projCoord.y < 0.005f || projCoord.y > 0.995f ||
-       projCoord.z >= 1.0f)
-    {
-        return 0.0f;
-    }
-    
-    float shadow = 0;
-    vec2 texelSize = 1.0f/textureSize(shadowMap, 0);
-    for(int i=-2; i<=2; i++) {
-        for(int j=-2; j<=2; j++) {
-            vec2 dr = texelSize * vec2(i, j);
-            float pcfDepth = texture(shadowMap, projCoord.xy + dr).r;
-            if(projCoord.z + 0.001f > pcfDepth)
-                shadow += 0.8f;
+    // The nearest cascade covering the fragment has the sharpest shadow
+    for(int c=0; c<4; c++) {
+        if(c >= cascadeCount)
+            break;
+        vec3 projCoord = 0.5f*shadowMapProj[c] + vec3(0.5f);
+        if(projCoord.x < 0.005f || projCoord.x > 0.995f ||
+           projCoord.y < 0.005f || projCoord.y > 0.995f ||
+           projCoord.z >= 1.0f)
+        {
+            continue;
+        }
+        
+        // Fraction of the taps lit by the sun
+        float ref = projCoord.z + 0.001f;
+        #if SHADOW_TAPS == 1
+        float lit = texture(shadowMap, vec4(projCoord.xy, c, ref));
+        #else
+        vec2 tapScale = SHADOW_RADIUS/textureSize(shadowMap, 0).xy;
+        mat2 R = mat2(1.0f);
+        #if SHADOW_TAPS == 16
+        // Interleaved gradient noise turns the disk at every pixel
+        float a = 6.2831853f * fract(52.9829189f * fract(
+            dot(gl_FragCoord.xy, vec2(0.06711056f, 0.00583715f))));
+        R = mat2(cos(a), sin(a), -sin(a), cos(a));
+        #endif
+        float lit = 0;
+        for(int i=0; i<SHADOW_TAPS; i++) {
+            vec2 uv = projCoord.xy + tapScale * (R * shadowTaps[i]);
+            lit += texture(shadowMap, vec4(uv, c, ref));
         }
+        lit /= SHADOW_TAPS;
+        #endif
+        return 0.8f * (1.0f - lit);
     }
-    return shadow / 25;
+    return 0.0f;
 }
+#endif
 
 
 void main() {
+    Material mat = Material(matMRAO.x, matMRAO.y, matMRAO.z, matColor);
     vec3 reflDir = reflect(dirLight.direction, normalCamera);
     float smoothness = 1.0f - mat.roughness;
     float cosTheta = dot(normalCamera, -dirLight.direction);
@@ -57,14 +114,11 @@ void main() {
     float diff = clamp(0.7f*cosTheta + 0.3f, 0.15f, 1) * mat.roughness;
     float spec = pow(clamp(cosAlpha,0,1), 24*smoothness) * smoothness;
     
-    float dirLightPow;
-    if(bool(flags & (1 << 0))) { // Shadow option
-        float shadow = calculateShadow();
-        dirLightPow = (1-shadow) * dirLight.color.w;
-    }
-    else {
-        dirLightPow = dirLight.color.w;
-    }
+    #ifdef SHADOW
+    float dirLightPow = (1-calculateShadow()) * dirLight.color.w;
+    #else
+    float dirLightPow = dirLight.color.w;
+    #endif
     vec3 color = mat.color.xyz;
     fragColor = color * dirLight.color.xyz * dirLightPow * (diff+spec);
 }
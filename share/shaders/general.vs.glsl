@@ -3,34 +3,69 @@
 layout(location = 0) in vec3 vertex;
 layout(location = 1) in vec3 normal;
 layout(location = 2) in vec2 texCoord;
+layout(location = 3) in mat4 model;
+layout(location = 7) in vec3 scale;
+layout(location = 8) in vec4 color;
+layout(location = 9) in vec3 mrao;
+layout(location = 10) in vec3 posOffset;
+layout(location = 11) in vec3 posScale;
 
-uniform mat4 MVP;
-uniform mat4 MV;
-uniform mat4 shadowMVP;
-uniform vec3 scale;
-uniform int vflags;
+uniform mat4 V;
+uniform mat4 P;
+#ifdef SHADOW
+uniform mat4 shadowVP[4];
+uniform int cascadeCount;
+#endif
 
 out vec3 normalCamera;
 out vec3 eyeDirection;
-out vec3 shadowMapProj;
+#ifdef SHADOW
+out vec3 shadowMapProj[4];
+#endif
+#ifdef TEXTURED
 out vec2 texUV;
-flat out int flags;
+#endif
+flat out vec4 matColor;
+flat out vec3 matMRAO;
+
+
+vec3 decodeOctahedral(vec2 e) {
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if(v.z < 0.0)
+        v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0,
+                                        v.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(v);
+}
 
 
 void main() {
-    flags = vflags;
+    matColor = color;
+    matMRAO = mrao;
+    
+    vec3 v = posOffset + posScale * vertex;
+    #ifdef COMPRESSED_NORMAL
+    vec3 n = decodeOctahedral(normal.xy);
+    #else
+    vec3 n = normal;
+    #endif
     
-    normalCamera = (MV * vec4(normal,0)).xyz;
-    normalCamera.x /= scale.x;
-    normalCamera.y /= scale.y;
-    normalCamera.z /= scale.z;
+    // Same as the inverse transpose of the model matrix for the normals
+    mat4 MV = V * model;
+    normalCamera = normalize((MV * vec4(n / (scale*scale),0)).xyz);
     
-    vec3 vertexCamera = (MV * vec4(vertex,1)).xyz;
+    vec3 vertexCamera = (MV * vec4(v,1)).xyz;
     eyeDirection = normalize(vec3(0,0,0) - vertexCamera);
-    gl_Position = MVP * vec4(vertex,1);
+    gl_Position = P * vec4(vertexCamera,1);
     
-    if(bool(flags & (1 << 0))) // Shadow option
-        shadowMapProj = (shadowMVP * vec4(vertex,1)).xyz;
-    if(bool(flags & (1 << 8))) // Texture option
-        texUV = texCoord;
+    #ifdef SHADOW
+    vec4 vertexWorld = model * vec4(v,1);
+    for(int i=0; i<4; i++) {
+        if(i >= cascadeCount)
+            break;
+        shadowMapProj[i] = (shadowVP[i] * vertexWorld).xyz;
+    }
+    #endif
+    #ifdef TEXTURED
+    texUV = texCoord;
+    #endif
 }
@@ -0,0 +1,16 @@
+#version 330 core
+
+in vec2 texCoord;
+
+uniform uvec2 objectID;
+uniform bool textured;
+uniform sampler2D image;
+
+out uvec2 fragID;
+
+void main() {
+    // Transparent texels of the sprites do not cover the objects behind
+    if(textured && texture(image, texCoord).a < 0.5)
+        discard;
+    fragID = objectID;
+}
@@ -0,0 +1,13 @@
+#version 330 core
+
+layout(location = 0) in vec3 vertex;
+
+uniform mat4 MVP;
+
+out vec2 texCoord;
+
+
+void main() {
+    texCoord = vec2(0, 0);
+    gl_Position = MVP * vec4(vertex,1);
+}
@@ -46,6 +46,8 @@ Context::Context() {
     dlColor = Color(1, 1, 1, 1);
     destroyed = false;
     initDone = false;
+    vertexCompression = true;
+    lodThreshold = 1.0f;
     fps = 0;
     errorCode = 0;
 }
@@ -85,11 +87,15 @@ void Context::destroy() {
         return;
     setCurrent();
     cleanup();
+    meshes.clear();
+    geometry.clear();
     generalShader = internal::GeneralShader();
     shadowMapShader = internal::ShadowMapShader();
     object2dShader = internal::Object2DShader();
     particleShader = internal::ParticleShader();
     line3dShader = internal::Line3DShader();
+    pickingShader = internal::PickingShader();
+    profiler = internal::FrameProfiler();
     
     contextList.remove(this);
     destroyed = true;
@@ -124,6 +130,7 @@ void Context::addObject(Object* obj) {
         Object3D* obj3d = (Object3D*) obj;
         loader.push(obj3d->getVBOLoad());
         object3d_list.push_front(obj);
+        bvh.insert(obj3d);
     }
     else if(type == ObjectType::Particle3D) {
         Particle3D* particle = (Particle3D*) obj;
@@ -73,49 +73,86 @@ void Context::render() {
                                      "GPU driver.\n");
             #endif
         }
+        internal::Shader::enableParallelCompile();
         generalShader.load();
         shadowMapShader.load();
         object2dShader.load();
         particleShader.load();
         line3dShader.load();
+        pickingShader.load();
         initDone = true;
         onLoaded();
     }
     
     if(loader.getLoadCount() > 0)
         loader.load();
+    // Frees the shared meshes whose objects are all gone
+    meshes.collect();
+    // Packs the arenas once a quarter of their space is lost to the holes
+    geometry.defragment(0.25f);
+    // Refits the bounds of the objects moved by the last update
+    bvh.update();
     
     float t2 = getTime();
     fps = 1.0f/(t2-t1);
     t1 = t2;
+    profiler.beginFrame();
     
-    uint32_t shadow = shadowMapShader.createShadowMap(object3d_list);
+    profiler.beginPass(RenderPass::ShadowMap);
+    uint32_t shadow = shadowMapShader.createShadowMap(camera, bvh);
+    profiler.endPass();
     
+    profiler.beginPass(RenderPass::Picking);
+    pickingShader.render(
+        camera.getViewMatrix(),
+        camera.getProjectionMatrix(),
+        width,
+        height,
+        bvh,
+        line3d_list,
+        particle3d_list,
+        line3dShader,
+        particleShader
+    );
+    profiler.endPass();
+    
+    internal::glBindFramebuffer(GL_FRAMEBUFFER, getFramebuffer());
     glViewport(0, 0, width, height);
     glClearColor(bgColor.red, bgColor.green, bgColor.blue, 1);
     glClearDepth(1.0);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     
+    profiler.beginPass(RenderPass::Line3D);
     line3dShader.render(camera.getVPMatrix(), line3d_list);
+    profiler.endPass();
     
+    profiler.beginPass(RenderPass::General);
     generalShader.render(
         camera.getViewMatrix(),
         camera.getProjectionMatrix(),
-        shadowMapShader.getShadowMatrix(),
+        shadowMapShader.getShadowMatrices(),
+        shadowMapShader.getCascadeCount(),
         dlCameraSpace,
         dlColor,
         shadow,
-        object3d_list
+        bvh,
+        2.0f * lodThreshold / height
     );
+    profiler.endPass();
     
+    profiler.beginPass(RenderPass::Particle);
     particleShader.render(
         camera.getViewMatrix(),
         camera.getProjectionMatrix(),
         particle3d_list
     );
+    profiler.endPass();
     
+    profiler.beginPass(RenderPass::Object2D);
     object2dShader.render(object2d_list);
+    profiler.endPass();
     internal::glUseProgram(0);
+    profiler.endFrame();
     
     update();
     if(destroyed)
@@ -155,6 +192,13 @@ void Context::flush() {
     glFlush();
 }
 
+/**
+ * @brief Gets the framebuffer the context draws its final image into
+ * 
+ * @return OpenGL framebuffer object ID
+ */
+uint32_t Context::getFramebuffer() { return 0; }
+
 /**
  * @brief Gets the running time of the context
  * 
@@ -171,6 +215,200 @@ float Context::getTime() const { return 0; }
  */
 float Context::getFPS() const { return fps; }
 
+/**
+ * @brief Gets the timing and workload statistics of the rendering passes
+ * 
+ * Includes CPU and GPU times of each pass, draw call and uniform upload
+ * counts and percentiles of the recent frame times.
+ * 
+ * @return Statistics of the recent frames
+ */
+const FrameStats &Context::getFrameStats() const {
+    return profiler.getStats();
+}
+
+/**
+ * @brief Gets the progress of loading the resources into the GPU
+ * 
+ * Files like images and 3D models are decoded by background threads and
+ * loaded into the GPU during the frames after. The progress covers the
+ * resources added since the loading list was last empty.
+ * 
+ * @return Fraction of the resources loaded from 0 to 1
+ */
+float Context::getLoadProgress() const {
+    return loader.getProgress();
+}
+
+/**
+ * @brief Waits until the background threads decode the pending resources
+ * 
+ * The decoded resources are loaded into the GPU by the next frame. Useful
+ * to make sure the first frame is complete.
+ */
+void Context::waitForLoads() { loader.wait(); }
+
+/**
+ * @brief Sets the limit of the GPU uploads in each frame
+ * 
+ * Spreads the uploads across frames so that adding a lot of resources
+ * at once does not stall a frame. The objects not loaded yet are not
+ * drawn. Zero means no limit which is the default.
+ * 
+ * @param ms Time limit in milliseconds
+ * @param bytes Limit of the bytes sent to the GPU
+ */
+void Context::setUploadBudget(float ms, uint64_t bytes) {
+    loader.setBudget(ms, bytes);
+}
+
+/**
+ * @brief Sets whether the 3D objects store their vertices compressed
+ * 
+ * Compressed vertices take about half the GPU memory and bandwidth at
+ * a small loss of precision. Applies to the 3D objects and meshes
+ * created after the call. Enabled by default.
+ * 
+ * @param enable True to compress the vertices
+ */
+void Context::setVertexCompression(bool enable) {
+    vertexCompression = enable;
+}
+
+/**
+ * @brief Checks whether the 3D objects store their vertices compressed
+ * 
+ * @return True if the vertices are compressed
+ */
+bool Context::getVertexCompression() const { return vertexCompression; }
+
+/**
+ * @brief Sets the screen-space error allowed for the levels of detail
+ * 
+ * The 3D objects with levels of detail are drawn at the coarsest level
+ * whose error projects to less than this size. A larger value saves
+ * vertices at the cost of visible facets. The default is 1 pixel.
+ * 
+ * @param pixels Error in pixels
+ */
+void Context::setLODThreshold(float pixels) {
+    lodThreshold = pixels;
+    // The casters are drawn at the levels chosen for the camera
+    shadowMapShader.invalidate();
+}
+
+/**
+ * @brief Gets the screen-space error allowed for the levels of detail
+ * 
+ * @return Error in pixels
+ */
+float Context::getLODThreshold() const { return lodThreshold; }
+
+/**
+ * @brief Sets the width and height of each cascade of the shadow map
+ * 
+ * The default is 1024 texels.
+ * 
+ * @param size Resolution in texels
+ */
+void Context::setShadowMapResolution(uint16_t size) {
+    shadowMapShader.setResolution(size);
+}
+
+/**
+ * @brief Gets the width and height of each cascade of the shadow map
+ * 
+ * @return Resolution in texels
+ */
+uint16_t Context::getShadowMapResolution() const {
+    return shadowMapShader.getResolution();
+}
+
+/**
+ * @brief Sets the number of slices the camera view is split into for the
+ *        shadows
+ * 
+ * More cascades give sharper shadows over a long viewing distance at the
+ * cost of drawing the casters once more for each. The default is 3.
+ * 
+ * @param n Number of cascades from 1 to 4
+ */
+void Context::setShadowCascadeCount(uint32_t n) {
+    shadowMapShader.setCascadeCount(n);
+}
+
+/**
+ * @brief Gets the number of slices the camera view is split into for the
+ *        shadows
+ * 
+ * @return Number of cascades
+ */
+uint32_t Context::getShadowCascadeCount() const {
+    return shadowMapShader.getCascadeCount();
+}
+
+/**
+ * @brief Sets the filter kernel softening the edges of the shadows
+ * 
+ * The kernels of more taps give smoother edges at the cost of the fill
+ * rate. The default is the 9-tap Poisson disk.
+ * 
+ * @param k Shadow filter kernel
+ */
+void Context::setShadowKernel(ShadowKernel k) {
+    generalShader.setShadowKernel(k);
+}
+
+/**
+ * @brief Gets the filter kernel softening the edges of the shadows
+ * 
+ * @return Shadow filter kernel
+ */
+ShadowKernel Context::getShadowKernel() const {
+    return generalShader.getShadowKernel();
+}
+
+/**
+ * @brief Gets the geometry arenas the 3D objects load their vertices
+ *        into
+ * 
+ * @return Geometry arenas of the context
+ */
+internal::GeometryPool *Context::getGeometryPool() { return &geometry; }
+
+/**
+ * @brief Gets the VBOs shared by the 3D objects of identical meshes
+ * 
+ * @return Mesh cache of the context
+ */
+internal::MeshCache *Context::getMeshCache() { return &meshes; }
+
+/**
+ * @brief Gets the bounding volume hierarchy of the 3D objects
+ * 
+ * @return Scene BVH of the context
+ */
+internal::SceneBVH *Context::getSceneBVH() { return &bvh; }
+
+/**
+ * @brief Sets the trade-off between the build time and the query speed
+ *        of the bounding volume hierarchy
+ * 
+ * The hierarchy is refitted as the objects move and rebuilt once the
+ * refits have made it notably worse. A higher quality takes longer to
+ * rebuild and culls faster. The default is medium.
+ * 
+ * @param q Build quality
+ */
+void Context::setBVHQuality(BVHQuality q) { bvh.setQuality(q); }
+
+/**
+ * @brief Gets the build quality of the bounding volume hierarchy
+ * 
+ * @return Build quality
+ */
+BVHQuality Context::getBVHQuality() const { return bvh.getQuality(); }
+
 /**
  * @breif Sets the error code of the context
  * 
@@ -16,6 +16,11 @@
 
 #include "rmg/context.hpp"
 
+#include <algorithm>
+
+#include "rmg/object3d.hpp"
+#include "rmg/internal/vbo_load.hpp"
+
 
 namespace rmg {
 
@@ -70,6 +75,13 @@ void Context::setBackgroundColor(const Color &col) {
  */
 Color Context::getBackgroundColor() const { return bgColor; }
 
+/**
+ * @brief Gets the camera that displays the context
+ * 
+ * @return Reference to the immutable camera object
+ */
+const Camera& Context::getCamera() const { return camera; }
+
 /**
  * @brief Sets xyz position of the camera
  * 
@@ -81,7 +93,6 @@ Color Context::getBackgroundColor() const { return bgColor; }
  */
 void Context::setCameraTranslation(float x, float y, float z) {
     camera.setTranslation(x, y, z);
-    shadowMapShader.setCameraTranslation(Vec3(x,y,z));
 }
 
 /**
@@ -93,7 +104,6 @@ void Context::setCameraTranslation(float x, float y, float z) {
  */
 void Context::setCameraTranslation(const Vec3 &pos) {
     camera.setTranslation(pos);
-    shadowMapShader.setCameraTranslation(pos);
 }
 
 /**
@@ -109,7 +119,6 @@ void Context::setCameraTranslation(const Vec3 &pos) {
 void Context::setCameraRotation(float x, float y, float z) {
     camera.setRotation(x, y, z);
     dlCameraSpace = (Vec3) (camera.getViewMatrix() * Vec4(dlWorldSpace, 0));
-    shadowMapShader.setCameraRotation(x, y, z);
 }
 
 /**
@@ -126,7 +135,6 @@ void Context::setCameraRotation(float x, float y, float z) {
 void Context::setCameraRotation(float x, float y, float z, AngleUnit unit) {
     camera.setRotation(x, y, z, unit);
     dlCameraSpace = (Vec3) (camera.getViewMatrix() * Vec4(dlWorldSpace, 0));
-    shadowMapShader.setCameraRotation(x, y, z, unit);
 }
 
 /**
@@ -140,7 +148,6 @@ void Context::setCameraRotation(float x, float y, float z, AngleUnit unit) {
 void Context::setCameraRotation(const Euler &rot) {
     camera.setRotation(rot);
     dlCameraSpace = (Vec3) (camera.getViewMatrix() * Vec4(dlWorldSpace, 0));
-    shadowMapShader.setCameraRotation(rot);
 }
 
 /**
@@ -167,8 +174,6 @@ Euler Context::getCameraRotation() const { return camera.getRotation(); }
  */
 void Context::setPerspectiveProjection() {
     camera.setPerspectiveProjection();
-    shadowMapShader.setMinimumDistance(1.0f);
-    shadowMapShader.setMaximumDistance(10.0f);
 }
 
 /**
@@ -182,8 +187,6 @@ void Context::setPerspectiveProjection() {
  */
 void Context::setPerspectiveProjection(float fov, float n, float f) {
     camera.setPerspectiveProjection(fov, n, f);
-    shadowMapShader.setMinimumDistance(n);
-    shadowMapShader.setMaximumDistance(f);
 }
 
 /**
@@ -191,8 +194,6 @@ void Context::setPerspectiveProjection(float fov, float n, float f) {
  */
 void Context::setOrthographicProjection() {
     camera.setOrthographicProjection();
-    shadowMapShader.setMinimumDistance(1.0f);
-    shadowMapShader.setMaximumDistance(10.0f);
 }
 
 /**
@@ -206,8 +207,6 @@ void Context::setOrthographicProjection() {
  */
 void Context::setOrthographicProjection(float fov, float n, float f) {
     camera.setOrthographicProjection(fov, n, f);
-    shadowMapShader.setMinimumDistance(n);
-    shadowMapShader.setMaximumDistance(f);
 }
 
 /**
@@ -224,7 +223,6 @@ void Context::setFieldOfView(float fov) { camera.setFieldOfView(fov); }
  */
 void Context::setMinimumDistance(float n) {
     camera.setMinimumDistance(n);
-    shadowMapShader.setMinimumDistance(n);
 }
 
 /**
@@ -234,7 +232,6 @@ void Context::setMinimumDistance(float n) {
  */
 void Context::setMaximumDistance(float f) {
     camera.setMaximumDistance(f);
-    shadowMapShader.setMaximumDistance(f);
 }
 
 /**
@@ -374,7 +371,9 @@ Rect Context::worldToScreen(const Vec3 &p) const {
 /**
  * @brief Converts screen coordinate to world coordinate
  * 
- * Useful when interacting 3D objects with a mouse.
+ * Useful when interacting 3D objects with a mouse. The returned ray
+ * starts on the near plane of the camera and reaches the far plane at
+ * the end of its direction vector.
  * 
  * @param x X-coordinate
  * @param y Y-coordinate
@@ -382,20 +381,156 @@ Rect Context::worldToScreen(const Vec3 &p) const {
  * @return Line equation in 3D world
  */
 LineEq Context::screenToWorld(uint16_t x, uint16_t y) const {
-    return LineEq();
+    // Unprojects the center of the pixel on the near and far planes
+    Mat4 inverse = camera.getVPMatrix().inverse();
+    float nx = 2 * (x + 0.5f) / width - 1;
+    float ny = 1 - 2 * (y + 0.5f) / height;
+    Vec4 A = inverse * Vec4(nx, ny, -1, 1);
+    Vec4 B = inverse * Vec4(nx, ny, 1, 1);
+    Vec3 P = Vec3(A.x/A.w, A.y/A.w, A.z/A.w);
+    Vec3 Q = Vec3(B.x/B.w, B.y/B.w, B.z/B.w);
+    return LineEq(P, Q - P);
 }
 
 /**
  * @brief Converts screen coordinate to world coordinate
  * 
- * Useful when interacting 3D objects with a mouse.
+ * Useful when interacting 3D objects with a mouse. The returned ray
+ * starts on the near plane of the camera and reaches the far plane at
+ * the end of its direction vector.
  * 
  * @param p Point on screen
  * 
  * @return Line equation in 3D world
  */
 LineEq Context::screenToWorld(const Rect &p) const {
-    return LineEq();
+    return screenToWorld(p.x, p.y);
+}
+
+/**
+ * @brief Finds the nearest 3D object under a point on the screen
+ * 
+ * The objects are narrowed down by their bounds in the bounding volume
+ * hierarchy of the context and then tested triangle by triangle. The
+ * triangle hierarchy of a mesh is built by its first pick. Hidden
+ * objects and the objects not loaded yet are not picked.
+ * 
+ * @param x X-coordinate
+ * @param y Y-coordinate
+ * @param point Returns the hit point in world space if not null
+ * 
+ * @return Nearest 3D object or null if nothing is hit
+ */
+Object3D *Context::pick(uint16_t x, uint16_t y, Vec3 *point) {
+    return pick(screenToWorld(x, y), 1, point);
+}
+
+/**
+ * @brief Finds the nearest 3D object under a point on the screen
+ * 
+ * @param p Point on screen
+ * @param point Returns the hit point in world space if not null
+ * 
+ * @return Nearest 3D object or null if nothing is hit
+ */
+Object3D *Context::pick(const Rect &p, Vec3 *point) {
+    return pick(screenToWorld(p.x, p.y), 1, point);
+}
+
+/**
+ * @brief Finds the nearest 3D object hit by a ray
+ * 
+ * @param ray Ray in world space
+ * @param maxDistance Limit of the distance along the ray in the units
+ *                    of its direction vector
+ * @param point Returns the hit point in world space if not null
+ * 
+ * @return Nearest 3D object or null if nothing is hit
+ */
+Object3D *Context::pick(const LineEq &ray, float maxDistance, Vec3 *point) {
+    bvh.update();
+    Object3D *nearest = nullptr;
+    bvh.raycast(ray, maxDistance, [&](Object3D *obj, float t) {
+        const internal::VBO *vbo = obj->getVBO();
+        if(obj->isHidden() || vbo->getMeshBVH() == nullptr)
+            return maxDistance;
+        // The distances along the ray stay the same in model space
+        Mat4 inverse = obj->getModelMatrix().inverse();
+        Vec4 P = inverse * Vec4(ray.P, 1);
+        Vec4 v = inverse * Vec4(ray.v, 0);
+        LineEq local = LineEq(Vec3(P.x, P.y, P.z), Vec3(v.x, v.y, v.z));
+        if(vbo->getMeshBVH()->raycast(local, maxDistance, &t)) {
+            maxDistance = t;
+            nearest = obj;
+        }
+        return maxDistance;
+    });
+    if(nearest != nullptr && point != nullptr)
+        *point = ray.P + maxDistance * ray.v;
+    return nearest;
+}
+
+/**
+ * @brief Requests the object under a point on the screen from the GPU
+ * 
+ * The IDs of the objects are drawn into an integer image by the next frame
+ * and read back a frame later without waiting for the GPU. The result is
+ * taken by getPickResult(). Unlike pick(), the lines and particles are
+ * picked as well. A request not drawn yet is replaced by the newer one.
+ * 
+ * @param x X-coordinate
+ * @param y Y-coordinate
+ */
+void Context::requestPick(uint16_t x, uint16_t y) {
+    pickingShader.request(x, y, 1, 1);
+}
+
+/**
+ * @brief Requests the object under a point on the screen from the GPU
+ * 
+ * @param p Point on screen
+ */
+void Context::requestPick(const Rect &p) { requestPick(p.x, p.y); }
+
+/**
+ * @brief Requests the objects in a rectangle on the screen from the GPU
+ * 
+ * Used for box selection. Only the objects seen on at least a pixel of the
+ * rectangle are picked. The ones entirely behind others are not.
+ * 
+ * @param p1 A corner of the rectangle
+ * @param p2 The opposite corner of the rectangle
+ */
+void Context::requestPick(const Rect &p1, const Rect &p2) {
+    uint16_t x = std::min(p1.x, p2.x);
+    uint16_t y = std::min(p1.y, p2.y);
+    pickingShader.request(x, y, std::max(p1.x, p2.x) - x + 1,
+                          std::max(p1.y, p2.y) - y + 1);
+}
+
+/**
+ * @brief Gets the objects of the last request read back from the GPU
+ * 
+ * @param objects Returns the 3D objects, lines and particles picked
+ * 
+ * @return True if a new result is returned since the last call
+ */
+bool Context::getPickResult(std::vector<Object*> *objects) {
+    std::vector<uint64_t> ids;
+    if(!pickingShader.getResult(&ids))
+        return false;
+    // The objects removed since the frame was drawn are left out
+    objects->clear();
+    const ObjectList *lists[] = {
+        &object3d_list, &line3d_list, &particle3d_list
+    };
+    for(int i=0; i<3; i++) {
+        for(auto it=lists[i]->begin(); it!=lists[i]->end(); it++) {
+            if(std::binary_search(ids.begin(), ids.end(), it->getID()))
+                objects->push_back(&(*it));
+        }
+    }
+    return true;
 }
 
 }
@@ -16,6 +16,8 @@
 
 #include "rmg/cube.hpp"
 
+#include "rmg/internal/mesh_cache.hpp"
+
 
 namespace rmg {
 
@@ -41,76 +43,93 @@ Cube3D::Cube3D(Context* ctx, float l, float b, float h): Object3D(ctx)
     length = l;
     breadth = b;
     height = h;
-    setMesh(createMesh());
+    // The cubes of the same proportions share a mesh of unit size
+    setMeshScale(l, b, h);
+    updateMesh();
+}
+
+void Cube3D::updateMesh() {
+    // Only the texture layout depends on the dimensions
+    Vec3 texDim = Vec3(0, 0, 0);
+    if(getMaterial() == nullptr) {
+        float sum = length + breadth + height;
+        texDim = Vec3(length/sum, breadth/sum, height/sum);
+    }
+    uint64_t key = internal::MeshCache::hash("Cube3D", 6);
+    key = internal::MeshCache::hash(&texDim, sizeof(texDim), key);
+    setMesh(key, [&]() { return createMesh(texDim); });
 }
 
-Mesh Cube3D::createMesh() {
+Mesh Cube3D::createMesh(const Vec3 &texDim) {
     Vec3 vertices[6][4];
     Vec3 normals[6][4];
     Vec2 texCoords[6][4];
     uint32_t indecies[6][6];
+    float l = texDim.x;
+    float b = texDim.y;
+    float h = texDim.z;
     
     // Left and right faces
     for(int i=-1; i<=1; i+=2) {
         int a = (i==-1) ? 0 : 1;
-        vertices[a][0] = Vec3(i*length/2,  i*breadth/2, -height/2);
-        vertices[a][1] = Vec3(i*length/2,  i*breadth/2,  height/2);
-        vertices[a][2] = Vec3(i*length/2, -i*breadth/2,  height/2);
-        vertices[a][3] = Vec3(i*length/2, -i*breadth/2, -height/2);
+        vertices[a][0] = Vec3(i*0.5f,  i*0.5f, -0.5f);
+        vertices[a][1] = Vec3(i*0.5f,  i*0.5f,  0.5f);
+        vertices[a][2] = Vec3(i*0.5f, -i*0.5f,  0.5f);
+        vertices[a][3] = Vec3(i*0.5f, -i*0.5f, -0.5f);
         Vec3 n = Vec3(i, 0, 0);
         for(int j=0; j<4; j++)
             normals[a][j] = n;
         if(getMaterial() == nullptr) {
-            float d = (i==-1) ? 0 : length+breadth;
-            texCoords[a][0] = Vec2(d+breadth, breadth);
-            texCoords[a][1] = Vec2(d+breadth, breadth+height);
-            texCoords[a][2] = Vec2(d, breadth+height);
-            texCoords[a][3] = Vec2(d, breadth);
+            float d = (i==-1) ? 0 : l+b;
+            texCoords[a][0] = Vec2(d+b, b);
+            texCoords[a][1] = Vec2(d+b, b+h);
+            texCoords[a][2] = Vec2(d, b+h);
+            texCoords[a][3] = Vec2(d, b);
         }
     }
     
     // Front and back faces
     for(int i=-1; i<=1; i+=2) {
         int a = (i==-1) ? 2 : 3;
-        vertices[a][0] = Vec3(-i*length/2, i*breadth/2, -height/2);
-        vertices[a][1] = Vec3(-i*length/2, i*breadth/2,  height/2);
-        vertices[a][2] = Vec3( i*length/2, i*breadth/2,  height/2);
-        vertices[a][3] = Vec3( i*length/2, i*breadth/2, -height/2);
+        vertices[a][0] = Vec3(-i*0.5f, i*0.5f, -0.5f);
+        vertices[a][1] = Vec3(-i*0.5f, i*0.5f,  0.5f);
+        vertices[a][2] = Vec3( i*0.5f, i*0.5f,  0.5f);
+        vertices[a][3] = Vec3( i*0.5f, i*0.5f, -0.5f);
         Vec3 n = Vec3(0, i, 0);
         for(int j=0; j<4; j++)
             normals[a][j] = n;
         if(getMaterial() == nullptr) {
-            float d = (i==-1) ? breadth : length+2*breadth;
-            texCoords[a][0] = Vec2(d+length, breadth);
-            texCoords[a][1] = Vec2(d+length, breadth+height);
-            texCoords[a][2] = Vec2(d, breadth+height);
-            texCoords[a][3] = Vec2(d, breadth);
+            float d = (i==-1) ? b : l+2*b;
+            texCoords[a][0] = Vec2(d+l, b);
+            texCoords[a][1] = Vec2(d+l, b+h);
+            texCoords[a][2] = Vec2(d, b+h);
+            texCoords[a][3] = Vec2(d, b);
         }
     }
     
     // Top and bottom faces
     for(int i=-1; i<=1; i+=2) {
         int a = (i==-1) ? 4 : 5;
-        vertices[a][0] = Vec3( length/2, -i*breadth/2, i*height/2);
-        vertices[a][1] = Vec3( length/2,  i*breadth/2, i*height/2);
-        vertices[a][2] = Vec3(-length/2,  i*breadth/2, i*height/2);
-        vertices[a][3] = Vec3(-length/2, -i*breadth/2, i*height/2);
+        vertices[a][0] = Vec3( 0.5f, -i*0.5f, i*0.5f);
+        vertices[a][1] = Vec3( 0.5f,  i*0.5f, i*0.5f);
+        vertices[a][2] = Vec3(-0.5f,  i*0.5f, i*0.5f);
+        vertices[a][3] = Vec3(-0.5f, -i*0.5f, i*0.5f);
         Vec3 n = Vec3(0, 0, i);
         for(int j=0; j<4; j++)
             normals[a][j] = n;
         if(getMaterial() == nullptr) {
-            float d = (i==-1) ? breadth : breadth+length;
-            texCoords[a][0] = Vec2(d+length, height);
-            texCoords[a][1] = Vec2(d+length, height+breadth);
-            texCoords[a][2] = Vec2(d, height+breadth);
-            texCoords[a][3] = Vec2(d, height);
+            float d = (i==-1) ? b : b+l;
+            texCoords[a][0] = Vec2(d+l, h);
+            texCoords[a][1] = Vec2(d+l, h+b);
+            texCoords[a][2] = Vec2(d, h+b);
+            texCoords[a][3] = Vec2(d, h);
         }
     }
     
     // Scaling textural coordinates
     if(getMaterial() == nullptr) {
-        float imageWidth = 2*(breadth+length);
-        float imageHeight = height + 2*breadth;
+        float imageWidth = 2*(b+l);
+        float imageHeight = h + 2*b;
         for(int i=0; i<6; i++) {
             for(int j=0; j<4; j++) {
                 texCoords[i][j].x /= imageWidth;
@@ -163,8 +182,8 @@ Vec3 Cube3D::getDimension() const {
 void Cube3D::setMaterial(Material* mat) {
     Material *prev = getMaterial();
     Object3D::setMaterial(mat);
-    if(prev == nullptr)
-        setMesh(createMesh());
+    if((prev == nullptr) != (mat == nullptr))
+        updateMesh();
 }
 
 }
@@ -16,6 +16,11 @@
 
 #include "rmg/cylinder.hpp"
 
+#include <cmath>
+#include <vector>
+
+#include "rmg/internal/mesh_cache.hpp"
+
 
 namespace rmg {
 
@@ -38,108 +43,114 @@ Cylinder3D::Cylinder3D(Context* ctx, float d, float l): Object3D(ctx)
 {
     diameter = d;
     length = l;
-    setMesh(createMesh());
+    // The cylinders of the same proportions share a mesh of unit size
+    setMeshScale(l, d, d);
+    updateMesh();
 }
 
-Mesh Cylinder3D::createMesh() {
-    #define FRAGMENT_COUNT 32
-    
-    Vec3 vertices[FRAGMENT_COUNT+1][4];
-    Vec3 normals[FRAGMENT_COUNT+1][4];
-    Vec2 texCoords[FRAGMENT_COUNT+1][4];
-    uint32_t indecies[FRAGMENT_COUNT][12];
+void Cylinder3D::updateMesh() {
+    // Only the texture layout depends on the dimensions. The texture
+    // coordinates are in the real size when using a material.
+    Vec2 texDim = Vec2(diameter, length);
+    if(getMaterial() == nullptr)
+        texDim /= diameter + length;
+    uint64_t key = internal::MeshCache::hash("Cylinder3D", 10);
+    key = internal::MeshCache::hash(&texDim, sizeof(texDim), key);
+    setMeshLevels(key, [&]() { return createLevels(texDim); });
+}
+
+std::vector<internal::LevelOfDetail>
+Cylinder3D::createLevels(const Vec2 &texDim)
+{
+    // Fragments around the circumference of each level
+    const int fragments[] = {64, 32, 16, 8};
+    std::vector<internal::LevelOfDetail> lods;
+    for(int f : fragments) {
+        // Sagitta of a fragment
+        float error = 0.5f * (1 - cos(M_PI / f));
+        lods.push_back({createMesh(texDim, f), error});
+    }
+    return lods;
+}
+
+Mesh Cylinder3D::createMesh(const Vec2 &texDim, int n) {
+    std::vector<Vec3> vertices = std::vector<Vec3>(n*4 + 2);
+    std::vector<Vec3> normals = std::vector<Vec3>(n*4 + 2);
+    std::vector<Vec2> texCoords = std::vector<Vec2>(n*4 + 2);
+    std::vector<uint32_t> indices = std::vector<uint32_t>(n*12);
     
-    float radius = diameter/2.0f;
+    float d = texDim.x;
+    float l = texDim.y;
+    float radius = d/2.0f;
     Vec2 c1 = Vec2(radius, radius);
-    Vec2 c2 = Vec2(radius, diameter+length);
-    float imageWidth = M_PI * diameter;
-    float imageHeight = 2*diameter + length;
+    Vec2 c2 = Vec2(radius, d+l);
+    float imageWidth = M_PI * d;
+    float imageHeight = 2*d + l;
     
     // Pole vertices
-    vertices[FRAGMENT_COUNT][0] = Vec3(-length/2, 0, 0);
-    vertices[FRAGMENT_COUNT][1] = Vec3(length/2, 0, 0);
-    normals[FRAGMENT_COUNT][0] = Vec3(-1, 0, 0);
-    normals[FRAGMENT_COUNT][1] = Vec3(1, 0, 0);
-    texCoords[FRAGMENT_COUNT][0].x = c1.x / imageWidth;
-    texCoords[FRAGMENT_COUNT][0].y = c1.y / imageHeight;
-    texCoords[FRAGMENT_COUNT][1].x = c2.x / imageWidth;
-    texCoords[FRAGMENT_COUNT][1].y = c2.y / imageHeight;
+    vertices[n*4] = Vec3(-0.5f, 0, 0);
+    vertices[n*4 + 1] = Vec3(0.5f, 0, 0);
+    normals[n*4] = Vec3(-1, 0, 0);
+    normals[n*4 + 1] = Vec3(1, 0, 0);
+    texCoords[n*4].x = c1.x / imageWidth;
+    texCoords[n*4].y = c1.y / imageHeight;
+    texCoords[n*4 + 1].x = c2.x / imageWidth;
+    texCoords[n*4 + 1].y = c2.y / imageHeight;
     
     // Iterate through the circumference
-    for(int i=0; i<FRAGMENT_COUNT; i++) {
-        float t = - M_PI/2 - 1 + 2*M_PI*((float)i/FRAGMENT_COUNT);
+    for(int i=0; i<n; i++) {
+        float t = - M_PI/2 - 1 + 2*M_PI*((float)i/n);
         float c = cos(t);
         float s = sin(t);
         
-        vertices[i][0] = Vec3(-length/2, radius*c, radius*s);
-        vertices[i][1] = Vec3(-length/2, radius*c, radius*s);
-        vertices[i][2] = Vec3(length/2, radius*c, radius*s);
-        vertices[i][3] = Vec3(length/2, radius*c, radius*s);
-        normals[i][0] = Vec3(-1, 0, 0);
-        normals[i][1] = Vec3(0, c, s);
-        normals[i][2] = Vec3(0, c, s);
-        normals[i][3] = Vec3(1, 0, 0);
+        vertices[i*4] = Vec3(-0.5f, 0.5f*c, 0.5f*s);
+        vertices[i*4 + 1] = Vec3(-0.5f, 0.5f*c, 0.5f*s);
+        vertices[i*4 + 2] = Vec3(0.5f, 0.5f*c, 0.5f*s);
+        vertices[i*4 + 3] = Vec3(0.5f, 0.5f*c, 0.5f*s);
+        normals[i*4] = Vec3(-1, 0, 0);
+        normals[i*4 + 1] = Vec3(0, c, s);
+        normals[i*4 + 2] = Vec3(0, c, s);
+        normals[i*4 + 3] = Vec3(1, 0, 0);
         
-        texCoords[i][0] = c1 + Vec2(radius*c, radius*s);
-        texCoords[i][1] = Vec2(radius*t, radius);
-        texCoords[i][1] = Vec2(radius*t, diameter+length);
-        texCoords[i][3] = c2 + Vec2(radius*c, radius*s);
+        texCoords[i*4] = c1 + Vec2(radius*c, radius*s);
+        texCoords[i*4 + 1] = Vec2(radius*t, d);
+        texCoords[i*4 + 2] = Vec2(radius*t, d+l);
+        texCoords[i*4 + 3] = c2 + Vec2(radius*c, radius*s);
         
-        if(i == 0) {
-            indecies[0][0] = (FRAGMENT_COUNT-1)*4;
-            indecies[0][1] = FRAGMENT_COUNT*4;
-            indecies[0][2] = 0;
-            
-            indecies[0][3] = (FRAGMENT_COUNT-1)*4 + 2;
-            indecies[0][4] = (FRAGMENT_COUNT-1)*4 + 1;
-            indecies[0][5] = 1;
-            indecies[0][6] = 1;
-            indecies[0][7] = 2;
-            indecies[0][8] = (FRAGMENT_COUNT-1)*4 + 2;
-            
-            indecies[0][9] = (FRAGMENT_COUNT-1)*4 + 3;
-            indecies[0][10] = 3;
-            indecies[0][11] = FRAGMENT_COUNT*4 + 1;
-        }
-        else {
-            indecies[i][0] = (i-1)*4;
-            indecies[i][1] = FRAGMENT_COUNT*4;
-            indecies[i][2] = i*4;
-            
-            indecies[i][3] = (i-1)*4 + 2;
-            indecies[i][4] = (i-1)*4 + 1;
-            indecies[i][5] = i*4 + 1;
-            indecies[i][6] = i*4 + 1;
-            indecies[i][7] = i*4 + 2;
-            indecies[i][8] = (i-1)*4 + 2;
-            
-            indecies[i][9] = (i-1)*4 + 3;
-            indecies[i][10] = i*4 + 3;
-            indecies[i][11] = FRAGMENT_COUNT*4 + 1;
-        }
+        uint32_t *in = &indices[i*12];
+        int prev = (i == 0) ? n-1 : i-1;
+        in[0] = prev*4;
+        in[1] = n*4;
+        in[2] = i*4;
+        
+        in[3] = prev*4 + 2;
+        in[4] = prev*4 + 1;
+        in[5] = i*4 + 1;
+        in[6] = i*4 + 1;
+        in[7] = i*4 + 2;
+        in[8] = prev*4 + 2;
+        
+        in[9] = prev*4 + 3;
+        in[10] = i*4 + 3;
+        in[11] = n*4 + 1;
     }
     
     // Scaling textural coordinates
     if(getMaterial() == nullptr) {
-        float imageWidth = M_PI * diameter;
-        float imageHeight = length + 2*diameter;
-        for(int i=0; i<FRAGMENT_COUNT; i++) {
-            for(int j=0; j<4; j++) {
-                texCoords[i][j].x /= imageWidth;
-                texCoords[i][j].y /= imageHeight;
-            }
+        for(int i=0; i<n*4; i++) {
+            texCoords[i].x /= imageWidth;
+            texCoords[i].y /= imageHeight;
         }
     }
     
     return Mesh(
-        &vertices[0][0],
-        &normals[0][0],
-        &texCoords[0][0],
-        FRAGMENT_COUNT*4 + 2,
-        &indecies[0][0],
-        FRAGMENT_COUNT*12
+        vertices.data(),
+        normals.data(),
+        texCoords.data(),
+        vertices.size(),
+        indices.data(),
+        indices.size()
     );
-    #undef FRAGMENT_COUNT
 }
 
 /**
@@ -167,8 +178,8 @@ float Cylinder3D::getLength() const { return length; }
 void Cylinder3D::setMaterial(Material* mat) {
     Material *prev = getMaterial();
     Object3D::setMaterial(mat);
-    if(prev == nullptr)
-        setMesh(createMesh());
+    if((prev == nullptr) != (mat == nullptr))
+        updateMesh();
 }
 
 }
@@ -19,6 +19,8 @@
 
 #include "../rmg/internal/context_load.hpp"
 
+#include <chrono>
+#include <thread>
 #include <utility>
 
 
@@ -27,11 +29,44 @@ namespace internal {
 
 // Class: ContextLoad
 
+/**
+ * @brief Constructor
+ * 
+ * @param prepared False if the load has CPU work to be done by
+ *                 prepare() before it can be loaded to the GPU
+ */
+ContextLoad::ContextLoad(bool prepared) {
+    this->prepared = prepared;
+}
+
+/**
+ * @brief Does the CPU work of the load like decoding files
+ * 
+ * Runs on a worker thread, so it must not call OpenGL functions.
+ */
+void ContextLoad::prepare() {}
+
 /**
  * @brief Loads the data to the GPU
  */
 void ContextLoad::load() {}
 
+/**
+ * @brief Gets the number of bytes the load sends to the GPU
+ * 
+ * Used to spread the uploads across frames within a budget.
+ * 
+ * @return Upload size in bytes. Zero if unknown or negligible.
+ */
+uint64_t ContextLoad::getUploadSize() const { return 0; }
+
+/**
+ * @brief Checks if the CPU work of the load is complete
+ * 
+ * @return True if the load is ready to be loaded to the GPU
+ */
+bool ContextLoad::isPrepared() const { return prepared; }
+
 
 
 
@@ -132,82 +167,42 @@ const ContextLoad *Pending::getData() const { return data; }
 
 
 
-// Class: PendingStack
+// Class: ContextLoader
 
 /**
- * @brief Destructor
+ * @brief Default constructor
  */
-PendingStack::~PendingStack() {
-    if(next != nullptr)
-        delete next;
+ContextLoader::ContextLoader() {
+    budgetTime = 0;
+    budgetBytes = 0;
+    pushCount = 0;
+    loadCount = 0;
+    unprepared = 0;
 }
 
 /**
  * @brief Destructor
  */
-PendingStack::Node::~Node() {
-    if(next != nullptr)
-        delete next;
-}
+ContextLoader::~ContextLoader() {}
 
 /**
- * @brief Appends an element to the top of the stack
+ * @brief Copy constructor makes an empty loader
  * 
- * @param elem New element to the stack
- */
-void PendingStack::push(Pending elem) {
-    Node* tmp = next;
-    next = new Node();
-    next->next = tmp;
-    next->data = data;
-    data = elem;
-    count++;
-}
-
-/**
- * @brief Retrives an element from the top of the stack
+ * The loads and the worker threads belong to a single loader and are
+ * not copied.
  * 
- * @return The retrived element
- */
-Pending& PendingStack::front() { return data; }
-
-/**
- * @brief Removes an element from the top of the stack
+ * @param loader Source
  */
-void PendingStack::pop() {
-    if(count == 0)
-        return;
-    
-    if(next != nullptr) {
-        Node* tmp = next->next;
-        next->next = nullptr;
-        data = next->data;
-        delete next;
-        next = tmp;
-    }
-    else {
-        data = Pending();
-    }
-    count--;
-}
-
-/**
- * @brief Gets the number of elements in the stack
- * 
- * @return The number of elements
- */
-uint32_t PendingStack::size() const { return count; }
-
-
-
-
-// Class: ContextLoader
+ContextLoader::ContextLoader(const ContextLoader& loader)
+              :ContextLoader()
+{}
 
 /**
  * @brief Append load into the loading list
  * 
  * If the function is called again for the same load, the shared data
  * of the Pending class determines that it already exists and cancels.
+ * If the load has CPU work to do, it is queued to the worker threads.
  * 
  * @param elem Instance containing data to be loaded into GPU
  */
@@ -216,17 +211,65 @@ void ContextLoader::push(const Pending& elem)
     if(elem.shared == nullptr || elem.shared->added)
         return;
     elem.shared->added = true;
-    pendingList.push(elem);
+    if(pendingList.size() == 0) {
+        pushCount = 0;
+        loadCount = 0;
+    }
+    pendingList.push_back(elem);
+    pushCount++;
+    
+    if(elem.data != nullptr && !elem.data->prepared) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            prepareQueue.push_back(elem.data);
+        }
+        unprepared++;
+        workers.push([this] { prepareNext(); });
+    }
+}
+
+void ContextLoader::prepareNext() {
+    ContextLoad* load;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(prepareQueue.size() == 0)
+            return;
+        load = prepareQueue.front();
+        prepareQueue.pop_front();
+    }
+    load->prepare();
+    load->prepared = true;
+    unprepared--;
+}
+
+bool ContextLoader::cancel(ContextLoad* load) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for(auto it=prepareQueue.begin(); it!=prepareQueue.end(); it++) {
+        if(*it == load) {
+            prepareQueue.erase(it);
+            unprepared--;
+            return true;
+        }
+    }
+    return false;
 }
 
 /**
  * @brief Loads the data to the GPU
  * 
- * Loads the data from the list to the GPU and then clear the memory
- * from the list. If the reference count of the load is zero, discard it
- * without loading into the GPU.
+ * Loads the prepared data from the list to the GPU in the order they
+ * are pushed and then clear the memory from the list. The loads still
+ * being prepared stay in the list for the later calls. If the reference
+ * count of the load is zero, discard it without loading into the GPU.
+ * 
+ * Stops when the upload budget is used up leaving the rest for the
+ * next call. At least one load is uploaded in each call.
  */
 void ContextLoader::load() {
+    std::deque<Pending> waiting;
+    auto start = std::chrono::steady_clock::now();
+    uint64_t bytes = 0;
+    uint32_t uploads = 0;
     while(pendingList.size() != 0) {
         Pending& p = pendingList.front();
         /*
@@ -235,14 +278,79 @@ void ContextLoader::load() {
          * Reference count when no load is in the world is at least 1 because
          * the load pushed in the pending list is counted.
          */
-        if(p.shared != nullptr) {
-            if(p.shared->use_count != 1) {
-                if(p.data != nullptr)
-                    p.data->load();
+        if(p.shared != nullptr && p.data != nullptr) {
+            if(!p.data->prepared) {
+                // A worker thread may be using the data. It is released
+                // only if it is still in the queue.
+                if(p.shared->use_count != 1 || !cancel(p.data)) {
+                    waiting.push_back(std::move(p));
+                    pendingList.pop_front();
+                    continue;
+                }
+            }
+            else if(p.shared->use_count != 1) {
+                uint64_t size = p.data->getUploadSize();
+                if(uploads > 0) {
+                    std::chrono::duration<float, std::milli> t =
+                        std::chrono::steady_clock::now() - start;
+                    if(budgetTime > 0 && t.count() >= budgetTime)
+                        break;
+                    if(budgetBytes > 0 && bytes + size > budgetBytes)
+                        break;
+                }
+                p.data->load();
+                bytes += size;
+                uploads++;
             }
         }
-        pendingList.pop();
+        loadCount++;
+        pendingList.pop_front();
     }
+    pendingList.insert(pendingList.begin(), waiting.begin(), waiting.end());
+}
+
+/**
+ * @brief Sets the limit of the uploads for each call of load()
+ * 
+ * Spreads the uploads across multiple frames when a lot of resources
+ * are added at once. Zero means no limit.
+ * 
+ * @param ms Time limit in milliseconds
+ * @param bytes Limit of the bytes sent to the GPU
+ */
+void ContextLoader::setBudget(float ms, uint64_t bytes) {
+    budgetTime = ms;
+    budgetBytes = bytes;
+}
+
+/**
+ * @brief Waits until every load in the list is prepared
+ * 
+ * The calling thread helps the worker threads with the queued loads.
+ */
+void ContextLoader::wait() {
+    while(unprepared != 0) {
+        bool queued;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queued = (prepareQueue.size() > 0);
+        }
+        if(queued)
+            prepareNext();
+        else
+            std::this_thread::yield();
+    }
+}
+
+/**
+ * @brief Gets the progress of the loads pushed since the list was empty
+ * 
+ * @return Fraction of the loads completed from 0 to 1
+ */
+float ContextLoader::getProgress() const {
+    if(pendingList.size() == 0)
+        return 1.0f;
+    return (float) loadCount / pushCount;
 }
 
 /**
@@ -0,0 +1,185 @@
+/**
+ * @file frame_profiler.cpp
+ * @brief Measures the CPU and GPU time of the rendering passes
+ * 
+ * GPU times are measured with timer queries which are kept in a ring and
+ * only read back once the results are available so the CPU never waits for
+ * the GPU.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#define RMG_EXPORT
+
+
+#include "../rmg/internal/frame_profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "../rmg/internal/glcontext.hpp"
+
+
+static double getTimeMillis() {
+    auto t = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration<double, std::milli>(t).count();
+}
+
+
+namespace rmg {
+namespace internal {
+
+/**
+ * @brief Default constructor
+ */
+FrameProfiler::FrameProfiler() {
+    memset(queries, 0, sizeof(queries));
+    memset(queryIssued, 0, sizeof(queryIssued));
+    ringIndex = 0;
+    currentPass = -1;
+    passStartTime = 0;
+    lastFrameTime = 0;
+    passStartDrawCalls = 0;
+    passStartUniforms = 0;
+    historyCount = 0;
+    historyIndex = 0;
+    gpuTimerChecked = false;
+}
+
+/**
+ * @brief Destructor
+ */
+FrameProfiler::~FrameProfiler() {
+    if(queries[0][0] != 0)
+        glDeleteQueries(sizeof(queries)/sizeof(uint32_t), &queries[0][0]);
+}
+
+/**
+ * @brief Starts measuring a new frame
+ * 
+ * Collects the GPU times of the oldest frame in the query ring if they
+ * are ready and resets the per-frame counters.
+ */
+void FrameProfiler::beginFrame() {
+    if(!gpuTimerChecked) {
+        int major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        if(major*100 + minor >= 3*100 + 3 && glGetQueryObjectui64v != NULL) {
+            glGenQueries(sizeof(queries)/sizeof(uint32_t), &queries[0][0]);
+            stats.gpuTimerSupported = true;
+        }
+        gpuTimerChecked = true;
+    }
+    if(stats.gpuTimerSupported && queryIssued[ringIndex])
+        readQueries(ringIndex);
+    
+    for(int i=0; i<RMG_RENDER_PASS_COUNT; i++) {
+        stats.passes[i].cpuTime = 0;
+        stats.passes[i].drawCalls = 0;
+        stats.passes[i].uniformUploads = 0;
+    }
+    stats.drawCalls = 0;
+    stats.uniformUploads = 0;
+    stats.cpuTime = 0;
+    
+    double t = getTimeMillis();
+    if(lastFrameTime > 0) {
+        stats.frameTime = (float)(t - lastFrameTime);
+        history[historyIndex] = stats.frameTime;
+        historyIndex = (historyIndex + 1) % RMG_FRAME_HISTORY;
+        if(historyCount < RMG_FRAME_HISTORY)
+            historyCount++;
+        calculatePercentiles();
+    }
+    lastFrameTime = t;
+}
+
+void FrameProfiler::readQueries(uint32_t slot) {
+    // Queries finish in the order they are issued
+    uint32_t last = queries[slot][RMG_RENDER_PASS_COUNT-1];
+    GLint available = 0;
+    glGetQueryObjectiv(last, GL_QUERY_RESULT_AVAILABLE, &available);
+    if(!available)
+        return;
+    
+    stats.gpuTime = 0;
+    for(int i=0; i<RMG_RENDER_PASS_COUNT; i++) {
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(queries[slot][i], GL_QUERY_RESULT, &ns);
+        stats.passes[i].gpuTime = (float)(ns / 1.0e6);
+        stats.gpuTime += stats.passes[i].gpuTime;
+    }
+    queryIssued[slot] = false;
+}
+
+void FrameProfiler::calculatePercentiles() {
+    float sorted[RMG_FRAME_HISTORY];
+    uint32_t n = historyCount;
+    memcpy(sorted, history, n*sizeof(float));
+    uint32_t i50 = (n-1) * 50 / 100;
+    uint32_t i95 = (n-1) * 95 / 100;
+    uint32_t i99 = (n-1) * 99 / 100;
+    std::nth_element(sorted, sorted+i50, sorted+n);
+    stats.p50 = sorted[i50];
+    std::nth_element(sorted+i50, sorted+i95, sorted+n);
+    stats.p95 = sorted[i95];
+    std::nth_element(sorted+i95, sorted+i99, sorted+n);
+    stats.p99 = sorted[i99];
+}
+
+/**
+ * @brief Starts measuring a rendering pass
+ * 
+ * @param pass Rendering pass
+ */
+void FrameProfiler::beginPass(RenderPass pass) {
+    currentPass = (int) pass;
+    passStartDrawCalls = drawCallCount;
+    passStartUniforms = uniformUploadCount;
+    if(stats.gpuTimerSupported)
+        glBeginQuery(GL_TIME_ELAPSED, queries[ringIndex][currentPass]);
+    passStartTime = getTimeMillis();
+}
+
+/**
+ * @brief Ends the measurement of the current rendering pass
+ */
+void FrameProfiler::endPass() {
+    if(currentPass < 0)
+        return;
+    PassStats &ps = stats.passes[currentPass];
+    ps.cpuTime = (float)(getTimeMillis() - passStartTime);
+    if(stats.gpuTimerSupported)
+        glEndQuery(GL_TIME_ELAPSED);
+    ps.drawCalls = drawCallCount - passStartDrawCalls;
+    ps.uniformUploads = uniformUploadCount - passStartUniforms;
+    stats.cpuTime += ps.cpuTime;
+    stats.drawCalls += ps.drawCalls;
+    stats.uniformUploads += ps.uniformUploads;
+    currentPass = -1;
+}
+
+/**
+ * @brief Ends the measurement of the frame
+ */
+void FrameProfiler::endFrame() {
+    if(stats.gpuTimerSupported) {
+        queryIssued[ringIndex] = true;
+        ringIndex = (ringIndex + 1) % RMG_FRAME_QUERY_RING;
+    }
+    stats.frameCount++;
+}
+
+/**
+ * @brief Gets the statistics of the recent frames
+ * 
+ * @return Frame statistics
+ */
+const FrameStats &FrameProfiler::getStats() const { return stats; }
+
+}}
@@ -18,96 +18,418 @@
 
 #include "../rmg/internal/general_shader.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
 #include "shader_def.h"
 #include "../../config/rmg/config.h"
 #include "../rmg/object3d.hpp"
+#include "../rmg/internal/scene_bvh.hpp"
+#include "../rmg/math/frustum.hpp"
+
+
+#define GENERAL_SHADOW (1 << 0)
+#define GENERAL_TEXTURED (1 << 1)
+#define GENERAL_COMPRESSED_NORMAL (1 << 2)
+
+// Uniforms in the order of their names given to the permutations
+#define UNIFORM_V 0
+#define UNIFORM_P 1
+#define UNIFORM_SHADOW 2
+#define UNIFORM_SHADOW_VP 3
+#define UNIFORM_CASCADE_COUNT 4
+#define UNIFORM_DL_CAMERA 5
+#define UNIFORM_DL_COLOR 6
+
+
+// Features of the program drawing the object apart from the shadows
+static uint32_t getFeatures(const rmg::Object3D *obj) {
+    uint32_t format = obj->getVBO()->getArena()->getFormat();
+    uint32_t features = 0;
+    if((format & RMG_VERTEX_TEXTURED) && obj->getTexture() != nullptr)
+        features |= GENERAL_TEXTURED;
+    if(format & RMG_VERTEX_COMPRESSED)
+        features |= GENERAL_COMPRESSED_NORMAL;
+    return features;
+}
+
+
+static const char* getKernelDefinition(rmg::ShadowKernel kernel) {
+    switch(kernel) {
+      case rmg::ShadowKernel::Single:
+        return "#define SHADOW_TAPS 1\n";
+      case rmg::ShadowKernel::Box4:
+        return "#define SHADOW_TAPS 4\n";
+      case rmg::ShadowKernel::RotatedPoisson16:
+        return "#define SHADOW_TAPS 16\n";
+      default:
+        return "#define SHADOW_TAPS 9\n";
+    }
+}
 
 
 namespace rmg {
 namespace internal {
 
+/**
+ * @brief Destructor
+ */
+GeneralShader::~GeneralShader() {
+    if(instanceBuffer != 0)
+        glDeleteBuffers(1, &instanceBuffer);
+    if(indirectBuffer != 0)
+        glDeleteBuffers(1, &indirectBuffer);
+}
+
 /**
  * @brief Compiles and links shader program and assigns parameter IDs
  */
 void GeneralShader::load() {
-    id = compileShaderProgram(
+    programs = ShaderPermutations(
         RMG_RESOURCE_PATH "/shaders/general.vs.glsl",
-        RMG_RESOURCE_PATH "/shaders/general.fs.glsl"
+        RMG_RESOURCE_PATH "/shaders/general.fs.glsl",
+        {"SHADOW", "TEXTURED", "COMPRESSED_NORMAL"},
+        {"V", "P", "shadowMap", "shadowVP", "cascadeCount",
+         "dirLight.direction", "dirLight.color"}
     );
-    idMVP = glGetUniformLocation(id, "MVP");
-    idMV = glGetUniformLocation(id, "MV");
-    idScale = glGetUniformLocation(id, "scale");
-    idShadow = glGetUniformLocation(id, "shadowMap");
-    idShadowMVP = glGetUniformLocation(id, "shadowMVP");
-    idDLCamera = glGetUniformLocation(id, "dirLight.direction");
-    idDLColor = glGetUniformLocation(id, "dirLight.color");
-    idMatColor = glGetUniformLocation(id, "mat.color");
-    idMatMetal = glGetUniformLocation(id, "mat.metalness");
-    idMatRough = glGetUniformLocation(id, "mat.roughness");
-    idMatAO = glGetUniformLocation(id, "mat.ao");
-    idFlags = glGetUniformLocation(id, "vflags");
+    programs.setDefinitions(getKernelDefinition(kernel));
+    // The common combinations compile while the other shaders load
+    programs.prepare(GENERAL_SHADOW);
+    programs.prepare(GENERAL_SHADOW | GENERAL_COMPRESSED_NORMAL);
+    loaded = true;
+    glGenBuffers(1, &instanceBuffer);
+    
+    // Base instances of the indirect draws require OpenGL 4.2 as well
+    int major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if(major*100 + minor >= 4*100 + 3 &&
+       glMultiDrawElementsIndirect != NULL)
+    {
+        glGenBuffers(1, &indirectBuffer);
+        multiDrawIndirect = true;
+    }
+}
+
+/**
+ * @brief Sets the filter kernel of the shadow edges
+ * 
+ * The programs are compiled again with the kernel by the next render.
+ * 
+ * @param k Shadow filter kernel
+ */
+void GeneralShader::setShadowKernel(ShadowKernel k) { kernel = k; }
+
+/**
+ * @brief Gets the filter kernel of the shadow edges
+ * 
+ * @return Shadow filter kernel
+ */
+ShadowKernel GeneralShader::getShadowKernel() const { return kernel; }
+
+/**
+ * @brief Gets the number of programs compiled for the combinations of
+ *        features drawn so far
+ * 
+ * @return Number of programs
+ */
+size_t GeneralShader::getProgramCount() const {
+    return programs.getProgramCount();
 }
 
 /**
- * @brief Renders the given list of 3D objects with world model, object model
+ * @brief Renders the 3D objects in view with world model, object model
  *        and material properties
  * 
  * @param V View matrix
  * @param P Projection matrix
- * @param S Shadow matrix
+ * @param S Shadow matrices of the cascades
+ * @param cascades Number of cascades
  * @param dlCam Directional light vector in camera space
  * @param dlColor Directional light color
  * @param shadow Shadow map
- * @param list List of 3D objects
+ * @param bvh Bounding volume hierarchy of the 3D objects
+ * @param lodError Largest error of the levels of detail in normalized
+ *                 device coordinates
  */
-void GeneralShader::render(const Mat4 &V, const Mat4 &P, const Mat4 &S,
-                           const Vec3 &dlCam, const Color &dlColor,
-                           uint32_t shadow, const ObjectList &list)
+void GeneralShader::render(const Mat4 &V, const Mat4 &P, const Mat4 *S,
+                           uint32_t cascades, const Vec3 &dlCam,
+                           const Color &dlColor, uint32_t shadow,
+                           const SceneBVH &bvh, float lodError)
 {
-    if(id == 0)
+    if(!loaded)
         return;
+    programs.setDefinitions(getKernelDefinition(kernel));
+    
+    // Groups the visible objects by their geometry arena, texture and VBO
+    Frustum frustum = Frustum(P * V);
+    batch.clear();
+    bvh.query(frustum, [&](Object3D *obj) {
+        const VBO *vbo = obj->getVBO();
+        if(obj->isHidden() || vbo == nullptr || vbo->getArena() == nullptr)
+            return;
+        batch.push_back(obj);
+    });
+    if(batch.size() == 0)
+        return;
+    selectLevels(V, P, lodError);
+    std::sort(batch.begin(), batch.end(), [](Object3D *a, Object3D *b) {
+        uint32_t fa = getFeatures(a);
+        uint32_t fb = getFeatures(b);
+        if(fa != fb)
+            return fa < fb;
+        if(a->getVBO()->getArena() != b->getVBO()->getArena())
+            return a->getVBO()->getArena() < b->getVBO()->getArena();
+        if(a->getTexture() != b->getTexture())
+            return a->getTexture() < b->getTexture();
+        if(a->getVBO() != b->getVBO())
+            return a->getVBO() < b->getVBO();
+        return a->getLOD() < b->getLOD();
+    });
+    
+    instances.resize(batch.size());
+    for(size_t i=0; i<batch.size(); i++) {
+        Object3D *obj = batch[i];
+        GeneralInstance &inst = instances[i];
+        const Mat4 &M = obj->getModelMatrix();
+        for(int r=0; r<4; r++) {
+            for(int c=0; c<4; c++)
+                inst.model[c*4 + r] = M[r][c];
+        }
+        Vec3 scale = obj->getScale();
+        Vec3 meshScale = obj->getMeshScale();
+        Color color = obj->getColor();
+        const Vec3 &posOffset = obj->getVBO()->getPositionOffset();
+        const Vec3 &posScale = obj->getVBO()->getPositionScale();
+        for(int j=0; j<3; j++) {
+            inst.scale[j] = scale[j] * meshScale[j];
+            inst.posOffset[j] = posOffset[j];
+            inst.posScale[j] = posScale[j];
+        }
+        inst.color[0] = color.red;
+        inst.color[1] = color.green;
+        inst.color[2] = color.blue;
+        inst.color[3] = color.alpha;
+        inst.mrao[0] = obj->getMetalness();
+        inst.mrao[1] = obj->getRoughness();
+        inst.mrao[2] = obj->getAmbientOcculation();
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, instances.size()*sizeof(GeneralInstance),
+                 instances.data(), GL_STREAM_DRAW);
+    
+    // An instanced draw for each VBO and level of detail, relative to the
+    // start of its group
+    commands.clear();
+    size_t groupStart = 0;
+    for(size_t start=0; start<batch.size(); ) {
+        const VBO *vbo = batch[start]->getVBO();
+        const Texture *tex = batch[start]->getTexture();
+        uint32_t lod = batch[start]->getLOD();
+        size_t end = start + 1;
+        while(end < batch.size() && batch[end]->getVBO() == vbo &&
+              batch[end]->getTexture() == tex &&
+              batch[end]->getLOD() == lod)
+        {
+            end++;
+        }
+        if(start > 0) {
+            const Object3D *prev = batch[start-1];
+            if(prev->getVBO()->getArena() != vbo->getArena() ||
+               prev->getTexture() != tex)
+            {
+                groupStart = start;
+            }
+        }
+        const GeometryRange &range = vbo->getRange(lod);
+        DrawElementsCommand cmd;
+        cmd.count = range.indexCount;
+        cmd.instanceCount = (uint32_t)(end - start);
+        cmd.firstIndex = range.indexOffset;
+        cmd.baseVertex = (int32_t) range.vertexOffset;
+        cmd.baseInstance = (uint32_t)(start - groupStart);
+        commands.push_back(cmd);
+        start = end;
+    }
+    if(multiDrawIndirect) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER,
+                     commands.size()*sizeof(DrawElementsCommand),
+                     commands.data(), GL_STREAM_DRAW);
+    }
+    
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LESS);
     glFrontFace(GL_CCW);
     glDisable(GL_CULL_FACE);
     glDisable(GL_BLEND);
-    glUseProgram(id);
-    glUniform3fv(idDLCamera, 1, &dlCam[0]);
-    glUniform4fv(idDLColor, 1, &dlColor[0]);
-    glUniform1i(idShadow, TEXTURE_SHADOW);
+    if(shadow != 0) {
+        glActiveTexture(_GL_TEXTURE_SHADOW);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, shadow);
+    }
+    uint32_t baseFeatures = (shadow != 0) ? GENERAL_SHADOW : 0;
     
-    for(auto it=list.begin(); it!=list.end(); it++) {
-        uint32_t flags = 0;
-        Object3D *obj = (Object3D*) &(*it);
-        if(obj->isHidden() || obj->getVBO() == nullptr)
-            continue;
-        Mat4 MV = V * obj->getModelMatrix();
-        Mat4 MVP = P * MV;
-        glUniformMatrix4fv(idMVP, 1, GL_TRUE, &MVP[0][0]);
-        glUniformMatrix4fv(idMV, 1, GL_TRUE, &MV[0][0]);
-        glUniform3fv(idScale, 1, &obj->getScale()[0]);
-        
-        if(shadow != 0) {
-            flags |= (1 << 0);
-            Mat4 shadowMVP = S * obj->getModelMatrix();
-            glUniformMatrix4fv(idShadowMVP, 1, GL_TRUE, &shadowMVP[0][0]);
-            glActiveTexture(_GL_TEXTURE_SHADOW);
-            glBindTexture(GL_TEXTURE_2D, shadow);
+    // The groups come in the order of their programs so the uniforms are
+    // set once for each program
+    int64_t prevKey = -1;
+    const ShaderPermutation *perm = nullptr;
+    size_t start = 0;
+    size_t first = 0;
+    while(first < commands.size()) {
+        GeometryArena *arena = batch[start]->getVBO()->getArena();
+        const Texture *tex = batch[start]->getTexture();
+        size_t last = first + 1;
+        size_t end = start + commands[first].instanceCount;
+        while(last < commands.size() &&
+              batch[end]->getVBO()->getArena() == arena &&
+              batch[end]->getTexture() == tex)
+        {
+            end += commands[last].instanceCount;
+            last++;
         }
         
-        glUniform4fv(idMatColor, 1, &obj->getColor()[0]);
-        glUniform1f(idMatMetal, obj->getMetalness());
-        glUniform1f(idMatRough, obj->getRoughness());
-        glUniform1f(idMatAO, obj->getAmbientOcculation());
-        
-        if(obj->getVBO()->getMode() == VBOMode::Textured &&
-           obj->getTexture() != nullptr)
-        {
-            flags |= (1 << 8);
+        uint32_t key = baseFeatures | getFeatures(batch[start]);
+        if((int64_t) key != prevKey) {
+            perm = &programs.get(key);
+            prevKey = key;
+            if(perm->program != 0) {
+                setUniforms(*perm, V, P, S, cascades, dlCam, dlColor,
+                            shadow);
+            }
+        }
+        if(perm->program == 0) {
+            start = end;
+            first = last;
+            continue;
+        }
+        arena->bindVertexArray();
+        setInstanceAttributes(start * sizeof(GeneralInstance));
+        if(multiDrawIndirect) {
+            glMultiDrawElementsIndirect(
+                GL_TRIANGLES,
+                arena->getIndexType(),
+                (void*)(first * sizeof(DrawElementsCommand)),
+                (GLsizei)(last - first),
+                0
+            );
+            drawCallCount++;
+        }
+        else {
+            for(size_t i=first; i<last; i++) {
+                const DrawElementsCommand &cmd = commands[i];
+                if(cmd.baseInstance > 0) {
+                    size_t offset = start + cmd.baseInstance;
+                    setInstanceAttributes(offset * sizeof(GeneralInstance));
+                }
+                glDrawElementsInstancedBaseVertex(
+                    GL_TRIANGLES,
+                    cmd.count,
+                    arena->getIndexType(),
+                    (void*)(size_t)(cmd.firstIndex * arena->getIndexSize()),
+                    cmd.instanceCount,
+                    cmd.baseVertex
+                );
+                drawCallCount++;
+            }
         }
-        glUniform1i(idFlags, flags);
-        obj->getVBO()->draw();
+        start = end;
+        first = last;
+    }
+    glBindVertexArray(0);
+}
+
+
+void GeneralShader::setUniforms(const ShaderPermutation &perm,
+                                const Mat4 &V, const Mat4 &P, const Mat4 *S,
+                                uint32_t cascades, const Vec3 &dlCam,
+                                const Color &dlColor, uint32_t shadow)
+{
+    const int32_t *id = perm.uniforms.data();
+    glUseProgram(perm.program);
+    glUniformMatrix4fv(id[UNIFORM_V], 1, GL_TRUE, &V[0][0]);
+    glUniformMatrix4fv(id[UNIFORM_P], 1, GL_TRUE, &P[0][0]);
+    glUniform3fv(id[UNIFORM_DL_CAMERA], 1, &dlCam[0]);
+    glUniform4fv(id[UNIFORM_DL_COLOR], 1, &dlColor[0]);
+    if(shadow != 0) {
+        glUniform1i(id[UNIFORM_SHADOW], TEXTURE_SHADOW);
+        glUniformMatrix4fv(id[UNIFORM_SHADOW_VP], cascades, GL_TRUE,
+                           &S[0][0][0]);
+        glUniform1i(id[UNIFORM_CASCADE_COUNT], cascades);
+    }
+}
+
+
+void GeneralShader::selectLevels(const Mat4 &V, const Mat4 &P,
+                                 float lodError)
+{
+    // The clip space w grows with the depth in the perspective projection
+    // and is 1 in the orthographic projection
+    Mat4 PV = P * V;
+    for(auto it=batch.begin(); it!=batch.end(); it++) {
+        Object3D *obj = *it;
+        if(obj->getVBO()->getLevelCount() <= 1)
+            continue;
+        const Mat4 &M = obj->getModelMatrix();
+        const BoundingBox &box = obj->getVBO()->getBoundingBox();
+        float scale = 0;
+        for(int c=0; c<3; c++) {
+            Vec3 axis = Vec3(M[0][c], M[1][c], M[2][c]);
+            scale = std::max(scale, axis.magnitude());
+        }
+        Vec3 center = (box.min + box.max) / 2;
+        float radius = (box.max - box.min).magnitude() / 2 * scale;
+        Vec4 c = PV * (M * Vec4(center.x, center.y, center.z, 1));
+        
+        // Measured at the nearest point of the bounding sphere
+        float w = c.w - fabs(P[3][2]) * radius;
+        float maxError = 0;
+        if(w > 0 && scale > 0)
+            maxError = lodError * w / (P[1][1] * scale);
+        obj->selectLOD(maxError);
+    }
+}
+
+
+void GeneralShader::setInstanceAttributes(size_t offset) {
+    const GLsizei stride = sizeof(GeneralInstance);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    // Model matrix takes up 4 attribute locations, one for each column
+    for(int i=0; i<4; i++) {
+        glEnableVertexAttribArray(3 + i);
+        glVertexAttribPointer(
+            3 + i,
+            4,
+            GL_FLOAT,
+            GL_FALSE,
+            stride,
+            (void*)(offset + offsetof(GeneralInstance, model) +
+                    i*4*sizeof(float))
+        );
+        glVertexAttribDivisor(3 + i, 1);
     }
+    glEnableVertexAttribArray(7);
+    glVertexAttribPointer(7, 3, GL_FLOAT, GL_FALSE, stride,
+                          (void*)(offset + offsetof(GeneralInstance, scale)));
+    glVertexAttribDivisor(7, 1);
+    glEnableVertexAttribArray(8);
+    glVertexAttribPointer(8, 4, GL_FLOAT, GL_FALSE, stride,
+                          (void*)(offset + offsetof(GeneralInstance, color)));
+    glVertexAttribDivisor(8, 1);
+    glEnableVertexAttribArray(9);
+    glVertexAttribPointer(9, 3, GL_FLOAT, GL_FALSE, stride,
+                          (void*)(offset + offsetof(GeneralInstance, mrao)));
+    glVertexAttribDivisor(9, 1);
+    glEnableVertexAttribArray(10);
+    glVertexAttribPointer(10, 3, GL_FLOAT, GL_FALSE, stride,
+                          (void*)(offset + offsetof(GeneralInstance,
+                                                    posOffset)));
+    glVertexAttribDivisor(10, 1);
+    glEnableVertexAttribArray(11);
+    glVertexAttribPointer(11, 3, GL_FLOAT, GL_FALSE, stride,
+                          (void*)(offset + offsetof(GeneralInstance,
+                                                    posScale)));
+    glVertexAttribDivisor(11, 1);
 }
 
 }}
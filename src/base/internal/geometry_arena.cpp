@@ -0,0 +1,572 @@
+/**
+ * @file geometry_arena.cpp
+ * @brief Suballocates the vertex and index arrays of many meshes from shared
+ *        GPU buffers
+ * 
+ * Meshes of the same vertex format share a set of large buffers behind a
+ * single vertex array. Switching between them needs no rebinding and a
+ * group of them is drawn by a single multi-draw call.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#define RMG_EXPORT
+
+
+#include "../rmg/internal/geometry_arena.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include "../rmg/internal/glcontext.hpp"
+
+
+namespace rmg {
+namespace internal {
+
+// Class: FreeList
+
+/**
+ * @brief Default constructor
+ */
+FreeList::FreeList() {
+    capacity = 0;
+    freeCount = 0;
+}
+
+/**
+ * @brief Empties the list with a new capacity
+ * 
+ * @param cap Number of elements the buffer holds
+ */
+void FreeList::reset(uint32_t cap) {
+    blocks.clear();
+    if(cap > 0)
+        blocks[0] = cap;
+    capacity = cap;
+    freeCount = cap;
+}
+
+/**
+ * @brief Extends the capacity keeping the current allocations
+ * 
+ * @param cap New number of elements the buffer holds
+ */
+void FreeList::grow(uint32_t cap) {
+    if(cap <= capacity)
+        return;
+    uint32_t old = capacity;
+    capacity = cap;
+    release(old, cap - old);
+}
+
+/**
+ * @brief Allocates a range
+ * 
+ * @param count Number of elements
+ * @param offset Returns the first element of the range
+ * 
+ * @return True if a free range is large enough
+ */
+bool FreeList::allocate(uint32_t count, uint32_t *offset) {
+    for(auto it=blocks.begin(); it!=blocks.end(); it++) {
+        if(it->second < count)
+            continue;
+        *offset = it->first;
+        uint32_t rest = it->second - count;
+        blocks.erase(it);
+        if(rest > 0)
+            blocks[*offset + count] = rest;
+        freeCount -= count;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Returns a range to the free list
+ * 
+ * @param offset First element of the range
+ * @param count Number of elements
+ */
+void FreeList::release(uint32_t offset, uint32_t count) {
+    if(count == 0)
+        return;
+    freeCount += count;
+    auto next = blocks.lower_bound(offset);
+    // Merges with the range before
+    if(next != blocks.begin()) {
+        auto prev = std::prev(next);
+        if(prev->first + prev->second == offset) {
+            offset = prev->first;
+            count += prev->second;
+            blocks.erase(prev);
+        }
+    }
+    // Merges with the range after
+    if(next != blocks.end() && offset + count == next->first) {
+        count += next->second;
+        blocks.erase(next);
+    }
+    blocks[offset] = count;
+}
+
+/**
+ * @brief Gets the number of elements the buffer holds
+ * 
+ * @return Capacity
+ */
+uint32_t FreeList::getCapacity() const { return capacity; }
+
+/**
+ * @brief Gets the number of elements not allocated
+ * 
+ * @return Free elements
+ */
+uint32_t FreeList::getFreeCount() const { return freeCount; }
+
+/**
+ * @brief Gets the size of the largest free range
+ * 
+ * @return Number of elements in the largest free range
+ */
+uint32_t FreeList::getLargestBlock() const {
+    uint32_t largest = 0;
+    for(auto it=blocks.begin(); it!=blocks.end(); it++)
+        largest = std::max(largest, it->second);
+    return largest;
+}
+
+
+
+
+// Class: GeometryArena
+
+/**
+ * @brief Constructor
+ * 
+ * The GPU buffers are created by the first allocation.
+ * 
+ * @param format Vertex format flags (RMG_VERTEX_*)
+ */
+GeometryArena::GeometryArena(uint32_t format) {
+    this->format = format;
+}
+
+/**
+ * @brief Destructor
+ */
+GeometryArena::~GeometryArena() {
+    if(vertexArrayID != 0) {
+        glDeleteBuffers(1, &vertexbuffer);
+        glDeleteBuffers(1, &attributebuffer);
+        glDeleteBuffers(1, &elementbuffer);
+        glDeleteVertexArrays(1, &vertexArrayID);
+        glDeleteVertexArrays(1, &positionArrayID);
+    }
+}
+
+/**
+ * @brief Gets the vertex format
+ * 
+ * @return Vertex format flags (RMG_VERTEX_*)
+ */
+uint32_t GeometryArena::getFormat() const { return format; }
+
+/**
+ * @brief Gets the size of a position in the position buffer
+ * 
+ * @return Size in bytes
+ */
+uint32_t GeometryArena::getPositionSize() const {
+    // The 4th component keeps the compressed positions 8-byte aligned
+    if(format & RMG_VERTEX_COMPRESSED)
+        return 4 * sizeof(uint16_t);
+    return 3 * sizeof(float);
+}
+
+/**
+ * @brief Gets the size of a vertex in the attribute buffer
+ * 
+ * @return Size in bytes
+ */
+uint32_t GeometryArena::getAttributeSize() const {
+    bool compressed = format & RMG_VERTEX_COMPRESSED;
+    uint32_t size = compressed ? 2*sizeof(int16_t) : 3*sizeof(float);
+    if(format & RMG_VERTEX_TEXTURED)
+        size += compressed ? 2*sizeof(uint16_t) : 2*sizeof(float);
+    return size;
+}
+
+/**
+ * @brief Gets the size of an index
+ * 
+ * @return Size in bytes
+ */
+uint32_t GeometryArena::getIndexSize() const {
+    if(format & RMG_VERTEX_SHORT_INDICES)
+        return sizeof(uint16_t);
+    return sizeof(uint32_t);
+}
+
+/**
+ * @brief Gets the GL type of the indices
+ * 
+ * @return GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+ */
+uint32_t GeometryArena::getIndexType() const {
+    if(format & RMG_VERTEX_SHORT_INDICES)
+        return GL_UNSIGNED_SHORT;
+    return GL_UNSIGNED_INT;
+}
+
+/**
+ * @brief Allocates the ranges of a mesh and uploads its arrays
+ * 
+ * @param positions Position stream
+ * @param attributes Attribute stream of normals and texture
+ *                   coordinates
+ * @param indices Indices relative to the first vertex of the mesh
+ * @param vertexCount Number of vertices
+ * @param indexCount Number of indices
+ * 
+ * @return Slot of the mesh
+ */
+uint32_t GeometryArena::allocate(const void* positions,
+                                 const void* attributes,
+                                 const void* indices, uint32_t vertexCount,
+                                 uint32_t indexCount)
+{
+    GeometryRange range;
+    if(!reserve(vertexCount, indexCount, &range)) {
+        // Grows the buffers if packing the meshes does not make the space
+        uint32_t vertexCap = std::max(vertexSpace.getCapacity(),
+                                      (uint32_t) RMG_GEOMETRY_MIN_VERTICES);
+        uint32_t indexCap = std::max(indexSpace.getCapacity(),
+                                     (uint32_t) RMG_GEOMETRY_MIN_INDICES);
+        uint64_t vertexUsed = vertexSpace.getCapacity() -
+                              vertexSpace.getFreeCount() + vertexCount;
+        uint64_t indexUsed = indexSpace.getCapacity() -
+                             indexSpace.getFreeCount() + indexCount;
+        while(vertexCap < vertexUsed)
+            vertexCap *= 2;
+        while(indexCap < indexUsed)
+            indexCap *= 2;
+        rebuild(vertexCap, indexCap);
+        reserve(vertexCount, indexCount, &range);
+    }
+    
+    uint32_t posSize = getPositionSize();
+    uint32_t attrSize = getAttributeSize();
+    uint32_t indexSize = getIndexSize();
+    // The copy target leaves the element buffer of the bound vertex array
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vertexbuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER,
+                    (GLintptr) range.vertexOffset * posSize,
+                    (GLsizeiptr) vertexCount * posSize, positions);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, attributebuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER,
+                    (GLintptr) range.vertexOffset * attrSize,
+                    (GLsizeiptr) vertexCount * attrSize, attributes);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, elementbuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER,
+                    (GLintptr) range.indexOffset * indexSize,
+                    (GLsizeiptr) indexCount * indexSize, indices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    
+    uint32_t slot;
+    if(freeSlots.size() > 0) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+        ranges[slot] = range;
+    }
+    else {
+        slot = ranges.size();
+        ranges.push_back(range);
+    }
+    return slot;
+}
+
+/**
+ * @brief Frees the ranges of a mesh
+ * 
+ * @param slot Slot of the mesh
+ */
+void GeometryArena::release(uint32_t slot) {
+    GeometryRange &range = ranges[slot];
+    vertexSpace.release(range.vertexOffset, range.vertexCount);
+    indexSpace.release(range.indexOffset, range.indexCount);
+    range.vertexCount = 0;
+    range.indexCount = 0;
+    freeSlots.push_back(slot);
+}
+
+/**
+ * @brief Gets the location of a mesh in the buffers
+ * 
+ * @param slot Slot of the mesh
+ * 
+ * @return Vertex and index ranges
+ */
+const GeometryRange &GeometryArena::getRange(uint32_t slot) const {
+    return ranges[slot];
+}
+
+/**
+ * @brief Binds the vertex array of all the attributes
+ */
+void GeometryArena::bindVertexArray() const {
+    glBindVertexArray(vertexArrayID);
+}
+
+/**
+ * @brief Binds the vertex array of the positions only
+ */
+void GeometryArena::bindPositionArray() const {
+    glBindVertexArray(positionArrayID);
+}
+
+/**
+ * @brief Gets the ratio of the free space unusable by a large
+ *        allocation
+ * 
+ * The free space outside the largest free range of the vertex or index
+ * buffer, whichever is higher, relative to the capacity.
+ * 
+ * @return Ratio from 0 to 1
+ */
+float GeometryArena::getFragmentation() const {
+    float ratio = 0;
+    const FreeList* lists[2] = { &vertexSpace, &indexSpace };
+    for(int i=0; i<2; i++) {
+        const FreeList* list = lists[i];
+        if(list->getCapacity() == 0)
+            continue;
+        uint32_t wasted = list->getFreeCount() - list->getLargestBlock();
+        ratio = std::max(ratio, (float) wasted / list->getCapacity());
+    }
+    return ratio;
+}
+
+/**
+ * @brief Packs the meshes to the front of the buffers
+ */
+void GeometryArena::defragment() {
+    if(vertexArrayID == 0)
+        return;
+    rebuild(vertexSpace.getCapacity(), indexSpace.getCapacity());
+}
+
+
+bool GeometryArena::reserve(uint32_t vertexCount, uint32_t indexCount,
+                            GeometryRange *range)
+{
+    if(!vertexSpace.allocate(vertexCount, &range->vertexOffset))
+        return false;
+    if(!indexSpace.allocate(indexCount, &range->indexOffset)) {
+        vertexSpace.release(range->vertexOffset, vertexCount);
+        return false;
+    }
+    range->vertexCount = vertexCount;
+    range->indexCount = indexCount;
+    return true;
+}
+
+
+void GeometryArena::rebuild(uint32_t vertexCapacity, uint32_t indexCapacity) {
+    uint32_t posSize = getPositionSize();
+    uint32_t attrSize = getAttributeSize();
+    uint32_t indexSize = getIndexSize();
+    uint32_t buffers[3];
+    glGenBuffers(3, buffers);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[0]);
+    glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr) vertexCapacity * posSize,
+                 NULL, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[1]);
+    glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr) vertexCapacity * attrSize,
+                 NULL, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[2]);
+    glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr) indexCapacity * indexSize,
+                 NULL, GL_STATIC_DRAW);
+    
+    // Packs the live ranges in the order they lie in the old buffers
+    std::vector<uint32_t> live;
+    for(uint32_t i=0; i<ranges.size(); i++) {
+        if(ranges[i].vertexCount > 0)
+            live.push_back(i);
+    }
+    std::sort(live.begin(), live.end(), [this](uint32_t a, uint32_t b) {
+        return ranges[a].vertexOffset < ranges[b].vertexOffset;
+    });
+    std::vector<GeometryRange> moved = ranges;
+    vertexSpace.reset(vertexCapacity);
+    indexSpace.reset(indexCapacity);
+    for(auto it=live.begin(); it!=live.end(); it++) {
+        GeometryRange &r = moved[*it];
+        vertexSpace.allocate(r.vertexCount, &r.vertexOffset);
+        indexSpace.allocate(r.indexCount, &r.indexOffset);
+    }
+    
+    if(vertexArrayID != 0) {
+        const uint32_t old[3] = {
+            vertexbuffer, attributebuffer, elementbuffer
+        };
+        for(int b=0; b<3; b++) {
+            glBindBuffer(GL_COPY_READ_BUFFER, old[b]);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[b]);
+            for(auto it=live.begin(); it!=live.end(); it++) {
+                const GeometryRange &src = ranges[*it];
+                const GeometryRange &dst = moved[*it];
+                GLintptr readOffset, writeOffset;
+                GLsizeiptr size;
+                if(b < 2) {
+                    uint32_t stride = (b == 0) ? posSize : attrSize;
+                    readOffset = (GLintptr) src.vertexOffset * stride;
+                    writeOffset = (GLintptr) dst.vertexOffset * stride;
+                    size = (GLsizeiptr) src.vertexCount * stride;
+                }
+                else {
+                    readOffset = (GLintptr) src.indexOffset * indexSize;
+                    writeOffset = (GLintptr) dst.indexOffset * indexSize;
+                    size = (GLsizeiptr) src.indexCount * indexSize;
+                }
+                glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                                    readOffset, writeOffset, size);
+            }
+        }
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glDeleteBuffers(3, old);
+    }
+    else {
+        glGenVertexArrays(1, &vertexArrayID);
+        glGenVertexArrays(1, &positionArrayID);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    ranges = moved;
+    vertexbuffer = buffers[0];
+    attributebuffer = buffers[1];
+    elementbuffer = buffers[2];
+    setAttributePointers();
+}
+
+
+void GeometryArena::setAttributePointers() {
+    bool compressed = format & RMG_VERTEX_COMPRESSED;
+    GLsizei posSize = getPositionSize();
+    GLsizei attrSize = getAttributeSize();
+    GLsizei normalSize = compressed ? 2*sizeof(int16_t) : 3*sizeof(float);
+    
+    for(int i=0; i<2; i++) {
+        glBindVertexArray(i == 0 ? positionArrayID : vertexArrayID);
+        // 1st attribute buffer : vertices
+        glEnableVertexAttribArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
+        glVertexAttribPointer(
+            0,                                          // attribute
+            3,                                          // size
+            compressed ? GL_UNSIGNED_SHORT : GL_FLOAT,  // type
+            compressed ? GL_TRUE : GL_FALSE,            // normalized?
+            posSize,                                    // stride
+            (void*)0                                    // array buffer offset
+        );
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementbuffer);
+    }
+    // 2nd attribute buffer : normals
+    glEnableVertexAttribArray(1);
+    glBindBuffer(GL_ARRAY_BUFFER, attributebuffer);
+    glVertexAttribPointer(
+        1,
+        compressed ? 2 : 3,
+        compressed ? GL_SHORT : GL_FLOAT,
+        compressed ? GL_TRUE : GL_FALSE,
+        attrSize,
+        (void*)0
+    );
+    // 3nd attribute buffer : textures
+    if(format & RMG_VERTEX_TEXTURED) {
+        GLenum type = GL_FLOAT;
+        if(format & RMG_VERTEX_HALF_TEXCOORDS)
+            type = GL_HALF_FLOAT;
+        else if(compressed)
+            type = GL_UNSIGNED_SHORT;
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(
+            2,
+            2,
+            type,
+            type == GL_UNSIGNED_SHORT ? GL_TRUE : GL_FALSE,
+            attrSize,
+            (void*)(size_t) normalSize
+        );
+    }
+    glBindVertexArray(0);
+}
+
+
+
+
+// Class: GeometryPool
+
+/**
+ * @brief Default constructor
+ */
+GeometryPool::GeometryPool() {
+    for(int i=0; i<RMG_VERTEX_FORMAT_COUNT; i++)
+        arenas[i] = nullptr;
+}
+
+/**
+ * @brief Destructor
+ */
+GeometryPool::~GeometryPool() { clear(); }
+
+/**
+ * @brief Move constructor
+ * 
+ * @param pool Source
+ */
+GeometryPool::GeometryPool(GeometryPool&& pool) noexcept {
+    for(int i=0; i<RMG_VERTEX_FORMAT_COUNT; i++)
+        arenas[i] = std::exchange(pool.arenas[i], nullptr);
+}
+
+/**
+ * @brief Gets the arena of a vertex format
+ * 
+ * @param format Vertex format flags (RMG_VERTEX_*)
+ * 
+ * @return Geometry arena created on the first use
+ */
+GeometryArena *GeometryPool::getArena(uint32_t format) {
+    if(arenas[format] == nullptr)
+        arenas[format] = new GeometryArena(format);
+    return arenas[format];
+}
+
+/**
+ * @brief Defragments the arenas wasting too much space
+ * 
+ * @param threshold Fragmentation above which an arena is packed
+ */
+void GeometryPool::defragment(float threshold) {
+    for(int i=0; i<RMG_VERTEX_FORMAT_COUNT; i++) {
+        if(arenas[i] != nullptr && arenas[i]->getFragmentation() > threshold)
+            arenas[i]->defragment();
+    }
+}
+
+/**
+ * @brief Deletes the arenas and their GPU buffers
+ */
+void GeometryPool::clear() {
+    for(int i=0; i<RMG_VERTEX_FORMAT_COUNT; i++) {
+        delete arenas[i];
+        arenas[i] = nullptr;
+    }
+}
+
+}}
@@ -42,49 +42,111 @@ namespace internal {
 
 RMG_API PFNGLACTIVETEXTUREPROC glActiveTexture = NULL;
 RMG_API PFNGLATTACHSHADERPROC glAttachShader = NULL;
+RMG_API PFNGLBEGINQUERYPROC glBeginQuery = NULL;
 RMG_API PFNGLBINDBUFFERPROC glBindBuffer = NULL;
 RMG_API PFNGLBINDFRAMEBUFFERPROC glBindFramebuffer = NULL;
+RMG_API PFNGLBINDRENDERBUFFERPROC glBindRenderbuffer = NULL;
 RMG_API PFNGLBINDVERTEXARRAYPROC glBindVertexArray = NULL;
 RMG_API PFNGLBUFFERDATAPROC glBufferData = NULL;
+RMG_API PFNGLBUFFERSUBDATAPROC glBufferSubData = NULL;
+RMG_API PFNGLCHECKFRAMEBUFFERSTATUSPROC glCheckFramebufferStatus = NULL;
+RMG_API PFNGLCLEARBUFFERUIVPROC glClearBufferuiv = NULL;
+RMG_API PFNGLCLIENTWAITSYNCPROC glClientWaitSync = NULL;
 RMG_API PFNGLCOMPILESHADERPROC glCompileShader = NULL;
+RMG_API PFNGLCOPYBUFFERSUBDATAPROC glCopyBufferSubData = NULL;
 RMG_API PFNGLCREATEPROGRAMPROC glCreateProgram = NULL;
 RMG_API PFNGLCREATESHADERPROC glCreateShader = NULL;
 RMG_API PFNGLDELETEBUFFERSPROC glDeleteBuffers = NULL;
 RMG_API PFNGLDELETEFRAMEBUFFERSPROC glDeleteFramebuffers = NULL;
 RMG_API PFNGLDELETEPROGRAMPROC glDeleteProgram = NULL;
+RMG_API PFNGLDELETEQUERIESPROC glDeleteQueries = NULL;
+RMG_API PFNGLDELETERENDERBUFFERSPROC glDeleteRenderbuffers = NULL;
 RMG_API PFNGLDELETESHADERPROC glDeleteShader = NULL;
+RMG_API PFNGLDELETESYNCPROC glDeleteSync = NULL;
 RMG_API PFNGLDELETEVERTEXARRAYSPROC glDeleteVertexArrays = NULL;
 RMG_API PFNGLDETACHSHADERPROC glDetachShader = NULL;
 RMG_API PFNGLDISABLEVERTEXATTRIBARRAYPROC glDisableVertexAttribArray = NULL;
+RMG_API PFNGLDRAWELEMENTSBASEVERTEXPROC glDrawElementsBaseVertex = NULL;
+RMG_API PFNGLDRAWELEMENTSINSTANCEDPROC glDrawElementsInstanced = NULL;
+RMG_API PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXPROC glDrawElementsInstancedBaseVertex = NULL;
 RMG_API PFNGLENABLEVERTEXATTRIBARRAYPROC glEnableVertexAttribArray = NULL;
+RMG_API PFNGLENDQUERYPROC glEndQuery = NULL;
+RMG_API PFNGLFENCESYNCPROC glFenceSync = NULL;
+RMG_API PFNGLFRAMEBUFFERRENDERBUFFERPROC glFramebufferRenderbuffer = NULL;
+RMG_API PFNGLFRAMEBUFFERTEXTURELAYERPROC glFramebufferTextureLayer = NULL;
 RMG_API PFNGLGENERATEMIPMAPEXTPROC glGenerateMipmap = NULL;
 RMG_API PFNGLFRAMEBUFFERTEXTURE2DPROC glFramebufferTexture2D = NULL;
 RMG_API PFNGLGENBUFFERSPROC glGenBuffers = NULL;
 RMG_API PFNGLGENFRAMEBUFFERSPROC glGenFramebuffers = NULL;
+RMG_API PFNGLGENQUERIESPROC glGenQueries = NULL;
+RMG_API PFNGLGENRENDERBUFFERSPROC glGenRenderbuffers = NULL;
 RMG_API PFNGLGENVERTEXARRAYSPROC glGenVertexArrays = NULL;
+RMG_API PFNGLGETPROGRAMBINARYPROC glGetProgramBinary = NULL;
 RMG_API PFNGLGETPROGRAMINFOLOGPROC glGetProgramInfoLog = NULL;
 RMG_API PFNGLGETPROGRAMIVPROC glGetProgramiv = NULL;
+RMG_API PFNGLGETQUERYOBJECTIVPROC glGetQueryObjectiv = NULL;
+RMG_API PFNGLGETQUERYOBJECTUI64VPROC glGetQueryObjectui64v = NULL;
 RMG_API PFNGLGETSHADERINFOLOGPROC glGetShaderInfoLog = NULL;
 RMG_API PFNGLGETSHADERIVPROC glGetShaderiv = NULL;
+RMG_API PFNGLGETSTRINGIPROC glGetStringi = NULL;
 RMG_API PFNGLGETUNIFORMLOCATIONPROC glGetUniformLocation = NULL;
 RMG_API PFNGLLINKPROGRAMPROC glLinkProgram = NULL;
+RMG_API PFNGLMAPBUFFERRANGEPROC glMapBufferRange = NULL;
+RMG_API PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glMaxShaderCompilerThreadsKHR = NULL;
+RMG_API PFNGLMULTIDRAWELEMENTSINDIRECTPROC glMultiDrawElementsIndirect = NULL;
+RMG_API PFNGLPROGRAMBINARYPROC glProgramBinary = NULL;
+RMG_API PFNGLPROGRAMPARAMETERIPROC glProgramParameteri = NULL;
+RMG_API PFNGLRENDERBUFFERSTORAGEPROC glRenderbufferStorage = NULL;
 RMG_API PFNGLSHADERSOURCEPROC glShaderSource = NULL;
+RMG_API PFNGLTEXIMAGE3DPROC glTexImage3D = NULL;
 RMG_API PFNGLUNIFORM1FPROC glUniform1f = NULL;
 RMG_API PFNGLUNIFORM1IPROC glUniform1i = NULL;
 RMG_API PFNGLUNIFORM2FPROC glUniform2f = NULL;
+RMG_API PFNGLUNIFORM2UIPROC glUniform2ui = NULL;
 RMG_API PFNGLUNIFORM3FVPROC glUniform3fv = NULL;
 RMG_API PFNGLUNIFORM4FVPROC glUniform4fv = NULL;
 RMG_API PFNGLUNIFORMMATRIX3FVPROC glUniformMatrix3fv = NULL;
 RMG_API PFNGLUNIFORMMATRIX4FVPROC glUniformMatrix4fv = NULL;
+RMG_API PFNGLUNMAPBUFFERPROC glUnmapBuffer = NULL;
 RMG_API PFNGLUSEPROGRAMPROC glUseProgram = NULL;
+RMG_API PFNGLVERTEXATTRIBDIVISORPROC glVertexAttribDivisor = NULL;
 RMG_API PFNGLVERTEXATTRIBPOINTERPROC glVertexAttribPointer = NULL;
 
+RMG_API uint32_t drawCallCount = 0;
+RMG_API uint32_t uniformUploadCount = 0;
+
 
 #define GETANDTEST(type, name) \
     func_ ## name = (type) getGLFuncAddress(#name); \
     if(func_ ## name == 0) \
         return 1;
 
+// For functions newer than OpenGL 3.2 whose absence only disables a feature
+#define GETOPTIONAL(type, name) \
+    func_ ## name = (type) getGLFuncAddress(#name);
+
+
+// Routes a glUniform* pointer through a wrapper counting the uploads.
+// N only keeps the functions sharing the same signature apart.
+template<int N, typename... Args>
+struct UniformCounter {
+    static void (GLAPIENTRY* func)(Args...);
+    
+    static void GLAPIENTRY call(Args... args) {
+        uniformUploadCount++;
+        func(args...);
+    }
+};
+
+template<int N, typename... Args>
+void (GLAPIENTRY* UniformCounter<N, Args...>::func)(Args...) = NULL;
+
+template<int N, typename... Args>
+static auto countUniform(void (GLAPIENTRY* func)(Args...)) {
+    UniformCounter<N, Args...>::func = func;
+    return &UniformCounter<N, Args...>::call;
+}
+
 
 /**
  * @brief Initialize the GL pointers
@@ -94,41 +156,74 @@ RMG_API PFNGLVERTEXATTRIBPOINTERPROC glVertexAttribPointer = NULL;
 int GLContext::init() {
     GETANDTEST(PFNGLACTIVETEXTUREPROC, glActiveTexture)
     GETANDTEST(PFNGLATTACHSHADERPROC, glAttachShader)
+    GETANDTEST(PFNGLBEGINQUERYPROC, glBeginQuery)
     GETANDTEST(PFNGLBINDBUFFERPROC, glBindBuffer)
     GETANDTEST(PFNGLBINDFRAMEBUFFERPROC, glBindFramebuffer)
+    GETANDTEST(PFNGLBINDRENDERBUFFERPROC, glBindRenderbuffer)
     GETANDTEST(PFNGLBINDVERTEXARRAYPROC, glBindVertexArray)
     GETANDTEST(PFNGLBUFFERDATAPROC, glBufferData)
+    GETANDTEST(PFNGLBUFFERSUBDATAPROC, glBufferSubData)
+    GETANDTEST(PFNGLCHECKFRAMEBUFFERSTATUSPROC, glCheckFramebufferStatus)
+    GETANDTEST(PFNGLCLEARBUFFERUIVPROC, glClearBufferuiv)
+    GETANDTEST(PFNGLCLIENTWAITSYNCPROC, glClientWaitSync)
     GETANDTEST(PFNGLCOMPILESHADERPROC, glCompileShader)
+    GETANDTEST(PFNGLCOPYBUFFERSUBDATAPROC, glCopyBufferSubData)
     GETANDTEST(PFNGLCREATEPROGRAMPROC, glCreateProgram)
     GETANDTEST(PFNGLCREATESHADERPROC, glCreateShader)
     GETANDTEST(PFNGLDELETEBUFFERSPROC, glDeleteBuffers)
     GETANDTEST(PFNGLDELETEFRAMEBUFFERSPROC, glDeleteFramebuffers)
     GETANDTEST(PFNGLDELETEPROGRAMPROC, glDeleteProgram)
+    GETANDTEST(PFNGLDELETEQUERIESPROC, glDeleteQueries)
+    GETANDTEST(PFNGLDELETERENDERBUFFERSPROC, glDeleteRenderbuffers)
     GETANDTEST(PFNGLDELETESHADERPROC, glDeleteShader)
+    GETANDTEST(PFNGLDELETESYNCPROC, glDeleteSync)
     GETANDTEST(PFNGLDELETEVERTEXARRAYSPROC, glDeleteVertexArrays)
     GETANDTEST(PFNGLDETACHSHADERPROC, glDetachShader)
     GETANDTEST(PFNGLDISABLEVERTEXATTRIBARRAYPROC, glDisableVertexAttribArray)
+    GETANDTEST(PFNGLDRAWELEMENTSBASEVERTEXPROC, glDrawElementsBaseVertex)
+    GETANDTEST(PFNGLDRAWELEMENTSINSTANCEDPROC, glDrawElementsInstanced)
+    GETANDTEST(PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXPROC, glDrawElementsInstancedBaseVertex)
     GETANDTEST(PFNGLENABLEVERTEXATTRIBARRAYPROC, glEnableVertexAttribArray)
+    GETANDTEST(PFNGLENDQUERYPROC, glEndQuery)
+    GETANDTEST(PFNGLFENCESYNCPROC, glFenceSync)
+    GETANDTEST(PFNGLFRAMEBUFFERRENDERBUFFERPROC, glFramebufferRenderbuffer)
     GETANDTEST(PFNGLFRAMEBUFFERTEXTURE2DPROC, glFramebufferTexture2D)
+    GETANDTEST(PFNGLFRAMEBUFFERTEXTURELAYERPROC, glFramebufferTextureLayer)
     GETANDTEST(PFNGLGENBUFFERSPROC, glGenBuffers)
     GETANDTEST(PFNGLGENERATEMIPMAPEXTPROC, glGenerateMipmap)
     GETANDTEST(PFNGLGENFRAMEBUFFERSPROC, glGenFramebuffers)
+    GETANDTEST(PFNGLGENQUERIESPROC, glGenQueries)
+    GETANDTEST(PFNGLGENRENDERBUFFERSPROC, glGenRenderbuffers)
     GETANDTEST(PFNGLGENVERTEXARRAYSPROC, glGenVertexArrays)
+    GETOPTIONAL(PFNGLGETPROGRAMBINARYPROC, glGetProgramBinary)
     GETANDTEST(PFNGLGETPROGRAMINFOLOGPROC, glGetProgramInfoLog)
     GETANDTEST(PFNGLGETPROGRAMIVPROC, glGetProgramiv)
+    GETANDTEST(PFNGLGETQUERYOBJECTIVPROC, glGetQueryObjectiv)
+    GETOPTIONAL(PFNGLGETQUERYOBJECTUI64VPROC, glGetQueryObjectui64v)
     GETANDTEST(PFNGLGETSHADERINFOLOGPROC, glGetShaderInfoLog)
     GETANDTEST(PFNGLGETSHADERIVPROC, glGetShaderiv)
+    GETANDTEST(PFNGLGETSTRINGIPROC, glGetStringi)
     GETANDTEST(PFNGLGETUNIFORMLOCATIONPROC, glGetUniformLocation)
     GETANDTEST(PFNGLLINKPROGRAMPROC, glLinkProgram)
+    GETANDTEST(PFNGLMAPBUFFERRANGEPROC, glMapBufferRange)
+    GETOPTIONAL(PFNGLMAXSHADERCOMPILERTHREADSKHRPROC, glMaxShaderCompilerThreadsKHR)
+    GETOPTIONAL(PFNGLMULTIDRAWELEMENTSINDIRECTPROC, glMultiDrawElementsIndirect)
+    GETOPTIONAL(PFNGLPROGRAMBINARYPROC, glProgramBinary)
+    GETOPTIONAL(PFNGLPROGRAMPARAMETERIPROC, glProgramParameteri)
+    GETANDTEST(PFNGLRENDERBUFFERSTORAGEPROC, glRenderbufferStorage)
     GETANDTEST(PFNGLSHADERSOURCEPROC, glShaderSource)
+    GETANDTEST(PFNGLTEXIMAGE3DPROC, glTexImage3D)
     GETANDTEST(PFNGLUNIFORM1FPROC, glUniform1f)
     GETANDTEST(PFNGLUNIFORM1IPROC, glUniform1i)
     GETANDTEST(PFNGLUNIFORM2FPROC, glUniform2f)
+    GETANDTEST(PFNGLUNIFORM2UIPROC, glUniform2ui)
     GETANDTEST(PFNGLUNIFORM3FVPROC, glUniform3fv)
     GETANDTEST(PFNGLUNIFORM4FVPROC, glUniform4fv)
     GETANDTEST(PFNGLUNIFORMMATRIX4FVPROC, glUniformMatrix3fv)
     GETANDTEST(PFNGLUNIFORMMATRIX4FVPROC, glUniformMatrix4fv)
+    GETANDTEST(PFNGLUNMAPBUFFERPROC, glUnmapBuffer)
     GETANDTEST(PFNGLUSEPROGRAMPROC, glUseProgram)
+    GETANDTEST(PFNGLVERTEXATTRIBDIVISORPROC, glVertexAttribDivisor)
     GETANDTEST(PFNGLVERTEXATTRIBPOINTERPROC, glVertexAttribPointer)
     setCurrent();
     return 0;
@@ -143,41 +238,74 @@ int GLContext::init() {
 void GLContext::setCurrent() {
     glActiveTexture = func_glActiveTexture;
     glAttachShader = func_glAttachShader;
+    glBeginQuery = func_glBeginQuery;
     glBindBuffer = func_glBindBuffer;
     glBindFramebuffer = func_glBindFramebuffer;
+    glBindRenderbuffer = func_glBindRenderbuffer;
     glBindVertexArray = func_glBindVertexArray;
     glBufferData = func_glBufferData;
+    glBufferSubData = func_glBufferSubData;
+    glCheckFramebufferStatus = func_glCheckFramebufferStatus;
+    glClearBufferuiv = func_glClearBufferuiv;
+    glClientWaitSync = func_glClientWaitSync;
     glCompileShader = func_glCompileShader;
+    glCopyBufferSubData = func_glCopyBufferSubData;
     glCreateProgram = func_glCreateProgram;
     glCreateShader = func_glCreateShader;
     glDeleteBuffers = func_glDeleteBuffers;
     glDeleteFramebuffers = func_glDeleteFramebuffers;
     glDeleteProgram = func_glDeleteProgram;
+    glDeleteQueries = func_glDeleteQueries;
+    glDeleteRenderbuffers = func_glDeleteRenderbuffers;
     glDeleteShader = func_glDeleteShader;
+    glDeleteSync = func_glDeleteSync;
     glDeleteVertexArrays = func_glDeleteVertexArrays;
     glDetachShader = func_glDetachShader;
     glDisableVertexAttribArray = func_glDisableVertexAttribArray;
+    glDrawElementsBaseVertex = func_glDrawElementsBaseVertex;
+    glDrawElementsInstanced = func_glDrawElementsInstanced;
+    glDrawElementsInstancedBaseVertex = func_glDrawElementsInstancedBaseVertex;
     glEnableVertexAttribArray = func_glEnableVertexAttribArray;
+    glEndQuery = func_glEndQuery;
+    glFenceSync = func_glFenceSync;
+    glFramebufferRenderbuffer = func_glFramebufferRenderbuffer;
     glFramebufferTexture2D = func_glFramebufferTexture2D;
+    glFramebufferTextureLayer = func_glFramebufferTextureLayer;
     glGenBuffers = func_glGenBuffers;
     glGenerateMipmap = func_glGenerateMipmap;
     glGenFramebuffers = func_glGenFramebuffers;
+    glGenQueries = func_glGenQueries;
+    glGenRenderbuffers = func_glGenRenderbuffers;
     glGenVertexArrays = func_glGenVertexArrays;
+    glGetProgramBinary = func_glGetProgramBinary;
     glGetProgramInfoLog = func_glGetProgramInfoLog;
     glGetProgramiv = func_glGetProgramiv;
+    glGetQueryObjectiv = func_glGetQueryObjectiv;
+    glGetQueryObjectui64v = func_glGetQueryObjectui64v;
     glGetShaderInfoLog = func_glGetShaderInfoLog;
     glGetShaderiv = func_glGetShaderiv;
+    glGetStringi = func_glGetStringi;
     glGetUniformLocation = func_glGetUniformLocation;
     glLinkProgram = func_glLinkProgram;
+    glMapBufferRange = func_glMapBufferRange;
+    glMaxShaderCompilerThreadsKHR = func_glMaxShaderCompilerThreadsKHR;
+    glMultiDrawElementsIndirect = func_glMultiDrawElementsIndirect;
+    glProgramBinary = func_glProgramBinary;
+    glProgramParameteri = func_glProgramParameteri;
+    glRenderbufferStorage = func_glRenderbufferStorage;
     glShaderSource = func_glShaderSource;
-    glUniform1f = func_glUniform1f;
-    glUniform1i = func_glUniform1i;
-    glUniform2f = func_glUniform2f;
-    glUniform3fv = func_glUniform3fv;
-    glUniform4fv = func_glUniform4fv;
-    glUniformMatrix3fv = func_glUniformMatrix3fv;
-    glUniformMatrix4fv = func_glUniformMatrix4fv;
+    glTexImage3D = func_glTexImage3D;
+    glUniform1f = countUniform<0>(func_glUniform1f);
+    glUniform1i = countUniform<1>(func_glUniform1i);
+    glUniform2f = countUniform<2>(func_glUniform2f);
+    glUniform2ui = countUniform<7>(func_glUniform2ui);
+    glUniform3fv = countUniform<3>(func_glUniform3fv);
+    glUniform4fv = countUniform<4>(func_glUniform4fv);
+    glUniformMatrix3fv = countUniform<5>(func_glUniformMatrix3fv);
+    glUniformMatrix4fv = countUniform<6>(func_glUniformMatrix4fv);
+    glUnmapBuffer = func_glUnmapBuffer;
     glUseProgram = func_glUseProgram;
+    glVertexAttribDivisor = func_glVertexAttribDivisor;
     glVertexAttribPointer = func_glVertexAttribPointer;
 }
 
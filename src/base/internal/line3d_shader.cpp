@@ -115,6 +115,27 @@ void Line3DShader::load() {
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3*sizeof(float), (void*)0);
 }
 
+/**
+ * @brief Binds the cylinder mesh the lines are drawn with
+ */
+void Line3DShader::bindMesh() const {
+    glBindVertexArray(vertexArrayID);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementbuffer);
+}
+
+/**
+ * @brief Draws the bound cylinder mesh with the program in use
+ */
+void Line3DShader::drawMesh() const {
+    glDrawElements(
+        GL_TRIANGLES,    // mode
+        INDEX_COUNT,     // count
+        GL_UNSIGNED_INT, // type
+        (void*)0         // element array buffer offset
+    );
+    drawCallCount++;
+}
+
 /**
  * @brief Renders the given list of lines in 3D space
  * 
@@ -130,8 +151,7 @@ void Line3DShader::render(const Mat4 &VP, const ObjectList &list) {
     glDisable(GL_CULL_FACE);
     glDisable(GL_BLEND);
     glUseProgram(id);
-    glBindVertexArray(vertexArrayID);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementbuffer);
+    bindMesh();
     
     for(auto it=list.begin(); it!=list.end(); it++) {
         Line3D* line = (Line3D*) &(*it);
@@ -140,13 +160,7 @@ void Line3DShader::render(const Mat4 &VP, const ObjectList &list) {
         Mat4 MVP = VP * line->getModelMatrix();
         glUniformMatrix4fv(idMVP, 1, GL_TRUE, &MVP[0][0]);
         glUniform3fv(idColor, 1, &line->getColor()[0]);
-        
-        glDrawElements(
-            GL_TRIANGLES,    // mode
-            INDEX_COUNT,     // count
-            GL_UNSIGNED_INT, // type
-            (void*)0         // element array buffer offset
-        );
+        drawMesh();
     }
 }
 
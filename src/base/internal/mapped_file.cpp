@@ -0,0 +1,153 @@
+/**
+ * @file mapped_file.cpp
+ * @brief Read-only view of a file mapped into the memory
+ * 
+ * Lets the parsers read large files without copying them through stdio
+ * buffers.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#define RMG_EXPORT
+
+
+#include "../rmg/internal/mapped_file.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace rmg {
+namespace internal {
+
+/**
+ * @brief Default constructor
+ */
+MappedFile::MappedFile() {
+    data = nullptr;
+    size = 0;
+    #ifdef _WIN32
+    fileHandle = INVALID_HANDLE_VALUE;
+    mapHandle = NULL;
+    #endif
+}
+
+/**
+ * @brief Constructor maps a file
+ * 
+ * @param file Path to the file
+ */
+MappedFile::MappedFile(const char* file): MappedFile() {
+    open(file);
+}
+
+/**
+ * @brief Destructor unmaps the file
+ */
+MappedFile::~MappedFile() { close(); }
+
+/**
+ * @brief Maps a file replacing the current one
+ * 
+ * @param file Path to the file
+ * 
+ * @return True if the file is mapped successfully
+ */
+bool MappedFile::open(const char* file) {
+    close();
+    #ifdef _WIN32
+    HANDLE fh = CreateFileA(file, GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(fh == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER len;
+    if(!GetFileSizeEx(fh, &len) || len.QuadPart == 0) {
+        CloseHandle(fh);
+        return false;
+    }
+    HANDLE mh = CreateFileMappingA(fh, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(mh == NULL) {
+        CloseHandle(fh);
+        return false;
+    }
+    void* ptr = MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0);
+    if(ptr == NULL) {
+        CloseHandle(mh);
+        CloseHandle(fh);
+        return false;
+    }
+    fileHandle = fh;
+    mapHandle = mh;
+    data = (const char*) ptr;
+    size = (size_t) len.QuadPart;
+    #else
+    int fd = ::open(file, O_RDONLY);
+    if(fd < 0)
+        return false;
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* ptr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(ptr == MAP_FAILED)
+        return false;
+    // The file is read from the start to the end once
+    madvise(ptr, st.st_size, MADV_SEQUENTIAL);
+    data = (const char*) ptr;
+    size = (size_t) st.st_size;
+    #endif
+    return true;
+}
+
+/**
+ * @brief Unmaps the file
+ */
+void MappedFile::close() {
+    if(data == nullptr)
+        return;
+    #ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle(mapHandle);
+    CloseHandle(fileHandle);
+    fileHandle = INVALID_HANDLE_VALUE;
+    mapHandle = NULL;
+    #else
+    munmap((void*) data, size);
+    #endif
+    data = nullptr;
+    size = 0;
+}
+
+/**
+ * @brief Checks if a file is mapped
+ * 
+ * @return True if the file is mapped. Empty files are never mapped.
+ */
+bool MappedFile::isOpen() const { return data != nullptr; }
+
+/**
+ * @brief Gets the content of the file
+ * 
+ * @return Pointer to the first byte of the file
+ */
+const char* MappedFile::getData() const { return data; }
+
+/**
+ * @brief Gets the size of the file
+ * 
+ * @return Number of bytes in the file
+ */
+size_t MappedFile::getSize() const { return size; }
+
+}}
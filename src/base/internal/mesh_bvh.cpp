@@ -0,0 +1,397 @@
+/**
+ * @file mesh_bvh.cpp
+ * @brief Bounding volume hierarchy over the triangles of a mesh
+ * 
+ * Keeps the positions and indices of a mesh uploaded to the GPU so that
+ * the rays of mouse picking can be tested against the triangles. The tree
+ * is only built by the first ray query.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#define RMG_EXPORT
+
+
+#include "../rmg/internal/mesh_bvh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <utility>
+
+#include "../rmg/internal/parallel_for.hpp"
+
+
+#define MESH_BVH_LEAF_SIZE 4 ///< Most triangles of a leaf
+#define MESH_BVH_BIN_COUNT 16
+#define MESH_BVH_PARALLEL_GRAIN 16384 ///< Least triangles built on a thread
+#define MESH_BVH_PARALLEL_DEPTH 4 ///< Levels building the halves in parallel
+#define MESH_BVH_INTERSECT_COST 1.0f ///< Ray-triangle test relative to a box
+
+
+static float getArea(const rmg::BoundingBox &box) {
+    if(box.isEmpty())
+        return 0;
+    rmg::Vec3 d = box.max - box.min;
+    return d.x*d.y + d.y*d.z + d.z*d.x;
+}
+
+
+// Inlined versions of BoundingBox::extend for the inner loops of the build
+static inline void grow(rmg::BoundingBox &box, const rmg::Vec3 &p) {
+    for(int i=0; i<3; i++) {
+        box.min[i] = std::min(box.min[i], p[i]);
+        box.max[i] = std::max(box.max[i], p[i]);
+    }
+}
+
+
+static inline void grow(rmg::BoundingBox &box, const rmg::BoundingBox &b) {
+    for(int i=0; i<3; i++) {
+        box.min[i] = std::min(box.min[i], b.min[i]);
+        box.max[i] = std::max(box.max[i], b.max[i]);
+    }
+}
+
+
+namespace rmg {
+namespace internal {
+
+/**
+ * @brief Constructor copying the triangles of a mesh
+ * 
+ * @param vert Vertex positions
+ * @param vcount Number of vertices
+ * @param idx Vertex indices of the triangles. Null if the vertices form
+ *            the triangles in order.
+ * @param icount Number of indices
+ */
+MeshBVH::MeshBVH(const Vec3* vert, uint32_t vcount, const uint32_t* idx,
+                 uint32_t icount)
+{
+    assign(vert, vcount, idx, icount);
+}
+
+/**
+ * @brief Constructor taking over a mesh
+ * 
+ * The triangles are copied out of the mesh by the first ray query so that
+ * the meshes never picked cost no copy. Only the positions and indices are
+ * kept until then. The arrays of a mapped mesh stay in the mapping.
+ * 
+ * @param mesh Source mesh
+ */
+MeshBVH::MeshBVH(Mesh&& mesh): source(std::move(mesh)) {
+    if(source.mapping != nullptr)
+        return;
+    free(source.normals);
+    free(source.texCoords);
+    source.normals = nullptr;
+    source.texCoords = nullptr;
+}
+
+
+void MeshBVH::assign(const Vec3* vert, uint32_t vcount, const uint32_t* idx,
+                     uint32_t icount)
+{
+    vertices.assign(vert, vert + vcount);
+    if(idx != nullptr) {
+        indices.assign(idx, idx + icount - icount % 3);
+    }
+    else {
+        indices.resize(vcount - vcount % 3);
+        for(uint32_t i=0; i<indices.size(); i++)
+            indices[i] = i;
+    }
+}
+
+/**
+ * @brief Builds the tree if it is not built yet
+ */
+void MeshBVH::build() {
+    if(source.vertices != nullptr) {
+        assign(source.vertices, source.vertex_count, source.indices,
+               source.index_count);
+        source = Mesh();
+    }
+    if(isBuilt() || indices.empty())
+        return;
+    uint32_t count = indices.size() / 3;
+    primitives.resize(count);
+    parallelFor(count, MESH_BVH_PARALLEL_GRAIN, [&](size_t b, size_t e) {
+        for(size_t i=b; i<e; i++) {
+            Primitive &prim = primitives[i];
+            prim.box = BoundingBox();
+            for(int j=0; j<3; j++)
+                grow(prim.box, vertices[indices[3*i + j]]);
+            prim.center = prim.box.getCenter();
+            prim.triangle = i;
+        }
+    });
+    BoundingBox box, centerBox;
+    measure(0, count, box, centerBox);
+    std::vector<Node> out;
+    out.reserve(count);
+    build(out, 0, count, box, centerBox, 0);
+    
+    // The triangles are stored in the order of the leaves
+    std::vector<uint32_t> sorted(indices.size());
+    for(uint32_t i=0; i<count; i++) {
+        for(int j=0; j<3; j++)
+            sorted[3*i + j] = indices[3*primitives[i].triangle + j];
+    }
+    indices.swap(sorted);
+    nodes.swap(out);
+    std::vector<Primitive>().swap(primitives);
+}
+
+/**
+ * @brief Checks if the tree is built
+ * 
+ * @return True if the tree is built
+ */
+bool MeshBVH::isBuilt() const { return !nodes.empty(); }
+
+/**
+ * @brief Gets the number of triangles
+ * 
+ * @return Number of triangles
+ */
+uint32_t MeshBVH::getTriangleCount() const {
+    if(source.vertices == nullptr)
+        return indices.size() / 3;
+    if(source.indices == nullptr)
+        return source.vertex_count / 3;
+    return source.index_count / 3;
+}
+
+/**
+ * @brief Finds the nearest triangle a ray hits
+ * 
+ * Both sides of the triangles are hit. Builds the tree first if it is not
+ * built yet.
+ * 
+ * @param ray Ray in the space of the mesh
+ * @param maxDistance Limit of the distance along the ray in the units of
+ *                    its direction vector
+ * @param t Returns the distance of the hit
+ * 
+ * @return True if a triangle is hit within the limit
+ */
+bool MeshBVH::raycast(const LineEq &ray, float maxDistance, float *t) {
+    build();
+    if(nodes.empty())
+        return false;
+    Vec3 inverse = Vec3(1/ray.v.x, 1/ray.v.y, 1/ray.v.z);
+    
+    // Distance where the ray enters a box or infinity if it misses
+    auto enter = [&](const BoundingBox &box) {
+        float t0 = 0, t1 = maxDistance;
+        for(int i=0; i<3; i++) {
+            float a = (box.min[i] - ray.P[i]) * inverse[i];
+            float b = (box.max[i] - ray.P[i]) * inverse[i];
+            if(std::isnan(a) || std::isnan(b))
+                continue; // Parallel to the slab and on its plane
+            t0 = std::max(t0, std::min(a, b));
+            t1 = std::min(t1, std::max(a, b));
+        }
+        return (t0 <= t1) ? t0 : INFINITY;
+    };
+    
+    // Moller-Trumbore test of both sides of a triangle
+    auto intersect = [&](uint32_t tri) {
+        const Vec3 &A = vertices[indices[3*tri]];
+        Vec3 e1 = vertices[indices[3*tri + 1]] - A;
+        Vec3 e2 = vertices[indices[3*tri + 2]] - A;
+        Vec3 p = Vec3::cross(ray.v, e2);
+        float det = Vec3::dot(e1, p);
+        if(det == 0)
+            return false;
+        float inv = 1 / det;
+        Vec3 s = ray.P - A;
+        float u = Vec3::dot(s, p) * inv;
+        if(u < 0 || u > 1)
+            return false;
+        Vec3 q = Vec3::cross(s, e1);
+        float v = Vec3::dot(ray.v, q) * inv;
+        if(v < 0 || u + v > 1)
+            return false;
+        float d = Vec3::dot(e2, q) * inv;
+        if(d < 0 || d > maxDistance)
+            return false;
+        maxDistance = d;
+        return true;
+    };
+    
+    bool hit = false;
+    std::vector<std::pair<uint32_t,float>> stack;
+    float t0 = enter(nodes[0].box);
+    if(t0 != INFINITY)
+        stack.push_back(std::make_pair(0, t0));
+    while(!stack.empty()) {
+        uint32_t index = stack.back().first;
+        t0 = stack.back().second;
+        stack.pop_back();
+        if(t0 > maxDistance)
+            continue;
+        const Node &node = nodes[index];
+        if(node.count > 0) {
+            for(uint32_t i=0; i<node.count; i++) {
+                if(intersect(node.first + i))
+                    hit = true;
+            }
+            continue;
+        }
+        // The nearer child is popped first
+        uint32_t a = index + 1;
+        uint32_t b = node.first;
+        float ta = enter(nodes[a].box);
+        float tb = enter(nodes[b].box);
+        if(ta < tb) {
+            std::swap(a, b);
+            std::swap(ta, tb);
+        }
+        if(ta != INFINITY)
+            stack.push_back(std::make_pair(a, ta));
+        if(tb != INFINITY)
+            stack.push_back(std::make_pair(b, tb));
+    }
+    if(hit)
+        *t = maxDistance;
+    return hit;
+}
+
+
+void MeshBVH::measure(uint32_t first, uint32_t count, BoundingBox &box,
+                      BoundingBox &centerBox) const
+{
+    for(uint32_t i=first; i<first+count; i++) {
+        grow(box, primitives[i].box);
+        grow(centerBox, primitives[i].center);
+    }
+}
+
+
+void MeshBVH::build(std::vector<Node> &out, uint32_t first, uint32_t count,
+                    const BoundingBox &box, const BoundingBox &centerBox,
+                    int depth)
+{
+    uint32_t index = out.size();
+    out.push_back(Node());
+    out[index].box = box;
+    out[index].first = first;
+    out[index].count = count;
+    if(count <= MESH_BVH_LEAF_SIZE)
+        return;
+    
+    // Sweeps the bins of the longest axis for the split of the least
+    // surface area cost. The bins also give the bounds of the halves.
+    Primitive *items = &primitives[first];
+    Vec3 extent = centerBox.max - centerBox.min;
+    int axis = 0;
+    if(extent.y > extent[axis])
+        axis = 1;
+    if(extent.z > extent[axis])
+        axis = 2;
+    uint32_t mid = 0;
+    BoundingBox halves[2], centerHalves[2];
+    if(extent[axis] > 0) {
+        BoundingBox bins[MESH_BVH_BIN_COUNT];
+        BoundingBox centerBins[MESH_BVH_BIN_COUNT];
+        uint32_t counts[MESH_BVH_BIN_COUNT] = {};
+        float origin = centerBox.min[axis];
+        float scale = MESH_BVH_BIN_COUNT / extent[axis];
+        auto getBin = [&](const Primitive &prim) {
+            int bin = (int)((prim.center[axis] - origin) * scale);
+            return std::min(std::max(bin, 0), MESH_BVH_BIN_COUNT - 1);
+        };
+        for(uint32_t i=0; i<count; i++) {
+            int b = getBin(items[i]);
+            grow(bins[b], items[i].box);
+            grow(centerBins[b], items[i].center);
+            counts[b]++;
+        }
+        float rightCost[MESH_BVH_BIN_COUNT];
+        BoundingBox side;
+        uint32_t n = 0;
+        for(int b=MESH_BVH_BIN_COUNT-1; b>0; b--) {
+            grow(side, bins[b]);
+            n += counts[b];
+            rightCost[b] = getArea(side) * n;
+        }
+        side = BoundingBox();
+        n = 0;
+        int best = 0;
+        float bestCost = INFINITY;
+        for(int b=0; b<MESH_BVH_BIN_COUNT-1; b++) {
+            grow(side, bins[b]);
+            n += counts[b];
+            float cost = getArea(side) * n + rightCost[b+1];
+            if(cost < bestCost) {
+                bestCost = cost;
+                best = b;
+                mid = n;
+            }
+        }
+        // A leaf is cheaper than the split for the small groups
+        float leafCost = getArea(box) * count * MESH_BVH_INTERSECT_COST;
+        if(count <= 2 * MESH_BVH_LEAF_SIZE && leafCost <= bestCost)
+            return;
+        if(mid > 0 && mid < count) {
+            std::partition(items, items + count, [&](const Primitive &prim) {
+                return getBin(prim) <= best;
+            });
+            for(int b=0; b<MESH_BVH_BIN_COUNT; b++) {
+                grow(halves[b > best], bins[b]);
+                grow(centerHalves[b > best], centerBins[b]);
+            }
+        }
+    }
+    if(mid == 0 || mid == count) {
+        // The centers are too close to bin. Splits at the median.
+        mid = count / 2;
+        std::nth_element(items, items + mid, items + count,
+                         [&](const Primitive &a, const Primitive &b) {
+            return a.center[axis] < b.center[axis];
+        });
+        measure(first, mid, halves[0], centerHalves[0]);
+        measure(first + mid, count - mid, halves[1], centerHalves[1]);
+    }
+    out[index].count = 0;
+    
+    // The second half is built into a separate array in parallel and
+    // appended after the first one
+    if(count >= MESH_BVH_PARALLEL_GRAIN && depth < MESH_BVH_PARALLEL_DEPTH) {
+        std::vector<Node> right;
+        parallelFor(2, 1, [&](size_t b, size_t e) {
+            for(size_t i=b; i<e; i++) {
+                if(i == 0) {
+                    build(out, first, mid, halves[0], centerHalves[0],
+                          depth + 1);
+                }
+                else {
+                    build(right, first + mid, count - mid, halves[1],
+                          centerHalves[1], depth + 1);
+                }
+            }
+        });
+        uint32_t offset = out.size();
+        for(auto it=right.begin(); it!=right.end(); it++) {
+            if(it->count == 0)
+                it->first += offset;
+            out.push_back(*it);
+        }
+        out[index].first = offset;
+    }
+    else {
+        build(out, first, mid, halves[0], centerHalves[0], depth + 1);
+        out[index].first = out.size();
+        build(out, first + mid, count - mid, halves[1], centerHalves[1],
+              depth + 1);
+    }
+}
+
+}}
@@ -0,0 +1,150 @@
+/**
+ * @file mesh_cache.cpp
+ * @brief Shares the VBOs of identical meshes among the 3D objects
+ * 
+ * The meshes are addressed by a hash of their data or of the parameters
+ * generating them. The 3D objects looking up the same key share a single
+ * VBO instead of uploading the same vertices again.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#define RMG_EXPORT
+
+
+#include "../rmg/internal/mesh_cache.hpp"
+
+#include <cstring>
+#include <utility>
+
+#include "../rmg/internal/vbo_load.hpp"
+
+
+#define HASH_PRIME1 0x9e3779b97f4a7c15ULL
+#define HASH_PRIME2 0xbf58476d1ce4e5b9ULL
+
+
+namespace rmg {
+namespace internal {
+
+/**
+ * @brief Destructor
+ */
+MeshCache::~MeshCache() { clear(); }
+
+/**
+ * @brief Move constructor
+ * 
+ * @param cache Source
+ */
+MeshCache::MeshCache(MeshCache&& cache) noexcept
+          :entries(std::move(cache.entries))
+{
+    cache.entries.clear();
+}
+
+/**
+ * @brief Hashes a block of memory
+ * 
+ * A fast non-cryptographic 64-bit hash reading the data by words.
+ * 
+ * @param data Start of the data
+ * @param size Size in bytes
+ * @param seed Hash of the preceding data to chain the blocks
+ * 
+ * @return Hash value
+ */
+uint64_t MeshCache::hash(const void* data, size_t size, uint64_t seed) {
+    const uint8_t* ptr = (const uint8_t*) data;
+    uint64_t h = seed ^ (size * HASH_PRIME1);
+    for(; size >= 8; size -= 8, ptr += 8) {
+        uint64_t w;
+        memcpy(&w, ptr, 8);
+        h ^= w * HASH_PRIME2;
+        h = ((h << 27) | (h >> 37)) * HASH_PRIME1;
+    }
+    if(size > 0) {
+        uint64_t w = 0;
+        memcpy(&w, ptr, size);
+        h ^= w * HASH_PRIME2;
+        h = ((h << 27) | (h >> 37)) * HASH_PRIME1;
+    }
+    h ^= h >> 31;
+    h *= HASH_PRIME2;
+    return h ^ (h >> 29);
+}
+
+/**
+ * @brief Looks up a shared VBO
+ * 
+ * @param key Hash of the mesh or its parameters
+ * 
+ * @return The shared VBO or nullptr if the key is not in the cache
+ */
+const SharedVBO *MeshCache::find(uint64_t key) const {
+    auto it = entries.find(key);
+    if(it == entries.end())
+        return nullptr;
+    return &it->second;
+}
+
+/**
+ * @brief Adds a VBO to the cache
+ * 
+ * The cache takes a reference of the VBO.
+ * 
+ * @param key Hash of the mesh or its parameters
+ * @param vbo VBO, its reference count and its load
+ */
+void MeshCache::insert(uint64_t key, const SharedVBO &vbo) {
+    auto res = entries.insert(std::make_pair(key, vbo));
+    if(res.second)
+        (*vbo.shareCount)++;
+}
+
+/**
+ * @brief Releases the VBOs no 3D object uses
+ */
+void MeshCache::collect() {
+    for(auto it=entries.begin(); it!=entries.end(); ) {
+        if(*it->second.shareCount == 1) {
+            release(it->second);
+            it = entries.erase(it);
+        }
+        else {
+            it++;
+        }
+    }
+}
+
+/**
+ * @brief Releases all the VBOs of the cache
+ * 
+ * The VBOs still used by 3D objects are deleted by the last of them.
+ */
+void MeshCache::clear() {
+    for(auto it=entries.begin(); it!=entries.end(); it++)
+        release(it->second);
+    entries.clear();
+}
+
+/**
+ * @brief Gets the number of meshes in the cache
+ * 
+ * @return Number of shared VBOs
+ */
+size_t MeshCache::getSize() const { return entries.size(); }
+
+
+void MeshCache::release(SharedVBO &entry) {
+    (*entry.shareCount)--;
+    if(*entry.shareCount == 0) {
+        delete entry.vbo;
+        delete entry.shareCount;
+    }
+}
+
+}}
@@ -88,6 +88,7 @@ void SpriteShader::render(Sprite2D* sprite, const Mat3 &VP) {
     glUniform4fv(idColor, 1, &color[0]);
     sprite->getTexture()->bind();
     glDrawArrays(GL_TRIANGLES, 0, 6);
+    drawCallCount++;
 }
 
 
@@ -199,6 +200,7 @@ void Text2DShader::render(Text2D* txt, const Mat3 &VP) {
         float h = glyph.height / (16.0f * ft->getSize());
         glUniform2f(idSize, w, h);
         glDrawArrays(GL_TRIANGLES, 0, 6);
+        drawCallCount++;
         x += glyph.advance;
         c = *(++ptr);
     }
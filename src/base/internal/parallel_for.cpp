@@ -0,0 +1,106 @@
+/**
+ * @file parallel_for.cpp
+ * @brief Splits a loop over ranges run by several threads
+ * 
+ * Used by the mesh builders whose loops over vertices and triangles are
+ * independent of each other.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#define RMG_EXPORT
+
+
+#include "../rmg/internal/parallel_for.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+#include "../rmg/internal/worker_pool.hpp"
+
+
+namespace {
+
+// Ranges of a loop taken one by one by the calling thread and the pool
+struct Loop {
+    const std::function<void(size_t,size_t)>* func;
+    size_t count;
+    size_t rangeCount;
+    std::atomic<size_t> next;
+    size_t remaining;
+    std::mutex mutex;
+    std::condition_variable finished;
+};
+
+
+// Helpers started after the loop has finished find no range to take
+void runRanges(Loop &loop) {
+    size_t n = loop.rangeCount;
+    for(size_t i=loop.next++; i<n; i=loop.next++) {
+        (*loop.func)(loop.count*i/n, loop.count*(i+1)/n);
+        std::lock_guard<std::mutex> lock(loop.mutex);
+        if(--loop.remaining == 0)
+            loop.finished.notify_all();
+    }
+}
+
+
+// Shared by all the loops so that the threads are only started once
+rmg::internal::WorkerPool& getPool() {
+    static rmg::internal::WorkerPool pool;
+    return pool;
+}
+
+}
+
+
+namespace rmg {
+namespace internal {
+
+/**
+ * @brief Runs a loop over ranges on several threads
+ * 
+ * The ranges run on a pool of threads shared by all the loops. The calling
+ * thread takes ranges as well and waits for the ones taken by the pool,
+ * so nested loops and loops called from the pool never wait for a thread
+ * to be free. Loops too short to pay for the threads run in the calling
+ * thread only.
+ * 
+ * @param count Number of iterations
+ * @param grain Least number of iterations given to a thread
+ * @param func Function running the iterations from the first argument up
+ *             to the second argument
+ */
+void parallelFor(size_t count, size_t grain,
+                 const std::function<void(size_t,size_t)> &func)
+{
+    if(count == 0)
+        return;
+    WorkerPool &pool = getPool();
+    size_t n = pool.getThreadCount() + 1;
+    n = std::min(n, count / std::max(grain, (size_t) 1));
+    if(n <= 1) {
+        func(0, count);
+        return;
+    }
+    
+    auto loop = std::make_shared<Loop>();
+    loop->func = &func;
+    loop->count = count;
+    loop->rangeCount = n;
+    loop->next = 0;
+    loop->remaining = n;
+    for(size_t i=1; i<n; i++)
+        pool.push([loop]() { runRanges(*loop); });
+    runRanges(*loop);
+    std::unique_lock<std::mutex> lock(loop->mutex);
+    loop->finished.wait(lock, [&loop] { return loop->remaining == 0; });
+}
+
+}}
@@ -65,6 +65,21 @@ void ParticleShader::load() {
     glEnableVertexAttribArray(0);
 }
 
+/**
+ * @brief Binds the quad the particles are drawn with
+ */
+void ParticleShader::bindQuad() const {
+    glBindVertexArray(quadVertexArrayID);
+}
+
+/**
+ * @brief Draws the bound quad with the program in use
+ */
+void ParticleShader::drawQuad() const {
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    drawCallCount++;
+}
+
 /**
  * @brief Renders the given list of particles
  * 
@@ -85,7 +100,7 @@ void ParticleShader::render(const Mat4 &V, const Mat4 &P,
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     
     glUseProgram(id);
-    glBindVertexArray(quadVertexArrayID);
+    bindQuad();
     glUniformMatrix4fv(idProjection, 1, GL_TRUE, &P[0][0]);
     glUniform1i(idTexture, TEXTURE_SPRITE);
     std::map<float, Particle3D*> sorted;
@@ -108,7 +123,7 @@ void ParticleShader::render(const Mat4 &V, const Mat4 &P,
         glUniformMatrix3fv(idModel, 1, GL_TRUE, &obj->getModelMatrix()[0][0]);
         glUniform4fv(idColor, 1, &obj->getColor()[0]);
         obj->getTexture()->bind();
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        drawQuad();
     }
 }
 
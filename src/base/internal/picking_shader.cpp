@@ -0,0 +1,326 @@
+/**
+ * @file picking_shader.cpp
+ * @brief Draws the IDs of the objects to find the ones under the mouse
+ * 
+ * The object IDs are drawn into an integer image instead of colors. The
+ * pixels of a requested rectangle on the screen are copied into pixel
+ * buffer objects and read a frame later so that the CPU never waits for
+ * the GPU.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#define RMG_EXPORT
+
+
+#include "../rmg/internal/picking_shader.hpp"
+
+#include <algorithm>
+
+#include "shader_def.h"
+#include "../../config/rmg/config.h"
+#include "../rmg/line3d.hpp"
+#include "../rmg/object3d.hpp"
+#include "../rmg/particle.hpp"
+#include "../rmg/internal/line3d_shader.hpp"
+#include "../rmg/internal/particle_shader.hpp"
+#include "../rmg/internal/scene_bvh.hpp"
+#include "../rmg/internal/sprite_load.hpp"
+#include "../rmg/math/frustum.hpp"
+
+
+// Splits the 64-bit ID into the two channels of the image
+static void setObjectID(uint32_t location, uint64_t id) {
+    rmg::internal::glUniform2ui(location, (uint32_t) id,
+                                (uint32_t)(id >> 32));
+}
+
+
+namespace rmg {
+namespace internal {
+
+/**
+ * @brief Destructor
+ */
+PickingShader::~PickingShader() {
+    for(int i=0; i<RMG_PICKING_READBACK_COUNT; i++) {
+        if(readbacks[i].fence != NULL)
+            glDeleteSync(readbacks[i].fence);
+        if(readbacks[i].buffer != 0)
+            glDeleteBuffers(1, &readbacks[i].buffer);
+    }
+    if(framebuffer != 0)
+        glDeleteFramebuffers(1, &framebuffer);
+    if(idBuffer != 0)
+        glDeleteRenderbuffers(1, &idBuffer);
+    if(depthBuffer != 0)
+        glDeleteRenderbuffers(1, &depthBuffer);
+    if(particleProgram != 0)
+        glDeleteProgram(particleProgram);
+}
+
+/**
+ * @brief Compiles and links shader program and assigns parameter IDs
+ */
+void PickingShader::load() {
+    id = compileShaderProgram(
+        RMG_RESOURCE_PATH "/shaders/picking.vs.glsl",
+        RMG_RESOURCE_PATH "/shaders/picking.fs.glsl"
+    );
+    idMVP = glGetUniformLocation(id, "MVP");
+    idObjectID = glGetUniformLocation(id, "objectID");
+    idTextured = glGetUniformLocation(id, "textured");
+    
+    // The particles are placed by their own vertex shader
+    particleProgram = compileShaderProgram(
+        RMG_RESOURCE_PATH "/shaders/particle.vs.glsl",
+        RMG_RESOURCE_PATH "/shaders/picking.fs.glsl"
+    );
+    idParticleTV = glGetUniformLocation(particleProgram, "TV");
+    idParticleModel = glGetUniformLocation(particleProgram, "model");
+    idParticleProjection = glGetUniformLocation(particleProgram,
+                                                "projection");
+    idParticleObjectID = glGetUniformLocation(particleProgram, "objectID");
+    idParticleTextured = glGetUniformLocation(particleProgram, "textured");
+    idParticleTexture = glGetUniformLocation(particleProgram, "image");
+    
+    glGenFramebuffers(1, &framebuffer);
+    glGenRenderbuffers(1, &idBuffer);
+    glGenRenderbuffers(1, &depthBuffer);
+    for(int i=0; i<RMG_PICKING_READBACK_COUNT; i++)
+        glGenBuffers(1, &readbacks[i].buffer);
+}
+
+/**
+ * @brief Requests the IDs of the objects in a rectangle on the screen
+ * 
+ * The rectangle is drawn by the next render. A request not drawn yet is
+ * replaced by the newer one.
+ * 
+ * @param x X-coordinate of the top-left corner
+ * @param y Y-coordinate of the top-left corner
+ * @param w Width of the rectangle
+ * @param h Height of the rectangle
+ */
+void PickingShader::request(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+    requestX = x;
+    requestY = y;
+    requestWidth = w;
+    requestHeight = h;
+    requested = true;
+}
+
+/**
+ * @brief Checks if a request is waiting to be drawn
+ * 
+ * @return True if a request is not drawn yet
+ */
+bool PickingShader::isRequested() const { return requested; }
+
+/**
+ * @brief Gets the IDs read back for the last finished request
+ * 
+ * @param ids Returns the object IDs in ascending order
+ * 
+ * @return True if a new result is returned since the last call
+ */
+bool PickingShader::getResult(std::vector<uint64_t> *ids) {
+    if(!resultReady)
+        return false;
+    ids->swap(result);
+    result.clear();
+    resultReady = false;
+    return true;
+}
+
+
+void PickingShader::resize(uint16_t w, uint16_t h) {
+    if(w <= bufferWidth && h <= bufferHeight)
+        return;
+    bufferWidth = std::max(w, bufferWidth);
+    bufferHeight = std::max(h, bufferHeight);
+    glBindRenderbuffer(GL_RENDERBUFFER, idBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RG32UI, bufferWidth,
+                          bufferHeight);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, bufferWidth,
+                          bufferHeight);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                              GL_RENDERBUFFER, idBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                              GL_RENDERBUFFER, depthBuffer);
+}
+
+
+void PickingShader::poll() {
+    // The fences signal in the order the readbacks are issued
+    while(readCount != writeCount) {
+        Readback &rb = readbacks[readCount % RMG_PICKING_READBACK_COUNT];
+        GLenum status = glClientWaitSync(rb.fence, 0, 0);
+        if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            return;
+        glDeleteSync(rb.fence);
+        rb.fence = NULL;
+        readCount++;
+        
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, rb.buffer);
+        const uint32_t *pixels = (const uint32_t*) glMapBufferRange(
+            GL_PIXEL_PACK_BUFFER,
+            0,
+            2 * sizeof(uint32_t) * rb.pixelCount,
+            GL_MAP_READ_BIT
+        );
+        if(pixels == nullptr) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            continue;
+        }
+        // Skips the runs of the same object before sorting
+        result.clear();
+        uint64_t last = 0;
+        for(uint32_t i=0; i<rb.pixelCount; i++) {
+            uint64_t id = pixels[2*i] | ((uint64_t) pixels[2*i + 1] << 32);
+            if(id == 0 || id == last)
+                continue;
+            result.push_back(id);
+            last = id;
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+        resultReady = true;
+    }
+}
+
+/**
+ * @brief Reads back the finished requests and draws the pending one
+ * 
+ * Nothing is drawn if there is no request or all the readbacks are still
+ * in flight. A request outside the screen gives an empty result.
+ * 
+ * @param V View matrix
+ * @param P Projection matrix
+ * @param width Width of the screen
+ * @param height Height of the screen
+ * @param bvh Bounding volume hierarchy of the 3D objects
+ * @param lines List of 3D lines
+ * @param particles List of particles
+ * @param lineShader Shader holding the mesh of the lines
+ * @param particleShader Shader holding the quad of the particles
+ */
+void PickingShader::render(const Mat4 &V, const Mat4 &P, uint16_t width,
+                           uint16_t height, const SceneBVH &bvh,
+                           const ObjectList &lines,
+                           const ObjectList &particles,
+                           const Line3DShader &lineShader,
+                           const ParticleShader &particleShader)
+{
+    if(id == 0)
+        return;
+    poll();
+    if(!requested || writeCount - readCount >= RMG_PICKING_READBACK_COUNT)
+        return;
+    
+    // Clips the rectangle to the screen
+    if(requestX >= width || requestY >= height) {
+        // Waits for the earlier readbacks not to be overwritten by them
+        if(readCount != writeCount)
+            return;
+        requested = false;
+        result.clear();
+        resultReady = true;
+        return;
+    }
+    requested = false;
+    uint16_t x = requestX;
+    uint16_t w = std::min<uint16_t>(std::max<uint16_t>(requestWidth, 1),
+                                    width - x);
+    uint16_t h = std::min<uint16_t>(std::max<uint16_t>(requestHeight, 1),
+                                    height - requestY);
+    uint16_t y = height - requestY - h; // From the bottom
+    
+    // Narrows the projection down to the rectangle
+    Mat4 R = Mat4();
+    R[0][0] = (float) width / w;
+    R[0][3] = (float)(width - 2*x - w) / w;
+    R[1][1] = (float) height / h;
+    R[1][3] = (float)(height - 2*y - h) / h;
+    Mat4 RP = R * P;
+    Mat4 VP = RP * V;
+    
+    resize(w, h);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, w, h);
+    const GLuint zero[4] = {0, 0, 0, 0};
+    glClearBufferuiv(GL_COLOR, 0, zero);
+    glClearDepth(1.0);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glDisable(GL_CULL_FACE);
+    glDisable(GL_BLEND);
+    
+    glUseProgram(id);
+    glUniform1i(idTextured, 0);
+    bvh.query(Frustum(VP), [&](Object3D *obj) {
+        if(obj->isHidden() || obj->getVBO() == nullptr)
+            return;
+        const VBO *vbo = obj->getVBO();
+        Mat4 MVP = VP * obj->getModelMatrix() * vbo->getPositionMatrix();
+        glUniformMatrix4fv(idMVP, 1, GL_TRUE, &MVP[0][0]);
+        setObjectID(idObjectID, obj->getID());
+        vbo->drawPositions(obj->getLOD());
+    });
+    
+    lineShader.bindMesh();
+    for(auto it=lines.begin(); it!=lines.end(); it++) {
+        Line3D* line = (Line3D*) &(*it);
+        if(line->isHidden())
+            continue;
+        Mat4 MVP = VP * line->getModelMatrix();
+        glUniformMatrix4fv(idMVP, 1, GL_TRUE, &MVP[0][0]);
+        setObjectID(idObjectID, line->getID());
+        lineShader.drawMesh();
+    }
+    
+    glUseProgram(particleProgram);
+    glUniformMatrix4fv(idParticleProjection, 1, GL_TRUE, &RP[0][0]);
+    glUniform1i(idParticleTextured, 1);
+    glUniform1i(idParticleTexture, TEXTURE_SPRITE);
+    particleShader.bindQuad();
+    for(auto it=particles.begin(); it!=particles.end(); it++) {
+        Particle3D* obj = (Particle3D*) &(*it);
+        if(obj->isHidden() || obj->getTexture() == nullptr)
+            continue;
+        Vec3 TV = Vec3(V * Vec4(obj->getTranslation(), 1));
+        glUniform3fv(idParticleTV, 1, &TV[0]);
+        glUniformMatrix3fv(idParticleModel, 1, GL_TRUE,
+                           &obj->getModelMatrix()[0][0]);
+        setObjectID(idParticleObjectID, obj->getID());
+        obj->getTexture()->bind();
+        particleShader.drawQuad();
+    }
+    
+    // Copied into the pixel buffer on the GPU and mapped a frame later
+    Readback &rb = readbacks[writeCount % RMG_PICKING_READBACK_COUNT];
+    rb.pixelCount = (uint32_t) w * h;
+    uint32_t size = 2 * sizeof(uint32_t) * rb.pixelCount;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, rb.buffer);
+    if(size > rb.capacity) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+        rb.capacity = size;
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, w, h, GL_RG_INTEGER, GL_UNSIGNED_INT, (void*)0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    rb.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    writeCount++;
+}
+
+}}
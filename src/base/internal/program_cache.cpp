@@ -0,0 +1,278 @@
+/**
+ * @file program_cache.cpp
+ * @brief Keeps the linked shader programs on the disk between the runs
+ * 
+ * The drivers hand out the linked programs as binaries in their own
+ * formats. Loading them back skips compiling and linking the shaders,
+ * which is the most of the time spent before the first frame.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#define RMG_EXPORT
+
+
+#include "../rmg/internal/program_cache.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include "../../config/rmg/config.h"
+#include "../rmg/internal/glcontext.hpp"
+#include "../rmg/internal/mapped_file.hpp"
+#include "../rmg/internal/mesh_cache.hpp"
+
+
+namespace {
+
+struct ProgramFileHeader {
+    char magic[8];
+    uint64_t key;
+    uint32_t format;
+    uint32_t length;
+};
+
+static_assert(sizeof(ProgramFileHeader) == 24, "Unexpected header padding");
+
+const char PROGRAM_FILE_MAGIC[8] = {'R', 'M', 'G', 'P', 'R', 'O', 'G', '\0'};
+
+std::string directory;
+bool directoryChosen = false;
+
+
+std::string getDefaultDirectory() {
+    #ifdef _WIN32
+    const char* base = getenv("LOCALAPPDATA");
+    if(base != nullptr && base[0] != '\0')
+        return std::string(base) + "/rmg/shaders";
+    #else
+    const char* base = getenv("XDG_CACHE_HOME");
+    if(base != nullptr && base[0] != '\0')
+        return std::string(base) + "/rmg/shaders";
+    base = getenv("HOME");
+    if(base != nullptr && base[0] != '\0')
+        return std::string(base) + "/.cache/rmg/shaders";
+    #endif
+    return "";
+}
+
+
+void makeDirectories(const std::string &dir) {
+    for(size_t i=1; i<=dir.size(); i++) {
+        if(i < dir.size() && dir[i] != '/' && dir[i] != '\\')
+            continue;
+        std::string parent = dir.substr(0, i);
+        #ifdef _WIN32
+        _mkdir(parent.c_str());
+        #else
+        mkdir(parent.c_str(), 0755);
+        #endif
+    }
+}
+
+
+std::string getProgramFile(uint64_t key) {
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.bin", (unsigned long long) key);
+    return rmg::internal::ProgramCache::getDirectory() + name;
+}
+
+}
+
+
+namespace rmg {
+namespace internal {
+
+/**
+ * @brief Sets the directory to keep the programs
+ * 
+ * The directory is shared by all the contexts. It is created when the
+ * first program is stored.
+ * 
+ * @param dir Path to the directory or an empty string to turn off the
+ *            cache
+ */
+void ProgramCache::setDirectory(const std::string &dir) {
+    directory = dir;
+    directoryChosen = true;
+}
+
+/**
+ * @brief Gets the directory to keep the programs
+ * 
+ * Defaults to rmg/shaders under the cache directory of the user.
+ * 
+ * @return Path to the directory or an empty string if the cache is
+ *         turned off
+ */
+const std::string& ProgramCache::getDirectory() {
+    if(!directoryChosen) {
+        directory = getDefaultDirectory();
+        directoryChosen = true;
+    }
+    return directory;
+}
+
+/**
+ * @brief Checks if the programs of the current context can be cached
+ * 
+ * @return True if the driver gives out program binaries and the cache
+ *         has a directory
+ */
+bool ProgramCache::isSupported() {
+    if(getDirectory().empty() || glGetProgramBinary == NULL ||
+       glProgramBinary == NULL || glProgramParameteri == NULL)
+    {
+        return false;
+    }
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+/**
+ * @brief Gets the key of a program in the current context
+ * 
+ * @param vert Vertex shader source
+ * @param frag Fragment shader source
+ * @param defines Preprocessor definitions for both shaders or null
+ * 
+ * @return Hash of the driver, the sources and the definitions
+ */
+uint64_t ProgramCache::getKey(const std::string &vert,
+                              const std::string &frag,
+                              const char* defines)
+{
+    // The binaries are only valid for the same driver and its version
+    const GLenum names[] = {
+        GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION
+    };
+    uint64_t key = MeshCache::hash(RMG_VERSION_STRING,
+                                   strlen(RMG_VERSION_STRING));
+    for(GLenum name : names) {
+        const char* str = (const char*) glGetString(name);
+        if(str != nullptr)
+            key = MeshCache::hash(str, strlen(str), key);
+    }
+    key = MeshCache::hash(vert.data(), vert.size(), key);
+    key = MeshCache::hash(frag.data(), frag.size(), key);
+    if(defines != nullptr)
+        key = MeshCache::hash(defines, strlen(defines), key);
+    return key;
+}
+
+/**
+ * @brief Loads a program from its binary
+ * 
+ * @param key Key of the program
+ * 
+ * @return Linked shader program or zero if it is not in the cache or
+ *         the driver has rejected it
+ */
+uint32_t ProgramCache::load(uint64_t key) {
+    if(!isSupported())
+        return 0;
+    std::string path = getProgramFile(key);
+    MappedFile file;
+    if(!file.open(path.c_str()))
+        return 0;
+    const ProgramFileHeader* header = (const ProgramFileHeader*)
+                                      file.getData();
+    if(file.getSize() < sizeof(ProgramFileHeader) ||
+       memcmp(header->magic, PROGRAM_FILE_MAGIC, sizeof(header->magic)) != 0
+       || header->key != key ||
+       sizeof(ProgramFileHeader) + header->length != file.getSize())
+    {
+        file.close();
+        remove(path.c_str());
+        return 0;
+    }
+    
+    uint32_t program = glCreateProgram();
+    glProgramBinary(program, header->format,
+                    file.getData() + sizeof(ProgramFileHeader),
+                    header->length);
+    file.close();
+    GLint res = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &res);
+    if(res != GL_TRUE) {
+        // The driver has changed without changing its version strings
+        glDeleteProgram(program);
+        remove(path.c_str());
+        return 0;
+    }
+    return program;
+}
+
+/**
+ * @brief Saves the binary of a linked program
+ * 
+ * The program must have been linked with the binary retrievable hint.
+ * 
+ * @param key Key of the program
+ * @param program Shader program ID
+ * 
+ * @return True if the file is written
+ */
+bool ProgramCache::store(uint64_t key, uint32_t program) {
+    if(!isSupported())
+        return false;
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if(length <= 0)
+        return false;
+    
+    std::vector<char> data(sizeof(ProgramFileHeader) + length);
+    ProgramFileHeader header;
+    memcpy(header.magic, PROGRAM_FILE_MAGIC, sizeof(header.magic));
+    header.key = key;
+    GLenum format = 0;
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &format,
+                       data.data() + sizeof(ProgramFileHeader));
+    if(written <= 0)
+        return false;
+    header.format = format;
+    header.length = written;
+    memcpy(data.data(), &header, sizeof(header));
+    size_t size = sizeof(ProgramFileHeader) + written;
+    
+    // Several processes may store the same program at once
+    makeDirectories(getDirectory());
+    std::string path = getProgramFile(key);
+    size_t id = std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+                std::chrono::steady_clock::now().time_since_epoch().count();
+    std::string tmp = path + ".tmp" + std::to_string(id);
+    FILE* fp = fopen(tmp.c_str(), "wb");
+    if(!fp)
+        return false;
+    bool ok = fwrite(data.data(), 1, size, fp) == size;
+    ok = (fclose(fp) == 0) && ok;
+    
+    #ifdef _WIN32
+    // Renaming does not replace an existing file on Windows
+    if(ok)
+        remove(path.c_str());
+    #endif
+    if(!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+        remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+}}
@@ -0,0 +1,682 @@
+/**
+ * @file scene_bvh.cpp
+ * @brief Bounding volume hierarchy over the 3D objects of a context
+ * 
+ * A dynamic tree of the world-space bounding boxes of the 3D objects. The
+ * render passes visit the objects in a view volume and the ray queries the
+ * objects along a ray without walking the whole object list.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#define RMG_EXPORT
+
+
+#include "../rmg/internal/scene_bvh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "../rmg/object3d.hpp"
+#include "../rmg/internal/parallel_for.hpp"
+#include "../rmg/internal/vbo_load.hpp"
+
+
+#define BVH_NONE UINT32_MAX
+#define BVH_REBUILD_RATIO 1.5f ///< Cost growth rebuilding the tree
+#define BVH_PARALLEL_GRAIN 4096 ///< Least objects to build on a thread
+#define BVH_PARALLEL_DEPTH 3 ///< Levels building the halves in parallel
+
+
+static float getArea(const rmg::BoundingBox &box) {
+    if(box.isEmpty())
+        return 0;
+    rmg::Vec3 d = box.max - box.min;
+    return d.x*d.y + d.y*d.z + d.z*d.x;
+}
+
+
+static rmg::BoundingBox getUnion(const rmg::BoundingBox &a,
+                                 const rmg::BoundingBox &b)
+{
+    rmg::BoundingBox box = a;
+    box.extend(b);
+    return box;
+}
+
+
+static rmg::BoundingBox getWorldBounds(const rmg::Object3D *obj) {
+    const rmg::internal::VBO *vbo = obj->getVBO();
+    if(vbo == nullptr)
+        return rmg::BoundingBox();
+    return vbo->getBoundingBox().transform(obj->getModelMatrix());
+}
+
+
+static bool isUploaded(const rmg::Object3D *obj) {
+    const rmg::internal::VBO *vbo = obj->getVBO();
+    return vbo != nullptr && vbo->getArena() != nullptr;
+}
+
+
+namespace rmg {
+namespace internal {
+
+/**
+ * @brief Default constructor
+ */
+SceneBVH::SceneBVH() {
+    root = BVH_NONE;
+    leafCount = 0;
+    quality = BVHQuality::Medium;
+    areaSum = 0;
+    builtCost = 0;
+    revision = 0;
+}
+
+/**
+ * @brief Destructor
+ */
+SceneBVH::~SceneBVH() { clear(); }
+
+/**
+ * @brief Move constructor
+ * 
+ * The objects of the source tree are moved to this tree.
+ * 
+ * @param bvh Source
+ */
+SceneBVH::SceneBVH(SceneBVH&& bvh) noexcept
+         :nodes(std::move(bvh.nodes)),
+          freeNodes(std::move(bvh.freeNodes)),
+          proxies(std::move(bvh.proxies)),
+          freeProxies(std::move(bvh.freeProxies)),
+          dirty(std::move(bvh.dirty)),
+          uploads(std::move(bvh.uploads))
+{
+    root = bvh.root;
+    leafCount = bvh.leafCount;
+    quality = bvh.quality;
+    areaSum = bvh.areaSum;
+    builtCost = bvh.builtCost;
+    revision = bvh.revision;
+    for(auto it=proxies.begin(); it!=proxies.end(); it++) {
+        if(it->object != nullptr)
+            it->object->bvh = this;
+    }
+    bvh.clear();
+}
+
+/**
+ * @brief Adds a 3D object to the tree
+ * 
+ * The object is placed in the tree by the next update.
+ * 
+ * @param obj 3D object
+ */
+void SceneBVH::insert(Object3D* obj) {
+    if(obj->bvh != nullptr)
+        obj->bvh->remove(obj);
+    uint32_t id;
+    if(freeProxies.empty()) {
+        id = proxies.size();
+        proxies.push_back(Proxy());
+    }
+    else {
+        id = freeProxies.back();
+        freeProxies.pop_back();
+    }
+    Proxy &proxy = proxies[id];
+    proxy.object = obj;
+    proxy.box = BoundingBox();
+    proxy.node = BVH_NONE;
+    proxy.dirty = false;
+    proxy.uploading = false;
+    obj->bvh = this;
+    obj->bvhProxy = id;
+    markDirty(id);
+}
+
+/**
+ * @brief Removes a 3D object from the tree
+ * 
+ * @param obj 3D object
+ */
+void SceneBVH::remove(Object3D* obj) {
+    if(obj->bvh != this)
+        return;
+    uint32_t id = obj->bvhProxy;
+    if(proxies[id].node != BVH_NONE)
+        removeLeaf(id);
+    proxies[id].object = nullptr;
+    freeProxies.push_back(id);
+    obj->bvh = nullptr;
+    revision++;
+}
+
+/**
+ * @brief Marks the bounds of an object to be refitted by the next
+ *        update
+ * 
+ * @param proxy Handle of the object in the tree
+ */
+void SceneBVH::markDirty(uint32_t proxy) {
+    if(proxies[proxy].dirty)
+        return;
+    proxies[proxy].dirty = true;
+    dirty.push_back(proxy);
+}
+
+/**
+ * @brief Refits the objects marked dirty
+ * 
+ * Rebuilds the tree if it has become notably worse than its last
+ * build.
+ */
+void SceneBVH::update() {
+    // The results drawn before an upload are missing the object
+    size_t count = 0;
+    for(auto it=uploads.begin(); it!=uploads.end(); it++) {
+        Proxy &proxy = proxies[*it];
+        if(proxy.object == nullptr || !proxy.uploading)
+            continue;
+        if(!isUploaded(proxy.object)) {
+            uploads[count++] = *it;
+            continue;
+        }
+        proxy.uploading = false;
+        revision++;
+    }
+    uploads.resize(count);
+    
+    std::vector<uint32_t> pending;
+    std::vector<uint32_t> added;
+    for(auto it=dirty.begin(); it!=dirty.end(); it++) {
+        Proxy &proxy = proxies[*it];
+        if(proxy.object == nullptr || !proxy.dirty)
+            continue;
+        proxy.dirty = false;
+        proxy.box = getWorldBounds(proxy.object);
+        if(proxy.box.isEmpty()) {
+            // Waits for the mesh to load
+            if(proxy.node != BVH_NONE) {
+                removeLeaf(*it);
+                revision++;
+            }
+            proxy.dirty = true;
+            pending.push_back(*it);
+        }
+        else if(proxy.node == BVH_NONE) {
+            added.push_back(*it);
+        }
+        else {
+            nodes[proxy.node].box = proxy.box;
+            refit(nodes[proxy.node].parent);
+        }
+        if(!proxy.box.isEmpty() && !proxy.uploading &&
+           !isUploaded(proxy.object))
+        {
+            proxy.uploading = true;
+            uploads.push_back(*it);
+        }
+    }
+    if(dirty.size() > pending.size())
+        revision++;
+    dirty.swap(pending);
+    
+    // A large batch of objects builds a better tree from scratch
+    if(added.size() * 2 > leafCount + added.size()) {
+        rebuild();
+        return;
+    }
+    for(auto it=added.begin(); it!=added.end(); it++)
+        insertLeaf(*it);
+    if(getCost() > builtCost * BVH_REBUILD_RATIO)
+        rebuild();
+}
+
+/**
+ * @brief Builds the tree again from the bounds of all the objects
+ */
+void SceneBVH::rebuild() {
+    std::vector<uint32_t> items;
+    for(uint32_t i=0; i<proxies.size(); i++) {
+        proxies[i].node = BVH_NONE;
+        if(proxies[i].object != nullptr && !proxies[i].box.isEmpty())
+            items.push_back(i);
+    }
+    nodes.clear();
+    freeNodes.clear();
+    leafCount = items.size();
+    areaSum = 0;
+    if(items.empty()) {
+        root = BVH_NONE;
+        builtCost = 0;
+        return;
+    }
+    
+    // A subtree of n leaves takes 2n-1 consecutive nodes so that the
+    // halves are built in parallel without sharing the node array
+    nodes.resize(items.size() * 2 - 1);
+    root = 0;
+    build(0, BVH_NONE, &items[0], items.size(), 0);
+    for(auto it=nodes.begin(); it!=nodes.end(); it++) {
+        if(it->proxy == BVH_NONE)
+            areaSum += getArea(it->box);
+    }
+    builtCost = getCost();
+}
+
+/**
+ * @brief Removes all the objects from the tree
+ */
+void SceneBVH::clear() {
+    for(auto it=proxies.begin(); it!=proxies.end(); it++) {
+        if(it->object != nullptr)
+            it->object->bvh = nullptr;
+    }
+    nodes.clear();
+    freeNodes.clear();
+    proxies.clear();
+    freeProxies.clear();
+    dirty.clear();
+    uploads.clear();
+    root = BVH_NONE;
+    leafCount = 0;
+    areaSum = 0;
+    builtCost = 0;
+    revision++;
+}
+
+/**
+ * @brief Sets the quality of the rebuilds
+ * 
+ * @param q Build quality
+ */
+void SceneBVH::setQuality(BVHQuality q) { quality = q; }
+
+/**
+ * @brief Gets the quality of the rebuilds
+ * 
+ * @return Build quality
+ */
+BVHQuality SceneBVH::getQuality() const { return quality; }
+
+/**
+ * @brief Gets the number of objects placed in the tree
+ * 
+ * @return Number of leaves
+ */
+uint32_t SceneBVH::getObjectCount() const { return leafCount; }
+
+/**
+ * @brief Gets the bounds of all the objects in the tree
+ * 
+ * @return Bounding box of the root or an empty box
+ */
+BoundingBox SceneBVH::getBounds() const {
+    if(root == BVH_NONE)
+        return BoundingBox();
+    return nodes[root].box;
+}
+
+/**
+ * @brief Gets the number of changes made to the objects of the tree
+ * 
+ * Changes when an object is added, removed, moved, reshaped or hidden so
+ * that the results drawn from the tree can be kept while it stays the
+ * same.
+ * 
+ * @return Revision of the tree
+ */
+uint64_t SceneBVH::getRevision() const { return revision; }
+
+/**
+ * @brief Gets the expected cost of a query
+ * 
+ * The sum of the surface areas of the inner nodes relative to the
+ * root, which is the number of nodes a random ray visits on average.
+ * 
+ * @return Surface area heuristic cost
+ */
+float SceneBVH::getCost() const {
+    if(root == BVH_NONE)
+        return 0;
+    float area = getArea(nodes[root].box);
+    if(area == 0)
+        return 0;
+    return (float)(areaSum / area);
+}
+
+/**
+ * @brief Visits the objects whose bounds intersect a view volume
+ * 
+ * @param frustum View volume in world space
+ * @param func Function called for each object
+ */
+void SceneBVH::query(const Frustum &frustum,
+                     const std::function<void(Object3D*)> &func) const
+{
+    if(root == BVH_NONE)
+        return;
+    // The planes a box lies inside are not tested for its children
+    std::vector<std::pair<uint32_t,uint8_t>> stack;
+    stack.push_back(std::make_pair(root, (uint8_t) 0x3f));
+    while(!stack.empty()) {
+        uint32_t index = stack.back().first;
+        uint8_t mask = stack.back().second;
+        stack.pop_back();
+        const Node &node = nodes[index];
+        bool outside = false;
+        for(int i=0; i<6 && !outside; i++) {
+            if(!(mask & (1 << i)))
+                continue;
+            const Vec4 &p = frustum.planes[i];
+            float outer = p.w, inner = p.w;
+            for(int j=0; j<3; j++) {
+                float a = p[j] * node.box.min[j];
+                float b = p[j] * node.box.max[j];
+                outer += std::max(a, b);
+                inner += std::min(a, b);
+            }
+            if(outer < 0)
+                outside = true;
+            else if(inner >= 0)
+                mask &= ~(1 << i);
+        }
+        if(outside)
+            continue;
+        if(node.proxy != BVH_NONE) {
+            func(proxies[node.proxy].object);
+            continue;
+        }
+        stack.push_back(std::make_pair(node.children[0], mask));
+        stack.push_back(std::make_pair(node.children[1], mask));
+    }
+}
+
+/**
+ * @brief Visits the objects whose bounds a ray passes through
+ * 
+ * The objects are visited from the nearest bounding box on. The
+ * function tests the object and returns the distance of the hit to
+ * stop looking further than that, or the given limit otherwise. The
+ * distances are in the units of the direction vector of the ray.
+ * 
+ * @param ray Ray starting from its initial point
+ * @param maxDistance Limit of the distance along the ray
+ * @param func Function called with the object and the distance to its
+ *             bounding box
+ */
+void SceneBVH::raycast(
+    const LineEq &ray,
+    float maxDistance,
+    const std::function<float(Object3D*,float)> &func) const
+{
+    if(root == BVH_NONE)
+        return;
+    Vec3 inverse = Vec3(1/ray.v.x, 1/ray.v.y, 1/ray.v.z);
+    
+    // Distance where the ray enters a box or infinity if it misses
+    auto enter = [&](const BoundingBox &box) {
+        float t0 = 0, t1 = maxDistance;
+        for(int i=0; i<3; i++) {
+            float a = (box.min[i] - ray.P[i]) * inverse[i];
+            float b = (box.max[i] - ray.P[i]) * inverse[i];
+            if(std::isnan(a) || std::isnan(b))
+                continue; // Parallel to the slab and on its plane
+            t0 = std::max(t0, std::min(a, b));
+            t1 = std::min(t1, std::max(a, b));
+        }
+        return (t0 <= t1) ? t0 : INFINITY;
+    };
+    
+    std::vector<std::pair<uint32_t,float>> stack;
+    float t = enter(nodes[root].box);
+    if(t != INFINITY)
+        stack.push_back(std::make_pair(root, t));
+    while(!stack.empty()) {
+        uint32_t index = stack.back().first;
+        t = stack.back().second;
+        stack.pop_back();
+        if(t > maxDistance)
+            continue;
+        const Node &node = nodes[index];
+        if(node.proxy != BVH_NONE) {
+            maxDistance = std::min(maxDistance,
+                                   func(proxies[node.proxy].object, t));
+            continue;
+        }
+        // The nearer child is popped first
+        uint32_t a = node.children[0];
+        uint32_t b = node.children[1];
+        float ta = enter(nodes[a].box);
+        float tb = enter(nodes[b].box);
+        if(ta < tb) {
+            std::swap(a, b);
+            std::swap(ta, tb);
+        }
+        if(ta != INFINITY)
+            stack.push_back(std::make_pair(a, ta));
+        if(tb != INFINITY)
+            stack.push_back(std::make_pair(b, tb));
+    }
+}
+
+
+uint32_t SceneBVH::allocateNode() {
+    if(freeNodes.empty()) {
+        nodes.push_back(Node());
+        return nodes.size() - 1;
+    }
+    uint32_t index = freeNodes.back();
+    freeNodes.pop_back();
+    return index;
+}
+
+
+void SceneBVH::insertLeaf(uint32_t proxy) {
+    const BoundingBox &box = proxies[proxy].box;
+    uint32_t leaf = allocateNode();
+    nodes[leaf].box = box;
+    nodes[leaf].parent = BVH_NONE;
+    nodes[leaf].proxy = proxy;
+    proxies[proxy].node = leaf;
+    leafCount++;
+    if(root == BVH_NONE) {
+        root = leaf;
+        return;
+    }
+    
+    // Descends to the sibling adding the least surface area
+    uint32_t index = root;
+    while(nodes[index].proxy == BVH_NONE) {
+        const Node &node = nodes[index];
+        float area = getArea(node.box);
+        float combined = getArea(getUnion(node.box, box));
+        float cost = 2 * combined;
+        float inherited = 2 * (combined - area);
+        float childCost[2];
+        for(int i=0; i<2; i++) {
+            const Node &child = nodes[node.children[i]];
+            childCost[i] = getArea(getUnion(child.box, box)) + inherited;
+            if(child.proxy == BVH_NONE)
+                childCost[i] -= getArea(child.box);
+        }
+        if(cost < childCost[0] && cost < childCost[1])
+            break;
+        index = node.children[childCost[0] < childCost[1] ? 0 : 1];
+    }
+    
+    uint32_t sibling = index;
+    uint32_t oldParent = nodes[sibling].parent;
+    uint32_t parent = allocateNode();
+    nodes[parent].parent = oldParent;
+    nodes[parent].children[0] = sibling;
+    nodes[parent].children[1] = leaf;
+    nodes[parent].proxy = BVH_NONE;
+    nodes[parent].box = BoundingBox();
+    nodes[sibling].parent = parent;
+    nodes[leaf].parent = parent;
+    if(oldParent == BVH_NONE) {
+        root = parent;
+    }
+    else {
+        Node &p = nodes[oldParent];
+        p.children[p.children[0] == sibling ? 0 : 1] = parent;
+    }
+    refit(parent);
+}
+
+
+void SceneBVH::removeLeaf(uint32_t proxy) {
+    uint32_t leaf = proxies[proxy].node;
+    proxies[proxy].node = BVH_NONE;
+    freeNodes.push_back(leaf);
+    leafCount--;
+    if(leaf == root) {
+        root = BVH_NONE;
+        return;
+    }
+    
+    // The sibling takes the place of the parent
+    uint32_t parent = nodes[leaf].parent;
+    const Node &p = nodes[parent];
+    uint32_t sibling = p.children[p.children[0] == leaf ? 1 : 0];
+    uint32_t grandParent = p.parent;
+    areaSum -= getArea(p.box);
+    freeNodes.push_back(parent);
+    nodes[sibling].parent = grandParent;
+    if(grandParent == BVH_NONE) {
+        root = sibling;
+        return;
+    }
+    Node &g = nodes[grandParent];
+    g.children[g.children[0] == parent ? 0 : 1] = sibling;
+    refit(grandParent);
+}
+
+
+void SceneBVH::refit(uint32_t index) {
+    while(index != BVH_NONE) {
+        Node &node = nodes[index];
+        BoundingBox box = getUnion(nodes[node.children[0]].box,
+                                   nodes[node.children[1]].box);
+        if(box.min == node.box.min && box.max == node.box.max)
+            return;
+        areaSum += getArea(box) - getArea(node.box);
+        node.box = box;
+        index = node.parent;
+    }
+}
+
+
+void SceneBVH::build(uint32_t index, uint32_t parent, uint32_t *items,
+                     uint32_t count, int depth)
+{
+    Node &node = nodes[index];
+    node.parent = parent;
+    if(count == 1) {
+        node.box = proxies[items[0]].box;
+        node.proxy = items[0];
+        proxies[items[0]].node = index;
+        return;
+    }
+    uint32_t mid = split(items, count);
+    uint32_t left = index + 1;
+    uint32_t right = index + 2*mid;
+    if(count >= BVH_PARALLEL_GRAIN && depth < BVH_PARALLEL_DEPTH) {
+        parallelFor(2, 1, [&](size_t b, size_t e) {
+            for(size_t i=b; i<e; i++) {
+                if(i == 0)
+                    build(left, index, items, mid, depth + 1);
+                else
+                    build(right, index, items + mid, count - mid, depth + 1);
+            }
+        });
+    }
+    else {
+        build(left, index, items, mid, depth + 1);
+        build(right, index, items + mid, count - mid, depth + 1);
+    }
+    node.children[0] = left;
+    node.children[1] = right;
+    node.proxy = BVH_NONE;
+    node.box = getUnion(nodes[left].box, nodes[right].box);
+}
+
+
+uint32_t SceneBVH::split(uint32_t *items, uint32_t count) const {
+    BoundingBox centers;
+    for(uint32_t i=0; i<count; i++)
+        centers.extend(proxies[items[i]].box.getCenter());
+    Vec3 extent = centers.max - centers.min;
+    int axis = 0;
+    if(extent.y > extent[axis])
+        axis = 1;
+    if(extent.z > extent[axis])
+        axis = 2;
+    
+    auto getCenter = [&](uint32_t item) {
+        const BoundingBox &box = proxies[item].box;
+        return (box.min[axis] + box.max[axis]) / 2;
+    };
+    auto medianSplit = [&]() {
+        uint32_t mid = count / 2;
+        std::nth_element(items, items + mid, items + count,
+                         [&](uint32_t a, uint32_t b) {
+            return getCenter(a) < getCenter(b);
+        });
+        return mid;
+    };
+    if(quality == BVHQuality::Fast || extent[axis] <= 0)
+        return medianSplit();
+    
+    // Sweeps the bins for the split of the least surface area cost
+    const int binCount = (quality == BVHQuality::High) ? 32 : 8;
+    BoundingBox bins[32];
+    uint32_t counts[32] = {};
+    float scale = binCount / extent[axis];
+    auto getBin = [&](uint32_t item) {
+        int b = (int)((getCenter(item) - centers.min[axis]) * scale);
+        return std::min(std::max(b, 0), binCount - 1);
+    };
+    for(uint32_t i=0; i<count; i++) {
+        int b = getBin(items[i]);
+        bins[b].extend(proxies[items[i]].box);
+        counts[b]++;
+    }
+    float rightCost[32];
+    BoundingBox box;
+    uint32_t n = 0;
+    for(int b=binCount-1; b>0; b--) {
+        box.extend(bins[b]);
+        n += counts[b];
+        rightCost[b] = getArea(box) * n;
+    }
+    box = BoundingBox();
+    n = 0;
+    int best = 0;
+    float bestCost = INFINITY;
+    for(int b=0; b<binCount-1; b++) {
+        box.extend(bins[b]);
+        n += counts[b];
+        float cost = getArea(box) * n + rightCost[b+1];
+        if(cost < bestCost) {
+            bestCost = cost;
+            best = b;
+        }
+    }
+    uint32_t *mid = std::partition(items, items + count, [&](uint32_t item) {
+        return getBin(item) <= best;
+    });
+    if(mid == items || mid == items + count)
+        return medianSplit();
+    return mid - items;
+}
+
+}}
@@ -17,9 +17,100 @@
 #include "../rmg/internal/shader.hpp"
 
 #include <cstdio>
-#include <cstdlib>
+#include <cstring>
+#include <string>
 
+#include "../../config/rmg/config.h"
 #include "../rmg/assert.hpp"
+#include "../rmg/internal/program_cache.hpp"
+
+
+#ifdef RMG_EMBED_SHADERS
+namespace {
+
+struct EmbeddedShader {
+    const char* name;
+    const char* source;
+};
+
+// Generated from share/shaders by the build
+#include "shader_sources.inc"
+
+}
+#endif
+
+
+// The shaders under the resource path are taken from the library itself
+// when they are embedded in it
+static bool readShaderSource(const char* path, std::string &content) {
+    #ifdef RMG_EMBED_SHADERS
+    const char* dir = RMG_RESOURCE_PATH "/shaders/";
+    size_t len = strlen(dir);
+    if(strncmp(path, dir, len) == 0) {
+        for(const EmbeddedShader *e=embeddedShaders; e->name; e++) {
+            if(strcmp(path + len, e->name) == 0) {
+                content = e->source;
+                return true;
+            }
+        }
+    }
+    #endif
+    
+    FILE *fp = fopen(path, "rb");
+    if(fp == nullptr) {
+        #ifdef _WIN32
+        printf("error: Shader file '%s' could not be opened\n", path);
+        #else
+        printf("\033[0;1;31merror:\033[0m "
+               "Shader file '%s' could not be opened\n",
+               path);
+        #endif
+        return false;
+    }
+    content.clear();
+    char buffer[4096];
+    size_t n;
+    while((n = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+        content.append(buffer, n);
+    fclose(fp);
+    return true;
+}
+
+
+// Hands the source to the driver without waiting for the result
+static uint32_t submitShader(uint32_t type, const std::string &content,
+                             const char* defines)
+{
+    // The definitions go right after the version line
+    size_t split = 0;
+    if(defines != nullptr && content.compare(0, 8, "#version") == 0) {
+        split = content.find('\n');
+        split = (split == std::string::npos) ? content.size() : split + 1;
+    }
+    std::string version = content.substr(0, split);
+    char const* sources[3] = {
+        version.c_str(),
+        (defines != nullptr) ? defines : "",
+        content.c_str() + split
+    };
+    uint32_t shaderID = rmg::internal::glCreateShader(type);
+    rmg::internal::glShaderSource(shaderID, 3, sources, NULL);
+    rmg::internal::glCompileShader(shaderID);
+    return shaderID;
+}
+
+
+static void printShaderLog(uint32_t shaderID) {
+    int infoLogLength = 0;
+    rmg::internal::glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH,
+                                 &infoLogLength);
+    if(infoLogLength > 1) {
+        std::string message = std::string(infoLogLength, '\0');
+        rmg::internal::glGetShaderInfoLog(shaderID, infoLogLength, NULL,
+                                          &message[0]);
+        printf("%s\n", message.c_str());
+    }
+}
 
 
 namespace rmg {
@@ -38,60 +129,30 @@ Shader::~Shader() {
  * 
  * @param type Shader type (GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, .etc)
  * @param path Path to shader file
+ * @param defines Preprocessor definitions inserted after the version
+ *                line or null
  * 
  * @return ID of the compiled shader used to retrive it
  */
-uint32_t Shader::compileShader(uint32_t type, const char* path)
+uint32_t Shader::compileShader(uint32_t type, const char* path,
+                               const char* defines)
 {
     if(type != GL_VERTEX_SHADER && type != GL_FRAGMENT_SHADER) {
         RMG_EXPECT(type == GL_VERTEX_SHADER || type == GL_FRAGMENT_SHADER);
         return 0;
     }
-    
-    uint32_t shaderID = glCreateShader(type);
-    
-    // Opens the file
-    FILE *fp = fopen(path, "r");
-    if(fp == nullptr) {
-        #ifdef _WIN32
-        printf("error: Shader file '%s' could not be opened\n", path);
-        #else
-        printf("\033[0;1;31merror:\033[0m "
-               "Shader file '%s' could not be opened\n",
-               path);
-        #endif
+    std::string content;
+    if(!readShaderSource(path, content))
         return 0;
-    }
-    
-    // Reads the file
-    char fileContent[65536];
-    int i = 0;
-    char ch = getc(fp);
-    while(ch != EOF && i < 65535) {
-        fileContent[i] = ch;
-        ch = getc(fp);
-        i++;
-    }
-    fileContent[i] = '\0';
-    fclose(fp);
     
-    // Compiles the shader
+    uint32_t shaderID = submitShader(type, content, defines);
     GLint res = GL_FALSE;
-    int infoLogLength;
-    char const* ptr = fileContent;
-    glShaderSource(shaderID, 1, &ptr, NULL);
-    glCompileShader(shaderID);
-    
-    // Checks the shader
     glGetShaderiv(shaderID, GL_COMPILE_STATUS, &res);
-    glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &infoLogLength);
-    if(infoLogLength > 0) {
-        char *message = (char*) malloc(infoLogLength+1);
-        glGetShaderInfoLog(shaderID, infoLogLength, NULL, message);
-        printf("%s\n", message);
+    printShaderLog(shaderID);
+    if(res != GL_TRUE) {
+        glDeleteShader(shaderID);
         return 0;
     }
-    
     return shaderID;
 }
 
@@ -100,45 +161,126 @@ uint32_t Shader::compileShader(uint32_t type, const char* path)
  * 
  * @param vert Vertex shader file
  * @param frag Fragment shader file
+ * @param defines Preprocessor definitions for both shaders or null
  * 
  * @return Shader program ID
  */
-uint32_t Shader::compileShaderProgram(const char* vert, const char* frag)
+uint32_t Shader::compileShaderProgram(const char* vert, const char* frag,
+                                      const char* defines)
 {
-    uint32_t vertexShaderID = compileShader(GL_VERTEX_SHADER, vert);
-    uint32_t fragmentShaderID = compileShader(GL_FRAGMENT_SHADER, frag);
-    if(vertexShaderID == 0 || fragmentShaderID == 0) {
-        if(vertexShaderID != 0)
-            glDeleteShader(vertexShaderID);
-        if(fragmentShaderID != 0)
-            glDeleteShader(fragmentShaderID);
-        return 0;
+    return finishShaderProgram(beginShaderProgram(vert, frag, defines));
+}
+
+/**
+ * @brief Starts compiling and linking a shader program
+ * 
+ * Loads the program from the program cache if it is there. Otherwise
+ * the shaders are handed to the driver without waiting for them, so
+ * the driver can work on several programs at once if it compiles in
+ * parallel.
+ * 
+ * @param vert Vertex shader file
+ * @param frag Fragment shader file
+ * @param defines Preprocessor definitions for both shaders or null
+ * 
+ * @return Program to be finished by finishShaderProgram()
+ */
+ShaderProgramBuild Shader::beginShaderProgram(const char* vert,
+                                              const char* frag,
+                                              const char* defines)
+{
+    ShaderProgramBuild build;
+    std::string vertSource, fragSource;
+    if(!readShaderSource(vert, vertSource) ||
+       !readShaderSource(frag, fragSource))
+    {
+        return build;
     }
+    build.key = ProgramCache::getKey(vertSource, fragSource, defines);
+    build.program = ProgramCache::load(build.key);
+    if(build.program != 0)
+        return build;
     
-    // Link the program
-    uint32_t programID = glCreateProgram();
-    glAttachShader(programID, vertexShaderID);
-    glAttachShader(programID, fragmentShaderID);
-    glLinkProgram(programID);
+    // The program is linked right away as the link status is the first
+    // thing waited for
+    build.vertexShader = submitShader(GL_VERTEX_SHADER, vertSource,
+                                      defines);
+    build.fragmentShader = submitShader(GL_FRAGMENT_SHADER, fragSource,
+                                        defines);
+    build.program = glCreateProgram();
+    glAttachShader(build.program, build.vertexShader);
+    glAttachShader(build.program, build.fragmentShader);
+    if(ProgramCache::isSupported()) {
+        glProgramParameteri(build.program,
+                            GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(build.program);
+    return build;
+}
+
+/**
+ * @brief Waits for a shader program to be linked
+ * 
+ * Prints the errors of the shaders and stores the linked program in
+ * the program cache.
+ * 
+ * @param build Program started by beginShaderProgram()
+ * 
+ * @return Shader program ID or zero if it has failed
+ */
+uint32_t Shader::finishShaderProgram(const ShaderProgramBuild &build) {
+    // Loaded from the cache or failed to read the files
+    if(build.vertexShader == 0)
+        return build.program;
     
-    // Check the program
     GLint res = GL_FALSE;
     int infoLogLength;
-    glGetProgramiv(programID, GL_LINK_STATUS, &res);
-    glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &infoLogLength);
-    if(infoLogLength > 0) {
-        char *message = (char*) malloc(infoLogLength+1);
-        glGetProgramInfoLog(programID, infoLogLength, NULL, message);
-        printf("%s\n", message);
-        return 0;
+    glGetProgramiv(build.program, GL_LINK_STATUS, &res);
+    printShaderLog(build.vertexShader);
+    printShaderLog(build.fragmentShader);
+    glGetProgramiv(build.program, GL_INFO_LOG_LENGTH, &infoLogLength);
+    if(infoLogLength > 1) {
+        std::string message = std::string(infoLogLength, '\0');
+        glGetProgramInfoLog(build.program, infoLogLength, NULL, &message[0]);
+        printf("%s\n", message.c_str());
     }
     
-    glDetachShader(programID, vertexShaderID);
-    glDetachShader(programID, fragmentShaderID);
-    glDeleteShader(vertexShaderID);
-    glDeleteShader(fragmentShaderID);
+    glDetachShader(build.program, build.vertexShader);
+    glDetachShader(build.program, build.fragmentShader);
+    glDeleteShader(build.vertexShader);
+    glDeleteShader(build.fragmentShader);
+    if(res != GL_TRUE) {
+        glDeleteProgram(build.program);
+        return 0;
+    }
+    ProgramCache::store(build.key, build.program);
+    return build.program;
+}
 
-    return programID;
+/**
+ * @brief Lets the driver compile the shaders on its own threads
+ * 
+ * Only has effect if the current context has the extension
+ * KHR_parallel_shader_compile.
+ * 
+ * @return True if the extension is available
+ */
+bool Shader::enableParallelCompile() {
+    if(glMaxShaderCompilerThreadsKHR == NULL)
+        return false;
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for(GLint i=0; i<count; i++) {
+        const char* name = (const char*) glGetStringi(GL_EXTENSIONS, i);
+        if(name != nullptr &&
+           strcmp(name, "GL_KHR_parallel_shader_compile") == 0)
+        {
+            // As many threads as the driver likes
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+            return true;
+        }
+    }
+    return false;
 }
 
 }}
@@ -0,0 +1,186 @@
+/**
+ * @file shader_permutations.cpp
+ * @brief Programs compiled from the same shader files for each combination
+ *        of features
+ * 
+ * The features of a shader are turned on by preprocessor definitions
+ * instead of branches at runtime. A program is only compiled the first
+ * time its combination is asked for and then kept by the bit mask of its
+ * features.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#define RMG_EXPORT
+
+
+#include "../rmg/internal/shader_permutations.hpp"
+
+#include "../rmg/internal/glcontext.hpp"
+
+
+namespace rmg {
+namespace internal {
+
+/**
+ * @brief Constructor with the shader files and the feature names
+ * 
+ * @param vert Vertex shader file
+ * @param frag Fragment shader file
+ * @param feat Names defined by the bits of the keys
+ * @param uniforms Names of the uniforms located in every program
+ */
+ShaderPermutations::ShaderPermutations(
+    const char* vert,
+    const char* frag,
+    const std::vector<const char*> &feat,
+    const std::vector<const char*> &uniforms)
+{
+    vertPath = vert;
+    fragPath = frag;
+    features.assign(feat.begin(), feat.end());
+    uniformNames.assign(uniforms.begin(), uniforms.end());
+}
+
+/**
+ * @brief Destructor
+ */
+ShaderPermutations::~ShaderPermutations() { clear(); }
+
+/**
+ * @brief Copy constructor
+ * 
+ * The copy starts without compiled programs as they are owned by a single
+ * set.
+ * 
+ * @param p Source
+ */
+ShaderPermutations::ShaderPermutations(const ShaderPermutations& p) {
+    vertPath = p.vertPath;
+    fragPath = p.fragPath;
+    features = p.features;
+    uniformNames = p.uniformNames;
+    definitions = p.definitions;
+}
+
+/**
+ * @brief Copy assignment
+ * 
+ * Deletes the programs of this set. The copy starts without compiled
+ * programs as they are owned by a single set.
+ * 
+ * @param p Source
+ * 
+ * @return This set
+ */
+ShaderPermutations& ShaderPermutations::operator=(
+    const ShaderPermutations& p)
+{
+    if(this != &p) {
+        clear();
+        vertPath = p.vertPath;
+        fragPath = p.fragPath;
+        features = p.features;
+        uniformNames = p.uniformNames;
+        definitions = p.definitions;
+    }
+    return *this;
+}
+
+/**
+ * @brief Sets the definitions shared by all the programs
+ * 
+ * Deletes the compiled programs if the definitions are different.
+ * 
+ * @param defs Preprocessor definitions each ending with a new line
+ */
+void ShaderPermutations::setDefinitions(const std::string &defs) {
+    if(defs == definitions)
+        return;
+    clear();
+    definitions = defs;
+}
+
+/**
+ * @brief Starts compiling the program of a combination of features
+ * 
+ * The program is finished by the first get() of the key.
+ * 
+ * @param key Bit mask of the features
+ */
+void ShaderPermutations::prepare(uint32_t key) {
+    if(programs.count(key) > 0 || pending.count(key) > 0)
+        return;
+    std::string defs = getDefinitions(key);
+    pending[key] = Shader::beginShaderProgram(vertPath.c_str(),
+                                              fragPath.c_str(),
+                                              defs.c_str());
+}
+
+/**
+ * @brief Gets the program of a combination of features
+ * 
+ * Compiles the program if it is asked for the first time.
+ * 
+ * @param key Bit mask of the features
+ * 
+ * @return Program and its uniform locations
+ */
+const ShaderPermutation& ShaderPermutations::get(uint32_t key) {
+    auto it = programs.find(key);
+    if(it != programs.end())
+        return it->second;
+    
+    prepare(key);
+    auto build = pending.find(key);
+    ShaderPermutation &perm = programs[key];
+    perm.program = Shader::finishShaderProgram(build->second);
+    pending.erase(build);
+    perm.uniforms.resize(uniformNames.size(), -1);
+    if(perm.program != 0) {
+        for(size_t i=0; i<uniformNames.size(); i++) {
+            perm.uniforms[i] = glGetUniformLocation(perm.program,
+                                                    uniformNames[i].c_str());
+        }
+    }
+    return perm;
+}
+
+/**
+ * @brief Gets the number of programs compiled so far
+ * 
+ * @return Number of programs including the failed ones
+ */
+size_t ShaderPermutations::getProgramCount() const { return programs.size(); }
+
+/**
+ * @brief Deletes all the compiled programs
+ */
+void ShaderPermutations::clear() {
+    for(auto it=pending.begin(); it!=pending.end(); it++) {
+        uint32_t program = Shader::finishShaderProgram(it->second);
+        if(program != 0)
+            glDeleteProgram(program);
+    }
+    pending.clear();
+    for(auto it=programs.begin(); it!=programs.end(); it++) {
+        if(it->second.program != 0)
+            glDeleteProgram(it->second.program);
+    }
+    programs.clear();
+}
+
+
+std::string ShaderPermutations::getDefinitions(uint32_t key) const {
+    std::string defs = definitions;
+    for(size_t i=0; i<features.size(); i++) {
+        if(key & (1 << i))
+            defs += "#define " + features[i] + "\n";
+    }
+    return defs;
+}
+
+}}
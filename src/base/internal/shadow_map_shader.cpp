@@ -2,6 +2,11 @@
  * @file shadow_map_shader.hpp
  * @brief Generates an image representing the distance from sun at every pixel
  * 
+ * The view of the camera is split into slices by distance and each slice
+ * gets its own layer of the shadow map. The near slices are small so their
+ * shadows are sharp while the far ones cover much more ground with the
+ * same number of texels.
+ * 
  * @copyright Copyright (c) 2020 Khant Kyaw Khaung
  * 
  * @license{This project is released under the MIT License.}
@@ -13,13 +18,18 @@
 
 #include "../rmg/internal/shadow_map_shader.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 #include "../../config/rmg/config.h"
 #include "../rmg/object3d.hpp"
+#include "../rmg/internal/scene_bvh.hpp"
+#include "../rmg/math/frustum.hpp"
 
-#define SHADOW_COVERAGE 0.8f
-#define SHADOW_MAP_WIDTH 512
-#define SHADOW_MAP_HEIGHT 512
-#define SHADOW_MAP_ASPECT ((float)SHADOW_MAP_WIDTH/SHADOW_MAP_HEIGHT)
+#define SHADOW_MAP_RESOLUTION 1024 ///< Default size of a cascade
+#define SHADOW_CASCADE_COUNT 3 ///< Default number of cascades
+#define SHADOW_SPLIT_BLEND 0.75f ///< Logarithmic share of the split distances
+#define SHADOW_SLICE_TOLERANCE 0.02f ///< Slice move kept relative to its size
 
 
 namespace rmg {
@@ -29,19 +39,9 @@ namespace internal {
  * @brief Default constructor
  */
 ShadowMapShader::ShadowMapShader() {
-    shadowMapper.setAspectRatio(SHADOW_MAP_ASPECT);
-    shadowMapper.setOrthographicProjection();
-    shadowMapper.setMinimumDistance(0);
-    cameraPosition = Vec3(0, 0, 0);
-    cameraDirection = Vec3(1, 0, 0);
     lightDirection = Vec3(1, 0, 0);
-    nearDist = 1.0f;
-    farDist = 10.0f;
-    mapCenterDist = nearDist + SHADOW_COVERAGE * (farDist-nearDist)/2;
-    calculateShadowMapperTranslation();
-    shadowMapper.setFieldOfView(
-        SHADOW_MAP_ASPECT * SHADOW_COVERAGE * (farDist-nearDist)
-    );
+    resolution = SHADOW_MAP_RESOLUTION;
+    cascadeCount = SHADOW_CASCADE_COUNT;
 }
 
 /**
@@ -54,120 +54,73 @@ ShadowMapShader::~ShadowMapShader() {
         glDeleteTextures(1, &depthMap);
 }
 
-
-
-
-void ShadowMapShader::calculateShadowMapperTranslation() {
-    Vec3 pos =
-        cameraPosition + 
-        mapCenterDist * cameraDirection -
-        SHADOW_COVERAGE * (farDist-nearDist) * lightDirection;
-    
-    shadowMapper.setTranslation(pos);
-}
-
 /**
- * @brief Sets the camera position
- * 
- * Camera here means the world's camera. This function is used so that
- * the light's viewing point moves together with it.
+ * @brief Sets the directional light vector
  * 
- * @param x X-coordinate
- * @param y Y-coordinate
- * @param z Z-coordinate
+ * @param v Light direction
  */
-void ShadowMapShader::setCameraTranslation(float x, float y, float z) {
-    cameraPosition.x = x;
-    cameraPosition.y = y;
-    cameraPosition.z = z;
-    calculateShadowMapperTranslation();
+void ShadowMapShader::setDirectionalLightVector(Vec3 v) {
+    v = v.normalize();
+    if(v != lightDirection) {
+        lightDirection = v;
+        outdated = true;
+    }
 }
 
 /**
- * @brief Sets the camera position
- * 
- * Camera here means the world's camera. This function is used so that
- * the light's viewing point moves together with it.
+ * @brief Sets the width and height of each layer of the shadow map
  * 
- * @param p Position vector
+ * @param size Resolution in texels
  */
-void ShadowMapShader::setCameraTranslation(Vec3 p) {
-    cameraPosition = p;
-    calculateShadowMapperTranslation();
+void ShadowMapShader::setResolution(uint16_t size) {
+    if(size > 0 && size != resolution) {
+        resolution = size;
+        outdated = true;
+    }
 }
 
 /**
- * @brief Sets the camera rotation
- * 
- * Camera here means the world's camera. This function is used so that
- * the light's viewing direction moves together with it.
+ * @brief Gets the width and height of each layer of the shadow map
  * 
- * @param rot Euler angles
+ * @return Resolution in texels
  */
-void ShadowMapShader::setCameraRotation(Euler rot) {
-    cameraDirection = Vec3(Mat4(rot.toRotationMatrix()) * Vec4(1,0,0,0));
-    calculateShadowMapperTranslation();
-}
+uint16_t ShadowMapShader::getResolution() const { return resolution; }
 
 /**
- * @brief Sets minimum distance of the camera
+ * @brief Sets the number of slices the camera view is split into
  * 
- * @param n Minimum clipping distance
+ * @param n Number of cascades from 1 to RMG_SHADOW_CASCADE_MAX
  */
-void ShadowMapShader::setMinimumDistance(float n) {
-    nearDist = n;
-    mapCenterDist = n + SHADOW_COVERAGE * (farDist-n)/2;
-    calculateShadowMapperTranslation();
-    shadowMapper.setFieldOfView(
-        SHADOW_MAP_ASPECT * SHADOW_COVERAGE * (farDist-n)
-    );
-    shadowMapper.setMaximumDistance(2 * SHADOW_COVERAGE * (farDist-n));
+void ShadowMapShader::setCascadeCount(uint32_t n) {
+    n = std::min(std::max(n, 1u), (uint32_t)RMG_SHADOW_CASCADE_MAX);
+    if(n != cascadeCount) {
+        cascadeCount = n;
+        outdated = true;
+    }
 }
 
 /**
- * @brief Sets maximum distance of the camera
+ * @brief Gets the number of slices the camera view is split into
  * 
- * @param f Maximum clipping distance
+ * @return Number of cascades
  */
-void ShadowMapShader::setMaximumDistance(float f) {
-    farDist = f;
-    mapCenterDist = nearDist + SHADOW_COVERAGE * (f-nearDist)/2;
-    calculateShadowMapperTranslation();
-    shadowMapper.setFieldOfView(
-        SHADOW_MAP_ASPECT * SHADOW_COVERAGE * (f-nearDist)
-    );
-    shadowMapper.setMaximumDistance(2 * SHADOW_COVERAGE * (f-nearDist));
-}
+uint32_t ShadowMapShader::getCascadeCount() const { return cascadeCount; }
 
 /**
- * @brief Sets the directional light vector
- * 
- * Contributes the view matrix of the shadow mapper. The shadow mapper
- * is a camera that views the world from the light's position.
- * 
- * @param v Light direction
+ * @brief Makes the next call draw the shadow map again
  */
-void ShadowMapShader::setDirectionalLightVector(Vec3 v) {
-    float r = sqrt(v.x*v.x + v.y*v.y);
-    Euler rot;
-    rot.roll = 0;
-    rot.pitch = -atan(v.z/r);
-    rot.yaw = atan2(v.y, v.x);
-    shadowMapper.setRotation(rot);
-    lightDirection = v;
-    calculateShadowMapperTranslation();
-}
+void ShadowMapShader::invalidate() { outdated = true; }
 
 /**
- * @brief Gets the matrix to process shadow mapping
+ * @brief Gets the matrices to process shadow mapping
  * 
- * It is the composition of view and projection matrix from the position
- * of the light as a camera. Similar to the VP matrix of a normal camera.
+ * They are the compositions of view and projection matrix from the light
+ * for each cascade. Similar to the VP matrix of a normal camera.
  * 
- * @param v Light direction
+ * @return Shadow matrices from the nearest cascade
  */
-const Mat4& ShadowMapShader::getShadowMatrix() const {
-    return shadowMapper.getVPMatrix();
+const Mat4* ShadowMapShader::getShadowMatrices() const {
+    return shadowMatrices;
 }
 
 /**
@@ -181,33 +134,9 @@ void ShadowMapShader::load() {
     idMVP = glGetUniformLocation(id, "MVP");
     
     glGenTextures(1, &depthMap);
-    glBindTexture(GL_TEXTURE_2D, depthMap);
-    glTexImage2D(
-        GL_TEXTURE_2D,
-        0,
-        GL_DEPTH_COMPONENT,
-        SHADOW_MAP_WIDTH,
-        SHADOW_MAP_HEIGHT,
-        0,
-        GL_DEPTH_COMPONENT,
-        GL_FLOAT,
-        NULL
-    );
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER); 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    
+    allocate();
     glGenFramebuffers(1, &depthMapFBO);
     glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-    glFramebufferTexture2D(
-        GL_FRAMEBUFFER,
-        GL_DEPTH_ATTACHMENT,
-        GL_TEXTURE_2D,
-        depthMap,
-        0
-    );
     glDrawBuffer(GL_NONE);
     glReadBuffer(GL_NONE);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -216,20 +145,52 @@ void ShadowMapShader::load() {
 /**
  * @brief Generates the shadow map of the group of 3D objects
  * 
- * Renders depth image of the group of 3D objects which is then
- * used as the shadow map passing it to the general shader.
+ * Renders depth image of the group of 3D objects for each slice of the
+ * camera view which is then used as the shadow map passing it to the
+ * general shader.
+ * 
+ * The previous shadow map is kept unless the light, the settings or the
+ * objects of the tree have changed, or a slice of the camera view has
+ * moved more than a small part of its size.
  * 
- * @param list List of 3D objects
+ * @param camera Camera of the context
+ * @param bvh Bounding volume hierarchy of the 3D objects
  * 
- * @return Shadow map
+ * @return Shadow map as a texture array with a layer for each cascade
  */
-uint32_t ShadowMapShader::createShadowMap(const ObjectList &list) {
+uint32_t ShadowMapShader::createShadowMap(const Camera &camera,
+                                          const SceneBVH &bvh)
+{
     if(id == 0)
         return 0;
+    Vec3 centers[RMG_SHADOW_CASCADE_MAX];
+    float radii[RMG_SHADOW_CASCADE_MAX];
+    fitSlices(camera, centers, radii);
+    if(!outdated && bvh.getRevision() == sceneRevision) {
+        bool moved = false;
+        for(uint32_t i=0; i<cascadeCount; i++) {
+            float d = (centers[i] - sliceCenters[i]).magnitude();
+            if(radii[i] != sliceRadii[i] ||
+               d > SHADOW_SLICE_TOLERANCE * radii[i])
+            {
+                moved = true;
+            }
+        }
+        if(!moved)
+            return depthMap;
+    }
+    for(uint32_t i=0; i<cascadeCount; i++) {
+        sliceCenters[i] = centers[i];
+        sliceRadii[i] = radii[i];
+    }
+    sceneRevision = bvh.getRevision();
+    outdated = false;
+    
+    allocate();
+    fitCascades(bvh.getBounds());
     glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-    glViewport(0, 0, SHADOW_MAP_WIDTH, SHADOW_MAP_HEIGHT);
+    glViewport(0, 0, resolution, resolution);
     glClearDepth(1.0);
-    glClear(GL_DEPTH_BUFFER_BIT);
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LESS);
     glFrontFace(GL_CCW);
@@ -237,16 +198,153 @@ uint32_t ShadowMapShader::createShadowMap(const ObjectList &list) {
     glCullFace(GL_FRONT);
     glDisable(GL_BLEND);
     glUseProgram(id);
-    for(auto it=list.begin(); it!=list.end(); it++) {
-        Object3D *obj = (Object3D*) &(*it);
-        if(obj->isHidden() || obj->getVBO() == nullptr)
-            continue;
-        Mat4 MVP = shadowMapper.getVPMatrix() * obj->getModelMatrix();
-        glUniformMatrix4fv(idMVP, 1, GL_TRUE, &MVP[0][0]);
-        obj->getVBO()->draw();
+    for(uint32_t i=0; i<cascadeCount; i++) {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                  depthMap, 0, i);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        
+        // Each cascade only draws the casters inside its own box
+        const Mat4 &VP = shadowMatrices[i];
+        Frustum frustum = Frustum(VP);
+        bvh.query(frustum, [&](Object3D *obj) {
+            if(obj->isHidden() || obj->getVBO() == nullptr)
+                return;
+            const VBO *vbo = obj->getVBO();
+            Mat4 MVP = VP * obj->getModelMatrix() * vbo->getPositionMatrix();
+            glUniformMatrix4fv(idMVP, 1, GL_TRUE, &MVP[0][0]);
+            // The level chosen for the camera in the last frame
+            vbo->drawPositions(obj->getLOD());
+        });
     }
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     return depthMap;
 }
 
+
+void ShadowMapShader::allocate() {
+    if(mapResolution == resolution && mapCascadeCount == cascadeCount)
+        return;
+    glBindTexture(GL_TEXTURE_2D_ARRAY, depthMap);
+    glTexImage3D(
+        GL_TEXTURE_2D_ARRAY,
+        0,
+        GL_DEPTH_COMPONENT,
+        resolution,
+        resolution,
+        cascadeCount,
+        0,
+        GL_DEPTH_COMPONENT,
+        GL_FLOAT,
+        NULL
+    );
+    // Each lookup compares 4 texels against the depth and blends the results
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE,
+                    GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S,
+                    GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T,
+                    GL_CLAMP_TO_BORDER);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    mapResolution = resolution;
+    mapCascadeCount = cascadeCount;
+}
+
+
+void ShadowMapShader::fitSlices(const Camera &camera, Vec3 *centers,
+                                float *radii) const
+{
+    // Edges of the camera view from the near plane to the far plane
+    Mat4 inverse = camera.getVPMatrix().inverse();
+    auto unproject = [&](float x, float y, float z) {
+        Vec4 p = inverse * Vec4(x, y, z, 1);
+        return Vec3(p.x/p.w, p.y/p.w, p.z/p.w);
+    };
+    const float corners[4][2] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+    Vec3 nearCorners[4], farCorners[4];
+    for(int j=0; j<4; j++) {
+        nearCorners[j] = unproject(corners[j][0], corners[j][1], 0);
+        farCorners[j] = unproject(corners[j][0], corners[j][1], 1);
+    }
+    Vec3 origin = camera.getTranslation();
+    Vec3 forward = (unproject(0, 0, 1) - unproject(0, 0, 0)).normalize();
+    
+    // The splits blend the logarithmic and uniform distribution
+    float n = camera.getMinimumDistance();
+    float f = camera.getMaximumDistance();
+    float begin = n;
+    for(uint32_t i=0; i<cascadeCount; i++) {
+        float k = (float)(i + 1) / cascadeCount;
+        float end = n + (f - n) * k;
+        if(n > 0) {
+            end = SHADOW_SPLIT_BLEND * n * powf(f / n, k) +
+                  (1 - SHADOW_SPLIT_BLEND) * end;
+        }
+        Vec3 points[8];
+        Vec3 center = Vec3(0, 0, 0);
+        for(int j=0; j<4; j++) {
+            Vec3 edge = farCorners[j] - nearCorners[j];
+            float a = Vec3::dot(nearCorners[j] - origin, forward);
+            float b = Vec3::dot(farCorners[j] - origin, forward);
+            points[2*j] = nearCorners[j] + ((begin - a) / (b - a)) * edge;
+            points[2*j+1] = nearCorners[j] + ((end - a) / (b - a)) * edge;
+            center = center + points[2*j] + points[2*j+1];
+        }
+        centers[i] = center / 8;
+        
+        // A bounding sphere keeps the size of the box as the camera turns
+        float radius = 0;
+        for(int j=0; j<8; j++)
+            radius = std::max(radius, (points[j] - centers[i]).magnitude());
+        radii[i] = ceilf(radius * 16) / 16;
+        begin = end;
+    }
+}
+
+
+void ShadowMapShader::fitCascades(const BoundingBox &scene) {
+    // Axes of the light space
+    Vec3 dir = lightDirection;
+    Vec3 up = (fabs(dir.z) < 0.99f) ? Vec3(0, 0, 1) : Vec3(1, 0, 0);
+    Vec3 right = Vec3::cross(dir, up).normalize();
+    up = Vec3::cross(right, dir);
+    
+    // The casters between the sun and a slice are kept in its depth range
+    float sceneNear = INFINITY;
+    if(!scene.isEmpty()) {
+        for(int j=0; j<8; j++) {
+            Vec3 p = Vec3((j & 1) ? scene.max.x : scene.min.x,
+                          (j & 2) ? scene.max.y : scene.min.y,
+                          (j & 4) ? scene.max.z : scene.min.z);
+            sceneNear = std::min(sceneNear, Vec3::dot(dir, p));
+        }
+    }
+    
+    for(uint32_t i=0; i<cascadeCount; i++) {
+        const Vec3 &center = sliceCenters[i];
+        float radius = sliceRadii[i];
+        
+        // Moves the box by whole texels so that the shadow edges stay still
+        float texel = 2 * radius / resolution;
+        float x = floorf(Vec3::dot(right, center) / texel) * texel;
+        float y = floorf(Vec3::dot(up, center) / texel) * texel;
+        float zFar = Vec3::dot(dir, center) + radius;
+        float zNear = std::min(Vec3::dot(dir, center) - radius, sceneNear);
+        float depth = zFar - zNear;
+        
+        Mat4 &S = shadowMatrices[i];
+        S = Mat4();
+        for(int c=0; c<3; c++) {
+            S[0][c] = right[c] / radius;
+            S[1][c] = up[c] / radius;
+            S[2][c] = 2 * dir[c] / depth;
+        }
+        S[0][3] = -x / radius;
+        S[1][3] = -y / radius;
+        S[2][3] = -2 * zNear / depth - 1;
+    }
+}
+
 }}
@@ -25,15 +25,19 @@ namespace internal {
 /**
  * @brief Constructs a pending object
  * 
+ * The file is decoded later by prepare().
+ * 
  * @param tex Address to a Texture instance. This is to redirect 
  *            responses after loading.
  * @param f Path to texture file, folder or zip
  */
-SpriteLoad::SpriteLoad(SpriteTexture* tex, const char* f) {
+SpriteLoad::SpriteLoad(SpriteTexture* tex, const char* f)
+          :ContextLoad(false)
+{
     texture = tex;
-    bitmap = Bitmap::loadFromFile(f);
-    width = bitmap.getWidth();
-    height = bitmap.getHeight();
+    file = f;
+    width = 0;
+    height = 0;
 }
 
 /**
@@ -55,6 +59,17 @@ SpriteLoad::SpriteLoad(SpriteTexture* tex, const Bitmap& bmp) {
  */
 SpriteLoad::~SpriteLoad() {}
 
+/**
+ * @brief Decodes the image file
+ * 
+ * Runs on a worker thread of the context loader.
+ */
+void SpriteLoad::prepare() {
+    bitmap = Bitmap::loadFromFile(file.c_str());
+    width = bitmap.getWidth();
+    height = bitmap.getHeight();
+}
+
 /**
  * @brief Loads the texture data to the GPU
  * 
@@ -97,9 +112,21 @@ void SpriteLoad::load() {
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
+/**
+ * @brief Gets the number of bytes the load sends to the GPU
+ * 
+ * @return Upload size in bytes
+ */
+uint64_t SpriteLoad::getUploadSize() const {
+    return (uint64_t) bitmap.getWidth() * bitmap.getHeight() *
+           bitmap.getChannel();
+}
+
 /**
  * @brief Gets the width of the image
  * 
+ * Zero until the image file is decoded.
+ * 
  * @return Image width in pixels
  */
 uint16_t SpriteLoad::getWidth() const { return width; }
@@ -107,6 +134,8 @@ uint16_t SpriteLoad::getWidth() const { return width; }
 /**
  * @brief Gets the height of the image
  * 
+ * Zero until the image file is decoded.
+ * 
  * @return Image height in pixels
  */
 uint16_t SpriteLoad::getHeight() const { return height; }
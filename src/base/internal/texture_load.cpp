@@ -25,19 +25,23 @@ namespace internal {
 /**
  * @brief Constructs a pending object
  * 
+ * The file is decoded later by prepare().
+ * 
  * @param tex Address to a Texture instance. This is to redirect 
  *            responses after loading.
  * @param f Path to texture file, folder or zip
  */
-TextureLoad::TextureLoad(Texture* tex, const char* f) {
+TextureLoad::TextureLoad(Texture* tex, const char* f)
+           :ContextLoad(false)
+{
     texture = tex;
-    basecolor = Bitmap::loadFromFile(f);
+    file = f;
     heightmap = Bitmap();
     normalmap = Bitmap();
     mrao = Bitmap();
     emissivity = Bitmap();
-    width = basecolor.getWidth();
-    height = basecolor.getHeight();
+    width = 0;
+    height = 0;
 }
 
 /**
@@ -87,6 +91,17 @@ TextureLoad::TextureLoad(Texture* tex, const Bitmap& base, const Bitmap& h,
  */
 TextureLoad::~TextureLoad() {}
 
+/**
+ * @brief Decodes the image file
+ * 
+ * Runs on a worker thread of the context loader.
+ */
+void TextureLoad::prepare() {
+    basecolor = Bitmap::loadFromFile(file.c_str());
+    width = basecolor.getWidth();
+    height = basecolor.getHeight();
+}
+
 /**
  * @brief Loads the texture data to the GPU
  * 
@@ -118,9 +133,21 @@ void TextureLoad::load() {
     }
 }
 
+/**
+ * @brief Gets the number of bytes the load sends to the GPU
+ * 
+ * @return Upload size in bytes
+ */
+uint64_t TextureLoad::getUploadSize() const {
+    return (uint64_t) basecolor.getWidth() * basecolor.getHeight() *
+           basecolor.getChannel();
+}
+
 /**
  * @brief Gets the width of the image
  * 
+ * Zero until the image file is decoded.
+ * 
  * @return Image width in pixels
  */
 uint16_t TextureLoad::getWidth() const { return width; }
@@ -128,6 +155,8 @@ uint16_t TextureLoad::getWidth() const { return width; }
 /**
  * @brief Gets the height of the image
  * 
+ * Zero until the image file is decoded.
+ * 
  * @return Image height in pixels
  */
 uint16_t TextureLoad::getHeight() const { return height; }
@@ -13,10 +13,126 @@
 
 #include "../rmg/internal/vbo_load.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
+#include <cstring>
 #include <utility>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
 #include "../rmg/internal/glcontext.hpp"
+#include "../rmg/internal/parallel_for.hpp"
+
+
+// A coarser level is taken once its error is below this part of the limit
+#define LOD_HYSTERESIS 0.75f
+
+// Models of fewer triangles are always drawn in full detail
+#define LOD_MIN_TRIANGLES 4096
+#define LOD_LEVEL_COUNT 3 ///< Simplified levels of the 3D model files
+#define LOD_LEVEL_RATIO 0.25f ///< Fraction of the triangles of each level
+
+
+// Gets the size and the modification time of a file in the finest unit
+// of the system
+static bool getFileStamp(const std::string &file, uint64_t *size,
+                         uint64_t *time)
+{
+    #ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if(!GetFileAttributesExA(file.c_str(), GetFileExInfoStandard, &data))
+        return false;
+    *size = ((uint64_t) data.nFileSizeHigh << 32) | data.nFileSizeLow;
+    *time = ((uint64_t) data.ftLastWriteTime.dwHighDateTime << 32) |
+            data.ftLastWriteTime.dwLowDateTime;
+    #else
+    struct stat st;
+    if(stat(file.c_str(), &st) != 0)
+        return false;
+    *size = st.st_size;
+    #ifdef __APPLE__
+    const struct timespec &t = st.st_mtimespec;
+    #else
+    const struct timespec &t = st.st_mtim;
+    #endif
+    *time = (uint64_t) t.tv_sec * 1000000000 + t.tv_nsec;
+    #endif
+    return true;
+}
+
+
+static inline int16_t toSnorm16(float f) {
+    f = std::max(-1.0f, std::min(f, 1.0f));
+    return (int16_t) std::lround(f * 32767.0f);
+}
+
+
+static inline uint16_t toUnorm16(float f) {
+    f = std::max(0.0f, std::min(f, 1.0f));
+    return (uint16_t) std::lround(f * 65535.0f);
+}
+
+
+static uint16_t toHalf(float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    uint16_t sign = (u >> 16) & 0x8000;
+    int32_t exponent = (int32_t)((u >> 23) & 0xff) - 127 + 15;
+    uint32_t mantissa = u & 0x7fffff;
+    if(exponent <= 0)
+        return sign; // Too small values flush to zero
+    if(exponent >= 31)
+        return sign | 0x7c00;
+    // Rounds to the nearest
+    uint32_t half = ((uint32_t) exponent << 10) | (mantissa >> 13);
+    if(mantissa & 0x1000)
+        half++;
+    return sign | (uint16_t) std::min(half, (uint32_t) 0x7c00);
+}
+
+
+// Takes the maximum without branching like the check of the mesh files
+static bool checkIndices(const void* indices, uint32_t count,
+                         bool shortIndices, uint32_t vertexCount)
+{
+    uint32_t max = 0;
+    if(shortIndices) {
+        const uint16_t* in = (const uint16_t*) indices;
+        for(uint32_t i=0; i<count; i++)
+            max = std::max(max, (uint32_t) in[i]);
+    }
+    else {
+        const uint32_t* in = (const uint32_t*) indices;
+        for(uint32_t i=0; i<count; i++)
+            max = std::max(max, in[i]);
+    }
+    return max < vertexCount;
+}
+
+
+// Maps the unit sphere onto an octahedron unfolded into a square
+static void encodeOctahedral(const rmg::Vec3 &n, int16_t *out) {
+    float sum = fabs(n.x) + fabs(n.y) + fabs(n.z);
+    if(sum == 0) {
+        out[0] = out[1] = 0;
+        return;
+    }
+    float x = n.x / sum;
+    float y = n.y / sum;
+    if(n.z < 0) {
+        float ox = (1 - fabs(y)) * (x >= 0 ? 1 : -1);
+        float oy = (1 - fabs(x)) * (y >= 0 ? 1 : -1);
+        x = ox;
+        y = oy;
+    }
+    out[0] = toSnorm16(x);
+    out[1] = toSnorm16(y);
+}
 
 
 namespace rmg {
@@ -30,10 +146,132 @@ namespace internal {
  * 
  * @param vbo Address to a VBO instance. This is to redirect 
  *            responses after loading.
+ * @param geometry Geometry arenas of the context
  * @param mesh Mesh
+ * @param compress Stores the vertices in the compressed format
  */
-VBOLoad::VBOLoad(VBO* vbo, const Mesh& mesh): Mesh(mesh) {
+VBOLoad::VBOLoad(VBO* vbo, GeometryPool* geometry, const Mesh& mesh,
+                 bool compress)
+        :Mesh(mesh)
+{
     this->vbo = vbo;
+    this->geometry = geometry;
+    smooth = true;
+    compressed = compress;
+    encoded = false;
+    errors.push_back(0);
+    vbo->bounds = getBoundingBox();
+}
+
+/**
+ * @brief Constructs a pending object from the levels of detail of a mesh
+ * 
+ * @param vbo Address to a VBO instance. This is to redirect 
+ *            responses after loading.
+ * @param geometry Geometry arenas of the context
+ * @param lods Levels of detail from the most detailed one
+ * @param compress Stores the vertices in the compressed format
+ */
+VBOLoad::VBOLoad(VBO* vbo, GeometryPool* geometry,
+                 const std::vector<LevelOfDetail>& lods, bool compress)
+{
+    this->vbo = vbo;
+    this->geometry = geometry;
+    smooth = true;
+    compressed = compress;
+    encoded = false;
+    for(size_t i=0; i<lods.size(); i++) {
+        if(i == 0)
+            Mesh::operator=(lods[i].mesh);
+        else
+            levels.push_back(lods[i].mesh);
+        errors.push_back(lods[i].error);
+    }
+    vbo->bounds = getBoundingBox();
+}
+
+/**
+ * @brief Constructs a pending object from a 3D model file
+ * 
+ * The file is parsed later by prepare().
+ * 
+ * @param vbo Address to a VBO instance. This is to redirect 
+ *            responses after loading.
+ * @param geometry Geometry arenas of the context
+ * @param f 3D model file (.obj, .rmgmesh)
+ * @param smooth Generate smooth surface normals if the 3D model does
+ *               not contain preprocessed vertex normals
+ * @param compress Stores the vertices in the compressed format
+ */
+VBOLoad::VBOLoad(VBO* vbo, GeometryPool* geometry, const char* f,
+                 bool smooth, bool compress)
+        :ContextLoad(false)
+{
+    this->vbo = vbo;
+    this->geometry = geometry;
+    this->smooth = smooth;
+    compressed = compress;
+    encoded = false;
+    errors.push_back(0);
+    file = f;
+}
+
+/**
+ * @brief Parses the 3D model file and builds the mesh
+ * 
+ * Runs on a worker thread of the context loader. The built mesh is cached
+ * in a binary mesh file next to the 3D model file together with its
+ * levels of detail and their streams encoded for the GPU. Later loads map
+ * the cache instead of parsing the model as long as the size and the
+ * modification time of the model match the ones the cache was built
+ * from. Detailed models get coarser levels of detail simplified from the
+ * mesh when they are not in the file. The vertices are encoded for the
+ * GPU unless the file has them encoded in the same format.
+ */
+void VBOLoad::prepare() {
+    const char* ext = strrchr(file.c_str(), '.');
+    if(ext != nullptr && strcmp(ext, ".rmgmesh") == 0) {
+        // Reports the error of a broken file
+        if(!loadCache(file, nullptr))
+            Mesh::operator=(Mesh::loadFromFile(file.c_str(), smooth));
+        encode();
+        return;
+    }
+    
+    // The stamp is taken before parsing so that a model changed meanwhile
+    // does not match the cache
+    std::string cache = file + (smooth ? ".rmgmesh" : ".flat.rmgmesh");
+    SourceStamp source;
+    bool stamped = getFileStamp(file, &source.size, &source.time);
+    if(stamped && loadCache(cache, &source)) {
+        encode();
+        return;
+    }
+    Mesh::operator=(Mesh::loadFromFile(file.c_str(), smooth));
+    buildLevels();
+    encode();
+    if(!encoded)
+        return;
+    
+    // The streams the same as the arrays of the mesh are not stored twice
+    Encoding stored = encoding;
+    EncodedLevel &base = stored.levels[0];
+    if(base.positions == vertices) {
+        base.positions = nullptr;
+        base.positionSize = 0;
+    }
+    if(base.attributes == normals) {
+        base.attributes = nullptr;
+        base.attributeSize = 0;
+    }
+    if(base.indices == indices) {
+        base.indices = nullptr;
+        base.indexSize = 0;
+    }
+    // The model directory may be read-only in which case it is parsed
+    // every time
+    save(cache.c_str(), levels, errors, &stored,
+         stamped ? &source : nullptr);
 }
 
 /**
@@ -43,82 +281,338 @@ VBOLoad::VBOLoad(VBO* vbo, const Mesh& mesh): Mesh(mesh) {
  * which are created by model constructors (Cube3D, Model3D, .etc) into
  * GPU. Also this pending object's load function assigns the resource
  * addresses to the related VBO object.
+ * 
+ * The positions go into a buffer of their own so that the depth-only
+ * passes fetch nothing else. The normals and texture coordinates are
+ * interleaved in a second buffer. In the compressed format, positions
+ * are 16-bit integers quantized over the bounding box, normals are
+ * octahedral encoded into two 16-bit integers and texture coordinates
+ * are 16-bit normalized integers, or half floats if they are outside
+ * the range from 0 to 1. Meshes of less than 65536 vertices use 16-bit
+ * indices in either format. The levels of detail share the vertex
+ * format and the quantization of the most detailed mesh. The streams of
+ * a mapped binary mesh file are sent to the GPU without copying.
  */
 void VBOLoad::load() {
-    if(!isValid())
+    if(!isValid() || geometry == nullptr)
         return;
+    encode();
+    vbo->bounds = getBoundingBox();
     vbo->mode = VBOMode::Default;
-    glGenVertexArrays(1, &vbo->vertexArrayID);
-    glBindVertexArray(vbo->vertexArrayID);
+    if(texCoords != nullptr)
+        vbo->mode = VBOMode::Textured;
+    vbo->compressed = compressed;
+    vbo->positionOffset = encoding.offset;
+    vbo->positionScale = encoding.scale;
+    vbo->errors = errors;
+    
+    vbo->arena = geometry->getArena(encoding.format);
+    vbo->slots.resize(encoding.levels.size());
+    for(size_t i=0; i<encoding.levels.size(); i++) {
+        const EncodedLevel &e = encoding.levels[i];
+        vbo->slots[i] = vbo->arena->allocate(e.positions, e.attributes,
+                                             e.indices, e.vertexCount,
+                                             e.indexCount);
+    }
     
-    // Vertices
-    glGenBuffers(1, &vbo->vertexbuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo->vertexbuffer);
-    glBufferData(GL_ARRAY_BUFFER, vertex_count*sizeof(Vec3), vertices,
-                 GL_STATIC_DRAW);
-    // Normals
-    glGenBuffers(1, &vbo->normalbuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo->normalbuffer);
-    glBufferData(GL_ARRAY_BUFFER, vertex_count*sizeof(Vec3), normals,
-                 GL_STATIC_DRAW);
-    // Textural coordinates
+    // Kept on the CPU for picking without copying it here
+    delete vbo->triangles;
+    vbo->triangles = new MeshBVH(std::move(*(Mesh*) this));
+}
+
+/**
+ * @brief Gets the number of bytes the load sends to the GPU
+ * 
+ * @return Upload size in bytes
+ */
+uint64_t VBOLoad::getUploadSize() const {
+    if(encoded) {
+        uint64_t size = 0;
+        for(auto it=encoding.levels.begin(); it!=encoding.levels.end(); it++)
+            size += it->positionSize + it->attributeSize + it->indexSize;
+        return size;
+    }
+    uint32_t maxVertexCount = vertex_count;
+    for(auto it=levels.begin(); it!=levels.end(); it++)
+        maxVertexCount = std::max(maxVertexCount, it->vertex_count);
+    uint64_t size = 0;
+    for(size_t i=0; i<levels.size()+1; i++) {
+        const Mesh &mesh = getLevel(i);
+        uint64_t n = mesh.vertex_count;
+        if(compressed) {
+            size += n * 4 * sizeof(uint16_t);
+            size += n * 2 * sizeof(int16_t);
+            if(texCoords != nullptr)
+                size += n * 2 * sizeof(uint16_t);
+        }
+        else {
+            size += n * 2 * sizeof(Vec3);
+            if(texCoords != nullptr)
+                size += n * sizeof(Vec2);
+        }
+        if(maxVertexCount < 65536)
+            size += (uint64_t) mesh.index_count * sizeof(uint16_t);
+        else
+            size += (uint64_t) mesh.index_count * sizeof(uint32_t);
+    }
+    return size;
+}
+
+
+void VBOLoad::buildLevels() {
+    if(getPolygonCount() < LOD_MIN_TRIANGLES)
+        return;
+    // Every level is simplified from the full mesh in parallel
+    std::vector<Mesh> lods = std::vector<Mesh>(LOD_LEVEL_COUNT);
+    std::vector<float> errs = std::vector<float>(LOD_LEVEL_COUNT);
+    parallelFor(LOD_LEVEL_COUNT, 1, [&](size_t b, size_t e) {
+        for(size_t i=b; i<e; i++) {
+            lods[i] = Mesh(*this);
+            errs[i] = lods[i].simplify(powf(LOD_LEVEL_RATIO, i + 1));
+        }
+    });
+    
+    // Skips the levels the seams and borders keep from reducing
+    uint32_t count = getPolygonCount();
+    for(size_t i=0; i<lods.size(); i++) {
+        if(lods[i].getPolygonCount() > count * (1 - LOD_LEVEL_RATIO))
+            continue;
+        count = lods[i].getPolygonCount();
+        errors.push_back(std::max(errs[i], errors.back()));
+        levels.push_back(std::move(lods[i]));
+    }
+}
+
+
+bool VBOLoad::loadCache(const std::string &path,
+                        const SourceStamp* source)
+{
+    std::vector<float> errs;
+    Encoding enc;
+    SourceStamp stamp;
+    Mesh mesh = Mesh::loadMapped(path.c_str(), nullptr, &errs, &enc,
+                                 &stamp);
+    if(!mesh.isValid())
+        return false;
+    if(source != nullptr &&
+       (stamp.size != source->size || stamp.time != source->time))
+    {
+        return false;
+    }
+    Mesh::operator=(std::move(mesh));
+    if(errs.empty()) {
+        buildLevels();
+        return true;
+    }
+    if(acceptEncoding(enc)) {
+        errors = std::move(errs);
+        encoding = std::move(enc);
+        encoded = true;
+        return true;
+    }
+    
+    // Encoded in another format, so the levels are encoded again
+    std::vector<Mesh> lods;
+    mesh = Mesh::loadMapped(path.c_str(), &lods, &errs, nullptr, nullptr);
+    if(!mesh.isValid())
+        return false;
+    Mesh::operator=(std::move(mesh));
+    levels = std::move(lods);
+    errors = std::move(errs);
+    return true;
+}
+
+
+bool VBOLoad::acceptEncoding(Encoding &enc) const {
+    bool textured = texCoords != nullptr;
+    bool shortIndices = (enc.format & RMG_VERTEX_SHORT_INDICES) != 0;
+    if(enc.levels.empty() ||
+       compressed != ((enc.format & RMG_VERTEX_COMPRESSED) != 0) ||
+       textured != ((enc.format & RMG_VERTEX_TEXTURED) != 0) ||
+       ((enc.format & RMG_VERTEX_HALF_TEXCOORDS) && !(compressed && textured)))
+    {
+        return false;
+    }
+    uint64_t positionSize = compressed ? 4*sizeof(uint16_t) : sizeof(Vec3);
+    uint64_t attributeSize = compressed ? 2*sizeof(int16_t) : sizeof(Vec3);
+    if(textured)
+        attributeSize += compressed ? 2*sizeof(uint16_t) : sizeof(Vec2);
+    uint64_t indexSize = shortIndices ? sizeof(uint16_t) : sizeof(uint32_t);
+    
+    // The most detailed level leaves out the streams the same as its arrays
+    EncodedLevel &base = enc.levels[0];
+    if(base.positions == nullptr && !compressed) {
+        base.positions = vertices;
+        base.positionSize = vertex_count * sizeof(Vec3);
+    }
+    if(base.attributes == nullptr && !compressed && !textured) {
+        base.attributes = normals;
+        base.attributeSize = vertex_count * sizeof(Vec3);
+    }
+    if(base.indices == nullptr && !shortIndices) {
+        base.indices = indices;
+        base.indexSize = index_count * sizeof(uint32_t);
+    }
+    for(auto it=enc.levels.begin(); it!=enc.levels.end(); it++) {
+        if(it->positionSize != it->vertexCount * positionSize ||
+           it->attributeSize != it->vertexCount * attributeSize ||
+           it->indexSize != it->indexCount * indexSize ||
+           !checkIndices(it->indices, it->indexCount, shortIndices,
+                         it->vertexCount))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+const Mesh &VBOLoad::getLevel(size_t i) const {
+    if(i == 0)
+        return *this;
+    return levels[i-1];
+}
+
+
+void VBOLoad::encode() {
+    if(encoded || !isValid())
+        return;
+    encoded = true;
+    
+    // The levels share the vertex format and the quantization
+    BoundingBox box = getBoundingBox();
+    uint32_t maxVertexCount = vertex_count;
+    bool unitTexCoords = true;
+    for(size_t i=0; i<levels.size()+1; i++) {
+        const Mesh &mesh = getLevel(i);
+        if(i > 0) {
+            BoundingBox b = mesh.getBoundingBox();
+            box.extend(b.min);
+            box.extend(b.max);
+        }
+        maxVertexCount = std::max(maxVertexCount, mesh.vertex_count);
+        if(mesh.texCoords == nullptr)
+            continue;
+        for(uint32_t j=0; j<mesh.vertex_count && unitTexCoords; j++) {
+            const Vec2 &t = mesh.texCoords[j];
+            if(t.x < 0 || t.x > 1 || t.y < 0 || t.y > 1)
+                unitTexCoords = false;
+        }
+    }
+    bool shortIndices = maxVertexCount < 65536;
+    encoding = Encoding();
+    if(compressed)
+        encoding.format |= RMG_VERTEX_COMPRESSED;
     if(texCoords != nullptr) {
-        glGenBuffers(1, &vbo->texturebuffer);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo->texturebuffer);
-        glBufferData(GL_ARRAY_BUFFER, vertex_count*sizeof(Vec2), texCoords,
-                     GL_STATIC_DRAW);
-        vbo->mode = VBOMode::Textured;
+        encoding.format |= RMG_VERTEX_TEXTURED;
+        if(compressed && !unitTexCoords)
+            encoding.format |= RMG_VERTEX_HALF_TEXCOORDS;
+    }
+    if(shortIndices)
+        encoding.format |= RMG_VERTEX_SHORT_INDICES;
+    if(compressed) {
+        encoding.offset = box.min;
+        encoding.scale = box.max - box.min;
+    }
+    else {
+        encoding.offset = Vec3(0, 0, 0);
+        encoding.scale = Vec3(1, 1, 1);
     }
-    // Indices
-    glGenBuffers(1, &vbo->elementbuffer);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo->elementbuffer);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_count*sizeof(uint32_t),
-                 indices, GL_STATIC_DRAW);
-    vbo->indexCount = index_count;
     
-    setAttributePointers();
+    // The streams the GPU takes as they are point to the arrays
+    streams.resize(levels.size() + 1);
+    encoding.levels.resize(streams.size());
+    for(size_t i=0; i<streams.size(); i++) {
+        const Mesh &mesh = getLevel(i);
+        Streams &s = streams[i];
+        EncodedLevel &e = encoding.levels[i];
+        e.vertexCount = mesh.vertex_count;
+        e.indexCount = mesh.index_count;
+        e.positions = mesh.vertices;
+        e.positionSize = mesh.vertex_count * sizeof(Vec3);
+        if(compressed) {
+            encodePositions(mesh, s);
+            e.positions = s.positions.data();
+            e.positionSize = s.positions.size() * sizeof(uint16_t);
+        }
+        e.attributes = mesh.normals;
+        e.attributeSize = mesh.vertex_count * sizeof(Vec3);
+        if(compressed || texCoords != nullptr) {
+            encodeAttributes(mesh, s);
+            e.attributes = s.attributes.data();
+            e.attributeSize = s.attributes.size();
+        }
+        e.indices = mesh.indices;
+        e.indexSize = mesh.index_count * sizeof(uint32_t);
+        if(shortIndices) {
+            s.indices.resize(mesh.index_count);
+            for(uint32_t j=0; j<mesh.index_count; j++)
+                s.indices[j] = (uint16_t) mesh.indices[j];
+            e.indices = s.indices.data();
+            e.indexSize = mesh.index_count * sizeof(uint16_t);
+        }
+    }
 }
 
 
-void VBOLoad::setAttributePointers() {
-    // 1st attribute buffer : vertices
-    glEnableVertexAttribArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo->vertexbuffer);
-    glVertexAttribPointer(
-        0,              // attribute
-        3,              // size
-        GL_FLOAT,       // type
-        GL_FALSE,       // normalized?
-        0,              // stride
-        (void*)0        // array buffer offset
-    );
-    // 2nd attribute buffer : normals
-    glEnableVertexAttribArray(1);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo->normalbuffer);
-    glVertexAttribPointer(
-        1,
-        3,
-        GL_FLOAT,
-        GL_FALSE,
-        0,
-        (void*)0
-    );
-    // 3nd attribute buffer : textures
-    if(vbo->mode == VBOMode::Textured) {
-        glEnableVertexAttribArray(2);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo->texturebuffer);
-        glVertexAttribPointer(
-            2,
-            2,
-            GL_FLOAT,
-            GL_FALSE,
-            0,
-            (void*)0
-        );
+void VBOLoad::encodePositions(const Mesh &mesh, Streams &out) {
+    Vec3 inverse;
+    for(int i=0; i<3; i++) {
+        if(encoding.scale[i] > 0)
+            inverse[i] = 1.0f / encoding.scale[i];
+        else
+            inverse[i] = 0;
+    }
+    // The 4th component keeps the vertices 8-byte aligned
+    out.positions.resize(mesh.vertex_count * 4);
+    for(uint32_t i=0; i<mesh.vertex_count; i++) {
+        for(int j=0; j<3; j++) {
+            float f = (mesh.vertices[i][j] - encoding.offset[j]) * inverse[j];
+            out.positions[i*4 + j] = toUnorm16(f);
+        }
+        out.positions[i*4 + 3] = 0;
     }
 }
 
 
+void VBOLoad::encodeAttributes(const Mesh &mesh, Streams &out) {
+    size_t normalSize = compressed ? 2*sizeof(int16_t) : sizeof(Vec3);
+    size_t texSize = 0;
+    if(texCoords != nullptr)
+        texSize = compressed ? 2*sizeof(uint16_t) : sizeof(Vec2);
+    size_t stride = normalSize + texSize;
+    bool half = (encoding.format & RMG_VERTEX_HALF_TEXCOORDS) != 0;
+    // Levels missing the texture coordinates get zeros
+    out.attributes.assign(mesh.vertex_count * stride, 0);
+    
+    for(uint32_t i=0; i<mesh.vertex_count; i++) {
+        uint8_t *p = &out.attributes[i * stride];
+        if(compressed) {
+            int16_t oct[2];
+            encodeOctahedral(mesh.normals[i], oct);
+            memcpy(p, oct, sizeof(oct));
+        }
+        else {
+            memcpy(p, &mesh.normals[i], sizeof(Vec3));
+        }
+        if(texSize == 0 || mesh.texCoords == nullptr)
+            continue;
+        p += normalSize;
+        if(!compressed) {
+            memcpy(p, &mesh.texCoords[i], sizeof(Vec2));
+            continue;
+        }
+        uint16_t uv[2];
+        for(int j=0; j<2; j++) {
+            if(half)
+                uv[j] = toHalf(mesh.texCoords[i][j]);
+            else
+                uv[j] = toUnorm16(mesh.texCoords[i][j]);
+        }
+        memcpy(p, uv, sizeof(uv));
+    }
+}
+
 
 
 // Class: VBO
@@ -127,14 +621,38 @@ void VBOLoad::setAttributePointers() {
  * @brief Destructor
  */
 VBO::~VBO() {
-    if(mode != VBOMode::None) {
-        glDeleteBuffers(1, &vertexbuffer);
-        glDeleteBuffers(1, &normalbuffer);
-        if(mode == VBOMode::Textured)
-            glDeleteBuffers(1, &texturebuffer);
-        glDeleteBuffers(1, &elementbuffer);
-        glDeleteVertexArrays(1, &vertexArrayID);
-    }
+    delete triangles;
+    if(arena == nullptr)
+        return;
+    for(auto it=slots.begin(); it!=slots.end(); it++)
+        arena->release(*it);
+}
+
+/**
+ * @brief Move constructor
+ * 
+ * @param vbo Source
+ */
+VBO::VBO(VBO&& vbo) noexcept {
+    *this = std::move(vbo);
+}
+
+/**
+ * @brief Move assignment
+ * 
+ * @param vbo Source
+ */
+VBO& VBO::operator=(VBO&& vbo) noexcept {
+    std::swap(arena, vbo.arena);
+    std::swap(slots, vbo.slots);
+    std::swap(errors, vbo.errors);
+    std::swap(triangles, vbo.triangles);
+    mode = vbo.mode;
+    compressed = vbo.compressed;
+    positionOffset = vbo.positionOffset;
+    positionScale = vbo.positionScale;
+    bounds = vbo.bounds;
+    return *this;
 }
 
 /**
@@ -142,23 +660,208 @@ VBO::~VBO() {
  */
 VBOMode VBO::getMode() const { return mode; }
 
+/**
+ * @brief Gets the axis-aligned box enclosing the vertices
+ * 
+ * Available as soon as the VBO is constructed from a mesh, before the
+ * context loads it.
+ * 
+ * @return Bounding box in model space
+ */
+const BoundingBox &VBO::getBoundingBox() const { return bounds; }
+
+/**
+ * @brief Gets the geometry arena storing the vertices
+ * 
+ * @return Geometry arena or null if the VBO is not loaded
+ */
+GeometryArena *VBO::getArena() const { return arena; }
+
+/**
+ * @brief Gets the location of the vertices in the geometry arena
+ * 
+ * The VBO must be loaded.
+ * 
+ * @param level Level of detail
+ * 
+ * @return Vertex and index ranges
+ */
+const GeometryRange &VBO::getRange(uint32_t level) const {
+    return arena->getRange(slots[level]);
+}
+
+/**
+ * @brief Gets the number of levels of detail
+ * 
+ * @return Number of levels or zero if the VBO is not loaded
+ */
+uint32_t VBO::getLevelCount() const { return (uint32_t) slots.size(); }
+
+/**
+ * @brief Gets the geometric error of a level of detail
+ * 
+ * @param level Level of detail
+ * 
+ * @return Deviation from the exact surface in model space
+ */
+float VBO::getLevelError(uint32_t level) const { return errors[level]; }
+
+/**
+ * @brief Picks the coarsest level of detail within an error
+ * 
+ * A coarser level than the current one is only taken if its error is
+ * clearly below the limit, so that objects near the boundary do not
+ * flicker between two levels.
+ * 
+ * @param maxError Largest error allowed in model space
+ * @param current Level drawn in the previous frame
+ * 
+ * @return Level of detail
+ */
+uint32_t VBO::selectLevel(float maxError, uint32_t current) const {
+    uint32_t count = (uint32_t) slots.size();
+    if(count <= 1)
+        return 0;
+    uint32_t level = std::min(current, count - 1);
+    while(level > 0 && errors[level] > maxError)
+        level--;
+    while(level+1 < count && errors[level+1] <= maxError*LOD_HYSTERESIS)
+        level++;
+    return level;
+}
+
+/**
+ * @brief Checks if the vertices are stored in the compressed format
+ * 
+ * Normals of the compressed format are octahedral encoded and have to
+ * be decoded by the shader.
+ * 
+ * @return True if the vertices are compressed
+ */
+bool VBO::isCompressed() const { return compressed; }
+
+/**
+ * @brief Gets the offset of the quantized positions
+ * 
+ * The shader gets the model space position by the offset plus the
+ * scale times the value of the position attribute.
+ * 
+ * @return Position of the quantized value zero in model space
+ */
+const Vec3 &VBO::getPositionOffset() const { return positionOffset; }
+
+/**
+ * @brief Gets the scale of the quantized positions
+ * 
+ * @return Model space size of the quantized value range
+ */
+const Vec3 &VBO::getPositionScale() const { return positionScale; }
+
+/**
+ * @brief Gets the matrix converting the quantized positions into model
+ *        space
+ * 
+ * @return Translation and scale matrix
+ */
+Mat4 VBO::getPositionMatrix() const {
+    Mat4 M = Mat4();
+    for(int i=0; i<3; i++) {
+        M[i][i] = positionScale[i];
+        M[i][3] = positionOffset[i];
+    }
+    return M;
+}
+
+/**
+ * @brief Gets the triangles of the most detailed level for the ray
+ *        queries
+ * 
+ * The bounding volume hierarchy of the triangles is built by its first
+ * ray query.
+ * 
+ * @return Triangle BVH or null if the VBO is not loaded
+ */
+MeshBVH *VBO::getMeshBVH() const { return triangles; }
+
 /**
  * @brief Draws the VBO using a shader program
+ * 
+ * @param level Level of detail
  */
-void VBO::draw() const {
-    if(mode == VBOMode::None)
+void VBO::draw(uint32_t level) const {
+    if(arena == nullptr)
         return;
     
-    glBindVertexArray(vertexArrayID);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementbuffer);
+    arena->bindVertexArray();
+    const GeometryRange &range = arena->getRange(slots[level]);
     
     // Draw the triangles !
-    glDrawElements(
-        GL_TRIANGLES,      // mode
-        indexCount,        // count
-        GL_UNSIGNED_INT,   // type
-        (void*)0           // element array buffer offset
+    glDrawElementsBaseVertex(
+        GL_TRIANGLES,                                   // mode
+        range.indexCount,                               // count
+        arena->getIndexType(),                          // type
+        (void*)(size_t)(range.indexOffset * arena->getIndexSize()),
+        range.vertexOffset                              // base vertex
+    );
+    drawCallCount++;
+}
+
+/**
+ * @brief Draws the VBO binding the position stream only
+ * 
+ * Used by the depth-only passes whose shaders read the positions
+ * only.
+ * 
+ * @param level Level of detail
+ */
+void VBO::drawPositions(uint32_t level) const {
+    if(arena == nullptr)
+        return;
+    arena->bindPositionArray();
+    const GeometryRange &range = arena->getRange(slots[level]);
+    glDrawElementsBaseVertex(
+        GL_TRIANGLES,
+        range.indexCount,
+        arena->getIndexType(),
+        (void*)(size_t)(range.indexOffset * arena->getIndexSize()),
+        range.vertexOffset
+    );
+    drawCallCount++;
+}
+
+/**
+ * @brief Binds the vertex array of the VBO
+ * 
+ * The vertex array is shared by the VBOs of the same geometry arena.
+ * Per-instance attributes are set up on the vertex array after this
+ * call and before drawInstanced().
+ */
+void VBO::bind() const {
+    if(arena != nullptr)
+        arena->bindVertexArray();
+}
+
+/**
+ * @brief Draws multiple instances of the VBO in a single draw call
+ * 
+ * The VBO must be bound first.
+ * 
+ * @param count Number of instances
+ * @param level Level of detail
+ */
+void VBO::drawInstanced(uint32_t count, uint32_t level) const {
+    if(arena == nullptr)
+        return;
+    const GeometryRange &range = arena->getRange(slots[level]);
+    glDrawElementsInstancedBaseVertex(
+        GL_TRIANGLES,
+        range.indexCount,
+        arena->getIndexType(),
+        (void*)(size_t)(range.indexOffset * arena->getIndexSize()),
+        count,
+        range.vertexOffset
     );
+    drawCallCount++;
 }
 
 }}
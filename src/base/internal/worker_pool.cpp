@@ -0,0 +1,94 @@
+/**
+ * @file worker_pool.cpp
+ * @brief Group of background threads running queued jobs
+ * 
+ * Keeps the slow CPU work like file decoding away from the rendering
+ * thread.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#define RMG_EXPORT
+
+
+#include "../rmg/internal/worker_pool.hpp"
+
+#include <utility>
+
+
+namespace rmg {
+namespace internal {
+
+/**
+ * @brief Constructor
+ * 
+ * @param n Number of threads. Zero picks one less than the number of
+ *          hardware threads so that the rendering thread has a core.
+ */
+WorkerPool::WorkerPool(uint32_t n) {
+    if(n == 0) {
+        n = std::thread::hardware_concurrency();
+        n = (n > 1) ? n-1 : 1;
+    }
+    threadCount = n;
+    stopping = false;
+}
+
+/**
+ * @brief Destructor waits for the running jobs and stops the threads
+ */
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+    for(auto it=threads.begin(); it!=threads.end(); it++)
+        it->join();
+}
+
+/**
+ * @brief Queues a job to be run by one of the threads
+ * 
+ * @param job Function to run
+ */
+void WorkerPool::push(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push(std::move(job));
+        if(threads.size() == 0) {
+            for(uint32_t i=0; i<threadCount; i++)
+                threads.push_back(std::thread(&WorkerPool::run, this));
+        }
+    }
+    condition.notify_one();
+}
+
+void WorkerPool::run() {
+    while(true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this] {
+                return stopping || jobs.size() > 0;
+            });
+            if(stopping)
+                return;
+            job = std::move(jobs.front());
+            jobs.pop();
+        }
+        job();
+    }
+}
+
+/**
+ * @brief Gets the number of threads of the pool
+ * 
+ * @return Thread count
+ */
+uint32_t WorkerPool::getThreadCount() const { return threadCount; }
+
+}}
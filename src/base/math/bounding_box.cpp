@@ -0,0 +1,133 @@
+/**
+ * @file bounding_box.cpp
+ * @brief Axis-aligned box enclosing a set of points in 3D space
+ * 
+ * Used as the bounding volume of meshes for visibility tests.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#define RMG_EXPORT
+
+
+#include "../rmg/math/bounding_box.hpp"
+
+#include <cmath>
+#include <limits>
+
+
+namespace rmg {
+
+/**
+ * @brief Default constructor makes an empty box
+ */
+BoundingBox::BoundingBox() {
+    float inf = std::numeric_limits<float>::infinity();
+    min = Vec3(inf, inf, inf);
+    max = Vec3(-inf, -inf, -inf);
+}
+
+/**
+ * @brief Constructor
+ * 
+ * @param min Corner with the smallest coordinates
+ * @param max Corner with the largest coordinates
+ */
+BoundingBox::BoundingBox(const Vec3 &min, const Vec3 &max) {
+    this->min = min;
+    this->max = max;
+}
+
+/**
+ * @brief Checks if the box encloses nothing
+ * 
+ * @return True if no point has been added to the box
+ */
+bool BoundingBox::isEmpty() const {
+    return min.x > max.x || min.y > max.y || min.z > max.z;
+}
+
+/**
+ * @brief Grows the box to enclose a point
+ * 
+ * @param p Point in space
+ */
+void BoundingBox::extend(const Vec3 &p) {
+    min.x = fminf(min.x, p.x);
+    min.y = fminf(min.y, p.y);
+    min.z = fminf(min.z, p.z);
+    max.x = fmaxf(max.x, p.x);
+    max.y = fmaxf(max.y, p.y);
+    max.z = fmaxf(max.z, p.z);
+}
+
+/**
+ * @brief Grows the box to enclose another box
+ * 
+ * @param box Another bounding box
+ */
+void BoundingBox::extend(const BoundingBox &box) {
+    if(box.isEmpty())
+        return;
+    extend(box.min);
+    extend(box.max);
+}
+
+/**
+ * @brief Gets the center of the box
+ * 
+ * @return Center point
+ */
+Vec3 BoundingBox::getCenter() const {
+    return (min + max) / 2;
+}
+
+/**
+ * @brief Gets the radius of the sphere enclosing the box
+ * 
+ * @return Half of the diagonal length
+ */
+float BoundingBox::getRadius() const {
+    return (max - min).magnitude() / 2;
+}
+
+/**
+ * @brief Transforms the box into another coordinate system
+ * 
+ * The result is the axis-aligned box enclosing the transformed box.
+ * 
+ * @param M Transformation matrix like the model matrix of an object
+ * 
+ * @return Bounding box in the new coordinate system
+ */
+BoundingBox BoundingBox::transform(const Mat4 &M) const {
+    if(isEmpty())
+        return *this;
+    // Arvo's method: each matrix cell contributes either its product
+    // with the minimum or the maximum coordinate
+    float bmin[3] = {M[0][3], M[1][3], M[2][3]};
+    float bmax[3] = {M[0][3], M[1][3], M[2][3]};
+    const float amin[3] = {min.x, min.y, min.z};
+    const float amax[3] = {max.x, max.y, max.z};
+    for(int i=0; i<3; i++) {
+        for(int j=0; j<3; j++) {
+            float e = M[i][j] * amin[j];
+            float f = M[i][j] * amax[j];
+            if(e < f) {
+                bmin[i] += e;
+                bmax[i] += f;
+            }
+            else {
+                bmin[i] += f;
+                bmax[i] += e;
+            }
+        }
+    }
+    return BoundingBox(Vec3(bmin[0], bmin[1], bmin[2]),
+                       Vec3(bmax[0], bmax[1], bmax[2]));
+}
+
+}
@@ -0,0 +1,116 @@
+/**
+ * @file frustum.cpp
+ * @brief Viewing volume of a camera bounded by 6 planes
+ * 
+ * Tests whether bounding volumes are visible to the camera so that the
+ * invisible objects can be skipped before drawing.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#define RMG_EXPORT
+
+
+#include "../rmg/math/frustum.hpp"
+
+#include <cmath>
+
+
+namespace rmg {
+
+/**
+ * @brief Extracts the clipping planes from a view-projection matrix
+ * 
+ * @param VP View-projection matrix of a camera
+ */
+Frustum::Frustum(const Mat4 &VP) {
+    // Gribb-Hartmann method. A point is inside if -w <= x,y,z <= w in
+    // clip space where each clip coordinate is a row of the matrix.
+    for(int i=0; i<3; i++) {
+        for(int j=0; j<4; j++) {
+            planes[2*i][j] = VP[3][j] + VP[i][j];
+            planes[2*i+1][j] = VP[3][j] - VP[i][j];
+        }
+    }
+    for(int i=0; i<6; i++) {
+        Vec4 &p = planes[i];
+        float len = sqrtf(p.x*p.x + p.y*p.y + p.z*p.z);
+        if(len > 0)
+            p = p / len;
+    }
+}
+
+/**
+ * @brief Checks if a sphere is inside or intersects the volume
+ * 
+ * @param center Center of the sphere
+ * @param radius Radius of the sphere
+ * 
+ * @return False if the sphere is completely outside
+ */
+bool Frustum::intersects(const Vec3 &center, float radius) const {
+    for(int i=0; i<6; i++) {
+        const Vec4 &p = planes[i];
+        if(p.x*center.x + p.y*center.y + p.z*center.z + p.w < -radius)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Checks if a box is inside or intersects the volume
+ * 
+ * @param box Axis-aligned bounding box
+ * 
+ * @return False if the box is completely outside
+ */
+bool Frustum::intersects(const BoundingBox &box) const {
+    if(box.isEmpty())
+        return false;
+    for(int i=0; i<6; i++) {
+        const Vec4 &p = planes[i];
+        // Corner of the box furthest along the plane normal
+        float x = (p.x >= 0) ? box.max.x : box.min.x;
+        float y = (p.y >= 0) ? box.max.y : box.min.y;
+        float z = (p.z >= 0) ? box.max.z : box.min.z;
+        if(p.x*x + p.y*y + p.z*z + p.w < 0)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Checks if a transformed box is inside or intersects the volume
+ * 
+ * Rejects the box with its bounding sphere first and tests the box in
+ * world space afterwards.
+ * 
+ * @param box Bounding box in model space
+ * @param M Model matrix
+ * 
+ * @return False if the box is completely outside
+ */
+bool Frustum::intersects(const BoundingBox &box, const Mat4 &M) const {
+    if(box.isEmpty())
+        return false;
+    Vec3 c = box.getCenter();
+    Vec3 center = Vec3(
+        M[0][0]*c.x + M[0][1]*c.y + M[0][2]*c.z + M[0][3],
+        M[1][0]*c.x + M[1][1]*c.y + M[1][2]*c.z + M[1][3],
+        M[2][0]*c.x + M[2][1]*c.y + M[2][2]*c.z + M[2][3]
+    );
+    // The largest column length of the matrix is the largest scale
+    float s = 0;
+    for(int j=0; j<3; j++) {
+        float len = M[0][j]*M[0][j] + M[1][j]*M[1][j] + M[2][j]*M[2][j];
+        s = fmaxf(s, len);
+    }
+    if(!intersects(center, sqrtf(s) * box.getRadius()))
+        return false;
+    return intersects(box.transform(M));
+}
+
+}
@@ -13,11 +13,14 @@
 
 #include "rmg/mesh.hpp"
 
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <utility>
 
 #include "rmg/assert.hpp"
+#include "rmg/internal/mapped_file.hpp"
+#include "rmg/internal/mesh_cache.hpp"
 
 
 namespace rmg {
@@ -139,6 +142,11 @@ Mesh::Mesh(const Vec3* vert, const Vec3* norm, const Vec2* tex,
  * @brief Destructor
  */
 Mesh::~Mesh() {
+    // Arrays of a mapped mesh belong to the mapping
+    if(mapping != nullptr) {
+        delete mapping;
+        return;
+    }
     free(vertices);
     free(normals);
     free(texCoords);
@@ -187,6 +195,8 @@ Mesh::Mesh(Mesh&& mesh) noexcept {
     vertex_count = std::exchange(mesh.vertex_count, 0);
     indices = std::exchange(mesh.indices, nullptr);
     index_count = std::exchange(mesh.index_count, 0);
+    mapping = std::exchange(mesh.mapping, nullptr);
+    mappedBounds = mesh.mappedBounds;
 }
 
 /**
@@ -218,6 +228,8 @@ void Mesh::swap(Mesh& mesh) noexcept {
     std::swap(normals, mesh.normals);
     std::swap(texCoords, mesh.texCoords);
     std::swap(indices, mesh.indices);
+    std::swap(mapping, mesh.mapping);
+    std::swap(mappedBounds, mesh.mappedBounds);
 }
 
 /**
@@ -253,4 +265,78 @@ uint32_t Mesh::getPolygonCount() const {
     return index_count / 3;
 }
 
+/**
+ * @brief Gets the axis-aligned box enclosing the vertices
+ * 
+ * @return Bounding box in model space
+ */
+BoundingBox Mesh::getBoundingBox() const {
+    // Mesh files store the bounds so the mapped vertices are not touched
+    if(mapping != nullptr)
+        return mappedBounds;
+    BoundingBox box;
+    for(uint32_t i=0; i<vertex_count; i++)
+        box.extend(vertices[i]);
+    return box;
+}
+
+/**
+ * @brief Hashes the vertex arrays and indices
+ * 
+ * Identical meshes have the same hash, so the 3D objects use it to
+ * share a single VBO.
+ * 
+ * @return 64-bit hash of the mesh data
+ */
+uint64_t Mesh::getHash() const {
+    using internal::MeshCache;
+    uint64_t h = MeshCache::hash(&vertex_count, sizeof(vertex_count));
+    h = MeshCache::hash(vertices, sizeof(Vec3)*vertex_count, h);
+    h = MeshCache::hash(normals, sizeof(Vec3)*vertex_count, h);
+    if(texCoords != nullptr)
+        h = MeshCache::hash(texCoords, sizeof(Vec2)*vertex_count, h);
+    h = MeshCache::hash(&index_count, sizeof(index_count), h);
+    return MeshCache::hash(indices, sizeof(uint32_t)*index_count, h);
+}
+
+/**
+ * @brief Loads a mesh from a 3D model file
+ * 
+ * @param file 3D model file (.obj, .rmgmesh)
+ * @param smooth Generate smooth surface normals if the 3D model does not
+ *               contain preprocessed vertex normals
+ * 
+ * @return Loaded mesh or an invalid mesh if the file fails to load
+ */
+Mesh Mesh::loadFromFile(const char* file, bool smooth) {
+    const char* ext = strrchr(file, '.');
+    if(ext == nullptr)
+        ext = "";
+    
+    if(strcmp(ext, ".obj") == 0)
+        return loadOBJ(file, smooth);
+    if(strcmp(ext, ".rmgmesh") == 0) {
+        Mesh mesh = loadMapped(file);
+        if(!mesh.isValid()) {
+            #ifdef WIN32
+            printf("error: Failed to load 3D model '%s'\n", file);
+            #else
+            printf("\033[0;1;31merror: \033[0m"
+                   "Failed to load 3D model \033[1m'%s'\033[0m\n", file);
+            #endif
+        }
+        return mesh;
+    }
+    
+    #ifdef WIN32
+    printf("error: Attempted to load unsupported 3D model file '%s'\n",
+           file);
+    #else
+    printf("\033[0;1;31merror: \033[0m"
+           "Attempted to load unsupported 3D model file "
+           "\033[1m'%s'\033[0m\n", file);
+    #endif
+    return Mesh();
+}
+
 }
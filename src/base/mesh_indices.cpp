@@ -15,7 +15,7 @@
 
 #include <cstdlib>
 #include <cstring>
-#include <unordered_map>
+#include <vector>
 
 
 namespace rmg {
@@ -53,129 +53,125 @@ void Mesh::removeIndices() {
 }
 
 
-void Mesh::buildIndices() {
-    removeIndices();
-    if(texCoords == nullptr)
-        buildIndices1();
-    else
-        buildIndices2();
+static inline uint32_t floatBits(float f) {
+    // +0 and -0 are equal and must hash the same
+    if(f == 0)
+        return 0;
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
 }
 
 
-template <typename T>
-static void combineHash(size_t& seed, const T& key) {
-    seed ^= std::hash<T>{}(key) + 0x9e3779b9 + (seed<<6) + (seed>>2);
+static inline uint32_t combineHash(uint32_t h, float f) {
+    uint32_t k = floatBits(f) * 0xcc9e2d51;
+    k = ((k << 15) | (k >> 17)) * 0x1b873593;
+    h ^= k;
+    return ((h << 13) | (h >> 19)) * 5 + 0xe6546b64;
 }
 
 
-void Mesh::buildIndices1() {
-    auto hash = [](const std::pair<Vec3,Vec3>& k) {
-        size_t seed = 0;
-        combineHash(seed, k.first);
-        combineHash(seed, k.second);
-        return seed;
-    };
-    
-    auto equal = [](const std::pair<Vec3,Vec3>& a,
-                    const std::pair<Vec3,Vec3>& b)
-    {
-        return (a.first == b.first) && (a.second == b.second);
-    };
-    
-    std::unordered_map
-        <std::pair<Vec3,Vec3>, uint32_t,
-         decltype(hash), decltype(equal)> table(65536, hash, equal);
-    
-    index_count = vertex_count;
-    indices = (uint32_t*) malloc(sizeof(uint32_t)*index_count);
-    Vec3 *tempVertices = (Vec3*) malloc(sizeof(Vec3)*vertex_count);
-    Vec3 *tempNormals = (Vec3*) malloc(sizeof(Vec3)*vertex_count);
-    
-    for(uint32_t i=0; i<vertex_count; i++) {
-        auto key = std::make_pair(vertices[i], normals[i]);
-        auto res = table.find(key);
-        if(res == table.end()) {
-            uint32_t k = table.size();
-            tempVertices[k] = vertices[i];
-            tempNormals[k] = normals[i];
-            indices[i] = k;
-            auto elem = std::make_pair(key, k);
-            table.insert(elem);
-        }
-        else {
-            indices[i] = res->second;
+static inline uint32_t finishHash(uint32_t h) {
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    return h ^ (h >> 13);
+}
+
+
+static size_t getTableCapacity(uint32_t count) {
+    size_t capacity = 1;
+    while(capacity < (size_t) count * 2)
+        capacity <<= 1;
+    return capacity;
+}
+
+
+void Mesh::weldPositions(const Vec3* positions, uint32_t count,
+                         uint32_t* ids)
+{
+    size_t mask = getTableCapacity(count) - 1;
+    std::vector<uint32_t> table = std::vector<uint32_t>(mask + 1, UINT32_MAX);
+    for(uint32_t i=0; i<count; i++) {
+        const Vec3 v = positions[i];
+        uint32_t h = 0;
+        for(int j=0; j<3; j++)
+            h = combineHash(h, v[j]);
+        
+        size_t slot = finishHash(h) & mask;
+        while(true) {
+            uint32_t k = table[slot];
+            if(k == UINT32_MAX) {
+                table[slot] = i;
+                ids[i] = i;
+                break;
+            }
+            if(positions[k] == v) {
+                ids[i] = k;
+                break;
+            }
+            slot = (slot + 1) & mask;
         }
     }
-    
-    vertex_count = table.size();
-    free(vertices);
-    free(normals);
-    vertices = (Vec3*) malloc(sizeof(Vec3)*vertex_count);
-    normals = (Vec3*) malloc(sizeof(Vec3)*vertex_count);
-    memcpy(vertices, tempVertices, sizeof(Vec3)*table.size());
-    memcpy(normals, tempNormals, sizeof(Vec3)*table.size());
-    free(tempVertices);
-    free(tempNormals);
 }
 
 
-void Mesh::buildIndices2() {
-    auto hash = [](const std::tuple<Vec3,Vec3,Vec2>& k) {
-        size_t seed = 0;
-        combineHash(seed, std::get<0>(k));
-        combineHash(seed, std::get<1>(k));
-        combineHash(seed, std::get<2>(k));
-        return seed;
-    };
-    
-    auto equal = [](const std::tuple<Vec3,Vec3,Vec2>& a,
-                    const std::tuple<Vec3,Vec3,Vec2>& b)
-    {
-        return (std::get<0>(a) == std::get<0>(b)) &&
-               (std::get<1>(a) == std::get<1>(b)) &&
-               (std::get<2>(a) == std::get<2>(b));
-    };
+void Mesh::buildIndices() {
+    removeIndices();
+    if(vertices == nullptr)
+        return;
     
-    std::unordered_map
-        <std::tuple<Vec3,Vec3,Vec2>, uint32_t,
-         decltype(hash), decltype(equal)> table(65536, hash, equal);
+    // Open addressing table of vertex indices which is at most half full.
+    // The unique vertices are compacted to the front of the arrays in place
+    // since a vertex never moves behind its own position.
+    size_t mask = getTableCapacity(vertex_count) - 1;
+    std::vector<uint32_t> table = std::vector<uint32_t>(mask + 1, UINT32_MAX);
     
     index_count = vertex_count;
     indices = (uint32_t*) malloc(sizeof(uint32_t)*index_count);
-    Vec3 *tempVertices = (Vec3*) malloc(sizeof(Vec3)*vertex_count);
-    Vec3 *tempNormals = (Vec3*) malloc(sizeof(Vec3)*vertex_count);
-    Vec2 *tempTexCoords = (Vec2*) malloc(sizeof(Vec2)*vertex_count);
-    
+    uint32_t count = 0;
     for(uint32_t i=0; i<vertex_count; i++) {
-        auto key = std::make_tuple(vertices[i], normals[i], texCoords[i]);
-        auto res = table.find(key);
-        if(res == table.end()) {
-            uint32_t k = table.size();
-            tempVertices[k] = vertices[i];
-            tempNormals[k] = normals[i];
-            tempTexCoords[k] = texCoords[i];
-            indices[i] = k;
-            auto elem = std::make_pair(key, k);
-            table.insert(elem);
+        const Vec3 v = vertices[i];
+        const Vec3 n = normals[i];
+        const Vec2 t = (texCoords != nullptr) ? texCoords[i] : Vec2();
+        uint32_t h = 0;
+        for(int j=0; j<3; j++) {
+            h = combineHash(h, v[j]);
+            h = combineHash(h, n[j]);
+        }
+        if(texCoords != nullptr) {
+            h = combineHash(h, t.x);
+            h = combineHash(h, t.y);
         }
-        else {
-            indices[i] = res->second;
+        
+        size_t slot = finishHash(h) & mask;
+        while(true) {
+            uint32_t k = table[slot];
+            if(k == UINT32_MAX) {
+                k = count++;
+                table[slot] = k;
+                vertices[k] = v;
+                normals[k] = n;
+                if(texCoords != nullptr)
+                    texCoords[k] = t;
+                indices[i] = k;
+                break;
+            }
+            if(vertices[k] == v && normals[k] == n &&
+               (texCoords == nullptr || texCoords[k] == t))
+            {
+                indices[i] = k;
+                break;
+            }
+            slot = (slot + 1) & mask;
         }
     }
     
-    vertex_count = table.size();
-    free(vertices);
-    free(normals);
-    free(texCoords);
-    vertices = (Vec3*) malloc(sizeof(Vec3)*vertex_count);
-    normals = (Vec3*) malloc(sizeof(Vec3)*vertex_count);
-    texCoords = (Vec2*) malloc(sizeof(Vec2)*vertex_count);
-    memcpy(vertices, tempVertices, sizeof(Vec3)*table.size());
-    memcpy(normals, tempNormals, sizeof(Vec3)*table.size());
-    memcpy(texCoords, tempTexCoords, sizeof(Vec2)*table.size());
-    free(tempVertices);
-    free(tempNormals);
-    free(tempTexCoords);
+    vertex_count = count;
+    vertices = (Vec3*) realloc(vertices, sizeof(Vec3)*count);
+    normals = (Vec3*) realloc(normals, sizeof(Vec3)*count);
+    if(texCoords != nullptr)
+        texCoords = (Vec2*) realloc(texCoords, sizeof(Vec2)*count);
+    optimize();
 }
 
 }
@@ -14,12 +14,20 @@
 #include "rmg/mesh.hpp"
 
 #include <algorithm>
+#include <cmath>
 #include <cstdlib>
-#include <unordered_map>
+#include <vector>
+
+#include "rmg/internal/parallel_for.hpp"
+
+#define MESH_PARALLEL_GRAIN 16384 ///< Least triangles or corners per thread
 
 
 namespace rmg {
 
+using internal::parallelFor;
+
+
 void Mesh::buildNormals(bool smooth) {
     removeIndices();
     if(smooth)
@@ -45,52 +53,85 @@ void Mesh::buildNormals1() {
 
 void Mesh::buildNormals2() {
     normals = (Vec3*) malloc(sizeof(Vec3)*vertex_count);
-    uint32_t polygon_count = vertex_count / 3;
-    Vec3 *faceNormals = (Vec3*) malloc(sizeof(Vec3)*polygon_count);
-    float *angles = (float*) malloc(sizeof(float)*vertex_count);
-    std::unordered_multimap<Vec3, uint32_t> table;
+    std::vector<uint32_t> ids = std::vector<uint32_t>(vertex_count);
+    weldPositions(vertices, vertex_count, &ids[0]);
+    buildCornerNormals(vertices, vertex_count, &ids[0], vertex_count, true,
+                       normals);
+}
+
+
+void Mesh::buildCornerNormals(const Vec3* positions, uint32_t positionCount,
+                              const uint32_t* ids, uint32_t cornerCount,
+                              bool smooth, Vec3* normals)
+{
+    uint32_t faceCount = cornerCount / 3;
+    std::vector<Vec3> faceNormals = std::vector<Vec3>(faceCount);
+    std::vector<float> angles;
+    if(smooth)
+        angles.resize(cornerCount);
     
     // Generate hard edged normals and vertex angles
-    for(uint32_t i=0; i<polygon_count; i++) {
-        Vec3 p01 = vertices[i*3 + 1] - vertices[i*3];
-        Vec3 p02 = vertices[i*3 + 2] - vertices[i*3];
-        Vec3 p12 = vertices[i*3 + 2] - vertices[i*3 + 1];
-        
-        faceNormals[i] = (p01 * p02).normalize();
-        
-        float cosT0, cosT1, cosT2;
-        cosT0 = Vec3::dot( p01,  p02) / (p01.magnitude() * p02.magnitude());
-        cosT1 = Vec3::dot( p12, -p01) / (p12.magnitude() * p01.magnitude());
-        cosT2 = Vec3::dot(-p02, -p12) / (p02.magnitude() * p12.magnitude());
-        angles[i*3 + 0] = acos(cosT0);
-        angles[i*3 + 1] = acos(cosT1);
-        angles[i*3 + 2] = acos(cosT2);
-        
-        table.insert(std::make_pair(vertices[i*3 + 0], i*3));
-        table.insert(std::make_pair(vertices[i*3 + 1], i*3 + 1));
-        table.insert(std::make_pair(vertices[i*3 + 2], i*3 + 2));
-    }
+    parallelFor(faceCount, MESH_PARALLEL_GRAIN, [&](size_t b, size_t e) {
+        for(size_t i=b; i<e; i++) {
+            Vec3 p0 = positions[ids[i*3]];
+            Vec3 p01 = positions[ids[i*3 + 1]] - p0;
+            Vec3 p02 = positions[ids[i*3 + 2]] - p0;
+            faceNormals[i] = (p01 * p02).normalize();
+            if(!smooth) {
+                normals[i*3 + 0] = faceNormals[i];
+                normals[i*3 + 1] = faceNormals[i];
+                normals[i*3 + 2] = faceNormals[i];
+                continue;
+            }
+            
+            Vec3 p12 = p02 - p01;
+            float m01 = p01.magnitude();
+            float m02 = p02.magnitude();
+            float m12 = p12.magnitude();
+            float cosT0, cosT1, cosT2;
+            cosT0 = Vec3::dot( p01,  p02) / (m01 * m02);
+            cosT1 = Vec3::dot( p12, -p01) / (m12 * m01);
+            cosT2 = Vec3::dot(-p02, -p12) / (m02 * m12);
+            angles[i*3 + 0] = acos(cosT0);
+            angles[i*3 + 1] = acos(cosT1);
+            angles[i*3 + 2] = acos(cosT2);
+        }
+    });
+    if(!smooth)
+        return;
+    
+    // Groups the corners at the same position contiguously
+    std::vector<uint32_t> offsets = std::vector<uint32_t>(positionCount + 1);
+    for(uint32_t k=0; k<cornerCount; k++)
+        offsets[ids[k] + 1]++;
+    for(uint32_t i=1; i<=positionCount; i++)
+        offsets[i] += offsets[i-1];
+    std::vector<uint32_t> shared = std::vector<uint32_t>(cornerCount);
+    for(uint32_t k=0; k<cornerCount; k++)
+        shared[offsets[ids[k]]++] = k;
+    for(uint32_t i=positionCount; i>0; i--)
+        offsets[i] = offsets[i-1];
+    offsets[0] = 0;
     
     // Soften the edges with slightly different normals
-    for(uint32_t i=0; i<vertex_count; i++) {
-        auto range = table.equal_range(vertices[i]);
-        int count = std::distance(range.first, range.second);
-        
-        if(count > 1) {
+    parallelFor(cornerCount, MESH_PARALLEL_GRAIN, [&](size_t b, size_t e) {
+        for(size_t k=b; k<e; k++) {
+            uint32_t begin = offsets[ids[k]];
+            uint32_t end = offsets[ids[k] + 1];
+            Vec3 n1 = faceNormals[k/3];
+            if(end - begin < 2) {
+                normals[k] = n1;
+                continue;
+            }
             Vec3 n;
-            Vec3 n1 = faceNormals[i/3];
-            for(auto it=range.first; it!=range.second; it++) {
-                Vec3 n2 = faceNormals[it->second/3];
-                float cosT = Vec3::dot(n1, n2);
-                if(cosT > 0.866025f) // 30 degrees
-                    n += n2 * angles[it->second];
+            for(uint32_t j=begin; j<end; j++) {
+                Vec3 n2 = faceNormals[shared[j]/3];
+                if(Vec3::dot(n1, n2) > 0.866025f) // 30 degrees
+                    n += n2 * angles[shared[j]];
             }
-            normals[i] = n.normalize();
+            normals[k] = n.normalize();
         }
-        else {
-            normals[i] = faceNormals[i/3];
-        }
-    }
+    });
 }
 
 }
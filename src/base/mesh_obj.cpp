@@ -0,0 +1,502 @@
+/**
+ * @file mesh_obj.cpp
+ * @brief Loads and constructs 3D meshes from .OBJ files
+ * 
+ * The file is memory-mapped and split into chunks of whole lines which are
+ * parsed by multiple threads. A first pass counts the vertex attributes of
+ * each chunk so that the second pass can write them straight into the
+ * merged arrays and resolve the relative (negative) indices. The mesh is
+ * indexed by welding the corners which share the same OBJ attribute
+ * indices, so the face structure of the file is kept.
+ * 
+ * @copyright Copyright (c) 2020 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#define RMG_EXPORT
+
+
+#include "rmg/mesh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "rmg/internal/mapped_file.hpp"
+#include "rmg/internal/parallel_for.hpp"
+
+#define OBJ_MIN_CHUNK_SIZE (1 << 20) ///< Smallest file part for a thread
+
+
+namespace rmg {
+
+static void printLoadError(const char *file, const char *reason) {
+    #ifdef _WIN32
+    printf("error: Failed to load 3D model `%s`: %s\n", file, reason);
+    #else
+    printf("\033[0;1;31merror: \033[0m"
+           "Failed to load 3D model \033[1m'%s'\033[0m: %s\n",
+           file, reason);
+    #endif
+}
+
+
+namespace {
+
+enum class OBJLine {
+    Vertex,
+    TexCoord,
+    Normal,
+    Face,
+    Other
+};
+
+struct OBJCorner {
+    int32_t v; // Index of the vertex
+    int32_t t; // Index of the texture coordinate or -1
+    int32_t n; // Index of the normal or -1
+};
+
+struct OBJChunk {
+    const char* begin;
+    const char* end;
+    uint32_t vertexCount = 0;
+    uint32_t texCoordCount = 0;
+    uint32_t normalCount = 0;
+    uint32_t vertexOffset = 0;
+    uint32_t texCoordOffset = 0;
+    uint32_t normalOffset = 0;
+    std::vector<OBJCorner> corners;
+    bool hasTexCoord = false;
+    bool missingNormal = false;
+    const char* error = nullptr;
+};
+
+struct OBJArrays {
+    std::vector<Vec3> vertices;
+    std::vector<Vec2> texCoords;
+    std::vector<Vec3> normals;
+};
+
+}
+
+
+static inline bool isBlank(char c) { return c == ' ' || c == '\t'; }
+
+static inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+static inline const char* skipBlanks(const char* p, const char* end) {
+    while(p < end && isBlank(*p))
+        p++;
+    return p;
+}
+
+static inline const char* nextLine(const char* p, const char* end) {
+    const char* q = (const char*) memchr(p, '\n', end - p);
+    return (q == nullptr) ? end : q + 1;
+}
+
+static OBJLine readLineType(const char* &p, const char* end) {
+    p = skipBlanks(p, end);
+    if(end - p < 2)
+        return OBJLine::Other;
+    if(p[0] == 'v') {
+        if(isBlank(p[1])) {
+            p += 2;
+            return OBJLine::Vertex;
+        }
+        if(end - p >= 3 && isBlank(p[2])) {
+            if(p[1] == 't') {
+                p += 3;
+                return OBJLine::TexCoord;
+            }
+            if(p[1] == 'n') {
+                p += 3;
+                return OBJLine::Normal;
+            }
+        }
+    }
+    else if(p[0] == 'f' && isBlank(p[1])) {
+        p += 2;
+        return OBJLine::Face;
+    }
+    return OBJLine::Other;
+}
+
+static const char* parseFloat(const char* p, const char* end, float *out) {
+    static const double pow10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+        1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+        1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    p = skipBlanks(p, end);
+    bool negative = false;
+    if(p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+    // Keeps 18 significant digits which is more than a float needs
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    bool digits = false;
+    for(; p < end && isDigit(*p); p++) {
+        if(mantissa < 100000000000000000ULL)
+            mantissa = mantissa*10 + (*p - '0');
+        else
+            exponent++;
+        digits = true;
+    }
+    if(p < end && *p == '.') {
+        for(p++; p < end && isDigit(*p); p++) {
+            if(mantissa < 100000000000000000ULL) {
+                mantissa = mantissa*10 + (*p - '0');
+                exponent--;
+            }
+            digits = true;
+        }
+    }
+    if(!digits)
+        return nullptr;
+    if(p < end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool expNegative = false;
+        if(q < end && (*q == '-' || *q == '+')) {
+            expNegative = (*q == '-');
+            q++;
+        }
+        if(q < end && isDigit(*q)) {
+            int e = 0;
+            for(; q < end && isDigit(*q); q++) {
+                if(e < 10000)
+                    e = e*10 + (*q - '0');
+            }
+            exponent += expNegative ? -e : e;
+            p = q;
+        }
+    }
+    double value = (double) mantissa;
+    if(exponent < 0) {
+        if(exponent >= -22)
+            value /= pow10[-exponent];
+        else
+            value *= pow(10.0, exponent);
+    }
+    else if(exponent > 0) {
+        if(exponent <= 22)
+            value *= pow10[exponent];
+        else
+            value *= pow(10.0, exponent);
+    }
+    *out = (float) (negative ? -value : value);
+    return p;
+}
+
+static const char* parseInt(const char* p, const char* end, int32_t *out) {
+    bool negative = false;
+    if(p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+    if(p == end || !isDigit(*p))
+        return nullptr;
+    int64_t value = 0;
+    for(; p < end && isDigit(*p); p++) {
+        if(value <= INT32_MAX)
+            value = value*10 + (*p - '0');
+    }
+    if(value > INT32_MAX)
+        return nullptr;
+    *out = (int32_t) (negative ? -value : value);
+    return p;
+}
+
+static const char* parseFloats(const char* p, const char* end, float *out,
+                               int count)
+{
+    for(int i=0; i<count && p != nullptr; i++)
+        p = parseFloat(p, end, &out[i]);
+    return p;
+}
+
+// Converts a 1-based or negative relative index to a 0-based index
+static bool resolveIndex(int32_t i, uint32_t defined, uint32_t total,
+                         int32_t *out)
+{
+    int64_t index;
+    if(i > 0)
+        index = (int64_t) i - 1;
+    else if(i < 0)
+        index = (int64_t) defined + i;
+    else
+        return false;
+    if(index < 0 || index >= total)
+        return false;
+    *out = (int32_t) index;
+    return true;
+}
+
+static void countOBJChunk(OBJChunk &chunk) {
+    const char* end = chunk.end;
+    for(const char* p = chunk.begin; p < end; p = nextLine(p, end)) {
+        OBJLine type = readLineType(p, end);
+        if(type == OBJLine::Vertex)
+            chunk.vertexCount++;
+        else if(type == OBJLine::TexCoord)
+            chunk.texCoordCount++;
+        else if(type == OBJLine::Normal)
+            chunk.normalCount++;
+    }
+}
+
+static void parseOBJChunk(OBJChunk &chunk, OBJArrays &arr) {
+    const char* end = chunk.end;
+    uint32_t vCount = chunk.vertexOffset;
+    uint32_t tCount = chunk.texCoordOffset;
+    uint32_t nCount = chunk.normalOffset;
+    uint32_t vTotal = (uint32_t) arr.vertices.size();
+    uint32_t tTotal = (uint32_t) arr.texCoords.size();
+    uint32_t nTotal = (uint32_t) arr.normals.size();
+    
+    for(const char* p = chunk.begin; p < end; p = nextLine(p, end)) {
+        OBJLine type = readLineType(p, end);
+        if(type == OBJLine::Vertex) {
+            if(parseFloats(p, end, &arr.vertices[vCount++][0], 3) == nullptr)
+            {
+                chunk.error = "Invalid vertex coordinate";
+                return;
+            }
+        }
+        else if(type == OBJLine::TexCoord) {
+            if(parseFloats(p, end, &arr.texCoords[tCount++][0], 2) == nullptr)
+            {
+                chunk.error = "Invalid texture coordinate";
+                return;
+            }
+        }
+        else if(type == OBJLine::Normal) {
+            if(parseFloats(p, end, &arr.normals[nCount++][0], 3) == nullptr) {
+                chunk.error = "Invalid vertex normal";
+                return;
+            }
+        }
+        else if(type == OBJLine::Face) {
+            // Polygons with more than 3 corners are split into a fan of
+            // triangles
+            OBJCorner first = {0, 0, 0};
+            OBJCorner prev = {0, 0, 0};
+            int n = 0;
+            while(true) {
+                p = skipBlanks(p, end);
+                if(p == end || *p == '\r' || *p == '\n' || *p == '#')
+                    break;
+                OBJCorner c = {-1, -1, -1};
+                int32_t i;
+                p = parseInt(p, end, &i);
+                if(p == nullptr || !resolveIndex(i, vCount, vTotal, &c.v)) {
+                    chunk.error = "Vertex index out of bounds";
+                    return;
+                }
+                if(p < end && *p == '/') {
+                    p++;
+                    if(p < end && *p != '/') {
+                        p = parseInt(p, end, &i);
+                        if(p == nullptr ||
+                           !resolveIndex(i, tCount, tTotal, &c.t))
+                        {
+                            chunk.error = "Texture index out of bounds";
+                            return;
+                        }
+                    }
+                    if(p < end && *p == '/') {
+                        p++;
+                        p = parseInt(p, end, &i);
+                        if(p == nullptr ||
+                           !resolveIndex(i, nCount, nTotal, &c.n))
+                        {
+                            chunk.error = "Normal index out of bounds";
+                            return;
+                        }
+                    }
+                }
+                if(p < end && !isBlank(*p) && *p != '\r' && *p != '\n') {
+                    chunk.error = "Invalid face element";
+                    return;
+                }
+                chunk.hasTexCoord |= (c.t >= 0);
+                chunk.missingNormal |= (c.n < 0);
+                if(n == 0) {
+                    first = c;
+                }
+                else if(n >= 2) {
+                    chunk.corners.push_back(first);
+                    chunk.corners.push_back(prev);
+                    chunk.corners.push_back(c);
+                }
+                prev = c;
+                n++;
+            }
+            if(n < 3) {
+                chunk.error = "Face with less than 3 vertices";
+                return;
+            }
+        }
+    }
+}
+
+Mesh Mesh::loadOBJ(const char* file, bool smooth) {
+    internal::MappedFile mapped(file);
+    if(!mapped.isOpen()) {
+        #ifdef _WIN32
+        printf("error: File '%s' could not be opened\n", file);
+        #else
+        printf("\033[0;1;31merror: \033[0m"
+               "File \033[1m'%s'\033[0m "
+               "could not be opened\n", file);
+        #endif
+        return Mesh();
+    }
+    
+    // Splits the file into chunks of whole lines
+    const char* data = mapped.getData();
+    const char* dataEnd = data + mapped.getSize();
+    size_t chunkCount = std::thread::hardware_concurrency();
+    chunkCount = std::min(chunkCount, mapped.getSize() / OBJ_MIN_CHUNK_SIZE);
+    chunkCount = std::max(chunkCount, (size_t) 1);
+    std::vector<OBJChunk> chunks = std::vector<OBJChunk>(chunkCount);
+    const char* p = data;
+    for(size_t i=0; i<chunkCount; i++) {
+        chunks[i].begin = p;
+        if(i == chunkCount - 1)
+            p = dataEnd;
+        else
+            p = nextLine(data + mapped.getSize()*(i+1)/chunkCount, dataEnd);
+        chunks[i].end = std::max(p, chunks[i].begin);
+        p = chunks[i].end;
+    }
+    
+    // Counts the vertex attributes and finds where each chunk's go in the
+    // merged arrays
+    internal::parallelFor(chunkCount, 1, [&chunks](size_t b, size_t e) {
+        for(size_t i=b; i<e; i++)
+            countOBJChunk(chunks[i]);
+    });
+    OBJArrays arr;
+    uint32_t vTotal = 0, tTotal = 0, nTotal = 0;
+    for(auto it=chunks.begin(); it!=chunks.end(); it++) {
+        it->vertexOffset = vTotal;
+        it->texCoordOffset = tTotal;
+        it->normalOffset = nTotal;
+        vTotal += it->vertexCount;
+        tTotal += it->texCoordCount;
+        nTotal += it->normalCount;
+    }
+    arr.vertices.resize(vTotal);
+    arr.texCoords.resize(tTotal);
+    arr.normals.resize(nTotal);
+    
+    internal::parallelFor(chunkCount, 1, [&chunks, &arr](size_t b, size_t e) {
+        for(size_t i=b; i<e; i++)
+            parseOBJChunk(chunks[i], arr);
+    });
+    
+    // Merges the triangles of the chunks
+    size_t cornerCount = 0;
+    bool hasTexCoord = false;
+    bool hasNormal = true;
+    for(size_t i=0; i<chunkCount; i++) {
+        if(chunks[i].error != nullptr) {
+            printLoadError(file, chunks[i].error);
+            return Mesh();
+        }
+        cornerCount += chunks[i].corners.size();
+        hasTexCoord |= chunks[i].hasTexCoord;
+        hasNormal &= !chunks[i].missingNormal;
+    }
+    if(cornerCount == 0)
+        return Mesh();
+    std::vector<OBJCorner> corners = std::move(chunks[0].corners);
+    corners.reserve(cornerCount);
+    for(size_t i=1; i<chunkCount; i++) {
+        corners.insert(corners.end(), chunks[i].corners.begin(),
+                       chunks[i].corners.end());
+        std::vector<OBJCorner>().swap(chunks[i].corners);
+    }
+    
+    std::vector<Vec3> cornerNormals;
+    if(!hasNormal) {
+        // Patches of a model may repeat the positions on their seams which
+        // have to share the generated normals
+        std::vector<uint32_t> canonical = std::vector<uint32_t>(vTotal);
+        weldPositions(&arr.vertices[0], vTotal, &canonical[0]);
+        std::vector<uint32_t> ids = std::vector<uint32_t>(cornerCount);
+        for(size_t k=0; k<cornerCount; k++) {
+            corners[k].v = canonical[corners[k].v];
+            ids[k] = corners[k].v;
+        }
+        cornerNormals.resize(cornerCount);
+        buildCornerNormals(&arr.vertices[0], vTotal, &ids[0], cornerCount,
+                           smooth, &cornerNormals[0]);
+    }
+    
+    // Welds the corners with the same attributes into a vertex. The output
+    // vertices of an OBJ vertex are chained from first[v] so that only the
+    // few corners sharing the position are compared.
+    Mesh mesh;
+    mesh.indices = (uint32_t*) malloc(sizeof(uint32_t)*cornerCount);
+    mesh.index_count = cornerCount;
+    std::vector<uint32_t> first = std::vector<uint32_t>(vTotal, UINT32_MAX);
+    std::vector<uint32_t> next;
+    std::vector<uint32_t> sources;
+    for(uint32_t k=0; k<cornerCount; k++) {
+        const OBJCorner &c = corners[k];
+        uint32_t id = first[c.v];
+        while(id != UINT32_MAX) {
+            const OBJCorner &s = corners[sources[id]];
+            if(s.t == c.t) {
+                if(hasNormal && s.n == c.n)
+                    break;
+                if(!hasNormal && cornerNormals[sources[id]] == cornerNormals[k])
+                    break;
+            }
+            id = next[id];
+        }
+        if(id == UINT32_MAX) {
+            id = sources.size();
+            sources.push_back(k);
+            next.push_back(first[c.v]);
+            first[c.v] = id;
+        }
+        mesh.indices[k] = id;
+    }
+    
+    // Completes the mesh
+    uint32_t vcount = sources.size();
+    mesh.vertices = (Vec3*) malloc(sizeof(Vec3)*vcount);
+    mesh.normals = (Vec3*) malloc(sizeof(Vec3)*vcount);
+    if(hasTexCoord)
+        mesh.texCoords = (Vec2*) malloc(sizeof(Vec2)*vcount);
+    mesh.vertex_count = vcount;
+    for(uint32_t i=0; i<vcount; i++) {
+        const OBJCorner &c = corners[sources[i]];
+        mesh.vertices[i] = arr.vertices[c.v];
+        if(hasNormal)
+            mesh.normals[i] = arr.normals[c.n];
+        else
+            mesh.normals[i] = cornerNormals[sources[i]];
+        if(hasTexCoord) {
+            if(c.t >= 0)
+                mesh.texCoords[i] = arr.texCoords[c.t];
+            else
+                mesh.texCoords[i] = Vec2(0, 0);
+        }
+    }
+    mesh.optimize();
+    return mesh;
+}
+
+}
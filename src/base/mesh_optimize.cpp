@@ -0,0 +1,181 @@
+/**
+ * @file mesh_optimize.cpp
+ * @brief Reorders the triangles and vertices for the GPU vertex cache
+ * 
+ * The triangles are reordered with Tipsify (Sander, Nehab and Barczak,
+ * "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw",
+ * 2007) which fans around the vertices still in the cache. The vertices
+ * are then stored in the order of their first use so that the vertex
+ * fetches also read the memory in order.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#define RMG_EXPORT
+
+
+#include "rmg/mesh.hpp"
+
+#include <cstdlib>
+#include <vector>
+
+
+namespace rmg {
+
+/**
+ * @brief Reorders the triangles and vertices for the GPU vertex cache
+ * 
+ * Meshes built from vertex arrays and 3D model files are optimized
+ * already. Use this for meshes constructed from custom indices.
+ * 
+ * @param cacheSize Number of vertices the post-transform cache holds
+ */
+void Mesh::optimize(uint32_t cacheSize) {
+    if(!isValid() || cacheSize == 0)
+        return;
+    // Mapped arrays are read-only
+    if(mapping != nullptr)
+        *this = Mesh(*this);
+    
+    uint32_t triangleCount = index_count / 3;
+    
+    // Triangles around each vertex
+    std::vector<uint32_t> offsets = std::vector<uint32_t>(vertex_count + 1);
+    for(uint32_t i=0; i<index_count; i++)
+        offsets[indices[i] + 1]++;
+    for(uint32_t i=1; i<=vertex_count; i++)
+        offsets[i] += offsets[i-1];
+    std::vector<uint32_t> adjacent = std::vector<uint32_t>(index_count);
+    for(uint32_t i=0; i<index_count; i++)
+        adjacent[offsets[indices[i]]++] = i / 3;
+    for(uint32_t i=vertex_count; i>0; i--)
+        offsets[i] = offsets[i-1];
+    offsets[0] = 0;
+    
+    std::vector<uint32_t> live = std::vector<uint32_t>(vertex_count);
+    for(uint32_t i=0; i<vertex_count; i++)
+        live[i] = offsets[i+1] - offsets[i];
+    std::vector<uint32_t> cacheTime = std::vector<uint32_t>(vertex_count);
+    std::vector<bool> emitted = std::vector<bool>(triangleCount);
+    std::vector<uint32_t> deadEnd;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    output.reserve(index_count);
+    uint32_t time = cacheSize + 1;
+    uint32_t cursor = 0;
+    int64_t fan = 0;
+    
+    while(fan >= 0) {
+        // Emits the remaining triangles around the fanning vertex
+        candidates.clear();
+        for(uint32_t j=offsets[fan]; j<offsets[fan+1]; j++) {
+            uint32_t t = adjacent[j];
+            if(emitted[t])
+                continue;
+            for(int c=0; c<3; c++) {
+                uint32_t v = indices[t*3 + c];
+                output.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if(time - cacheTime[v] > cacheSize)
+                    cacheTime[v] = time++;
+            }
+            emitted[t] = true;
+        }
+        
+        // Picks the candidate which stays in the cache after its fan
+        int64_t next = -1;
+        uint32_t best = 0;
+        for(auto it=candidates.begin(); it!=candidates.end(); it++) {
+            if(live[*it] == 0)
+                continue;
+            uint32_t priority = 0;
+            if(time - cacheTime[*it] + 2*live[*it] <= cacheSize)
+                priority = time - cacheTime[*it];
+            if(next < 0 || priority > best) {
+                best = priority;
+                next = *it;
+            }
+        }
+        
+        // Otherwise continues from a recent vertex or the next in order
+        while(next < 0 && !deadEnd.empty()) {
+            uint32_t v = deadEnd.back();
+            deadEnd.pop_back();
+            if(live[v] > 0)
+                next = v;
+        }
+        while(next < 0 && cursor < vertex_count) {
+            if(live[cursor] > 0)
+                next = cursor;
+            cursor++;
+        }
+        fan = next;
+    }
+    
+    // Stores the vertices in the order of their first use
+    std::vector<uint32_t> remap = std::vector<uint32_t>(vertex_count,
+                                                        UINT32_MAX);
+    uint32_t count = 0;
+    for(uint32_t i=0; i<index_count; i++) {
+        uint32_t v = output[i];
+        if(remap[v] == UINT32_MAX)
+            remap[v] = count++;
+        indices[i] = remap[v];
+    }
+    Vec3 *tempVertices = (Vec3*) malloc(sizeof(Vec3)*count);
+    Vec3 *tempNormals = (Vec3*) malloc(sizeof(Vec3)*count);
+    for(uint32_t i=0; i<vertex_count; i++) {
+        if(remap[i] == UINT32_MAX)
+            continue;
+        tempVertices[remap[i]] = vertices[i];
+        tempNormals[remap[i]] = normals[i];
+    }
+    free(vertices);
+    free(normals);
+    vertices = tempVertices;
+    normals = tempNormals;
+    if(texCoords != nullptr) {
+        Vec2 *tempTexCoords = (Vec2*) malloc(sizeof(Vec2)*count);
+        for(uint32_t i=0; i<vertex_count; i++) {
+            if(remap[i] != UINT32_MAX)
+                tempTexCoords[remap[i]] = texCoords[i];
+        }
+        free(texCoords);
+        texCoords = tempTexCoords;
+    }
+    vertex_count = count;
+}
+
+/**
+ * @brief Gets the average cache miss ratio of the triangle order
+ * 
+ * Simulates a FIFO post-transform vertex cache. The ratio is the number
+ * of vertices transformed per triangle which lies between 0.5 and 3 and
+ * the lower the better.
+ * 
+ * @param cacheSize Number of vertices the post-transform cache holds
+ * 
+ * @return Average cache miss ratio (ACMR)
+ */
+float Mesh::getACMR(uint32_t cacheSize) const {
+    if(index_count == 0)
+        return 0;
+    std::vector<uint32_t> cacheTime = std::vector<uint32_t>(vertex_count);
+    uint32_t time = cacheSize + 1;
+    uint32_t misses = 0;
+    for(uint32_t i=0; i<index_count; i++) {
+        uint32_t v = indices[i];
+        if(time - cacheTime[v] > cacheSize) {
+            cacheTime[v] = time++;
+            misses++;
+        }
+    }
+    return (float) misses / (index_count / 3);
+}
+
+}
@@ -0,0 +1,426 @@
+/**
+ * @file mesh_rmgmesh.cpp
+ * @brief Saves and maps meshes in the binary mesh file format (.rmgmesh)
+ * 
+ * The file starts with a fixed size header and the headers of the levels
+ * of detail, followed by the arrays of vertices, normals, texture
+ * coordinates (optional) and indices of the mesh and then of each level.
+ * The context caches also store the streams of every level encoded for
+ * the GPU buffers after them. Every array is stored in the native byte
+ * order, so a mapped file needs neither parsing nor copying.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#define RMG_EXPORT
+
+
+#include "rmg/mesh.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "rmg/internal/mapped_file.hpp"
+
+
+#define RMG_MESH_FILE_VERSION 5
+
+#define RMG_MESH_FILE_TEXCOORDS 0x1
+#define RMG_MESH_FILE_LEVELS 0x2 ///< Levels of detail have been built
+#define RMG_MESH_FILE_ENCODED 0x4 ///< Streams encoded for the GPU follow
+
+
+namespace {
+
+struct MeshFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    float boundsMin[3];
+    float boundsMax[3];
+    uint32_t levelCount;
+    uint32_t encodedFormat;
+    float encodedOffset[3];
+    float encodedScale[3];
+    uint64_t sourceSize;
+    uint64_t sourceTime;
+};
+
+struct LevelHeader {
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    float error;
+};
+
+struct StreamHeader {
+    uint32_t positionSize;
+    uint32_t attributeSize;
+    uint32_t indexSize;
+};
+
+static_assert(sizeof(MeshFileHeader) == 96, "Unexpected header padding");
+static_assert(sizeof(LevelHeader) == 12, "Unexpected header padding");
+static_assert(sizeof(StreamHeader) == 12, "Unexpected header padding");
+static_assert(sizeof(rmg::Vec3) == 3*sizeof(float), "Vec3 is not packed");
+static_assert(sizeof(rmg::Vec2) == 2*sizeof(float), "Vec2 is not packed");
+
+const char MESH_FILE_MAGIC[8] = {'R', 'M', 'G', 'M', 'E', 'S', 'H', '\0'};
+
+uint64_t getArraySize(uint32_t vertexCount, uint32_t indexCount,
+                      uint32_t flags)
+{
+    uint64_t n = vertexCount;
+    uint64_t size = n * 2 * sizeof(rmg::Vec3);
+    if(flags & RMG_MESH_FILE_TEXCOORDS)
+        size += n * sizeof(rmg::Vec2);
+    return size + (uint64_t) indexCount * sizeof(uint32_t);
+}
+
+
+// The encoded streams are padded to keep the next ones 4-byte aligned
+inline uint64_t getPaddedSize(uint32_t size) { return (size + 3) & ~3ull; }
+
+
+// Every index refers to a vertex. Takes the maximum without branching so
+// that the check runs at the speed of reading the memory.
+bool checkIndices(const uint32_t* indices, uint32_t count,
+                  uint32_t vertexCount)
+{
+    uint32_t max = 0;
+    for(uint32_t i=0; i<count; i++)
+        max = std::max(max, indices[i]);
+    return max < vertexCount;
+}
+
+
+bool writeArrays(FILE* fp, const rmg::Vec3* vertices, const rmg::Vec3* normals,
+                 const rmg::Vec2* texCoords, uint32_t vertexCount,
+                 const uint32_t* indices, uint32_t indexCount)
+{
+    bool ok = fwrite(vertices, sizeof(rmg::Vec3), vertexCount, fp) ==
+              vertexCount;
+    ok = ok && fwrite(normals, sizeof(rmg::Vec3), vertexCount, fp) ==
+               vertexCount;
+    if(texCoords != nullptr) {
+        ok = ok && fwrite(texCoords, sizeof(rmg::Vec2), vertexCount, fp) ==
+                   vertexCount;
+    }
+    ok = ok && fwrite(indices, sizeof(uint32_t), indexCount, fp) ==
+               indexCount;
+    return ok;
+}
+
+
+bool writeStream(FILE* fp, const void* data, uint32_t size) {
+    const char padding[4] = {0, 0, 0, 0};
+    uint32_t n = getPaddedSize(size) - size;
+    return fwrite(data, 1, size, fp) == size &&
+           fwrite(padding, 1, n, fp) == n;
+}
+
+}
+
+
+namespace rmg {
+
+/**
+ * @brief Saves the mesh in the binary mesh file format (.rmgmesh)
+ * 
+ * The arrays are stored in the layout of the GPU buffers so that
+ * loadMapped() can hand them to the GPU without parsing. The file is
+ * written under a temporary name first and then renamed, so readers
+ * never see a partially written file.
+ * 
+ * @param file Path for the mesh file
+ * 
+ * @return True if the file is written
+ */
+bool Mesh::save(const char* file) const {
+    return save(file, std::vector<Mesh>(), std::vector<float>(), nullptr,
+                nullptr);
+}
+
+
+bool Mesh::save(const char* file, const std::vector<Mesh> &levels,
+                const std::vector<float> &errors, const Encoding* encoding,
+                const SourceStamp* source) const
+{
+    if(!isValid())
+        return false;
+    if(encoding != nullptr && encoding->levels.size() != levels.size() + 1)
+        return false;
+    
+    MeshFileHeader header;
+    memcpy(header.magic, MESH_FILE_MAGIC, sizeof(header.magic));
+    header.version = RMG_MESH_FILE_VERSION;
+    header.flags = (texCoords != nullptr) ? RMG_MESH_FILE_TEXCOORDS : 0;
+    if(!errors.empty())
+        header.flags |= RMG_MESH_FILE_LEVELS;
+    header.vertexCount = vertex_count;
+    header.indexCount = index_count;
+    BoundingBox box = getBoundingBox();
+    for(int i=0; i<3; i++) {
+        header.boundsMin[i] = box.min[i];
+        header.boundsMax[i] = box.max[i];
+    }
+    header.levelCount = levels.size();
+    header.encodedFormat = 0;
+    for(int i=0; i<3; i++) {
+        header.encodedOffset[i] = 0;
+        header.encodedScale[i] = 0;
+    }
+    header.sourceSize = (source != nullptr) ? source->size : 0;
+    header.sourceTime = (source != nullptr) ? source->time : 0;
+    std::vector<StreamHeader> streamHeaders;
+    if(encoding != nullptr) {
+        header.flags |= RMG_MESH_FILE_ENCODED;
+        header.encodedFormat = encoding->format;
+        for(int i=0; i<3; i++) {
+            header.encodedOffset[i] = encoding->offset[i];
+            header.encodedScale[i] = encoding->scale[i];
+        }
+        for(auto it=encoding->levels.begin(); it!=encoding->levels.end();
+            it++)
+        {
+            StreamHeader h;
+            h.positionSize = it->positionSize;
+            h.attributeSize = it->attributeSize;
+            h.indexSize = it->indexSize;
+            streamHeaders.push_back(h);
+        }
+    }
+    std::vector<LevelHeader> levelHeaders = std::vector<LevelHeader>(
+        levels.size()
+    );
+    for(size_t i=0; i<levels.size(); i++) {
+        // The levels share the vertex format of the mesh
+        if(!levels[i].isValid() ||
+           (levels[i].texCoords != nullptr) != (texCoords != nullptr))
+        {
+            return false;
+        }
+        levelHeaders[i].vertexCount = levels[i].vertex_count;
+        levelHeaders[i].indexCount = levels[i].index_count;
+        levelHeaders[i].error = errors[i+1];
+    }
+    
+    // Several loads of the same model may write the file at once
+    size_t id = std::hash<std::thread::id>()(std::this_thread::get_id());
+    std::string tmp = std::string(file) + ".tmp" + std::to_string(id);
+    FILE* fp = fopen(tmp.c_str(), "wb");
+    if(!fp)
+        return false;
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+    ok = ok && fwrite(levelHeaders.data(), sizeof(LevelHeader),
+                      levels.size(), fp) == levels.size();
+    ok = ok && fwrite(streamHeaders.data(), sizeof(StreamHeader),
+                      streamHeaders.size(), fp) == streamHeaders.size();
+    ok = ok && writeArrays(fp, vertices, normals, texCoords, vertex_count,
+                           indices, index_count);
+    for(auto it=levels.begin(); it!=levels.end(); it++) {
+        ok = ok && writeArrays(fp, it->vertices, it->normals, it->texCoords,
+                               it->vertex_count, it->indices,
+                               it->index_count);
+    }
+    for(size_t i=0; i<streamHeaders.size(); i++) {
+        const EncodedLevel &e = encoding->levels[i];
+        ok = ok && writeStream(fp, e.positions, e.positionSize);
+        ok = ok && writeStream(fp, e.attributes, e.attributeSize);
+        ok = ok && writeStream(fp, e.indices, e.indexSize);
+    }
+    ok = (fclose(fp) == 0) && ok;
+    
+    #ifdef _WIN32
+    // Renaming does not replace an existing file on Windows
+    if(ok)
+        remove(file);
+    #endif
+    if(!ok || rename(tmp.c_str(), file) != 0) {
+        remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Maps a binary mesh file (.rmgmesh) into the memory
+ * 
+ * The arrays of the returned mesh point into the mapped file and are
+ * read-only. The file stays mapped until the mesh is destroyed.
+ * Copies of the mesh own ordinary arrays.
+ * 
+ * @param file Path to the mesh file
+ * 
+ * @return Loaded mesh or an invalid mesh if the file is missing, was
+ *         written by another version, is truncated or has indices out
+ *         of the vertices
+ */
+Mesh Mesh::loadMapped(const char* file) {
+    return loadMapped(file, nullptr, nullptr, nullptr, nullptr);
+}
+
+
+Mesh Mesh::loadMapped(const char* file, std::vector<Mesh> *levels,
+                      std::vector<float> *errors, Encoding* encoding,
+                      SourceStamp* source)
+{
+    if(levels != nullptr)
+        levels->clear();
+    if(errors != nullptr)
+        errors->clear();
+    if(encoding != nullptr)
+        *encoding = Encoding();
+    auto mapped = new internal::MappedFile(file);
+    const MeshFileHeader* header = (const MeshFileHeader*) mapped->getData();
+    uint64_t size = sizeof(MeshFileHeader);
+    const LevelHeader* levelHeaders = nullptr;
+    const StreamHeader* streamHeaders = nullptr;
+    uint32_t streamCount = 0;
+    bool ok = mapped->getSize() >= size &&
+              memcmp(header->magic, MESH_FILE_MAGIC,
+                     sizeof(header->magic)) == 0 &&
+              header->version == RMG_MESH_FILE_VERSION &&
+              header->vertexCount != 0 && header->indexCount != 0 &&
+              header->indexCount % 3 == 0;
+    if(ok) {
+        levelHeaders = (const LevelHeader*) (mapped->getData() + size);
+        size += (uint64_t) header->levelCount * sizeof(LevelHeader);
+        streamHeaders = (const StreamHeader*) (mapped->getData() + size);
+        if(header->flags & RMG_MESH_FILE_ENCODED)
+            streamCount = header->levelCount + 1;
+        size += (uint64_t) streamCount * sizeof(StreamHeader);
+        ok = mapped->getSize() >= size;
+    }
+    uint64_t arrayEnd = 0;
+    if(ok) {
+        size += getArraySize(header->vertexCount, header->indexCount,
+                             header->flags);
+        for(uint32_t i=0; i<header->levelCount && ok; i++) {
+            const LevelHeader &h = levelHeaders[i];
+            ok = h.vertexCount != 0 && h.indexCount != 0 &&
+                 h.indexCount % 3 == 0;
+            size += getArraySize(h.vertexCount, h.indexCount, header->flags);
+        }
+        arrayEnd = size;
+        for(uint32_t i=0; i<streamCount; i++) {
+            const StreamHeader &h = streamHeaders[i];
+            size += getPaddedSize(h.positionSize);
+            size += getPaddedSize(h.attributeSize);
+            size += getPaddedSize(h.indexSize);
+        }
+        ok = ok && size == mapped->getSize();
+    }
+    if(!ok) {
+        delete mapped;
+        return Mesh();
+    }
+    
+    // The arrays are 4-byte aligned as the mapping starts at a page
+    Mesh mesh;
+    mesh.mapping = mapped;
+    const char* ptr = (const char*) (streamHeaders + streamCount);
+    uint32_t n = header->vertexCount;
+    mesh.vertices = (Vec3*) ptr;
+    ptr += n * sizeof(Vec3);
+    mesh.normals = (Vec3*) ptr;
+    ptr += n * sizeof(Vec3);
+    if(header->flags & RMG_MESH_FILE_TEXCOORDS) {
+        mesh.texCoords = (Vec2*) ptr;
+        ptr += n * sizeof(Vec2);
+    }
+    mesh.indices = (uint32_t*) ptr;
+    ptr += header->indexCount * sizeof(uint32_t);
+    mesh.vertex_count = n;
+    mesh.index_count = header->indexCount;
+    if(!checkIndices(mesh.indices, mesh.index_count, n))
+        return Mesh();
+    
+    Vec3 min = Vec3(header->boundsMin[0], header->boundsMin[1],
+                    header->boundsMin[2]);
+    Vec3 max = Vec3(header->boundsMax[0], header->boundsMax[1],
+                    header->boundsMax[2]);
+    mesh.mappedBounds = BoundingBox(min, max);
+    if(source != nullptr) {
+        source->size = header->sourceSize;
+        source->time = header->sourceTime;
+    }
+    
+    if(errors != nullptr && (header->flags & RMG_MESH_FILE_LEVELS)) {
+        errors->push_back(0);
+        for(uint32_t i=0; i<header->levelCount; i++)
+            errors->push_back(levelHeaders[i].error);
+    }
+    
+    // The levels are small enough to copy out of the mapping
+    if(levels != nullptr && (header->flags & RMG_MESH_FILE_LEVELS)) {
+        for(uint32_t i=0; i<header->levelCount; i++) {
+            const LevelHeader &h = levelHeaders[i];
+            const Vec3* vert = (const Vec3*) ptr;
+            ptr += h.vertexCount * sizeof(Vec3);
+            const Vec3* norm = (const Vec3*) ptr;
+            ptr += h.vertexCount * sizeof(Vec3);
+            const Vec2* tex = nullptr;
+            if(header->flags & RMG_MESH_FILE_TEXCOORDS) {
+                tex = (const Vec2*) ptr;
+                ptr += h.vertexCount * sizeof(Vec2);
+            }
+            const uint32_t* in = (const uint32_t*) ptr;
+            ptr += h.indexCount * sizeof(uint32_t);
+            if(!checkIndices(in, h.indexCount, h.vertexCount)) {
+                levels->clear();
+                if(errors != nullptr)
+                    errors->clear();
+                return Mesh();
+            }
+            levels->push_back(Mesh(vert, norm, tex, h.vertexCount, in,
+                                   h.indexCount));
+        }
+    }
+    
+    // The encoded streams stay in the mapping. Their contents are up to
+    // the reader to check.
+    if(encoding != nullptr && streamCount > 0) {
+        encoding->format = header->encodedFormat;
+        encoding->offset = Vec3(header->encodedOffset[0],
+                                header->encodedOffset[1],
+                                header->encodedOffset[2]);
+        encoding->scale = Vec3(header->encodedScale[0],
+                               header->encodedScale[1],
+                               header->encodedScale[2]);
+        encoding->levels.resize(streamCount);
+        ptr = mapped->getData() + arrayEnd;
+        for(uint32_t i=0; i<streamCount; i++) {
+            const StreamHeader &h = streamHeaders[i];
+            EncodedLevel &e = encoding->levels[i];
+            e.vertexCount = (i == 0) ? n : levelHeaders[i-1].vertexCount;
+            e.indexCount = (i == 0) ? header->indexCount
+                                    : levelHeaders[i-1].indexCount;
+            e.positionSize = h.positionSize;
+            e.attributeSize = h.attributeSize;
+            e.indexSize = h.indexSize;
+            if(h.positionSize > 0)
+                e.positions = ptr;
+            ptr += getPaddedSize(h.positionSize);
+            if(h.attributeSize > 0)
+                e.attributes = ptr;
+            ptr += getPaddedSize(h.attributeSize);
+            if(h.indexSize > 0)
+                e.indices = ptr;
+            ptr += getPaddedSize(h.indexSize);
+        }
+    }
+    return mesh;
+}
+
+}
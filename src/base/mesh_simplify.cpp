@@ -0,0 +1,446 @@
+/**
+ * @file mesh_simplify.cpp
+ * @brief Reduces the triangles of a mesh by collapsing its edges
+ * 
+ * The edges are collapsed in the order of their quadric error (Garland
+ * and Heckbert, "Surface Simplification Using Quadric Error Metrics",
+ * 1997). Each vertex moves onto one of its neighbours so that no new
+ * vertex attributes need to be interpolated. The vertices on the open
+ * borders only slide along the borders, held by the planes through the
+ * border edges. Likewise, the vertices on the edges shared by more than
+ * two triangles, common in the scanned models, only slide along those
+ * edges. The collapses run in passes over independent neighbourhoods,
+ * which lets the costs of a pass be evaluated in parallel.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#define RMG_EXPORT
+
+
+#include "rmg/mesh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "rmg/internal/parallel_for.hpp"
+
+
+#define SIMPLIFY_PARALLEL_GRAIN 16384 ///< Least vertices per thread
+#define SIMPLIFY_PASS_ERROR 1.5f ///< Error growth allowed within a pass
+#define SEAM_NORMAL_COS 0.866025f ///< Normals split by 30 degrees or more
+#define BORDER_WEIGHT 1.0 ///< Weight of the planes through the borders
+
+#define VERTEX_MANIFOLD 0
+#define VERTEX_BORDER 1 ///< On the edges of a single triangle
+#define VERTEX_COMPLEX 2 ///< On the edges of more than two triangles
+
+
+namespace {
+
+using rmg::Vec3;
+
+// Sum of the squared distances to a set of planes weighted by their areas
+struct Quadric {
+    double a00, a11, a22, a01, a02, a12;
+    double b0, b1, b2;
+    double c;
+    double w;
+};
+
+
+Quadric getPlaneQuadric(const Vec3 &p0, const Vec3 &p1, const Vec3 &p2) {
+    Quadric q = {};
+    Vec3 n = Vec3::cross(p1 - p0, p2 - p0);
+    double len = n.magnitude();
+    if(len == 0)
+        return q;
+    double x = n.x / len, y = n.y / len, z = n.z / len;
+    double d = -(x*p0.x + y*p0.y + z*p0.z);
+    double w = len / 2;
+    q.a00 = w*x*x; q.a11 = w*y*y; q.a22 = w*z*z;
+    q.a01 = w*x*y; q.a02 = w*x*z; q.a12 = w*y*z;
+    q.b0 = w*d*x; q.b1 = w*d*y; q.b2 = w*d*z;
+    q.c = w*d*d;
+    q.w = w;
+    return q;
+}
+
+
+// Plane through a border edge perpendicular to its triangle. It adds no
+// area to the weight of the surface.
+Quadric getBorderQuadric(const Vec3 &p0, const Vec3 &p1, const Vec3 &p2) {
+    Quadric q = {};
+    Vec3 e = p1 - p0;
+    Vec3 n = Vec3::cross(e, Vec3::cross(e, p2 - p0));
+    double len = n.magnitude();
+    if(len == 0)
+        return q;
+    double x = n.x / len, y = n.y / len, z = n.z / len;
+    double d = -(x*p0.x + y*p0.y + z*p0.z);
+    double w = BORDER_WEIGHT * Vec3::dot(e, e);
+    q.a00 = w*x*x; q.a11 = w*y*y; q.a22 = w*z*z;
+    q.a01 = w*x*y; q.a02 = w*x*z; q.a12 = w*y*z;
+    q.b0 = w*d*x; q.b1 = w*d*y; q.b2 = w*d*z;
+    q.c = w*d*d;
+    return q;
+}
+
+
+void addQuadric(Quadric &q, const Quadric &r) {
+    q.a00 += r.a00; q.a11 += r.a11; q.a22 += r.a22;
+    q.a01 += r.a01; q.a02 += r.a02; q.a12 += r.a12;
+    q.b0 += r.b0; q.b1 += r.b1; q.b2 += r.b2;
+    q.c += r.c;
+    q.w += r.w;
+}
+
+
+// Mean squared distance of a point to the planes of the quadric
+float getQuadricError(const Quadric &q, const Vec3 &p) {
+    if(q.w == 0)
+        return 0;
+    double x = p.x, y = p.y, z = p.z;
+    double e = q.a00*x*x + q.a11*y*y + q.a22*z*z +
+               2*(q.a01*x*y + q.a02*x*z + q.a12*y*z) +
+               2*(q.b0*x + q.b1*y + q.b2*z) + q.c;
+    return (float) std::max(e / q.w, 0.0);
+}
+
+
+struct Collapse {
+    uint32_t from;
+    uint32_t to;
+    float error;
+};
+
+}
+
+
+namespace rmg {
+
+using internal::parallelFor;
+
+/**
+ * @brief Reduces the number of triangles by collapsing the edges
+ * 
+ * The edges are collapsed in the order of their quadric errors. The
+ * vertices on the open borders and the seams, where the normals or the
+ * texture coordinates split, only move along them so that the outline and
+ * the texture mapping are preserved. The vertices on the edges shared by
+ * more than two triangles also move only along those edges. The result
+ * may keep more triangles than the target if the fold-overs prevent the
+ * collapses.
+ * 
+ * @param targetRatio Fraction of the triangles to keep
+ * 
+ * @return Root mean square distance of the removed vertices from the
+ *         simplified surface
+ */
+float Mesh::simplify(float targetRatio) {
+    if(!isValid() || targetRatio >= 1)
+        return 0;
+    // Mapped arrays are read-only
+    if(mapping != nullptr)
+        *this = Mesh(*this);
+    
+    uint32_t targetCount = (uint32_t)(index_count / 3 *
+                                      std::max(targetRatio, 0.0f)) * 3;
+    
+    // The vertices split by the attributes share a position
+    std::vector<uint32_t> ids = std::vector<uint32_t>(vertex_count);
+    weldPositions(vertices, vertex_count, &ids[0]);
+    std::vector<uint32_t> copyOffsets = std::vector<uint32_t>(vertex_count+1);
+    for(uint32_t i=0; i<vertex_count; i++)
+        copyOffsets[ids[i] + 1]++;
+    for(uint32_t i=1; i<=vertex_count; i++)
+        copyOffsets[i] += copyOffsets[i-1];
+    std::vector<uint32_t> copies = std::vector<uint32_t>(vertex_count);
+    for(uint32_t i=0; i<vertex_count; i++)
+        copies[copyOffsets[ids[i]]++] = i;
+    for(uint32_t i=vertex_count; i>0; i--)
+        copyOffsets[i] = copyOffsets[i-1];
+    copyOffsets[0] = 0;
+    
+    // The vertices of a position with close normals and the same texture
+    // coordinates form a wedge. The seams run between the wedges.
+    std::vector<uint32_t> wedges = std::vector<uint32_t>(vertex_count);
+    for(uint32_t j=0; j<vertex_count; j++) {
+        uint32_t v = copies[j];
+        wedges[v] = v;
+        for(uint32_t k=copyOffsets[ids[v]]; k<j; k++) {
+            uint32_t w = copies[k];
+            if(wedges[w] != w ||
+               Vec3::dot(normals[v], normals[w]) < SEAM_NORMAL_COS ||
+               (texCoords != nullptr && !(texCoords[v] == texCoords[w])))
+            {
+                continue;
+            }
+            wedges[v] = w;
+            break;
+        }
+    }
+    
+    // Triangles around each position
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> adjacent;
+    auto buildAdjacency = [&]() {
+        offsets.assign(vertex_count + 1, 0);
+        for(uint32_t i=0; i<index_count; i++)
+            offsets[ids[indices[i]] + 1]++;
+        for(uint32_t i=1; i<=vertex_count; i++)
+            offsets[i] += offsets[i-1];
+        adjacent.resize(index_count);
+        for(uint32_t i=0; i<index_count; i++)
+            adjacent[offsets[ids[indices[i]]]++] = i / 3;
+        for(uint32_t i=vertex_count; i>0; i--)
+            offsets[i] = offsets[i-1];
+        offsets[0] = 0;
+    };
+    buildAdjacency();
+    
+    // The vertex of a position sharing a triangle with a wedge
+    auto findCorner = [&](uint32_t wedge, uint32_t position,
+                          bool *used) -> uint32_t
+    {
+        uint32_t g = ids[wedge];
+        *used = false;
+        for(uint32_t j=offsets[g]; j<offsets[g+1]; j++) {
+            const uint32_t *tri = &indices[adjacent[j]*3];
+            bool inWedge = false;
+            uint32_t corner = UINT32_MAX;
+            for(int k=0; k<3; k++) {
+                if(wedges[tri[k]] == wedge)
+                    inWedge = true;
+                if(ids[tri[k]] == position)
+                    corner = tri[k];
+            }
+            if(!inWedge)
+                continue;
+            *used = true;
+            if(corner != UINT32_MAX)
+                return corner;
+        }
+        return UINT32_MAX;
+    };
+    
+    // Every wedge needs an edge to the target to keep the seams intact.
+    // The vertices on a seam thus move only along the seam.
+    auto canCollapse = [&](uint32_t from, uint32_t position) {
+        for(uint32_t j=copyOffsets[from]; j<copyOffsets[from+1]; j++) {
+            uint32_t w = copies[j];
+            bool used;
+            if(wedges[w] == w && findCorner(w, position, &used) ==
+               UINT32_MAX && used)
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+    
+    // Number of triangles on the edge between two positions
+    auto countEdge = [&](uint32_t a, uint32_t b) {
+        uint32_t count = 0;
+        for(uint32_t j=offsets[a]; j<offsets[a+1]; j++) {
+            const uint32_t *tri = &indices[adjacent[j]*3];
+            if(ids[tri[0]] == b || ids[tri[1]] == b || ids[tri[2]] == b)
+                count++;
+        }
+        return count;
+    };
+    
+    // An edge of a single triangle is on a border. An edge of more than two
+    // triangles joins several sheets of the surface.
+    std::vector<uint8_t> kinds;
+    auto classify = [&]() {
+        kinds.assign(vertex_count, VERTEX_MANIFOLD);
+        for(uint32_t i=0; i<index_count; i++) {
+            uint32_t a = ids[indices[i]];
+            uint32_t b = ids[indices[i - i%3 + (i+1)%3]];
+            uint32_t count = countEdge(a, b);
+            uint8_t kind = VERTEX_MANIFOLD;
+            if(count == 1)
+                kind = VERTEX_BORDER;
+            else if(count > 2)
+                kind = VERTEX_COMPLEX;
+            kinds[a] = std::max(kinds[a], kind);
+            kinds[b] = std::max(kinds[b], kind);
+        }
+    };
+    classify();
+    
+    // Quadrics of the planes around each position
+    std::vector<Quadric> quadrics = std::vector<Quadric>(vertex_count);
+    parallelFor(vertex_count, SIMPLIFY_PARALLEL_GRAIN,
+                [&](size_t b, size_t e)
+    {
+        for(size_t i=b; i<e; i++) {
+            Quadric q = {};
+            for(uint32_t j=offsets[i]; j<offsets[i+1]; j++) {
+                const uint32_t *tri = &indices[adjacent[j]*3];
+                addQuadric(q, getPlaneQuadric(vertices[tri[0]],
+                                              vertices[tri[1]],
+                                              vertices[tri[2]]));
+            }
+            quadrics[i] = q;
+        }
+    });
+    for(uint32_t i=0; i<index_count; i++) {
+        const uint32_t *tri = &indices[i - i%3];
+        uint32_t a = ids[indices[i]];
+        uint32_t b = ids[tri[(i+1)%3]];
+        if(kinds[a] == VERTEX_MANIFOLD || countEdge(a, b) != 1)
+            continue;
+        Quadric q = getBorderQuadric(vertices[indices[i]],
+                                     vertices[tri[(i+1)%3]],
+                                     vertices[tri[(i+2)%3]]);
+        addQuadric(quadrics[a], q);
+        addQuadric(quadrics[b], q);
+    }
+    
+    float maxError = 0;
+    std::vector<Collapse> candidates = std::vector<Collapse>(vertex_count);
+    std::vector<uint32_t> remap = std::vector<uint32_t>(vertex_count);
+    std::vector<uint8_t> touched;
+    while(index_count > targetCount) {
+        // The cheapest collapse of each vertex onto a neighbour
+        parallelFor(vertex_count, SIMPLIFY_PARALLEL_GRAIN,
+                    [&](size_t b, size_t e)
+        {
+            for(size_t i=b; i<e; i++) {
+                Collapse &best = candidates[i];
+                best.from = (uint32_t) i;
+                best.to = UINT32_MAX;
+                best.error = INFINITY;
+                if(ids[i] != i)
+                    continue;
+                for(uint32_t j=offsets[i]; j<offsets[i+1]; j++) {
+                    const uint32_t *tri = &indices[adjacent[j]*3];
+                    for(int k=0; k<3; k++) {
+                        uint32_t g = ids[tri[k]];
+                        if(g == i)
+                            continue;
+                        // Slides along the border or the joint of the sheets
+                        if(kinds[i] != VERTEX_MANIFOLD) {
+                            uint32_t edge = countEdge(i, g);
+                            if((kinds[i] == VERTEX_BORDER && edge != 1) ||
+                               (kinds[i] == VERTEX_COMPLEX && edge < 3))
+                            {
+                                continue;
+                            }
+                        }
+                        float err = getQuadricError(quadrics[i],
+                                                    vertices[tri[k]]);
+                        if(err >= best.error || !canCollapse(i, g))
+                            continue;
+                        best.to = tri[k];
+                        best.error = err;
+                    }
+                }
+            }
+        });
+        std::vector<Collapse> order;
+        for(auto it=candidates.begin(); it!=candidates.end(); it++) {
+            if(it->to != UINT32_MAX)
+                order.push_back(*it);
+        }
+        std::sort(order.begin(), order.end(),
+                  [](const Collapse &a, const Collapse &b) {
+            return a.error < b.error;
+        });
+        
+        // Collapses of a pass do not share any triangles
+        touched.assign(vertex_count, 0);
+        for(uint32_t i=0; i<vertex_count; i++)
+            remap[i] = i;
+        uint32_t removed = 0;
+        uint32_t needed = (index_count - targetCount) / 3;
+        // Leaves the costly collapses to the later passes as long as the
+        // cheap ones can still reach the target. The collapses rejected for
+        // folding over do not count among the cheap ones.
+        size_t cheap = needed / 2;
+        for(auto it=order.begin(); it!=order.end() && removed<needed; it++) {
+            if(cheap < order.size() && removed > 0 &&
+               it->error > order[cheap].error * SIMPLIFY_PASS_ERROR)
+            {
+                break;
+            }
+            uint32_t from = it->from;
+            uint32_t to = it->to;
+            uint32_t target = ids[to];
+            if(touched[from] || touched[target])
+                continue;
+            
+            // Rejects the collapses folding a triangle over
+            bool flip = false;
+            for(uint32_t j=offsets[from]; j<offsets[from+1] && !flip; j++) {
+                const uint32_t *tri = &indices[adjacent[j]*3];
+                if(ids[tri[0]] == target || ids[tri[1]] == target ||
+                   ids[tri[2]] == target)
+                {
+                    continue;
+                }
+                Vec3 p[3], q[3];
+                for(int k=0; k<3; k++) {
+                    p[k] = vertices[tri[k]];
+                    q[k] = (ids[tri[k]] == from) ? vertices[to] : p[k];
+                }
+                Vec3 n1 = Vec3::cross(p[1] - p[0], p[2] - p[0]);
+                Vec3 n2 = Vec3::cross(q[1] - q[0], q[2] - q[0]);
+                flip = Vec3::dot(n1, n2) <= 0;
+            }
+            if(flip) {
+                cheap++;
+                continue;
+            }
+            
+            // Each wedge moves to the vertex on its side
+            for(uint32_t j=copyOffsets[from]; j<copyOffsets[from+1]; j++) {
+                uint32_t v = copies[j];
+                bool used;
+                if(wedges[v] != v)
+                    remap[v] = remap[wedges[v]];
+                else if(findCorner(v, target, &used) != UINT32_MAX)
+                    remap[v] = findCorner(v, target, &used);
+            }
+            addQuadric(quadrics[target], quadrics[from]);
+            maxError = std::max(maxError, it->error);
+            for(uint32_t j=offsets[from]; j<offsets[from+1]; j++) {
+                const uint32_t *tri = &indices[adjacent[j]*3];
+                for(int k=0; k<3; k++)
+                    touched[ids[tri[k]]] = 1;
+            }
+            removed += countEdge(from, target);
+        }
+        if(removed == 0)
+            break;
+        
+        // Drops the triangles which collapsed into lines
+        uint32_t count = 0;
+        for(uint32_t i=0; i<index_count; i+=3) {
+            uint32_t a = remap[indices[i]];
+            uint32_t b = remap[indices[i+1]];
+            uint32_t c = remap[indices[i+2]];
+            if(ids[a] == ids[b] || ids[b] == ids[c] || ids[c] == ids[a])
+                continue;
+            indices[count++] = a;
+            indices[count++] = b;
+            indices[count++] = c;
+        }
+        index_count = count;
+        buildAdjacency();
+        classify();
+    }
+    
+    // Drops the unused vertices
+    optimize();
+    return sqrtf(maxError);
+}
+
+}
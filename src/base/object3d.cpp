@@ -1,7 +1,7 @@
 /**
  * @file object3d.cpp
  * @brief 3D object whose model and appearance can be controlled quickly
- *
+ * 
  * The constructor builds a vertex buffer object to load into the GPU and
  * keeps the address to that resource. The model matrix and material
  * properties like color, diffusion and specularity coefficient are passed
@@ -22,6 +22,9 @@
 #include <cstdio>
 #include <cstring>
 
+#include "rmg/context.hpp"
+#include "rmg/internal/mesh_cache.hpp"
+#include "rmg/internal/scene_bvh.hpp"
 #include "rmg/internal/texture_load.hpp"
 
 
@@ -38,6 +41,7 @@ namespace rmg {
 Object3D::Object3D() {
     modelMatrix = Mat4();
     scale = Vec3(1, 1, 1);
+    meshScale = Vec3(1, 1, 1);
     metalness = DEFAULT_METALNESS;
     roughness = DEFAULT_ROUGHNESS;
     ambientOcculation = DEFAULT_AO;
@@ -52,6 +56,7 @@ Object3D::Object3D() {
 Object3D::Object3D(Context* ctx): Object(ctx) {
     modelMatrix = Mat4();
     scale = Vec3(1, 1, 1);
+    meshScale = Vec3(1, 1, 1);
     metalness = DEFAULT_METALNESS;
     roughness = DEFAULT_ROUGHNESS;
     ambientOcculation = DEFAULT_AO;
@@ -61,38 +66,43 @@ Object3D::Object3D(Context* ctx): Object(ctx) {
 /**
  * @brief Constructor loads 3D model from file.
  * 
+ * The parsed model is cached in a binary mesh file (.rmgmesh) next to
+ * the model file, which is mapped by the later runs instead.
+ * 
  * @param ctx Container context
- * @param file 3D model file (.obj)
+ * @param file 3D model file (.obj, .rmgmesh)
  * @param smooth Generate smooth surface normals if the 3D model does not
  *               contain preprocessed vertex normals
  */
 Object3D::Object3D(Context* ctx, const char* file, bool smooth)
          :Object3D(ctx)
 {
-    const char* ext = "";
-    for(size_t i=strlen(file)-1; --i; ) {
-        if(file[i] == '.')
-            ext = &file[i+1];
-    }
-    
-    if(strcmp(ext, "obj") == 0)
-        loadOBJ(file, smooth);
-    else {
-        #ifdef WIN32
-        printf("error: Attempted to load unsupported 3D model file '%s'\n",
-               file);
-        #else
-        printf("\033[0;1;31merror: \033[0m"
-               "Attempted to load unsupported 3D model file "
-               "\033[1m'%s'\033[0m\n", file);
-        #endif
-    }
+    // The objects loading the same file share the VBO
+    uint64_t key = internal::MeshCache::hash(file, strlen(file));
+    key = internal::MeshCache::hash(&smooth, sizeof(smooth), key);
+    shareVBO(key, [&]() {
+        // The file is parsed by a worker thread of the context loader
+        vbo = new internal::VBO();
+        vboShareCount = new uint32_t;
+        *vboShareCount = 1;
+        internal::GeometryPool* geometry = nullptr;
+        bool compress = true;
+        if(ctx != nullptr) {
+            geometry = ctx->getGeometryPool();
+            compress = ctx->getVertexCompression();
+        }
+        auto load = new internal::VBOLoad(vbo, geometry, file, smooth,
+                                          compress);
+        vboLoad = internal::Pending(load);
+    });
 }
 
 /**
  * @brief Destructor
  */
 Object3D::~Object3D() {
+    if(bvh != nullptr)
+        bvh->remove(this);
     dereferenceVBO();
     dereferenceTexture();
 }
@@ -107,6 +117,7 @@ Object3D::Object3D(const Object3D& obj)
 {
     modelMatrix = obj.modelMatrix;
     scale = obj.scale;
+    meshScale = obj.meshScale;
     material = obj.material;
     metalness = obj.metalness;
     roughness = obj.roughness;
@@ -116,6 +127,7 @@ Object3D::Object3D(const Object3D& obj)
     if(vboShareCount != nullptr)
         (*vboShareCount)++;
     vboLoad = obj.vboLoad;
+    lod = obj.lod;
     texture = obj.texture;
     texShareCount = obj.texShareCount;
     if(texShareCount != nullptr)
@@ -133,19 +145,21 @@ Object3D::Object3D(Object3D&& obj) noexcept
 {
     modelMatrix = std::exchange(obj.modelMatrix, Mat4());
     scale = std::exchange(obj.scale, Vec3(1, 1, 1));
+    meshScale = std::exchange(obj.meshScale, Vec3(1, 1, 1));
     material = std::exchange(obj.material, nullptr);
     metalness = std::exchange(obj.metalness, DEFAULT_METALNESS);
     roughness = std::exchange(obj.roughness, DEFAULT_ROUGHNESS);
     ambientOcculation = std::exchange(obj.ambientOcculation, DEFAULT_AO);
     vbo = std::exchange(obj.vbo, nullptr);
     vboShareCount = std::exchange(obj.vboShareCount, nullptr);
+    lod = std::exchange(obj.lod, 0);
     texture = std::exchange(obj.texture, nullptr);
     texShareCount = std::exchange(obj.texShareCount, nullptr);
     internal::Pending load;
     vboLoad = std::exchange(obj.vboLoad, load);
     texLoad = std::exchange(obj.texLoad, load);
 }
-    
+
 /**
  * @brief Copy assignment
  * 
@@ -154,6 +168,7 @@ Object3D::Object3D(Object3D&& obj) noexcept
 Object3D& Object3D::operator=(const Object3D& obj) {
     Object3D tmp = Object3D(obj);
     swap(tmp);
+    markBoundsDirty();
     return *this;
 }
 
@@ -165,6 +180,7 @@ Object3D& Object3D::operator=(const Object3D& obj) {
 Object3D& Object3D::operator=(Object3D&& obj) noexcept {
     Object3D tmp = std::move(obj);
     swap(tmp);
+    markBoundsDirty();
     return *this;
 }
 
@@ -176,6 +192,7 @@ Object3D& Object3D::operator=(Object3D&& obj) noexcept {
 void Object3D::swap(Object3D& x) noexcept {
     std::swap(modelMatrix, x.modelMatrix);
     std::swap(scale, x.scale);
+    std::swap(meshScale, x.meshScale);
     std::swap(material, x.material);
     std::swap(metalness, x.metalness);
     std::swap(roughness, x.roughness);
@@ -183,6 +200,7 @@ void Object3D::swap(Object3D& x) noexcept {
     std::swap(vbo, x.vbo);
     std::swap(vboShareCount, x.vboShareCount);
     std::swap(vboLoad, x.vboLoad);
+    std::swap(lod, x.lod);
     std::swap(texture, x.texture);
     std::swap(texShareCount, x.texShareCount);
     std::swap(texLoad, x.texLoad);
@@ -192,15 +210,63 @@ void Object3D::swap(Object3D& x) noexcept {
 /**
  * @brief Sets the mesh of the 3D object
  * 
+ * The objects of a context setting identical meshes share a single
+ * VBO. The meshes are compared by the hash of their data.
+ * 
  * @param mesh 3D Mesh containing vertex coordinates
  */
 void Object3D::setMesh(const Mesh& mesh) {
-    dereferenceVBO();
-    vbo = new internal::VBO();
-    vboShareCount = new uint32_t;
-    *vboShareCount = 1;
-    auto load = new internal::VBOLoad(vbo, mesh);
-    vboLoad = internal::Pending(load);
+    uint64_t key = (getContext() != nullptr) ? mesh.getHash() : 0;
+    shareVBO(key, [&]() { loadMesh(mesh); });
+}
+
+/**
+ * @brief Sets a mesh shared by the objects of the same key
+ * 
+ * The mesh is generated only if no other object of the context has
+ * used the key. This way the primitive shapes are built once for all
+ * the objects of the same parameters.
+ * 
+ * @param key Hash of the parameters generating the mesh
+ * @param create Function generating the mesh
+ */
+void Object3D::setMesh(uint64_t key, const std::function<Mesh()> &create) {
+    shareVBO(key, [&]() { loadMesh(create()); });
+}
+
+/**
+ * @brief Sets the levels of detail shared by the objects of the same key
+ * 
+ * The renderer draws the coarsest level whose error is invisible at the
+ * distance of the object.
+ * 
+ * @param key Hash of the parameters generating the meshes
+ * @param create Function generating the levels from the most detailed
+ */
+void Object3D::setMeshLevels(
+    uint64_t key,
+    const std::function<std::vector<internal::LevelOfDetail>()> &create)
+{
+    shareVBO(key, [&]() { loadMesh(create()); });
+}
+
+/**
+ * @brief Sets the scale applied to the mesh before the object's scale
+ * 
+ * Lets the shapes of different dimensions share a mesh of unit size.
+ * 
+ * @param x Scaling factor in x-component
+ * @param y Scaling factor in y-component
+ * @param z Scaling factor in z-component
+ */
+void Object3D::setMeshScale(float x, float y, float z) {
+    for(int i=0; i<3; i++) {
+        modelMatrix[i][0] *= x/meshScale.x;
+        modelMatrix[i][1] *= y/meshScale.y;
+        modelMatrix[i][2] *= z/meshScale.z;
+    }
+    meshScale = Vec3(x, y, z);
+    markBoundsDirty();
 }
 
 /**
@@ -223,6 +289,7 @@ void Object3D::setTranslation(float x, float y, float z) {
     modelMatrix[0][3] = x;
     modelMatrix[1][3] = y;
     modelMatrix[2][3] = z;
+    markBoundsDirty();
 }
 
 /**
@@ -236,6 +303,7 @@ void Object3D::setTranslation(const Vec3 &pos) {
     modelMatrix[0][3] = pos.x;
     modelMatrix[1][3] = pos.y;
     modelMatrix[2][3] = pos.z;
+    markBoundsDirty();
 }
 
 /**
@@ -259,15 +327,12 @@ Vec3 Object3D::getTranslation() const {
  */
 void Object3D::setRotation(const Euler &rot) {
     Mat3 R = rot.toRotationMatrix();
-    modelMatrix[0][0] = R[0][0] * scale.x;
-    modelMatrix[0][1] = R[0][1] * scale.y;
-    modelMatrix[0][2] = R[0][2] * scale.z;
-    modelMatrix[1][0] = R[1][0] * scale.x;
-    modelMatrix[1][1] = R[1][1] * scale.y;
-    modelMatrix[1][2] = R[1][2] * scale.z;
-    modelMatrix[2][0] = R[2][0] * scale.x;
-    modelMatrix[2][1] = R[2][1] * scale.y;
-    modelMatrix[2][2] = R[2][2] * scale.z;
+    for(int i=0; i<3; i++) {
+        modelMatrix[i][0] = R[i][0] * scale.x * meshScale.x;
+        modelMatrix[i][1] = R[i][1] * scale.y * meshScale.y;
+        modelMatrix[i][2] = R[i][2] * scale.z * meshScale.z;
+    }
+    markBoundsDirty();
 }
 
 /**
@@ -279,15 +344,11 @@ void Object3D::setRotation(const Euler &rot) {
  */
 Euler Object3D::getRotation() const {
     Mat3 R = (Mat3) modelMatrix;
-    R[0][0] /= scale.x;
-    R[0][1] /= scale.y;
-    R[0][2] /= scale.z;
-    R[1][0] /= scale.x;
-    R[1][1] /= scale.y;
-    R[1][2] /= scale.z;
-    R[2][0] /= scale.x;
-    R[2][1] /= scale.y;
-    R[2][2] /= scale.z;
+    for(int i=0; i<3; i++) {
+        R[i][0] /= scale.x * meshScale.x;
+        R[i][1] /= scale.y * meshScale.y;
+        R[i][2] /= scale.z * meshScale.z;
+    }
     return Euler(R);
 }
 
@@ -315,6 +376,7 @@ void Object3D::setScale(float x, float y, float z) {
     scale.x = x;
     scale.y = y;
     scale.z = z;
+    markBoundsDirty();
 }
 
 /**
@@ -339,6 +401,7 @@ void Object3D::setScale(float f) {
     scale.x = f;
     scale.y = f;
     scale.z = f;
+    markBoundsDirty();
 }
 
 /**
@@ -348,6 +411,31 @@ void Object3D::setScale(float f) {
  */
 Vec3 Object3D::getScale() const { return scale; }
 
+/**
+ * @brief Gets the scale applied to the mesh before the object's scale
+ * 
+ * The primitive shapes keep their dimensions here as their meshes are
+ * of unit size.
+ * 
+ * @return Scaling factors in x, y and z components
+ */
+Vec3 Object3D::getMeshScale() const { return meshScale; }
+
+/**
+ * @brief Sets object visibility
+ * 
+ * The shadows drawn from the previous frames are drawn again with or
+ * without the object.
+ * 
+ * @param hide Hide flag
+ */
+void Object3D::setHidden(bool hide) {
+    if(hide == isHidden())
+        return;
+    Object::setHidden(hide);
+    markBoundsDirty();
+}
+
 /**
  * @brief Sets the material texture
  * 
@@ -481,6 +569,29 @@ float Object3D::getAmbientOcculation() const { return ambientOcculation; }
  */
 const internal::VBO *Object3D::getVBO() const { return vbo; }
 
+/**
+ * @brief Picks the level of detail to draw
+ * 
+ * Called by the renderer every frame. The level stays the same unless the
+ * error is clearly different from the limit.
+ * 
+ * @param maxError Largest error allowed in model space
+ * 
+ * @return Level of detail
+ */
+uint32_t Object3D::selectLOD(float maxError) {
+    if(vbo != nullptr)
+        lod = vbo->selectLevel(maxError, lod);
+    return lod;
+}
+
+/**
+ * @brief Gets the level of detail drawn
+ * 
+ * @return Level of detail, zero for the most detailed mesh
+ */
+uint32_t Object3D::getLOD() const { return lod; }
+
 /**
  * @brief Gets the pointer to the texture
  * 
@@ -506,6 +617,78 @@ const Pending& Object3D::getVBOLoad() const { return vboLoad; }
 const Pending& Object3D::getTextureLoad() const { return texLoad; }
 
 
+void Object3D::loadMesh(const Mesh& mesh) {
+    dereferenceVBO();
+    vbo = new internal::VBO();
+    vboShareCount = new uint32_t;
+    *vboShareCount = 1;
+    Context* ctx = getContext();
+    internal::GeometryPool* geometry = nullptr;
+    bool compress = true;
+    if(ctx != nullptr) {
+        geometry = ctx->getGeometryPool();
+        compress = ctx->getVertexCompression();
+    }
+    auto load = new internal::VBOLoad(vbo, geometry, mesh, compress);
+    vboLoad = internal::Pending(load);
+    lod = 0;
+}
+
+
+void Object3D::loadMesh(const std::vector<internal::LevelOfDetail>& lods) {
+    dereferenceVBO();
+    vbo = new internal::VBO();
+    vboShareCount = new uint32_t;
+    *vboShareCount = 1;
+    Context* ctx = getContext();
+    internal::GeometryPool* geometry = nullptr;
+    bool compress = true;
+    if(ctx != nullptr) {
+        geometry = ctx->getGeometryPool();
+        compress = ctx->getVertexCompression();
+    }
+    auto load = new internal::VBOLoad(vbo, geometry, lods, compress);
+    vboLoad = internal::Pending(load);
+    lod = 0;
+}
+
+
+void Object3D::shareVBO(uint64_t key, const std::function<void()> &load) {
+    Context* ctx = getContext();
+    if(ctx == nullptr) {
+        load();
+        markBoundsDirty();
+        return;
+    }
+    
+    // Compressed and uncompressed VBOs of the same mesh differ
+    bool compress = ctx->getVertexCompression();
+    key = internal::MeshCache::hash(&compress, sizeof(compress), key);
+    internal::MeshCache* cache = ctx->getMeshCache();
+    const internal::SharedVBO* shared = cache->find(key);
+    if(shared == nullptr) {
+        load();
+        internal::SharedVBO entry = {vbo, vboShareCount, vboLoad};
+        cache->insert(key, entry);
+    }
+    else if(shared->vbo != vbo) {
+        (*shared->shareCount)++;
+        dereferenceVBO();
+        vbo = shared->vbo;
+        vboShareCount = shared->shareCount;
+        vboLoad = shared->load;
+        lod = 0;
+    }
+    markBoundsDirty();
+}
+
+
+void Object3D::markBoundsDirty() {
+    if(bvh != nullptr)
+        bvh->markDirty(bvhProxy);
+}
+
+
 void Object3D::dereferenceVBO() {
     if(vbo != nullptr) {
         (*vboShareCount)--;
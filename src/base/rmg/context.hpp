@@ -31,6 +31,7 @@
 #include <cstdint>
 #include <stdexcept>
 #include <map>
+#include <vector>
 
 #include "camera.hpp"
 #include "color.hpp"
@@ -38,13 +39,19 @@
 #include "keyboard.hpp"
 #include "material.hpp"
 #include "mouse.hpp"
+#include "frame_stats.hpp"
 #include "object.hpp"
 #include "internal/general_shader.hpp"
 #include "internal/line3d_shader.hpp"
 #include "internal/particle_shader.hpp"
+#include "internal/picking_shader.hpp"
 #include "internal/shadow_map_shader.hpp"
 #include "internal/object2d_shader.hpp"
 #include "internal/context_load.hpp"
+#include "internal/frame_profiler.hpp"
+#include "internal/geometry_arena.hpp"
+#include "internal/mesh_cache.hpp"
+#include "internal/scene_bvh.hpp"
 #include "math/line_equation.hpp"
 
 
@@ -130,10 +137,17 @@ class RMG_API Context {
     internal::Object2DShader object2dShader;
     internal::ParticleShader particleShader;
     internal::Line3DShader line3dShader;
+    internal::PickingShader pickingShader;
     internal::ContextLoader loader;
     internal::GLContext glContext;
+    internal::FrameProfiler profiler;
+    internal::GeometryPool geometry;
+    internal::MeshCache meshes;
+    internal::SceneBVH bvh;
     
     bool initDone;
+    bool vertexCompression;
+    float lodThreshold;
     float fps;
     bool destroyed;
     int errorCode;
@@ -168,6 +182,13 @@ class RMG_API Context {
      */
     virtual ~Context();
     
+    /**
+     * @brief Move constructor
+     * 
+     * @param ctx Source context
+     */
+    Context(Context&& ctx) = default;
+    
     /**
      * @brief Idle display loop function
      * 
@@ -259,6 +280,177 @@ class RMG_API Context {
      */
     float getFPS() const;
     
+    /**
+     * @brief Gets the timing and workload statistics of the rendering passes
+     * 
+     * Includes CPU and GPU times of each pass, draw call and uniform upload
+     * counts and percentiles of the recent frame times.
+     * 
+     * @return Statistics of the recent frames
+     */
+    const FrameStats &getFrameStats() const;
+    
+    /**
+     * @brief Gets the progress of loading the resources into the GPU
+     * 
+     * Files like images and 3D models are decoded by background threads and
+     * loaded into the GPU during the frames after. The progress covers the
+     * resources added since the loading list was last empty.
+     * 
+     * @return Fraction of the resources loaded from 0 to 1
+     */
+    float getLoadProgress() const;
+    
+    /**
+     * @brief Waits until the background threads decode the pending resources
+     * 
+     * The decoded resources are loaded into the GPU by the next frame. Useful
+     * to make sure the first frame is complete.
+     */
+    void waitForLoads();
+    
+    /**
+     * @brief Sets the limit of the GPU uploads in each frame
+     * 
+     * Spreads the uploads across frames so that adding a lot of resources
+     * at once does not stall a frame. The objects not loaded yet are not
+     * drawn. Zero means no limit which is the default.
+     * 
+     * @param ms Time limit in milliseconds
+     * @param bytes Limit of the bytes sent to the GPU
+     */
+    void setUploadBudget(float ms, uint64_t bytes=0);
+    
+    /**
+     * @brief Sets whether the 3D objects store their vertices compressed
+     * 
+     * Compressed vertices take about half the GPU memory and bandwidth at
+     * a small loss of precision. Applies to the 3D objects and meshes
+     * created after the call. Enabled by default.
+     * 
+     * @param enable True to compress the vertices
+     */
+    void setVertexCompression(bool enable);
+    
+    /**
+     * @brief Checks whether the 3D objects store their vertices compressed
+     * 
+     * @return True if the vertices are compressed
+     */
+    bool getVertexCompression() const;
+    
+    /**
+     * @brief Sets the screen-space error allowed for the levels of detail
+     * 
+     * The 3D objects with levels of detail are drawn at the coarsest level
+     * whose error projects to less than this size. A larger value saves
+     * vertices at the cost of visible facets. The default is 1 pixel.
+     * 
+     * @param pixels Error in pixels
+     */
+    void setLODThreshold(float pixels);
+    
+    /**
+     * @brief Gets the screen-space error allowed for the levels of detail
+     * 
+     * @return Error in pixels
+     */
+    float getLODThreshold() const;
+    
+    /**
+     * @brief Sets the width and height of each cascade of the shadow map
+     * 
+     * The default is 1024 texels.
+     * 
+     * @param size Resolution in texels
+     */
+    void setShadowMapResolution(uint16_t size);
+    
+    /**
+     * @brief Gets the width and height of each cascade of the shadow map
+     * 
+     * @return Resolution in texels
+     */
+    uint16_t getShadowMapResolution() const;
+    
+    /**
+     * @brief Sets the number of slices the camera view is split into for
+     *        the shadows
+     * 
+     * More cascades give sharper shadows over a long viewing distance at
+     * the cost of drawing the casters once more for each. The default
+     * is 3.
+     * 
+     * @param n Number of cascades from 1 to 4
+     */
+    void setShadowCascadeCount(uint32_t n);
+    
+    /**
+     * @brief Gets the number of slices the camera view is split into for
+     *        the shadows
+     * 
+     * @return Number of cascades
+     */
+    uint32_t getShadowCascadeCount() const;
+    
+    /**
+     * @brief Sets the filter kernel softening the edges of the shadows
+     * 
+     * The kernels of more taps give smoother edges at the cost of the
+     * fill rate. The default is the 9-tap Poisson disk.
+     * 
+     * @param k Shadow filter kernel
+     */
+    void setShadowKernel(ShadowKernel k);
+    
+    /**
+     * @brief Gets the filter kernel softening the edges of the shadows
+     * 
+     * @return Shadow filter kernel
+     */
+    ShadowKernel getShadowKernel() const;
+    
+    /**
+     * @brief Gets the geometry arenas the 3D objects load their vertices
+     *        into
+     * 
+     * @return Geometry arenas of the context
+     */
+    internal::GeometryPool *getGeometryPool();
+    
+    /**
+     * @brief Gets the VBOs shared by the 3D objects of identical meshes
+     * 
+     * @return Mesh cache of the context
+     */
+    internal::MeshCache *getMeshCache();
+    
+    /**
+     * @brief Gets the bounding volume hierarchy of the 3D objects
+     * 
+     * @return Scene BVH of the context
+     */
+    internal::SceneBVH *getSceneBVH();
+    
+    /**
+     * @brief Sets the trade-off between the build time and the query speed
+     *        of the bounding volume hierarchy
+     * 
+     * The hierarchy is refitted as the objects move and rebuilt once the
+     * refits have made it notably worse. A higher quality takes longer to
+     * rebuild and culls faster. The default is medium.
+     * 
+     * @param q Build quality
+     */
+    void setBVHQuality(BVHQuality q);
+    
+    /**
+     * @brief Gets the build quality of the bounding volume hierarchy
+     * 
+     * @return Build quality
+     */
+    BVHQuality getBVHQuality() const;
+    
     /**
      * @brief Gets the ID of the context
      * 
@@ -571,7 +763,9 @@ class RMG_API Context {
     /**
      * @brief Converts screen coordinate to world coordinate
      * 
-     * Useful when interacting 3D objects with a mouse.
+     * Useful when interacting 3D objects with a mouse. The returned ray
+     * starts on the near plane of the camera and reaches the far plane at
+     * the end of its direction vector.
      * 
      * @param x X-coordinate
      * @param y Y-coordinate
@@ -583,7 +777,9 @@ class RMG_API Context {
     /**
      * @brief Converts screen coordinate to world coordinate
      * 
-     * Useful when interacting 3D objects with a mouse.
+     * Useful when interacting 3D objects with a mouse. The returned ray
+     * starts on the near plane of the camera and reaches the far plane at
+     * the end of its direction vector.
      * 
      * @param p Point on screen
      * 
@@ -591,6 +787,86 @@ class RMG_API Context {
      */
     LineEq screenToWorld(const Rect &p) const;
     
+    /**
+     * @brief Finds the nearest 3D object under a point on the screen
+     * 
+     * The objects are narrowed down by their bounds in the bounding volume
+     * hierarchy of the context and then tested triangle by triangle. The
+     * triangle hierarchy of a mesh is built by its first pick. Hidden
+     * objects and the objects not loaded yet are not picked.
+     * 
+     * @param x X-coordinate
+     * @param y Y-coordinate
+     * @param point Returns the hit point in world space if not null
+     * 
+     * @return Nearest 3D object or null if nothing is hit
+     */
+    Object3D *pick(uint16_t x, uint16_t y, Vec3 *point=nullptr);
+    
+    /**
+     * @brief Finds the nearest 3D object under a point on the screen
+     * 
+     * @param p Point on screen
+     * @param point Returns the hit point in world space if not null
+     * 
+     * @return Nearest 3D object or null if nothing is hit
+     */
+    Object3D *pick(const Rect &p, Vec3 *point=nullptr);
+    
+    /**
+     * @brief Finds the nearest 3D object hit by a ray
+     * 
+     * @param ray Ray in world space
+     * @param maxDistance Limit of the distance along the ray in the units
+     *                    of its direction vector
+     * @param point Returns the hit point in world space if not null
+     * 
+     * @return Nearest 3D object or null if nothing is hit
+     */
+    Object3D *pick(const LineEq &ray, float maxDistance,
+                   Vec3 *point=nullptr);
+    
+    /**
+     * @brief Requests the object under a point on the screen from the GPU
+     * 
+     * The IDs of the objects are drawn into an integer image by the next
+     * frame and read back a frame later without waiting for the GPU. The
+     * result is taken by getPickResult(). Unlike pick(), the lines and
+     * particles are picked as well. A request not drawn yet is replaced
+     * by the newer one.
+     * 
+     * @param x X-coordinate
+     * @param y Y-coordinate
+     */
+    void requestPick(uint16_t x, uint16_t y);
+    
+    /**
+     * @brief Requests the object under a point on the screen from the GPU
+     * 
+     * @param p Point on screen
+     */
+    void requestPick(const Rect &p);
+    
+    /**
+     * @brief Requests the objects in a rectangle on the screen from the GPU
+     * 
+     * Used for box selection. Only the objects seen on at least a pixel of
+     * the rectangle are picked. The ones entirely behind others are not.
+     * 
+     * @param p1 A corner of the rectangle
+     * @param p2 The opposite corner of the rectangle
+     */
+    void requestPick(const Rect &p1, const Rect &p2);
+    
+    /**
+     * @brief Gets the objects of the last request read back from the GPU
+     * 
+     * @param objects Returns the 3D objects, lines and particles picked
+     * 
+     * @return True if a new result is returned since the last call
+     */
+    bool getPickResult(std::vector<Object*> *objects);
+    
     /**
      * @brief Appends a 2D/3D object to the display list
      * 
@@ -683,6 +959,17 @@ class RMG_API Context {
      */
     virtual void flush();
     
+    /**
+     * @brief Gets the framebuffer the context draws its final image into
+     * 
+     * The default framebuffer (0) is used by on-screen contexts. Offscreen
+     * contexts override this to redirect the rendering passes into their
+     * own framebuffer object.
+     * 
+     * @return OpenGL framebuffer object ID
+     */
+    virtual uint32_t getFramebuffer();
+    
     /**
      * @brief Cleans up GPU resources
      */
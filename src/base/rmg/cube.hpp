@@ -45,7 +45,8 @@ class RMG_API Cube3D: public Object3D {
     float breadth;
     float height;
     
-    Mesh createMesh();
+    Mesh createMesh(const Vec3 &texDim);
+    void updateMesh();
     
   public:
     /**
@@ -44,7 +44,9 @@ class RMG_API Cylinder3D: public Object3D {
     float diameter;
     float length;
     
-    Mesh createMesh();
+    std::vector<internal::LevelOfDetail> createLevels(const Vec2 &texDim);
+    Mesh createMesh(const Vec2 &texDim, int n);
+    void updateMesh();
     
   public:
     /**
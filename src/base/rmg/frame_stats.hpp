@@ -0,0 +1,96 @@
+/**
+ * @file frame_stats.hpp
+ * @brief Timing and workload statistics of the rendering passes
+ * 
+ * Shows which rendering pass takes up the frame time as the scene grows.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#pragma once
+#ifndef __RMG_FRAME_STATS_H__
+#define __RMG_FRAME_STATS_H__
+
+#ifndef RMG_API
+#ifdef _WIN32
+#ifdef RMG_EXPORT
+#define RMG_API __declspec(dllexport)
+#else
+#define RMG_API __declspec(dllimport)
+#endif
+#else
+#define RMG_API
+#endif
+#endif
+
+
+#include <cstdint>
+
+
+namespace rmg {
+
+/**
+ * @brief Rendering passes of a frame in their order of execution
+ */
+enum class RenderPass {
+    ShadowMap,
+    Picking,
+    Line3D,
+    General,
+    Particle,
+    Object2D
+};
+
+#define RMG_RENDER_PASS_COUNT 6 ///< Number of rendering passes
+
+
+/**
+ * @brief Timing and workload of a single rendering pass
+ */
+struct PassStats {
+    float cpuTime = 0; ///< CPU time spent submitting the pass (ms)
+    float gpuTime = 0; ///< GPU time spent executing the pass (ms)
+    uint32_t drawCalls = 0; ///< Number of draw calls
+    uint32_t uniformUploads = 0; ///< Number of glUniform* calls
+};
+
+
+/**
+ * @brief Timing and workload statistics of the rendering passes
+ * 
+ * CPU times and counters belong to the last rendered frame. GPU times are
+ * read back from timer queries without waiting for the GPU, so they belong
+ * to a frame a few frames behind. They stay at zero if the driver does not
+ * support timer queries (OpenGL 3.3).
+ */
+struct FrameStats {
+    PassStats passes[RMG_RENDER_PASS_COUNT]; ///< Stats of each pass
+    uint32_t drawCalls = 0; ///< Total draw calls of the frame
+    uint32_t uniformUploads = 0; ///< Total glUniform* calls of the frame
+    float cpuTime = 0; ///< CPU time spent in all the passes (ms)
+    float gpuTime = 0; ///< GPU time spent in all the passes (ms)
+    float frameTime = 0; ///< Time from the previous frame (ms)
+    float p50 = 0; ///< Median of the recent frame times (ms)
+    float p95 = 0; ///< 95th percentile of the recent frame times (ms)
+    float p99 = 0; ///< 99th percentile of the recent frame times (ms)
+    uint64_t frameCount = 0; ///< Number of frames rendered
+    bool gpuTimerSupported = false; ///< Whether GPU times are measured
+    
+    /**
+     * @brief Gets the stats of a rendering pass
+     * 
+     * @param pass Rendering pass
+     * 
+     * @return Timing and workload of the pass
+     */
+    inline const PassStats &operator [](RenderPass pass) const {
+        return passes[(int) pass];
+    }
+};
+
+}
+
+#endif
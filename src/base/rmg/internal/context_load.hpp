@@ -31,9 +31,14 @@
 #endif
 
 
+#include <atomic>
 #include <cstdint>
+#include <deque>
+#include <mutex>
 #include <queue>
 
+#include "worker_pool.hpp"
+
 
 namespace rmg {
 namespace internal {
@@ -41,18 +46,59 @@ namespace internal {
 
 /**
  * @brief Maintains the data to be loaded into OpenGL context before startup
+ * 
+ * A load takes two steps. The CPU work like decoding files is done by
+ * prepare() on a worker thread of the ContextLoader. Only after that, the
+ * rendering thread calls load() to upload the data to the GPU.
  */
 class RMG_API ContextLoad {
+  private:
+    std::atomic<bool> prepared;
+    
+    friend class ContextLoader;
+    
+  protected:
+    /**
+     * @brief Constructor
+     * 
+     * @param prepared False if the load has CPU work to be done by
+     *                 prepare() before it can be loaded to the GPU
+     */
+    ContextLoad(bool prepared=true);
+    
   public:
     /**
      * @brief Destructor
      */
     virtual ~ContextLoad() = default;
     
+    /**
+     * @brief Does the CPU work of the load like decoding files
+     * 
+     * Runs on a worker thread, so it must not call OpenGL functions.
+     */
+    virtual void prepare();
+    
     /**
      * @brief Loads the data to the GPU
      */
     virtual void load();
+    
+    /**
+     * @brief Gets the number of bytes the load sends to the GPU
+     * 
+     * Used to spread the uploads across frames within a budget.
+     * 
+     * @return Upload size in bytes. Zero if unknown or negligible.
+     */
+    virtual uint64_t getUploadSize() const;
+    
+    /**
+     * @brief Checks if the CPU work of the load is complete
+     * 
+     * @return True if the load is ready to be loaded to the GPU
+     */
+    bool isPrepared() const;
 };
 
 
@@ -144,81 +190,42 @@ class RMG_API Pending {
 
 
 /**
- * @brief Stack data structure made from singly-linked list
+ * @brief Loads data in memory into GPU
+ * 
+ * After preprocessing of 3D data like model reading, texture reading,
+ * the parsed data are temporarily stored in a queue. When the OpenGL context
+ * starts up, these data are loaded into the GPU, the memory data are deleted
+ * and the newly obtained GPU resource is later used for rendering models
+ * frequently.
  */
-class RMG_API PendingStack {
-    /**
-     * @brief Node of the stack data structure
-     */
-    struct Node {
-        Node* next = nullptr; ///< Next node
-        Pending data; ///< The stored data
-        
-        /**
-         * @brief Destructor
-         */
-        ~Node();
-    };
-    
-  private:
-    Node* next = nullptr;
-    Pending data;
-    uint32_t count = 0;
-    
+class RMG_API ContextLoader {
   public:
     /**
      * @brief Default constructor
      */
-    PendingStack() = default;
+    ContextLoader();
     
     /**
      * @brief Destructor
      */
-    ~PendingStack();
+    ~ContextLoader();
     
     /**
-     * @brief Appends an element to the top of the stack
+     * @brief Copy constructor makes an empty loader
      * 
-     * @param elem New element to the stack
-     */
-    void push(Pending elem);
-    
-    /**
-     * @brief Retrives an element from the top of the stack
+     * The loads and the worker threads belong to a single loader and are
+     * not copied.
      * 
-     * @return The retrived element
+     * @param loader Source
      */
-    Pending& front();
+    ContextLoader(const ContextLoader& loader);
     
     /**
-     * @brief Removes an element from the top of the stack
-     */
-    void pop();
-    
-    /**
-     * @brief Gets the number of elements in the stack
+     * @brief Copy assignment (deleted)
      * 
-     * @return The number of elements
+     * @param loader Source
      */
-    uint32_t size() const;
-};
-
-
-/**
- * @brief Loads data in memory into GPU
- * 
- * After preprocessing of 3D data like model reading, texture reading,
- * the parsed data are temporarily stored in a queue. When the OpenGL context
- * starts up, these data are loaded into the GPU, the memory data are deleted
- * and the newly obtained GPU resource is later used for rendering models
- * frequently.
- */
-class RMG_API ContextLoader {
-  public:
-    /**
-     * @brief Default constructor
-     */
-    ContextLoader() = default;
+    ContextLoader& operator=(const ContextLoader& loader) = delete;
     
     /**
      * @brief Append load into the loading list
@@ -226,6 +233,8 @@ class RMG_API ContextLoader {
      * If the function is called again for the same load, the shared data
      * of the Pending class determines that it already exists and cancels.
      * 
+     * If the load has CPU work to do, it is queued to the worker threads.
+     * 
      * @param elem Instance containing data to be loaded into GPU
      */
     void push(const Pending& elem);
@@ -233,12 +242,41 @@ class RMG_API ContextLoader {
     /**
      * @brief Loads the data to the GPU
      * 
-     * Loads the data from the list to the GPU and then clear the memory
-     * from the list. If the reference count of the load is zero, discard it
-     * without loading into the GPU.
+     * Loads the prepared data from the list to the GPU in the order they
+     * are pushed and then clear the memory from the list. The loads still
+     * being prepared stay in the list for the later calls. If the reference
+     * count of the load is zero, discard it without loading into the GPU.
+     * 
+     * Stops when the upload budget is used up leaving the rest for the
+     * next call. At least one load is uploaded in each call.
      */
     void load();
     
+    /**
+     * @brief Sets the limit of the uploads for each call of load()
+     * 
+     * Spreads the uploads across multiple frames when a lot of resources
+     * are added at once. Zero means no limit.
+     * 
+     * @param ms Time limit in milliseconds
+     * @param bytes Limit of the bytes sent to the GPU
+     */
+    void setBudget(float ms, uint64_t bytes=0);
+    
+    /**
+     * @brief Waits until every load in the list is prepared
+     * 
+     * The calling thread helps the worker threads with the queued loads.
+     */
+    void wait();
+    
+    /**
+     * @brief Gets the progress of the loads pushed since the list was empty
+     * 
+     * @return Fraction of the loads completed from 0 to 1
+     */
+    float getProgress() const;
+    
     /**
      * @brief Gets the number of loads in the queue
      * 
@@ -247,7 +285,18 @@ class RMG_API ContextLoader {
     uint64_t getLoadCount() const;
     
   private:
-    PendingStack pendingList;
+    std::deque<Pending> pendingList;
+    float budgetTime;
+    uint64_t budgetBytes;
+    uint64_t pushCount;
+    uint64_t loadCount;
+    std::deque<ContextLoad*> prepareQueue;
+    std::mutex mutex;
+    std::atomic<uint32_t> unprepared;
+    WorkerPool workers;
+    
+    void prepareNext();
+    bool cancel(ContextLoad* load);
 };
 
 }}
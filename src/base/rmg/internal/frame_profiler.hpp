@@ -0,0 +1,115 @@
+/**
+ * @file frame_profiler.hpp
+ * @brief Measures the CPU and GPU time of the rendering passes
+ * 
+ * GPU times are measured with timer queries which are kept in a ring and
+ * only read back once the results are available so the CPU never waits for
+ * the GPU.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#pragma once
+#ifndef __RMG_FRAME_PROFILER_H__
+#define __RMG_FRAME_PROFILER_H__
+
+#ifndef RMG_API
+#ifdef _WIN32
+#ifdef RMG_EXPORT
+#define RMG_API __declspec(dllexport)
+#else
+#define RMG_API __declspec(dllimport)
+#endif
+#else
+#define RMG_API
+#endif
+#endif
+
+
+#include <cstdint>
+
+#include "../frame_stats.hpp"
+
+#define RMG_FRAME_QUERY_RING 4 ///< Frames of timer queries in flight
+#define RMG_FRAME_HISTORY 128 ///< Frame times used for the percentiles
+
+
+namespace rmg {
+namespace internal {
+
+/**
+ * @brief Measures the CPU and GPU time of the rendering passes
+ * 
+ * GPU times are measured with timer queries which are kept in a ring and
+ * only read back once the results are available so the CPU never waits for
+ * the GPU.
+ */
+class RMG_API FrameProfiler {
+  private:
+    FrameStats stats;
+    uint32_t queries[RMG_FRAME_QUERY_RING][RMG_RENDER_PASS_COUNT];
+    bool queryIssued[RMG_FRAME_QUERY_RING];
+    uint32_t ringIndex;
+    int currentPass;
+    double passStartTime;
+    double lastFrameTime;
+    uint32_t passStartDrawCalls;
+    uint32_t passStartUniforms;
+    float history[RMG_FRAME_HISTORY];
+    uint32_t historyCount;
+    uint32_t historyIndex;
+    bool gpuTimerChecked;
+    
+    void readQueries(uint32_t slot);
+    void calculatePercentiles();
+    
+  public:
+    /**
+     * @brief Default constructor
+     */
+    FrameProfiler();
+    
+    /**
+     * @brief Destructor
+     */
+    ~FrameProfiler();
+    
+    /**
+     * @brief Starts measuring a new frame
+     * 
+     * Collects the GPU times of the oldest frame in the query ring if they
+     * are ready and resets the per-frame counters.
+     */
+    void beginFrame();
+    
+    /**
+     * @brief Starts measuring a rendering pass
+     * 
+     * @param pass Rendering pass
+     */
+    void beginPass(RenderPass pass);
+    
+    /**
+     * @brief Ends the measurement of the current rendering pass
+     */
+    void endPass();
+    
+    /**
+     * @brief Ends the measurement of the frame
+     */
+    void endFrame();
+    
+    /**
+     * @brief Gets the statistics of the recent frames
+     * 
+     * @return Frame statistics
+     */
+    const FrameStats &getStats() const;
+};
+
+}}
+
+#endif
@@ -6,6 +6,7 @@
  * Reads the appearance model of the objects and display them on screen
  * processing in the general fragment shader. Positioning is done by
  * processing MVP (Model-View-Projection) matricies in vertex shader.
+ * Objects sharing a VBO are drawn together as instances of it.
  * 
  * @copyright Copyright (c) 2020 Khant Kyaw Khaung
  * 
@@ -30,7 +31,10 @@
 #endif
 
 
+#include <vector>
+
 #include "shader.hpp"
+#include "shader_permutations.hpp"
 #include "../color.hpp"
 #include "../object.hpp"
 #include "../math/mat4.hpp"
@@ -39,8 +43,53 @@
 
 namespace rmg {
 
+class Object3D;
+
+
+/**
+ * @brief Filter kernel softening the edges of the shadows
+ * 
+ * Each tap is a bilinear comparison against the shadow map by the
+ * hardware, which blends the results of 4 texels.
+ */
+enum class ShadowKernel {
+    Single, ///< A single tap
+    Box4, ///< 4 taps in a square
+    Poisson9, ///< 9 taps over a Poisson disk
+    RotatedPoisson16 ///< 16 taps over a Poisson disk rotated at every pixel
+};
+
+
 namespace internal {
 
+class SceneBVH;
+
+
+/**
+ * @brief Per-instance attributes of a 3D object for the general shader
+ */
+struct GeneralInstance {
+    float model[16]; ///< Model matrix in column-major order
+    float scale[3]; ///< Object scale
+    float color[4]; ///< Material color
+    float mrao[3]; ///< Metalness, roughness and ambient occulation
+    float posOffset[3]; ///< Offset of the quantized positions
+    float posScale[3]; ///< Scale of the quantized positions
+};
+
+
+/**
+ * @brief Parameters of an indirect indexed draw
+ */
+struct DrawElementsCommand {
+    uint32_t count; ///< Number of indices
+    uint32_t instanceCount; ///< Number of instances
+    uint32_t firstIndex; ///< First index in the element buffer
+    int32_t baseVertex; ///< Added to the indices
+    uint32_t baseInstance; ///< First instance in the instance buffer
+};
+
+
 /**
  * @brief Peforms general tasks like positioning and lighting
  * 
@@ -48,21 +97,38 @@ namespace internal {
  * Reads the appearance model of the objects and display them on screen
  * processing in the general fragment shader. Positioning is done by
  * processing MVP (Model-View-Projection) matricies in vertex shader.
+ * 
+ * Visible objects are grouped by their geometry arena and texture. Each
+ * group is drawn with a single indirect multi-draw call holding an
+ * instanced draw for every VBO in the group, or with an instanced draw
+ * for every VBO if the GPU lacks OpenGL 4.3. The model matrix, scale and
+ * material of each object are streamed through an instance buffer.
+ * 
+ * Each object is drawn at the coarsest level of detail whose error
+ * projects to less than the given size on the screen.
+ * 
+ * The shadows, textures and compressed normals are compiled into separate
+ * programs instead of branching on flags. The groups are drawn in the
+ * order of their programs so that each one is bound once a frame.
  */
 class RMG_API GeneralShader: public Shader {
   private:
-    uint32_t idMVP;
-    uint32_t idMV;
-    uint32_t idScale;
-    uint32_t idShadow;
-    uint32_t idShadowMVP;
-    uint32_t idDLCamera;
-    uint32_t idDLColor;
-    uint32_t idMatColor;
-    uint32_t idMatMetal;
-    uint32_t idMatRough;
-    uint32_t idMatAO;
-    uint32_t idFlags;
+    ShaderPermutations programs;
+    ShadowKernel kernel = ShadowKernel::Poisson9;
+    bool loaded = false;
+    uint32_t instanceBuffer = 0;
+    uint32_t indirectBuffer = 0;
+    bool multiDrawIndirect = false;
+    std::vector<Object3D*> batch;
+    std::vector<GeneralInstance> instances;
+    std::vector<DrawElementsCommand> commands;
+    
+    void setUniforms(const ShaderPermutation &perm, const Mat4 &V,
+                     const Mat4 &P, const Mat4 *S, uint32_t cascades,
+                     const Vec3 &dlCam, const Color &dlColor,
+                     uint32_t shadow);
+    void setInstanceAttributes(size_t offset);
+    void selectLevels(const Mat4 &V, const Mat4 &P, float lodError);
     
   public:
     /**
@@ -70,26 +136,58 @@ class RMG_API GeneralShader: public Shader {
      */
     GeneralShader() = default;
     
+    /**
+     * @brief Destructor
+     */
+    virtual ~GeneralShader();
+    
     /**
      * @brief Compiles and links shader program and assigns parameter IDs
      */
     void load() override;
     
     /**
-     * @brief Renders the given list of 3D objects with world model, object
+     * @brief Sets the filter kernel of the shadow edges
+     * 
+     * The programs are compiled again with the kernel by the next render.
+     * 
+     * @param k Shadow filter kernel
+     */
+    void setShadowKernel(ShadowKernel k);
+    
+    /**
+     * @brief Gets the filter kernel of the shadow edges
+     * 
+     * @return Shadow filter kernel
+     */
+    ShadowKernel getShadowKernel() const;
+    
+    /**
+     * @brief Gets the number of programs compiled for the combinations of
+     *        features drawn so far
+     * 
+     * @return Number of programs
+     */
+    size_t getProgramCount() const;
+    
+    /**
+     * @brief Renders the 3D objects in view with world model, object
      *        model and material properties
      * 
      * @param V View matrix
      * @param P Projection matrix
-     * @param S Shadow matrix
+     * @param S Shadow matrices of the cascades
+     * @param cascades Number of cascades
      * @param dlCam Directional light vector in camera space
      * @param dlColor Directional light color
      * @param shadow Shadow map
-     * @param list List of 3D objects
+     * @param bvh Bounding volume hierarchy of the 3D objects
+     * @param lodError Largest error of the levels of detail in normalized
+     *                 device coordinates
      */
-    void render(const Mat4 &V, const Mat4 &P, const Mat4 &S,
-                const Vec3 &dlCam, const Color &dlColor, uint32_t shadow,
-                const ObjectList &list);
+    void render(const Mat4 &V, const Mat4 &P, const Mat4 *S,
+                uint32_t cascades, const Vec3 &dlCam, const Color &dlColor,
+                uint32_t shadow, const SceneBVH &bvh, float lodError=0);
 };
 
 }}
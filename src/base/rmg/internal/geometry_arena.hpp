@@ -0,0 +1,353 @@
+/**
+ * @file geometry_arena.hpp
+ * @brief Suballocates the vertex and index arrays of many meshes from shared
+ *        GPU buffers
+ * 
+ * Meshes of the same vertex format share a set of large buffers behind a
+ * single vertex array. Switching between them needs no rebinding and a
+ * group of them is drawn by a single multi-draw call.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#pragma once
+#ifndef __RMG_GEOMETRY_ARENA_H__
+#define __RMG_GEOMETRY_ARENA_H__
+
+#ifndef RMG_API
+#ifdef _WIN32
+#ifdef RMG_EXPORT
+#define RMG_API __declspec(dllexport)
+#else
+#define RMG_API __declspec(dllimport)
+#endif
+#else
+#define RMG_API
+#endif
+#endif
+
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#define RMG_VERTEX_COMPRESSED 0x1 ///< Quantized positions and normals
+#define RMG_VERTEX_TEXTURED 0x2 ///< Has texture coordinates
+#define RMG_VERTEX_HALF_TEXCOORDS 0x4 ///< Half float texture coordinates
+#define RMG_VERTEX_SHORT_INDICES 0x8 ///< 16-bit indices
+#define RMG_VERTEX_FORMAT_COUNT 16 ///< Number of vertex formats
+
+#define RMG_GEOMETRY_MIN_VERTICES 65536 ///< Initial vertex capacity
+#define RMG_GEOMETRY_MIN_INDICES 196608 ///< Initial index capacity
+
+
+namespace rmg {
+namespace internal {
+
+/**
+ * @brief Keeps track of the free ranges of a buffer
+ * 
+ * The free ranges are sorted by their offsets. Allocations take the first
+ * range large enough and released ranges merge with their neighbours.
+ */
+class RMG_API FreeList {
+  private:
+    std::map<uint32_t, uint32_t> blocks;
+    uint32_t capacity;
+    uint32_t freeCount;
+    
+  public:
+    /**
+     * @brief Default constructor
+     */
+    FreeList();
+    
+    /**
+     * @brief Empties the list with a new capacity
+     * 
+     * @param cap Number of elements the buffer holds
+     */
+    void reset(uint32_t cap);
+    
+    /**
+     * @brief Extends the capacity keeping the current allocations
+     * 
+     * @param cap New number of elements the buffer holds
+     */
+    void grow(uint32_t cap);
+    
+    /**
+     * @brief Allocates a range
+     * 
+     * @param count Number of elements
+     * @param offset Returns the first element of the range
+     * 
+     * @return True if a free range is large enough
+     */
+    bool allocate(uint32_t count, uint32_t *offset);
+    
+    /**
+     * @brief Returns a range to the free list
+     * 
+     * @param offset First element of the range
+     * @param count Number of elements
+     */
+    void release(uint32_t offset, uint32_t count);
+    
+    /**
+     * @brief Gets the number of elements the buffer holds
+     * 
+     * @return Capacity
+     */
+    uint32_t getCapacity() const;
+    
+    /**
+     * @brief Gets the number of elements not allocated
+     * 
+     * @return Free elements
+     */
+    uint32_t getFreeCount() const;
+    
+    /**
+     * @brief Gets the size of the largest free range
+     * 
+     * @return Number of elements in the largest free range
+     */
+    uint32_t getLargestBlock() const;
+};
+
+
+/**
+ * @brief Location of a mesh in the buffers of a geometry arena
+ */
+struct GeometryRange {
+    uint32_t vertexOffset; ///< First vertex, the base vertex of the draws
+    uint32_t vertexCount; ///< Number of vertices
+    uint32_t indexOffset; ///< First index
+    uint32_t indexCount; ///< Number of indices
+};
+
+
+/**
+ * @brief Suballocates the meshes of a vertex format from shared buffers
+ * 
+ * The positions, the interleaved normals and texture coordinates and the
+ * indices live in three buffers bound to one vertex array. A second vertex
+ * array binds the positions only for the depth-only passes. The indices of
+ * each mesh stay relative to its first vertex and are drawn with a base
+ * vertex.
+ * 
+ * The buffers are rebuilt with a larger capacity when they run out of
+ * space. Rebuilding packs the meshes to the front, which is also how the
+ * arena is defragmented. The meshes are referenced by slots which stay
+ * valid as the ranges move.
+ */
+class RMG_API GeometryArena {
+  private:
+    uint32_t format;
+    uint32_t vertexArrayID = 0;
+    uint32_t positionArrayID = 0;
+    uint32_t vertexbuffer = 0;
+    uint32_t attributebuffer = 0;
+    uint32_t elementbuffer = 0;
+    FreeList vertexSpace;
+    FreeList indexSpace;
+    std::vector<GeometryRange> ranges;
+    std::vector<uint32_t> freeSlots;
+    
+    bool reserve(uint32_t vertexCount, uint32_t indexCount,
+                 GeometryRange *range);
+    void rebuild(uint32_t vertexCapacity, uint32_t indexCapacity);
+    void setAttributePointers();
+    
+  public:
+    /**
+     * @brief Constructor
+     * 
+     * The GPU buffers are created by the first allocation.
+     * 
+     * @param format Vertex format flags (RMG_VERTEX_*)
+     */
+    GeometryArena(uint32_t format);
+    
+    /**
+     * @brief Destructor
+     */
+    ~GeometryArena();
+    
+    /**
+     * @brief Copy constructor (deleted)
+     * 
+     * @param arena Source
+     */
+    GeometryArena(const GeometryArena& arena) = delete;
+    
+    /**
+     * @brief Copy assignment (deleted)
+     * 
+     * @param arena Source
+     */
+    GeometryArena& operator=(const GeometryArena& arena) = delete;
+    
+    /**
+     * @brief Gets the vertex format
+     * 
+     * @return Vertex format flags (RMG_VERTEX_*)
+     */
+    uint32_t getFormat() const;
+    
+    /**
+     * @brief Gets the size of a position in the position buffer
+     * 
+     * @return Size in bytes
+     */
+    uint32_t getPositionSize() const;
+    
+    /**
+     * @brief Gets the size of a vertex in the attribute buffer
+     * 
+     * @return Size in bytes
+     */
+    uint32_t getAttributeSize() const;
+    
+    /**
+     * @brief Gets the size of an index
+     * 
+     * @return Size in bytes
+     */
+    uint32_t getIndexSize() const;
+    
+    /**
+     * @brief Gets the GL type of the indices
+     * 
+     * @return GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+     */
+    uint32_t getIndexType() const;
+    
+    /**
+     * @brief Allocates the ranges of a mesh and uploads its arrays
+     * 
+     * @param positions Position stream
+     * @param attributes Attribute stream of normals and texture
+     *                   coordinates
+     * @param indices Indices relative to the first vertex of the mesh
+     * @param vertexCount Number of vertices
+     * @param indexCount Number of indices
+     * 
+     * @return Slot of the mesh
+     */
+    uint32_t allocate(const void* positions, const void* attributes,
+                      const void* indices, uint32_t vertexCount,
+                      uint32_t indexCount);
+    
+    /**
+     * @brief Frees the ranges of a mesh
+     * 
+     * @param slot Slot of the mesh
+     */
+    void release(uint32_t slot);
+    
+    /**
+     * @brief Gets the location of a mesh in the buffers
+     * 
+     * @param slot Slot of the mesh
+     * 
+     * @return Vertex and index ranges
+     */
+    const GeometryRange &getRange(uint32_t slot) const;
+    
+    /**
+     * @brief Binds the vertex array of all the attributes
+     */
+    void bindVertexArray() const;
+    
+    /**
+     * @brief Binds the vertex array of the positions only
+     */
+    void bindPositionArray() const;
+    
+    /**
+     * @brief Gets the ratio of the free space unusable by a large
+     *        allocation
+     * 
+     * The free space outside the largest free range of the vertex or index
+     * buffer, whichever is higher, relative to the capacity.
+     * 
+     * @return Ratio from 0 to 1
+     */
+    float getFragmentation() const;
+    
+    /**
+     * @brief Packs the meshes to the front of the buffers
+     */
+    void defragment();
+};
+
+
+/**
+ * @brief Geometry arenas of a context, one for each vertex format
+ */
+class RMG_API GeometryPool {
+  private:
+    GeometryArena* arenas[RMG_VERTEX_FORMAT_COUNT];
+    
+  public:
+    /**
+     * @brief Default constructor
+     */
+    GeometryPool();
+    
+    /**
+     * @brief Destructor
+     */
+    ~GeometryPool();
+    
+    /**
+     * @brief Copy constructor (deleted)
+     * 
+     * @param pool Source
+     */
+    GeometryPool(const GeometryPool& pool) = delete;
+    
+    /**
+     * @brief Move constructor
+     * 
+     * @param pool Source
+     */
+    GeometryPool(GeometryPool&& pool) noexcept;
+    
+    /**
+     * @brief Copy assignment (deleted)
+     * 
+     * @param pool Source
+     */
+    GeometryPool& operator=(const GeometryPool& pool) = delete;
+    
+    /**
+     * @brief Gets the arena of a vertex format
+     * 
+     * @param format Vertex format flags (RMG_VERTEX_*)
+     * 
+     * @return Geometry arena created on the first use
+     */
+    GeometryArena *getArena(uint32_t format);
+    
+    /**
+     * @brief Defragments the arenas wasting too much space
+     * 
+     * @param threshold Fragmentation above which an arena is packed
+     */
+    void defragment(float threshold);
+    
+    /**
+     * @brief Deletes the arenas and their GPU buffers
+     */
+    void clear();
+};
+
+}}
+
+#endif
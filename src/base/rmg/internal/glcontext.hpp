@@ -31,48 +31,81 @@
 #include "GL/gl.h"
 
 #include <cstddef>
+#include <cstdint>
 
 
 typedef void (GLAPIENTRY* PFNGLACTIVETEXTUREPROC) (GLenum texture); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLATTACHSHADERPROC) (GLuint program, GLuint shader); ///< GL typedef
+typedef void (GLAPIENTRY* PFNGLBEGINQUERYPROC) (GLenum target, GLuint id); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLBINDATTRIBLOCATIONPROC) (GLuint program, GLuint index, const GLchar *name); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLBINDBUFFERPROC) (GLenum target, GLuint buffer); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLBINDFRAMEBUFFERPROC) (GLenum target, GLuint framebuffer); ///< GL typedef
+typedef void (GLAPIENTRY* PFNGLBINDRENDERBUFFERPROC) (GLenum target, GLuint renderbuffer); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLBINDVERTEXARRAYPROC) (GLuint array); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLBUFFERDATAPROC) (GLenum target, GLsizeiptr size, const void *data, GLenum usage); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLBUFFERSUBDATAPROC) (GLenum target, GLintptr offset, GLsizeiptr size, const void *data); ///< GL typedef
+typedef GLenum (GLAPIENTRY* PFNGLCHECKFRAMEBUFFERSTATUSPROC) (GLenum target); ///< GL typedef
+typedef void (GLAPIENTRY* PFNGLCLEARBUFFERUIVPROC) (GLenum buffer, GLint drawbuffer, const GLuint *value); ///< GL typedef
+typedef GLenum (GLAPIENTRY* PFNGLCLIENTWAITSYNCPROC) (GLsync sync, GLbitfield flags, GLuint64 timeout); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLCOMPILESHADERPROC) (GLuint shader); ///< GL typedef
+typedef void (GLAPIENTRY* PFNGLCOPYBUFFERSUBDATAPROC) (GLenum readTarget, GLenum writeTarget, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size); ///< GL typedef
 typedef GLuint (GLAPIENTRY* PFNGLCREATEPROGRAMPROC) (void); ///< GL typedef
 typedef GLuint (GLAPIENTRY* PFNGLCREATESHADERPROC) (GLenum type); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLDELETEBUFFERSPROC) (GLsizei n, const GLuint *buffers); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLDELETEFRAMEBUFFERSPROC) (GLsizei n, const GLuint* framebuffers); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLDELETEPROGRAMPROC) (GLuint program); ///< GL typedef
+typedef void (GLAPIENTRY* PFNGLDELETEQUERIESPROC) (GLsizei n, const GLuint *ids); ///< GL typedef
+typedef void (GLAPIENTRY* PFNGLDELETERENDERBUFFERSPROC) (GLsizei n, const GLuint *renderbuffers); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLDELETESHADERPROC) (GLuint shader); ///< GL typedef
+typedef void (GLAPIENTRY* PFNGLDELETESYNCPROC) (GLsync sync); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLDELETEVERTEXARRAYSPROC) (GLsizei n, const GLuint *arrays); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLDETACHSHADERPROC) (GLuint program, GLuint shader); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLDISABLEVERTEXATTRIBARRAYPROC) (GLuint index); ///< GL typedef
+typedef void (GLAPIENTRY* PFNGLDRAWELEMENTSBASEVERTEXPROC) (GLenum mode, GLsizei count, GLenum type, const void *indices, GLint basevertex); ///< GL typedef
+typedef void (GLAPIENTRY* PFNGLDRAWELEMENTSINSTANCEDPROC) (GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instancecount); ///< GL typedef
+typedef void (GLAPIENTRY* PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXPROC) (GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instancecount, GLint basevertex); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLENABLEVERTEXATTRIBARRAYPROC) (GLuint index); ///< GL typedef
+typedef void (GLAPIENTRY* PFNGLENDQUERYPROC) (GLenum target); ///< GL typedef
+typedef GLsync (GLAPIENTRY* PFNGLFENCESYNCPROC) (GLenum condition, GLbitfield flags); ///< GL typedef
+typedef void (GLAPIENTRY* PFNGLFRAMEBUFFERRENDERBUFFERPROC) (GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLFRAMEBUFFERTEXTURE2DPROC) (GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level); ///< GL typedef
+typedef void (GLAPIENTRY* PFNGLFRAMEBUFFERTEXTURELAYERPROC) (GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLGENBUFFERSPROC) (GLsizei n, GLuint *buffers); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLGENERATEMIPMAPEXTPROC) (GLenum target); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLGENFRAMEBUFFERSPROC) (GLsizei n, GLuint *framebuffers); ///< GL typedef
+typedef void (GLAPIENTRY* PFNGLGENQUERIESPROC) (GLsizei n, GLuint *ids); ///< GL typedef
+typedef void (GLAPIENTRY* PFNGLGENRENDERBUFFERSPROC) (GLsizei n, GLuint *renderbuffers); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLGENVERTEXARRAYSPROC) (GLsizei n, GLuint *arrays); ///< GL typedef
+typedef void (GLAPIENTRY* PFNGLGETPROGRAMBINARYPROC) (GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLGETPROGRAMINFOLOGPROC) (GLuint program, GLsizei bufSize, GLsizei *length, GLchar *infoLog); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLGETPROGRAMIVPROC) (GLuint program, GLenum pname, GLint *params); ///< GL typedef
+typedef void (GLAPIENTRY* PFNGLGETQUERYOBJECTIVPROC) (GLuint id, GLenum pname, GLint *params); ///< GL typedef
+typedef void (GLAPIENTRY* PFNGLGETQUERYOBJECTUI64VPROC) (GLuint id, GLenum pname, GLuint64 *params); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLGETSHADERIVPROC) (GLuint shader, GLenum pname, GLint *params); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLGETSHADERINFOLOGPROC) (GLuint shader, GLsizei bufSize, GLsizei *length, GLchar *infoLog); ///< GL typedef
+typedef const GLubyte * (GLAPIENTRY* PFNGLGETSTRINGIPROC) (GLenum name, GLuint index); ///< GL typedef
 typedef GLint (GLAPIENTRY* PFNGLGETUNIFORMLOCATIONPROC) (GLuint program, const GLchar *name); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLLINKPROGRAMPROC) (GLuint program); ///< GL typedef
+typedef void * (GLAPIENTRY* PFNGLMAPBUFFERRANGEPROC) (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access); ///< GL typedef
+typedef void (GLAPIENTRY* PFNGLMAXSHADERCOMPILERTHREADSKHRPROC) (GLuint count); ///< GL typedef
+typedef void (GLAPIENTRY* PFNGLMULTIDRAWELEMENTSINDIRECTPROC) (GLenum mode, GLenum type, const void *indirect, GLsizei drawcount, GLsizei stride); ///< GL typedef
+typedef void (GLAPIENTRY* PFNGLPROGRAMBINARYPROC) (GLuint program, GLenum binaryFormat, const void *binary, GLsizei length); ///< GL typedef
+typedef void (GLAPIENTRY* PFNGLPROGRAMPARAMETERIPROC) (GLuint program, GLenum pname, GLint value); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLPROVOKINGVERTEXPROC) (GLenum mode); ///< GL typedef
+typedef void (GLAPIENTRY* PFNGLRENDERBUFFERSTORAGEPROC) (GLenum target, GLenum internalformat, GLsizei width, GLsizei height); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLSHADERSOURCEPROC) (GLuint shader, GLsizei count, const GLchar *const*string, const GLint *length); ///< GL typedef
+typedef void (GLAPIENTRY* PFNGLTEXIMAGE3DPROC) (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void *pixels); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLUNIFORM1FPROC) (GLint location, GLfloat v0); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLUNIFORM1IPROC) (GLint location, GLint v0); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLUNIFORM2FPROC) (GLint location, GLfloat v0, GLfloat v1); ///< GL typedef
+typedef void (GLAPIENTRY* PFNGLUNIFORM2UIPROC) (GLint location, GLuint v0, GLuint v1); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLUNIFORM3FVPROC) (GLint location, GLsizei count, const GLfloat *value); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLUNIFORM4FVPROC) (GLint location, GLsizei count, const GLfloat *value); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLUNIFORMMATRIX3FVPROC) (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLUNIFORMMATRIX4FVPROC) (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value); ///< GL typedef
+typedef GLboolean (GLAPIENTRY* PFNGLUNMAPBUFFERPROC) (GLenum target); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLUSEPROGRAMPROC) (GLuint program); ///< GL typedef
+typedef void (GLAPIENTRY* PFNGLVERTEXATTRIBDIVISORPROC) (GLuint index, GLuint divisor); ///< GL typedef
 typedef void (GLAPIENTRY* PFNGLVERTEXATTRIBPOINTERPROC) (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer); ///< GL typedef
 
 
@@ -81,43 +114,92 @@ namespace internal {
 
 RMG_API extern PFNGLACTIVETEXTUREPROC glActiveTexture; ///< GL function
 RMG_API extern PFNGLATTACHSHADERPROC glAttachShader; ///< GL function
+RMG_API extern PFNGLBEGINQUERYPROC glBeginQuery; ///< GL function
 RMG_API extern PFNGLBINDBUFFERPROC glBindBuffer; ///< GL function
 RMG_API extern PFNGLBINDFRAMEBUFFERPROC glBindFramebuffer; ///< GL function
+RMG_API extern PFNGLBINDRENDERBUFFERPROC glBindRenderbuffer; ///< GL function
 RMG_API extern PFNGLBINDVERTEXARRAYPROC glBindVertexArray; ///< GL function
 RMG_API extern PFNGLBUFFERDATAPROC glBufferData; ///< GL function
+RMG_API extern PFNGLBUFFERSUBDATAPROC glBufferSubData; ///< GL function
+RMG_API extern PFNGLCHECKFRAMEBUFFERSTATUSPROC glCheckFramebufferStatus; ///< GL function
+RMG_API extern PFNGLCLEARBUFFERUIVPROC glClearBufferuiv; ///< GL function
+RMG_API extern PFNGLCLIENTWAITSYNCPROC glClientWaitSync; ///< GL function
 RMG_API extern PFNGLCOMPILESHADERPROC glCompileShader; ///< GL function
+RMG_API extern PFNGLCOPYBUFFERSUBDATAPROC glCopyBufferSubData; ///< GL function
 RMG_API extern PFNGLCREATEPROGRAMPROC glCreateProgram; ///< GL function
 RMG_API extern PFNGLCREATESHADERPROC glCreateShader; ///< GL function
 RMG_API extern PFNGLDELETEBUFFERSPROC glDeleteBuffers; ///< GL function
 RMG_API extern PFNGLDELETEFRAMEBUFFERSPROC glDeleteFramebuffers; ///< GL function
 RMG_API extern PFNGLDELETEPROGRAMPROC glDeleteProgram; ///< GL function
+RMG_API extern PFNGLDELETEQUERIESPROC glDeleteQueries; ///< GL function
+RMG_API extern PFNGLDELETERENDERBUFFERSPROC glDeleteRenderbuffers; ///< GL function
 RMG_API extern PFNGLDELETESHADERPROC glDeleteShader; ///< GL function
+RMG_API extern PFNGLDELETESYNCPROC glDeleteSync; ///< GL function
 RMG_API extern PFNGLDELETEVERTEXARRAYSPROC glDeleteVertexArrays; ///< GL function
 RMG_API extern PFNGLDETACHSHADERPROC glDetachShader; ///< GL function
 RMG_API extern PFNGLDISABLEVERTEXATTRIBARRAYPROC glDisableVertexAttribArray; ///< GL function
+RMG_API extern PFNGLDRAWELEMENTSBASEVERTEXPROC glDrawElementsBaseVertex; ///< GL function
+RMG_API extern PFNGLDRAWELEMENTSINSTANCEDPROC glDrawElementsInstanced; ///< GL function
+RMG_API extern PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXPROC glDrawElementsInstancedBaseVertex; ///< GL function
 RMG_API extern PFNGLENABLEVERTEXATTRIBARRAYPROC glEnableVertexAttribArray; ///< GL function
+RMG_API extern PFNGLENDQUERYPROC glEndQuery; ///< GL function
+RMG_API extern PFNGLFENCESYNCPROC glFenceSync; ///< GL function
+RMG_API extern PFNGLFRAMEBUFFERRENDERBUFFERPROC glFramebufferRenderbuffer; ///< GL function
 RMG_API extern PFNGLFRAMEBUFFERTEXTURE2DPROC glFramebufferTexture2D; ///< GL function
+RMG_API extern PFNGLFRAMEBUFFERTEXTURELAYERPROC glFramebufferTextureLayer; ///< GL function
 RMG_API extern PFNGLGENBUFFERSPROC glGenBuffers; ///< GL function
 RMG_API extern PFNGLGENERATEMIPMAPEXTPROC glGenerateMipmap; ///< GL funtion
 RMG_API extern PFNGLGENFRAMEBUFFERSPROC glGenFramebuffers; ///< GL function
+RMG_API extern PFNGLGENQUERIESPROC glGenQueries; ///< GL function
+RMG_API extern PFNGLGENRENDERBUFFERSPROC glGenRenderbuffers; ///< GL function
 RMG_API extern PFNGLGENVERTEXARRAYSPROC glGenVertexArrays; ///< GL function
+RMG_API extern PFNGLGETPROGRAMBINARYPROC glGetProgramBinary; ///< GL function
 RMG_API extern PFNGLGETPROGRAMINFOLOGPROC glGetProgramInfoLog; ///< GL function
 RMG_API extern PFNGLGETPROGRAMIVPROC glGetProgramiv; ///< GL function
+RMG_API extern PFNGLGETQUERYOBJECTIVPROC glGetQueryObjectiv; ///< GL function
+RMG_API extern PFNGLGETQUERYOBJECTUI64VPROC glGetQueryObjectui64v; ///< GL function
 RMG_API extern PFNGLGETSHADERINFOLOGPROC glGetShaderInfoLog; ///< GL function
 RMG_API extern PFNGLGETSHADERIVPROC glGetShaderiv; ///< GL function
+RMG_API extern PFNGLGETSTRINGIPROC glGetStringi; ///< GL function
 RMG_API extern PFNGLGETUNIFORMLOCATIONPROC glGetUniformLocation; ///< GL function
 RMG_API extern PFNGLLINKPROGRAMPROC glLinkProgram; ///< GL function
+RMG_API extern PFNGLMAPBUFFERRANGEPROC glMapBufferRange; ///< GL function
+RMG_API extern PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glMaxShaderCompilerThreadsKHR; ///< GL function
+RMG_API extern PFNGLMULTIDRAWELEMENTSINDIRECTPROC glMultiDrawElementsIndirect; ///< GL function
+RMG_API extern PFNGLPROGRAMBINARYPROC glProgramBinary; ///< GL function
+RMG_API extern PFNGLPROGRAMPARAMETERIPROC glProgramParameteri; ///< GL function
+RMG_API extern PFNGLRENDERBUFFERSTORAGEPROC glRenderbufferStorage; ///< GL function
 RMG_API extern PFNGLSHADERSOURCEPROC glShaderSource; ///< GL function
+RMG_API extern PFNGLTEXIMAGE3DPROC glTexImage3D; ///< GL function
 RMG_API extern PFNGLUNIFORM1FPROC glUniform1f; ///< GL function
 RMG_API extern PFNGLUNIFORM1IPROC glUniform1i; ///< GL function
 RMG_API extern PFNGLUNIFORM2FPROC glUniform2f; ///< GL function
+RMG_API extern PFNGLUNIFORM2UIPROC glUniform2ui; ///< GL function
 RMG_API extern PFNGLUNIFORM3FVPROC glUniform3fv; ///< GL function
 RMG_API extern PFNGLUNIFORM4FVPROC glUniform4fv; ///< GL function
 RMG_API extern PFNGLUNIFORMMATRIX4FVPROC glUniformMatrix3fv; ///< GL function
 RMG_API extern PFNGLUNIFORMMATRIX4FVPROC glUniformMatrix4fv; ///< GL function
+RMG_API extern PFNGLUNMAPBUFFERPROC glUnmapBuffer; ///< GL function
 RMG_API extern PFNGLUSEPROGRAMPROC glUseProgram; ///< GL function
+RMG_API extern PFNGLVERTEXATTRIBDIVISORPROC glVertexAttribDivisor; ///< GL function
 RMG_API extern PFNGLVERTEXATTRIBPOINTERPROC glVertexAttribPointer; ///< GL function
 
+/**
+ * @brief Number of draw calls issued since the program started
+ * 
+ * Incremented by the shaders next to every glDraw* call. Frame statistics
+ * are taken from the differences of the counter.
+ */
+RMG_API extern uint32_t drawCallCount;
+
+/**
+ * @brief Number of glUniform* calls made since the program started
+ * 
+ * The uniform function pointers are routed through counting wrappers
+ * whenever a GL context is made current.
+ */
+RMG_API extern uint32_t uniformUploadCount;
+
 
 /**
  * @brief GL functions for a specific GL context
@@ -126,41 +208,74 @@ class RMG_API GLContext {
   private:
     PFNGLACTIVETEXTUREPROC func_glActiveTexture = NULL;
     PFNGLATTACHSHADERPROC func_glAttachShader = NULL;
+    PFNGLBEGINQUERYPROC func_glBeginQuery = NULL;
     PFNGLBINDBUFFERPROC func_glBindBuffer = NULL;
     PFNGLBINDFRAMEBUFFERPROC func_glBindFramebuffer = NULL;
+    PFNGLBINDRENDERBUFFERPROC func_glBindRenderbuffer = NULL;
     PFNGLBINDVERTEXARRAYPROC func_glBindVertexArray = NULL;
     PFNGLBUFFERDATAPROC func_glBufferData = NULL;
+    PFNGLBUFFERSUBDATAPROC func_glBufferSubData = NULL;
+    PFNGLCHECKFRAMEBUFFERSTATUSPROC func_glCheckFramebufferStatus = NULL;
+    PFNGLCLEARBUFFERUIVPROC func_glClearBufferuiv = NULL;
+    PFNGLCLIENTWAITSYNCPROC func_glClientWaitSync = NULL;
     PFNGLCOMPILESHADERPROC func_glCompileShader = NULL;
+    PFNGLCOPYBUFFERSUBDATAPROC func_glCopyBufferSubData = NULL;
     PFNGLCREATEPROGRAMPROC func_glCreateProgram = NULL;
     PFNGLCREATESHADERPROC func_glCreateShader = NULL;
     PFNGLDELETEBUFFERSPROC func_glDeleteBuffers = NULL;
     PFNGLDELETEFRAMEBUFFERSPROC func_glDeleteFramebuffers = NULL;
     PFNGLDELETEPROGRAMPROC func_glDeleteProgram = NULL;
+    PFNGLDELETEQUERIESPROC func_glDeleteQueries = NULL;
+    PFNGLDELETERENDERBUFFERSPROC func_glDeleteRenderbuffers = NULL;
     PFNGLDELETESHADERPROC func_glDeleteShader = NULL;
+    PFNGLDELETESYNCPROC func_glDeleteSync = NULL;
     PFNGLDELETEVERTEXARRAYSPROC func_glDeleteVertexArrays = NULL;
     PFNGLDETACHSHADERPROC func_glDetachShader = NULL;
     PFNGLDISABLEVERTEXATTRIBARRAYPROC func_glDisableVertexAttribArray = NULL;
+    PFNGLDRAWELEMENTSBASEVERTEXPROC func_glDrawElementsBaseVertex = NULL;
+    PFNGLDRAWELEMENTSINSTANCEDPROC func_glDrawElementsInstanced = NULL;
+    PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXPROC func_glDrawElementsInstancedBaseVertex = NULL;
     PFNGLENABLEVERTEXATTRIBARRAYPROC func_glEnableVertexAttribArray = NULL;
+    PFNGLENDQUERYPROC func_glEndQuery = NULL;
+    PFNGLFENCESYNCPROC func_glFenceSync = NULL;
+    PFNGLFRAMEBUFFERRENDERBUFFERPROC func_glFramebufferRenderbuffer = NULL;
     PFNGLFRAMEBUFFERTEXTURE2DPROC func_glFramebufferTexture2D = NULL;
+    PFNGLFRAMEBUFFERTEXTURELAYERPROC func_glFramebufferTextureLayer = NULL;
     PFNGLGENBUFFERSPROC func_glGenBuffers = NULL;
     PFNGLGENERATEMIPMAPEXTPROC func_glGenerateMipmap = NULL;
     PFNGLGENFRAMEBUFFERSPROC func_glGenFramebuffers = NULL;
+    PFNGLGENQUERIESPROC func_glGenQueries = NULL;
+    PFNGLGENRENDERBUFFERSPROC func_glGenRenderbuffers = NULL;
     PFNGLGENVERTEXARRAYSPROC func_glGenVertexArrays = NULL;
+    PFNGLGETPROGRAMBINARYPROC func_glGetProgramBinary = NULL;
     PFNGLGETPROGRAMINFOLOGPROC func_glGetProgramInfoLog = NULL;
     PFNGLGETPROGRAMIVPROC func_glGetProgramiv = NULL;
+    PFNGLGETQUERYOBJECTIVPROC func_glGetQueryObjectiv = NULL;
+    PFNGLGETQUERYOBJECTUI64VPROC func_glGetQueryObjectui64v = NULL;
     PFNGLGETSHADERINFOLOGPROC func_glGetShaderInfoLog = NULL;
     PFNGLGETSHADERIVPROC func_glGetShaderiv = NULL;
+    PFNGLGETSTRINGIPROC func_glGetStringi = NULL;
     PFNGLGETUNIFORMLOCATIONPROC func_glGetUniformLocation = NULL;
     PFNGLLINKPROGRAMPROC func_glLinkProgram = NULL;
+    PFNGLMAPBUFFERRANGEPROC func_glMapBufferRange = NULL;
+    PFNGLMAXSHADERCOMPILERTHREADSKHRPROC func_glMaxShaderCompilerThreadsKHR = NULL;
+    PFNGLMULTIDRAWELEMENTSINDIRECTPROC func_glMultiDrawElementsIndirect = NULL;
+    PFNGLPROGRAMBINARYPROC func_glProgramBinary = NULL;
+    PFNGLPROGRAMPARAMETERIPROC func_glProgramParameteri = NULL;
+    PFNGLRENDERBUFFERSTORAGEPROC func_glRenderbufferStorage = NULL;
     PFNGLSHADERSOURCEPROC func_glShaderSource = NULL;
+    PFNGLTEXIMAGE3DPROC func_glTexImage3D = NULL;
     PFNGLUNIFORM1FPROC func_glUniform1f = NULL;
     PFNGLUNIFORM1IPROC func_glUniform1i = NULL;
     PFNGLUNIFORM2FPROC func_glUniform2f = NULL;
+    PFNGLUNIFORM2UIPROC func_glUniform2ui = NULL;
     PFNGLUNIFORM3FVPROC func_glUniform3fv = NULL;
     PFNGLUNIFORM4FVPROC func_glUniform4fv = NULL;
     PFNGLUNIFORMMATRIX3FVPROC func_glUniformMatrix3fv = NULL;
     PFNGLUNIFORMMATRIX4FVPROC func_glUniformMatrix4fv = NULL;
+    PFNGLUNMAPBUFFERPROC func_glUnmapBuffer = NULL;
     PFNGLUSEPROGRAMPROC func_glUseProgram = NULL;
+    PFNGLVERTEXATTRIBDIVISORPROC func_glVertexAttribDivisor = NULL;
     PFNGLVERTEXATTRIBPOINTERPROC func_glVertexAttribPointer = NULL;
     
   public:
@@ -60,6 +60,16 @@ class RMG_API Line3DShader: public Shader {
      */
     void load() override;
     
+    /**
+     * @brief Binds the cylinder mesh the lines are drawn with
+     */
+    void bindMesh() const;
+    
+    /**
+     * @brief Draws the bound cylinder mesh with the program in use
+     */
+    void drawMesh() const;
+    
     /**
      * @brief Renders the given list of lines in 3D space
      * 
@@ -0,0 +1,122 @@
+/**
+ * @file mapped_file.hpp
+ * @brief Read-only view of a file mapped into the memory
+ * 
+ * Lets the parsers read large files without copying them through stdio
+ * buffers.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#pragma once
+#ifndef __RMG_MAPPED_FILE_H__
+#define __RMG_MAPPED_FILE_H__
+
+#ifndef RMG_API
+#ifdef _WIN32
+#ifdef RMG_EXPORT
+#define RMG_API __declspec(dllexport)
+#else
+#define RMG_API __declspec(dllimport)
+#endif
+#else
+#define RMG_API
+#endif
+#endif
+
+
+#include <cstddef>
+
+
+namespace rmg {
+namespace internal {
+
+/**
+ * @brief Read-only view of a file mapped into the memory
+ * 
+ * Lets the parsers read large files without copying them through stdio
+ * buffers. The mapping is released when the instance is destroyed.
+ */
+class RMG_API MappedFile {
+  private:
+    const char* data;
+    size_t size;
+    #ifdef _WIN32
+    void* fileHandle;
+    void* mapHandle;
+    #endif
+    
+  public:
+    /**
+     * @brief Default constructor
+     */
+    MappedFile();
+    
+    /**
+     * @brief Constructor maps a file
+     * 
+     * @param file Path to the file
+     */
+    MappedFile(const char* file);
+    
+    /**
+     * @brief Destructor unmaps the file
+     */
+    ~MappedFile();
+    
+    /**
+     * @brief Copy constructor (deleted)
+     * 
+     * @param f Source
+     */
+    MappedFile(const MappedFile& f) = delete;
+    
+    /**
+     * @brief Copy assignment (deleted)
+     * 
+     * @param f Source
+     */
+    MappedFile& operator=(const MappedFile& f) = delete;
+    
+    /**
+     * @brief Maps a file replacing the current one
+     * 
+     * @param file Path to the file
+     * 
+     * @return True if the file is mapped successfully
+     */
+    bool open(const char* file);
+    
+    /**
+     * @brief Unmaps the file
+     */
+    void close();
+    
+    /**
+     * @brief Checks if a file is mapped
+     * 
+     * @return True if the file is mapped. Empty files are never mapped.
+     */
+    bool isOpen() const;
+    
+    /**
+     * @brief Gets the content of the file
+     * 
+     * @return Pointer to the first byte of the file
+     */
+    const char* getData() const;
+    
+    /**
+     * @brief Gets the size of the file
+     * 
+     * @return Number of bytes in the file
+     */
+    size_t getSize() const;
+};
+
+}}
+
+#endif
@@ -0,0 +1,147 @@
+/**
+ * @file mesh_bvh.hpp
+ * @brief Bounding volume hierarchy over the triangles of a mesh
+ * 
+ * Keeps the positions and indices of a mesh uploaded to the GPU so that
+ * the rays of mouse picking can be tested against the triangles. The tree
+ * is only built by the first ray query.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#pragma once
+#ifndef __RMG_MESH_BVH_H__
+#define __RMG_MESH_BVH_H__
+
+#ifndef RMG_API
+#ifdef _WIN32
+#ifdef RMG_EXPORT
+#define RMG_API __declspec(dllexport)
+#else
+#define RMG_API __declspec(dllimport)
+#endif
+#else
+#define RMG_API
+#endif
+#endif
+
+
+#include <cstdint>
+#include <vector>
+
+#include "../math/bounding_box.hpp"
+#include "../math/line_equation.hpp"
+#include "../math/vec3.hpp"
+#include "../mesh.hpp"
+
+
+namespace rmg {
+namespace internal {
+
+/**
+ * @brief Bounding volume hierarchy over the triangles of a mesh
+ * 
+ * The triangles are split top-down with the surface area heuristic over
+ * the centers of their boxes. The leaves hold a few triangles each which
+ * are stored in the order of the leaves. The upper levels of the build
+ * run on several threads.
+ */
+class RMG_API MeshBVH {
+  private:
+    struct Node {
+        BoundingBox box;
+        uint32_t first; // First triangle of a leaf or the second child
+        uint32_t count; // Number of triangles or zero for inner nodes
+    };
+    
+    struct Primitive {
+        BoundingBox box;
+        Vec3 center;
+        uint32_t triangle;
+    };
+    
+    Mesh source;
+    std::vector<Vec3> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<Node> nodes;
+    std::vector<Primitive> primitives;
+    
+    void assign(const Vec3* vert, uint32_t vcount, const uint32_t* idx,
+                uint32_t icount);
+    void measure(uint32_t first, uint32_t count, BoundingBox &box,
+                 BoundingBox &centerBox) const;
+    void build(std::vector<Node> &out, uint32_t first, uint32_t count,
+               const BoundingBox &box, const BoundingBox &centerBox,
+               int depth);
+    
+  public:
+    /**
+     * @brief Default constructor
+     */
+    MeshBVH() = default;
+    
+    /**
+     * @brief Constructor copying the triangles of a mesh
+     * 
+     * @param vert Vertex positions
+     * @param vcount Number of vertices
+     * @param idx Vertex indices of the triangles. Null if the vertices
+     *            form the triangles in order.
+     * @param icount Number of indices
+     */
+    MeshBVH(const Vec3* vert, uint32_t vcount, const uint32_t* idx,
+            uint32_t icount);
+    
+    /**
+     * @brief Constructor taking over a mesh
+     * 
+     * The triangles are copied out of the mesh by the first ray query so
+     * that the meshes never picked cost no copy. Only the positions and
+     * indices are kept until then. The arrays of a mapped mesh stay in
+     * the mapping.
+     * 
+     * @param mesh Source mesh
+     */
+    MeshBVH(Mesh&& mesh);
+    
+    /**
+     * @brief Builds the tree if it is not built yet
+     */
+    void build();
+    
+    /**
+     * @brief Checks if the tree is built
+     * 
+     * @return True if the tree is built
+     */
+    bool isBuilt() const;
+    
+    /**
+     * @brief Gets the number of triangles
+     * 
+     * @return Number of triangles
+     */
+    uint32_t getTriangleCount() const;
+    
+    /**
+     * @brief Finds the nearest triangle a ray hits
+     * 
+     * Both sides of the triangles are hit. Builds the tree first if it is
+     * not built yet.
+     * 
+     * @param ray Ray in the space of the mesh
+     * @param maxDistance Limit of the distance along the ray in the units
+     *                    of its direction vector
+     * @param t Returns the distance of the hit
+     * 
+     * @return True if a triangle is hit within the limit
+     */
+    bool raycast(const LineEq &ray, float maxDistance, float *t);
+};
+
+}}
+
+#endif
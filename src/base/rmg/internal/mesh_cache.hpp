@@ -0,0 +1,154 @@
+/**
+ * @file mesh_cache.hpp
+ * @brief Shares the VBOs of identical meshes among the 3D objects
+ * 
+ * The meshes are addressed by a hash of their data or of the parameters
+ * generating them. The 3D objects looking up the same key share a single
+ * VBO instead of uploading the same vertices again.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#pragma once
+#ifndef __RMG_MESH_CACHE_H__
+#define __RMG_MESH_CACHE_H__
+
+#ifndef RMG_API
+#ifdef _WIN32
+#ifdef RMG_EXPORT
+#define RMG_API __declspec(dllexport)
+#else
+#define RMG_API __declspec(dllimport)
+#endif
+#else
+#define RMG_API
+#endif
+#endif
+
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+#include "context_load.hpp"
+
+
+namespace rmg {
+namespace internal {
+
+class VBO;
+
+
+/**
+ * @brief A VBO shared by the 3D objects, with its reference count
+ */
+struct SharedVBO {
+    VBO* vbo; ///< Vertex buffer object
+    uint32_t* shareCount; ///< Number of references including the cache's
+    Pending load; ///< Load of the VBO
+};
+
+
+/**
+ * @brief Shares the VBOs of identical meshes among the 3D objects
+ * 
+ * The cache holds a reference to each VBO so that a mesh stays loaded
+ * while no object uses it for a moment. The VBOs used only by the cache
+ * are released by collect().
+ */
+class RMG_API MeshCache {
+  private:
+    std::unordered_map<uint64_t, SharedVBO> entries;
+    
+    static void release(SharedVBO &entry);
+    
+  public:
+    /**
+     * @brief Default constructor
+     */
+    MeshCache() = default;
+    
+    /**
+     * @brief Destructor
+     */
+    ~MeshCache();
+    
+    /**
+     * @brief Copy constructor (deleted)
+     * 
+     * @param cache Source
+     */
+    MeshCache(const MeshCache& cache) = delete;
+    
+    /**
+     * @brief Move constructor
+     * 
+     * @param cache Source
+     */
+    MeshCache(MeshCache&& cache) noexcept;
+    
+    /**
+     * @brief Copy assignment (deleted)
+     * 
+     * @param cache Source
+     */
+    MeshCache& operator=(const MeshCache& cache) = delete;
+    
+    /**
+     * @brief Hashes a block of memory
+     * 
+     * A fast non-cryptographic 64-bit hash reading the data by words.
+     * 
+     * @param data Start of the data
+     * @param size Size in bytes
+     * @param seed Hash of the preceding data to chain the blocks
+     * 
+     * @return Hash value
+     */
+    static uint64_t hash(const void* data, size_t size, uint64_t seed=0);
+    
+    /**
+     * @brief Looks up a shared VBO
+     * 
+     * @param key Hash of the mesh or its parameters
+     * 
+     * @return The shared VBO or nullptr if the key is not in the cache
+     */
+    const SharedVBO *find(uint64_t key) const;
+    
+    /**
+     * @brief Adds a VBO to the cache
+     * 
+     * The cache takes a reference of the VBO.
+     * 
+     * @param key Hash of the mesh or its parameters
+     * @param vbo VBO, its reference count and its load
+     */
+    void insert(uint64_t key, const SharedVBO &vbo);
+    
+    /**
+     * @brief Releases the VBOs no 3D object uses
+     */
+    void collect();
+    
+    /**
+     * @brief Releases all the VBOs of the cache
+     * 
+     * The VBOs still used by 3D objects are deleted by the last of them.
+     */
+    void clear();
+    
+    /**
+     * @brief Gets the number of meshes in the cache
+     * 
+     * @return Number of shared VBOs
+     */
+    size_t getSize() const;
+};
+
+}}
+
+#endif
@@ -0,0 +1,57 @@
+/**
+ * @file parallel_for.hpp
+ * @brief Splits a loop over ranges run by several threads
+ * 
+ * Used by the mesh builders whose loops over vertices and triangles are
+ * independent of each other.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#pragma once
+#ifndef __RMG_PARALLEL_FOR_H__
+#define __RMG_PARALLEL_FOR_H__
+
+#ifndef RMG_API
+#ifdef _WIN32
+#ifdef RMG_EXPORT
+#define RMG_API __declspec(dllexport)
+#else
+#define RMG_API __declspec(dllimport)
+#endif
+#else
+#define RMG_API
+#endif
+#endif
+
+
+#include <cstddef>
+#include <functional>
+
+
+namespace rmg {
+namespace internal {
+
+/**
+ * @brief Runs a loop over ranges on several threads
+ * 
+ * The ranges run on a pool of threads shared by all the loops. The calling
+ * thread takes ranges as well and waits for the ones taken by the pool,
+ * so nested loops and loops called from the pool never wait for a thread
+ * to be free. Loops too short to pay for the threads run in the calling
+ * thread only.
+ * 
+ * @param count Number of iterations
+ * @param grain Least number of iterations given to a thread
+ * @param func Function running the iterations from the first argument up
+ *             to the second argument
+ */
+RMG_API void parallelFor(size_t count, size_t grain,
+                         const std::function<void(size_t,size_t)> &func);
+
+}}
+
+#endif
@@ -62,6 +62,16 @@ class RMG_API ParticleShader: public Shader {
      */
     void load() override;
     
+    /**
+     * @brief Binds the quad the particles are drawn with
+     */
+    void bindQuad() const;
+    
+    /**
+     * @brief Draws the bound quad with the program in use
+     */
+    void drawQuad() const;
+    
     /**
      * @brief Renders the given list of particles
      * 
@@ -0,0 +1,171 @@
+/**
+ * @file picking_shader.hpp
+ * @brief Draws the IDs of the objects to find the ones under the mouse
+ * 
+ * The object IDs are drawn into an integer image instead of colors. The
+ * pixels of a requested rectangle on the screen are copied into pixel
+ * buffer objects and read a frame later so that the CPU never waits for
+ * the GPU.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#pragma once
+#ifndef __RMG_PICKING_SHADER_H__
+#define __RMG_PICKING_SHADER_H__
+
+#ifndef RMG_API
+#ifdef _WIN32
+#ifdef RMG_EXPORT
+#define RMG_API __declspec(dllexport)
+#else
+#define RMG_API __declspec(dllimport)
+#endif
+#else
+#define RMG_API
+#endif
+#endif
+
+
+#include <cstdint>
+#include <vector>
+
+#include "shader.hpp"
+#include "../object.hpp"
+#include "../math/mat4.hpp"
+
+
+#define RMG_PICKING_READBACK_COUNT 2 ///< Readbacks in flight at once
+
+
+namespace rmg {
+namespace internal {
+
+class Line3DShader;
+class ParticleShader;
+class SceneBVH;
+
+
+/**
+ * @brief Draws the IDs of the objects to find the ones under the mouse
+ * 
+ * Only the requested rectangle of the screen is drawn. Its projection is
+ * narrowed down to the rectangle so that the objects outside of it are
+ * culled by the bounding volume hierarchy. The 3D objects, lines and
+ * particles are drawn from the vertex buffers of their own shaders.
+ */
+class RMG_API PickingShader: public Shader {
+  private:
+    struct Readback {
+        uint32_t buffer = 0;
+        GLsync fence = NULL;
+        uint32_t pixelCount = 0;
+        uint32_t capacity = 0;
+    };
+    
+    uint32_t idMVP;
+    uint32_t idObjectID;
+    uint32_t idTextured;
+    uint32_t particleProgram = 0;
+    uint32_t idParticleTV;
+    uint32_t idParticleModel;
+    uint32_t idParticleProjection;
+    uint32_t idParticleObjectID;
+    uint32_t idParticleTextured;
+    uint32_t idParticleTexture;
+    
+    uint32_t framebuffer = 0;
+    uint32_t idBuffer = 0;
+    uint32_t depthBuffer = 0;
+    uint16_t bufferWidth = 0;
+    uint16_t bufferHeight = 0;
+    
+    Readback readbacks[RMG_PICKING_READBACK_COUNT];
+    uint32_t readCount = 0;
+    uint32_t writeCount = 0;
+    
+    bool requested = false;
+    uint16_t requestX;
+    uint16_t requestY;
+    uint16_t requestWidth;
+    uint16_t requestHeight;
+    std::vector<uint64_t> result;
+    bool resultReady = false;
+    
+    void resize(uint16_t w, uint16_t h);
+    void poll();
+    
+  public:
+    /**
+     * @brief Default constructor
+     */
+    PickingShader() = default;
+    
+    /**
+     * @brief Destructor
+     */
+    virtual ~PickingShader();
+    
+    /**
+     * @brief Compile, link and assign program parameters
+     */
+    void load() override;
+    
+    /**
+     * @brief Requests the IDs of the objects in a rectangle on the screen
+     * 
+     * The rectangle is drawn by the next render. A request not drawn yet
+     * is replaced by the newer one.
+     * 
+     * @param x X-coordinate of the top-left corner
+     * @param y Y-coordinate of the top-left corner
+     * @param w Width of the rectangle
+     * @param h Height of the rectangle
+     */
+    void request(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+    
+    /**
+     * @brief Checks if a request is waiting to be drawn
+     * 
+     * @return True if a request is not drawn yet
+     */
+    bool isRequested() const;
+    
+    /**
+     * @brief Gets the IDs read back for the last finished request
+     * 
+     * @param ids Returns the object IDs in ascending order
+     * 
+     * @return True if a new result is returned since the last call
+     */
+    bool getResult(std::vector<uint64_t> *ids);
+    
+    /**
+     * @brief Reads back the finished requests and draws the pending one
+     * 
+     * Nothing is drawn if there is no request or all the readbacks are
+     * still in flight. A request outside the screen gives an empty result.
+     * 
+     * @param V View matrix
+     * @param P Projection matrix
+     * @param width Width of the screen
+     * @param height Height of the screen
+     * @param bvh Bounding volume hierarchy of the 3D objects
+     * @param lines List of 3D lines
+     * @param particles List of particles
+     * @param lineShader Shader holding the mesh of the lines
+     * @param particleShader Shader holding the quad of the particles
+     */
+    void render(const Mat4 &V, const Mat4 &P, uint16_t width,
+                uint16_t height, const SceneBVH &bvh,
+                const ObjectList &lines, const ObjectList &particles,
+                const Line3DShader &lineShader,
+                const ParticleShader &particleShader);
+};
+
+}}
+
+#endif
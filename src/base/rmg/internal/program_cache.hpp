@@ -0,0 +1,119 @@
+/**
+ * @file program_cache.hpp
+ * @brief Keeps the linked shader programs on the disk between the runs
+ * 
+ * The drivers hand out the linked programs as binaries in their own
+ * formats. Loading them back skips compiling and linking the shaders,
+ * which is the most of the time spent before the first frame.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#pragma once
+#ifndef __RMG_PROGRAM_CACHE_H__
+#define __RMG_PROGRAM_CACHE_H__
+
+#ifndef RMG_API
+#ifdef _WIN32
+#ifdef RMG_EXPORT
+#define RMG_API __declspec(dllexport)
+#else
+#define RMG_API __declspec(dllimport)
+#endif
+#else
+#define RMG_API
+#endif
+#endif
+
+
+#include <cstdint>
+#include <string>
+
+
+namespace rmg {
+namespace internal {
+
+/**
+ * @brief Keeps the linked shader programs on the disk between the runs
+ * 
+ * A program is filed under a hash of the driver, the shader sources and
+ * the definitions, so that the binaries of an updated driver or shader
+ * are never mixed up with the old ones. A binary the driver rejects is
+ * deleted and the program is compiled from the sources again.
+ * 
+ * The files go to the cache directory of the user by default. They are
+ * written under temporary names first and then renamed so that the
+ * processes sharing the directory never read a partially written file.
+ */
+class RMG_API ProgramCache {
+  public:
+    /**
+     * @brief Sets the directory to keep the programs
+     * 
+     * The directory is shared by all the contexts. It is created when the
+     * first program is stored.
+     * 
+     * @param dir Path to the directory or an empty string to turn off the
+     *            cache
+     */
+    static void setDirectory(const std::string &dir);
+    
+    /**
+     * @brief Gets the directory to keep the programs
+     * 
+     * Defaults to rmg/shaders under the cache directory of the user.
+     * 
+     * @return Path to the directory or an empty string if the cache is
+     *         turned off
+     */
+    static const std::string& getDirectory();
+    
+    /**
+     * @brief Checks if the programs of the current context can be cached
+     * 
+     * @return True if the driver gives out program binaries and the cache
+     *         has a directory
+     */
+    static bool isSupported();
+    
+    /**
+     * @brief Gets the key of a program in the current context
+     * 
+     * @param vert Vertex shader source
+     * @param frag Fragment shader source
+     * @param defines Preprocessor definitions for both shaders or null
+     * 
+     * @return Hash of the driver, the sources and the definitions
+     */
+    static uint64_t getKey(const std::string &vert, const std::string &frag,
+                           const char* defines);
+    
+    /**
+     * @brief Loads a program from its binary
+     * 
+     * @param key Key of the program
+     * 
+     * @return Linked shader program or zero if it is not in the cache or
+     *         the driver has rejected it
+     */
+    static uint32_t load(uint64_t key);
+    
+    /**
+     * @brief Saves the binary of a linked program
+     * 
+     * The program must have been linked with the binary retrievable hint.
+     * 
+     * @param key Key of the program
+     * @param program Shader program ID
+     * 
+     * @return True if the file is written
+     */
+    static bool store(uint64_t key, uint32_t program);
+};
+
+}}
+
+#endif
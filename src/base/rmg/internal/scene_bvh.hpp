@@ -0,0 +1,266 @@
+/**
+ * @file scene_bvh.hpp
+ * @brief Bounding volume hierarchy over the 3D objects of a context
+ * 
+ * A dynamic tree of the world-space bounding boxes of the 3D objects. The
+ * render passes visit the objects in a view volume and the ray queries the
+ * objects along a ray without walking the whole object list.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#pragma once
+#ifndef __RMG_SCENE_BVH_H__
+#define __RMG_SCENE_BVH_H__
+
+#ifndef RMG_API
+#ifdef _WIN32
+#ifdef RMG_EXPORT
+#define RMG_API __declspec(dllexport)
+#else
+#define RMG_API __declspec(dllimport)
+#endif
+#else
+#define RMG_API
+#endif
+#endif
+
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "../math/bounding_box.hpp"
+#include "../math/frustum.hpp"
+#include "../math/line_equation.hpp"
+
+
+namespace rmg {
+
+class Object3D;
+
+
+/**
+ * @brief Trade-off between the build time and the query speed of the
+ *        bounding volume hierarchies
+ */
+enum class BVHQuality {
+    Fast, ///< Splits the objects at the median of the longest axis
+    Medium, ///< Surface area heuristic over 8 bins
+    High ///< Surface area heuristic over 32 bins
+};
+
+
+namespace internal {
+
+/**
+ * @brief Bounding volume hierarchy over the 3D objects of a context
+ * 
+ * The objects moved or reshaped since the last update are refitted in
+ * place, which only touches the boxes from their leaves up to the root.
+ * Objects added a few at a time are inserted where they grow the surface
+ * area the least. The whole tree is rebuilt top-down with the surface
+ * area heuristic when the refits have made it notably worse or many
+ * objects are added at once. The upper levels of a rebuild run on
+ * several threads.
+ * 
+ * The objects whose meshes are still loading have no bounds yet and are
+ * inserted by the first update after their bounds are known. The objects
+ * placed before their meshes are uploaded to the GPU change the revision
+ * once more when the upload is done as nothing of them has been drawn.
+ */
+class RMG_API SceneBVH {
+  private:
+    struct Node {
+        BoundingBox box;
+        uint32_t parent;
+        uint32_t children[2];
+        uint32_t proxy;
+    };
+    
+    struct Proxy {
+        Object3D* object;
+        BoundingBox box;
+        uint32_t node;
+        bool dirty;
+        bool uploading;
+    };
+    
+    std::vector<Node> nodes;
+    std::vector<uint32_t> freeNodes;
+    std::vector<Proxy> proxies;
+    std::vector<uint32_t> freeProxies;
+    std::vector<uint32_t> dirty;
+    std::vector<uint32_t> uploads;
+    uint32_t root;
+    uint32_t leafCount;
+    BVHQuality quality;
+    double areaSum;
+    float builtCost;
+    uint64_t revision;
+    
+    uint32_t allocateNode();
+    void insertLeaf(uint32_t proxy);
+    void removeLeaf(uint32_t proxy);
+    void refit(uint32_t node);
+    void build(uint32_t node, uint32_t parent, uint32_t *items,
+               uint32_t count, int depth);
+    uint32_t split(uint32_t *items, uint32_t count) const;
+    
+  public:
+    /**
+     * @brief Default constructor
+     */
+    SceneBVH();
+    
+    /**
+     * @brief Destructor
+     */
+    ~SceneBVH();
+    
+    /**
+     * @brief Copy constructor (deleted)
+     * 
+     * @param bvh Source
+     */
+    SceneBVH(const SceneBVH& bvh) = delete;
+    
+    /**
+     * @brief Move constructor
+     * 
+     * The objects of the source tree are moved to this tree.
+     * 
+     * @param bvh Source
+     */
+    SceneBVH(SceneBVH&& bvh) noexcept;
+    
+    /**
+     * @brief Copy assignment (deleted)
+     * 
+     * @param bvh Source
+     */
+    SceneBVH& operator=(const SceneBVH& bvh) = delete;
+    
+    /**
+     * @brief Adds a 3D object to the tree
+     * 
+     * The object is placed in the tree by the next update.
+     * 
+     * @param obj 3D object
+     */
+    void insert(Object3D* obj);
+    
+    /**
+     * @brief Removes a 3D object from the tree
+     * 
+     * @param obj 3D object
+     */
+    void remove(Object3D* obj);
+    
+    /**
+     * @brief Marks the bounds of an object to be refitted by the next
+     *        update
+     * 
+     * @param proxy Handle of the object in the tree
+     */
+    void markDirty(uint32_t proxy);
+    
+    /**
+     * @brief Refits the objects marked dirty
+     * 
+     * Rebuilds the tree if it has become notably worse than its last
+     * build.
+     */
+    void update();
+    
+    /**
+     * @brief Builds the tree again from the bounds of all the objects
+     */
+    void rebuild();
+    
+    /**
+     * @brief Removes all the objects from the tree
+     */
+    void clear();
+    
+    /**
+     * @brief Sets the quality of the rebuilds
+     * 
+     * @param q Build quality
+     */
+    void setQuality(BVHQuality q);
+    
+    /**
+     * @brief Gets the quality of the rebuilds
+     * 
+     * @return Build quality
+     */
+    BVHQuality getQuality() const;
+    
+    /**
+     * @brief Gets the number of objects placed in the tree
+     * 
+     * @return Number of leaves
+     */
+    uint32_t getObjectCount() const;
+    
+    /**
+     * @brief Gets the bounds of all the objects in the tree
+     * 
+     * @return Bounding box of the root or an empty box
+     */
+    BoundingBox getBounds() const;
+    
+    /**
+     * @brief Gets the number of changes made to the objects of the tree
+     * 
+     * Changes when an object is added, removed, moved, reshaped or hidden
+     * so that the results drawn from the tree can be kept while it stays
+     * the same.
+     * 
+     * @return Revision of the tree
+     */
+    uint64_t getRevision() const;
+    
+    /**
+     * @brief Gets the expected cost of a query
+     * 
+     * The sum of the surface areas of the inner nodes relative to the
+     * root, which is the number of nodes a random ray visits on average.
+     * 
+     * @return Surface area heuristic cost
+     */
+    float getCost() const;
+    
+    /**
+     * @brief Visits the objects whose bounds intersect a view volume
+     * 
+     * @param frustum View volume in world space
+     * @param func Function called for each object
+     */
+    void query(const Frustum &frustum,
+               const std::function<void(Object3D*)> &func) const;
+    
+    /**
+     * @brief Visits the objects whose bounds a ray passes through
+     * 
+     * The objects are visited from the nearest bounding box on. The
+     * function tests the object and returns the distance of the hit to
+     * stop looking further than that, or the given limit otherwise. The
+     * distances are in the units of the direction vector of the ray.
+     * 
+     * @param ray Ray starting from its initial point
+     * @param maxDistance Limit of the distance along the ray
+     * @param func Function called with the object and the distance to its
+     *             bounding box
+     */
+    void raycast(const LineEq &ray, float maxDistance,
+                 const std::function<float(Object3D*,float)> &func) const;
+};
+
+}}
+
+#endif
@@ -37,6 +37,17 @@ namespace rmg {
 
 namespace internal {
 
+/**
+ * @brief A shader program the driver may still be compiling and linking
+ */
+struct ShaderProgramBuild {
+    uint32_t program = 0; ///< Shader program ID
+    uint32_t vertexShader = 0; ///< Vertex shader or zero if it is cached
+    uint32_t fragmentShader = 0; ///< Fragment shader or zero if it is cached
+    uint64_t key = 0; ///< Key of the program in the program cache
+};
+
+
 /**
  * @brief The shader program taking main backend role in drawing
  * 
@@ -68,20 +79,65 @@ class RMG_API Shader {
      * 
      * @param type Shader type (GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, .etc)
      * @param path Path to shader file
+     * @param defines Preprocessor definitions inserted after the version
+     *                line or null
      * 
      * @return ID of the compiled shader used to retrive it
      */
-    static uint32_t compileShader(uint32_t type, const char* path);
+    static uint32_t compileShader(uint32_t type, const char* path,
+                                  const char* defines=nullptr);
     
     /**
      * @brief Compiles and links a shader program
      * 
      * @param vert Vertex shader file
      * @param frag Fragment shader file
+     * @param defines Preprocessor definitions for both shaders or null
      * 
      * @return Shader program ID
      */
-    static uint32_t compileShaderProgram(const char* vert, const char* frag);
+    static uint32_t compileShaderProgram(const char* vert, const char* frag,
+                                         const char* defines=nullptr);
+    
+    /**
+     * @brief Starts compiling and linking a shader program
+     * 
+     * Loads the program from the program cache if it is there. Otherwise
+     * the shaders are handed to the driver without waiting for them, so
+     * the driver can work on several programs at once if it compiles in
+     * parallel.
+     * 
+     * @param vert Vertex shader file
+     * @param frag Fragment shader file
+     * @param defines Preprocessor definitions for both shaders or null
+     * 
+     * @return Program to be finished by finishShaderProgram()
+     */
+    static ShaderProgramBuild beginShaderProgram(const char* vert,
+                                                 const char* frag,
+                                                 const char* defines=nullptr);
+    
+    /**
+     * @brief Waits for a shader program to be linked
+     * 
+     * Prints the errors of the shaders and stores the linked program in
+     * the program cache.
+     * 
+     * @param build Program started by beginShaderProgram()
+     * 
+     * @return Shader program ID or zero if it has failed
+     */
+    static uint32_t finishShaderProgram(const ShaderProgramBuild &build);
+    
+    /**
+     * @brief Lets the driver compile the shaders on its own threads
+     * 
+     * Only has effect if the current context has the extension
+     * KHR_parallel_shader_compile.
+     * 
+     * @return True if the extension is available
+     */
+    static bool enableParallelCompile();
 };
 
 }}
@@ -0,0 +1,167 @@
+/**
+ * @file shader_permutations.hpp
+ * @brief Programs compiled from the same shader files for each combination
+ *        of features
+ * 
+ * The features of a shader are turned on by preprocessor definitions
+ * instead of branches at runtime. A program is only compiled the first
+ * time its combination is asked for and then kept by the bit mask of its
+ * features.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#pragma once
+#ifndef __RMG_SHADER_PERMUTATIONS_H__
+#define __RMG_SHADER_PERMUTATIONS_H__
+
+#ifndef RMG_API
+#ifdef _WIN32
+#ifdef RMG_EXPORT
+#define RMG_API __declspec(dllexport)
+#else
+#define RMG_API __declspec(dllimport)
+#endif
+#else
+#define RMG_API
+#endif
+#endif
+
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "shader.hpp"
+
+
+namespace rmg {
+namespace internal {
+
+/**
+ * @brief A program compiled for a combination of features
+ */
+struct ShaderPermutation {
+    uint32_t program = 0; ///< Shader program ID or zero if it has failed
+    std::vector<int32_t> uniforms; ///< Locations in the order of the names
+};
+
+
+/**
+ * @brief Programs compiled from the same shader files for each
+ *        combination of features
+ * 
+ * Bit i of a key defines the name of feature i in both shaders. The
+ * common definitions are shared by all the programs and changing them
+ * drops the compiled ones. A program failing to compile is kept as zero
+ * so that it is not compiled again every frame.
+ * 
+ * The programs known to be needed can be started ahead so that the
+ * driver compiles them while the rest of the work goes on.
+ */
+class RMG_API ShaderPermutations {
+  private:
+    std::string vertPath;
+    std::string fragPath;
+    std::vector<std::string> features;
+    std::vector<std::string> uniformNames;
+    std::string definitions;
+    std::unordered_map<uint32_t, ShaderPermutation> programs;
+    std::unordered_map<uint32_t, ShaderProgramBuild> pending;
+    
+    std::string getDefinitions(uint32_t key) const;
+    
+  public:
+    /**
+     * @brief Default constructor
+     */
+    ShaderPermutations() = default;
+    
+    /**
+     * @brief Constructor with the shader files and the feature names
+     * 
+     * @param vert Vertex shader file
+     * @param frag Fragment shader file
+     * @param feat Names defined by the bits of the keys
+     * @param uniforms Names of the uniforms located in every program
+     */
+    ShaderPermutations(const char* vert, const char* frag,
+                       const std::vector<const char*> &feat,
+                       const std::vector<const char*> &uniforms);
+    
+    /**
+     * @brief Destructor
+     */
+    ~ShaderPermutations();
+    
+    /**
+     * @brief Copy constructor
+     * 
+     * The copy starts without compiled programs as they are owned by a
+     * single set.
+     * 
+     * @param p Source
+     */
+    ShaderPermutations(const ShaderPermutations& p);
+    
+    /**
+     * @brief Copy assignment
+     * 
+     * Deletes the programs of this set. The copy starts without compiled
+     * programs as they are owned by a single set.
+     * 
+     * @param p Source
+     * 
+     * @return This set
+     */
+    ShaderPermutations& operator=(const ShaderPermutations& p);
+    
+    /**
+     * @brief Sets the definitions shared by all the programs
+     * 
+     * Deletes the compiled programs if the definitions are different.
+     * 
+     * @param defs Preprocessor definitions each ending with a new line
+     */
+    void setDefinitions(const std::string &defs);
+    
+    /**
+     * @brief Starts compiling the program of a combination of features
+     * 
+     * The program is finished by the first get() of the key.
+     * 
+     * @param key Bit mask of the features
+     */
+    void prepare(uint32_t key);
+    
+    /**
+     * @brief Gets the program of a combination of features
+     * 
+     * Compiles the program if it is asked for the first time.
+     * 
+     * @param key Bit mask of the features
+     * 
+     * @return Program and its uniform locations
+     */
+    const ShaderPermutation& get(uint32_t key);
+    
+    /**
+     * @brief Gets the number of programs compiled so far
+     * 
+     * @return Number of programs including the failed ones
+     */
+    size_t getProgramCount() const;
+    
+    /**
+     * @brief Deletes all the compiled programs
+     */
+    void clear();
+};
+
+}}
+
+#endif
@@ -2,6 +2,11 @@
  * @file shadow_map_shader.hpp
  * @brief Generates an image representing the distance from sun at every pixel
  * 
+ * The view of the camera is split into slices by distance and each slice
+ * gets its own layer of the shadow map. The near slices are small so their
+ * shadows are sharp while the far ones cover much more ground with the
+ * same number of texels.
+ * 
  * @copyright Copyright (c) 2020 Khant Kyaw Khaung
  * 
  * @license{This project is released under the MIT License.}
@@ -28,30 +33,48 @@
 #include "shader.hpp"
 #include "../camera.hpp"
 #include "../object.hpp"
+#include "../math/bounding_box.hpp"
 #include "../math/vec.hpp"
 
+
+#define RMG_SHADOW_CASCADE_MAX 4 ///< Most slices of the camera view
+
+
 namespace rmg {
 
 namespace internal {
 
+class SceneBVH;
+
+
 /**
  * @brief Generates an image representing the distance from sun at every pixel
+ * 
+ * The slices of the camera view are fitted with bounding spheres so that
+ * the size of their shadow maps stays the same as the camera turns. Their
+ * centers are snapped to the texels to keep the shadow edges still.
  */
 class RMG_API ShadowMapShader: public Shader {
   private:
-    Camera shadowMapper;
-    Vec3 cameraPosition;
-    Vec3 cameraDirection;
     Vec3 lightDirection;
-    float nearDist;
-    float farDist;
-    float mapCenterDist;
+    uint16_t resolution;
+    uint32_t cascadeCount;
+    Mat4 shadowMatrices[RMG_SHADOW_CASCADE_MAX];
+    Vec3 sliceCenters[RMG_SHADOW_CASCADE_MAX];
+    float sliceRadii[RMG_SHADOW_CASCADE_MAX];
+    uint64_t sceneRevision = 0;
+    bool outdated = true;
     
     uint32_t depthMapFBO = 0;
     uint32_t depthMap = 0;
+    uint16_t mapResolution = 0;
+    uint32_t mapCascadeCount = 0;
     uint32_t idMVP;
     
-    void calculateShadowMapperTranslation();
+    void allocate();
+    void fitSlices(const Camera &camera, Vec3 *centers,
+                   float *radii) const;
+    void fitCascades(const BoundingBox &scene);
     
   public:
     /**
@@ -65,99 +88,54 @@ class RMG_API ShadowMapShader: public Shader {
     virtual ~ShadowMapShader();
     
     /**
-     * @brief Sets the camera position
-     * 
-     * Camera here means the world's camera. This function is used so that
-     * the light's viewing point moves together with it.
-     * 
-     * @param x X-coordinate
-     * @param y Y-coordinate
-     * @param z Z-coordinate
-     */
-    void setCameraTranslation(float x, float y, float z);
-    
-    /**
-     * @brief Sets the camera position
-     * 
-     * Camera here means the world's camera. This function is used so that
-     * the light's viewing point moves together with it.
-     * 
-     * @param p Position vector
-     */
-    void setCameraTranslation(Vec3 p);
-
-    /**
-     * @brief Sets rotation of the camera
-     * 
-     * Sets the view matrix. Rotation of the camera is in Euler angles.
-     * Rotation order is ZYX (Yaw-Pitch-Roll).
+     * @brief Sets the directional light vector
      * 
-     * @param x Roll
-     * @param y Pitch
-     * @param z Yaw
+     * @param v Light direction
      */
-    inline void setCameraRotation(float x, float y, float z) {
-        setCameraRotation(Euler(x, y, z));
-    }
+    void setDirectionalLightVector(Vec3 v);
     
     /**
-     * @brief Sets the camera rotation
+     * @brief Sets the width and height of each layer of the shadow map
      * 
-     * Camera here means the world's camera. This function is used so that
-     * the light's viewing direction moves together with it.
-     * 
-     * @param x Roll
-     * @param y Pitch
-     * @param z Yaw
-     * @param unit The previous params are degree or radian
+     * @param size Resolution in texels
      */
-    inline void setCameraRotation(float x, float y, float z, AngleUnit unit) {
-        setCameraRotation(Euler(x, y, z, unit));
-    }
+    void setResolution(uint16_t size);
     
     /**
-     * @brief Sets the camera rotation
-     * 
-     * Camera here means the world's camera. This function is used so that
-     * the light's viewing direction moves together with it.
+     * @brief Gets the width and height of each layer of the shadow map
      * 
-     * @param rot Euler angles
+     * @return Resolution in texels
      */
-    void setCameraRotation(Euler rot);
+    uint16_t getResolution() const;
     
     /**
-     * @brief Sets minimum distance of the camera
+     * @brief Sets the number of slices the camera view is split into
      * 
-     * @param n Minimum clipping distance
+     * @param n Number of cascades from 1 to RMG_SHADOW_CASCADE_MAX
      */
-    void setMinimumDistance(float n);
+    void setCascadeCount(uint32_t n);
     
     /**
-     * @brief Sets maximum distance of the camera
+     * @brief Gets the number of slices the camera view is split into
      * 
-     * @param f Maximum clipping distance
+     * @return Number of cascades
      */
-    void setMaximumDistance(float f);
+    uint32_t getCascadeCount() const;
     
     /**
-     * @brief Sets the directional light vector
-     * 
-     * Contributes the view matrix of the shadow mapper. The shadow mapper
-     * is a camera that views the world from the light's position.
-     * 
-     * @param v Light direction
+     * @brief Makes the next call draw the shadow map again
      */
-    void setDirectionalLightVector(Vec3 v);
+    void invalidate();
     
     /**
-     * @brief Gets the matrix to process shadow mapping
+     * @brief Gets the matrices to process shadow mapping
      * 
-     * It is the composition of view and projection matrix from the position
-     * of the light as a camera. Similar to the VP matrix of a normal camera.
+     * They are the compositions of view and projection matrix from the
+     * light for each cascade. Similar to the VP matrix of a normal camera.
      * 
-     * @param v Light direction
+     * @return Shadow matrices from the nearest cascade
      */
-    const Mat4& getShadowMatrix() const;
+    const Mat4* getShadowMatrices() const;
     
     /**
      * @brief Compile, link and assign program parameters
@@ -167,14 +145,20 @@ class RMG_API ShadowMapShader: public Shader {
     /**
      * @brief Generates the shadow map of the group of 3D objects
      * 
-     * Renders depth image of the group of 3D objects which is then
-     * used as the shadow map passing it to the general shader.
+     * Renders depth image of the group of 3D objects for each slice of the
+     * camera view which is then used as the shadow map passing it to the
+     * general shader.
+     * 
+     * The previous shadow map is kept unless the light, the settings or
+     * the objects of the tree have changed, or a slice of the camera view
+     * has moved more than a small part of its size.
      * 
-     * @param list List of 3D objects
+     * @param camera Camera of the context
+     * @param bvh Bounding volume hierarchy of the 3D objects
      * 
-     * @return Shadow map
+     * @return Shadow map as a texture array with a layer for each cascade
      */
-    uint32_t createShadowMap(const ObjectList &list);
+    uint32_t createShadowMap(const Camera &camera, const SceneBVH &bvh);
 };
 
 }}
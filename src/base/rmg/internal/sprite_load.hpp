@@ -25,6 +25,8 @@
 #endif
 
 
+#include <string>
+
 #include "../bitmap.hpp"
 #include "../color.hpp"
 #include "../math/vec2.hpp"
@@ -55,11 +57,14 @@ class RMG_API SpriteLoad: public ContextLoad {
     Bitmap bitmap;
     uint16_t width;
     uint16_t height;
+    std::string file;
     
   public:
     /**
      * @brief Constructs a pending object
      * 
+     * The file is decoded later by prepare().
+     * 
      * @param tex Address to a Texture instance. This is to redirect 
      *            responses after loading.
      * @param f Path to texture file
@@ -80,6 +85,13 @@ class RMG_API SpriteLoad: public ContextLoad {
      */
     ~SpriteLoad();
     
+    /**
+     * @brief Decodes the image file
+     * 
+     * Runs on a worker thread of the context loader.
+     */
+    void prepare() override;
+    
     /**
      * @brief Loads the texture data to the GPU
      * 
@@ -89,9 +101,18 @@ class RMG_API SpriteLoad: public ContextLoad {
      */
     void load() override;
     
+    /**
+     * @brief Gets the number of bytes the load sends to the GPU
+     * 
+     * @return Upload size in bytes
+     */
+    uint64_t getUploadSize() const override;
+    
     /**
      * @brief Gets the width of the image
      * 
+     * Zero until the image file is decoded.
+     * 
      * @return Image width in pixels
      */
     uint16_t getWidth() const;
@@ -99,6 +120,8 @@ class RMG_API SpriteLoad: public ContextLoad {
     /**
      * @brief Gets the height of the image
      * 
+     * Zero until the image file is decoded.
+     * 
      * @return Image height in pixels
      */
     uint16_t getHeight() const;
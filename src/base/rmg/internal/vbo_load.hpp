@@ -25,8 +25,13 @@
 #endif
 
 
+#include <string>
+#include <vector>
+
 #include "../mesh.hpp"
 #include "context_load.hpp"
+#include "geometry_arena.hpp"
+#include "mesh_bvh.hpp"
 
 
 namespace rmg {
@@ -45,6 +50,15 @@ enum class VBOMode {
 };
 
 
+/**
+ * @brief A mesh of a level of detail with its geometric error
+ */
+struct LevelOfDetail {
+    Mesh mesh; ///< Mesh of the level
+    float error; ///< Deviation from the exact surface in model space
+};
+
+
 /**
  * @brief Maintains the array of VBOs before context startup
  * 
@@ -61,8 +75,29 @@ enum class VBOMode {
 class RMG_API VBOLoad: public ContextLoad, public Mesh {
   private:
     VBO* vbo;
+    GeometryPool* geometry;
+    std::string file;
+    bool smooth;
+    bool compressed;
+    bool encoded;
+    std::vector<Mesh> levels;
+    std::vector<float> errors;
+    
+    struct Streams {
+        std::vector<uint16_t> positions;
+        std::vector<uint8_t> attributes;
+        std::vector<uint16_t> indices;
+    };
+    std::vector<Streams> streams;
+    Encoding encoding;
     
-    void setAttributePointers();
+    void buildLevels();
+    bool loadCache(const std::string &path, const SourceStamp* source);
+    bool acceptEncoding(Encoding &enc) const;
+    const Mesh &getLevel(size_t i) const;
+    void encode();
+    void encodePositions(const Mesh &mesh, Streams &out);
+    void encodeAttributes(const Mesh &mesh, Streams &out);
     
   public:
     /**
@@ -70,9 +105,56 @@ class RMG_API VBOLoad: public ContextLoad, public Mesh {
      * 
      * @param vbo Address to a VBO instance. This is to redirect 
      *            responses after loading.
+     * @param geometry Geometry arenas of the context
      * @param mesh Mesh
+     * @param compress Stores the vertices in the compressed format
+     */
+    VBOLoad(VBO* vbo, GeometryPool* geometry, const Mesh& mesh,
+            bool compress=true);
+    
+    /**
+     * @brief Constructs a pending object from the levels of detail of a
+     *        mesh
+     * 
+     * @param vbo Address to a VBO instance. This is to redirect 
+     *            responses after loading.
+     * @param geometry Geometry arenas of the context
+     * @param lods Levels of detail from the most detailed one
+     * @param compress Stores the vertices in the compressed format
      */
-    VBOLoad(VBO* vbo, const Mesh& mesh);
+    VBOLoad(VBO* vbo, GeometryPool* geometry,
+            const std::vector<LevelOfDetail>& lods, bool compress=true);
+    
+    /**
+     * @brief Constructs a pending object from a 3D model file
+     * 
+     * The file is parsed later by prepare().
+     * 
+     * @param vbo Address to a VBO instance. This is to redirect 
+     *            responses after loading.
+     * @param geometry Geometry arenas of the context
+     * @param f 3D model file (.obj, .rmgmesh)
+     * @param smooth Generate smooth surface normals if the 3D model does
+     *               not contain preprocessed vertex normals
+     * @param compress Stores the vertices in the compressed format
+     */
+    VBOLoad(VBO* vbo, GeometryPool* geometry, const char* f,
+            bool smooth=true, bool compress=true);
+    
+    /**
+     * @brief Parses the 3D model file and builds the mesh
+     * 
+     * Runs on a worker thread of the context loader. The built mesh is
+     * cached in a binary mesh file next to the 3D model file together with
+     * its levels of detail and their streams encoded for the GPU. Later
+     * loads map the cache instead of parsing the model as long as the
+     * size and the modification time of the model match the ones the
+     * cache was built from. Detailed models get coarser levels of
+     * detail simplified from the mesh when they are not in the file. The
+     * vertices are encoded for the GPU unless the file has them encoded
+     * in the same format.
+     */
+    void prepare() override;
     
     /**
      * @brief Loads the array of VBOs to the GPU
@@ -81,8 +163,26 @@ class RMG_API VBOLoad: public ContextLoad, public Mesh {
      * which are created by model constructors (Cube3D, Model3D, .etc) into
      * GPU. Also this pending object's load function assigns the resource
      * addresses to the related VBO object.
+     * 
+     * The positions go into a buffer of their own so that the depth-only
+     * passes fetch nothing else. The normals and texture coordinates are
+     * interleaved in a second buffer. In the compressed format, positions
+     * are 16-bit integers quantized over the bounding box, normals are
+     * octahedral encoded into two 16-bit integers and texture coordinates
+     * are 16-bit normalized integers, or half floats if they are outside
+     * the range from 0 to 1. Meshes of less than 65536 vertices use 16-bit
+     * indices in either format. The levels of detail share the vertex
+     * format and the quantization of the most detailed mesh. The streams
+     * of a mapped binary mesh file are sent to the GPU without copying.
      */
     void load() override;
+    
+    /**
+     * @brief Gets the number of bytes the load sends to the GPU
+     * 
+     * @return Upload size in bytes
+     */
+    uint64_t getUploadSize() const override;
 };
 
 
@@ -95,13 +195,15 @@ class RMG_API VBOLoad: public ContextLoad, public Mesh {
  */
 class RMG_API VBO {
   private:
-    uint32_t vertexArrayID = 0;
-    uint32_t vertexbuffer = 0;
-    uint32_t normalbuffer = 0;
-    uint32_t texturebuffer = 0;
-    uint32_t elementbuffer = 0;
-    uint32_t indexCount = 0;
+    GeometryArena* arena = nullptr;
+    std::vector<uint32_t> slots;
+    std::vector<float> errors;
     VBOMode mode = VBOMode::None;
+    bool compressed = false;
+    Vec3 positionOffset = Vec3(0, 0, 0);
+    Vec3 positionScale = Vec3(1, 1, 1);
+    BoundingBox bounds;
+    MeshBVH* triangles = nullptr;
     
     friend class VBOLoad;
     
@@ -131,7 +233,7 @@ class RMG_API VBO {
      * 
      * @param vbo Source
      */
-    VBO(VBO&& vbo) noexcept = default;
+    VBO(VBO&& vbo) noexcept;
     
     /**
      * @brief Copy assignment (deleted)
@@ -148,17 +250,152 @@ class RMG_API VBO {
      * 
      * @param vbo Source
      */
-    VBO& operator=(VBO&& vbo) noexcept = default;
+    VBO& operator=(VBO&& vbo) noexcept;
     
     /**
      * @brief Gets the mode of VBO rendering
      */
     VBOMode getMode() const;
     
+    /**
+     * @brief Gets the axis-aligned box enclosing the vertices
+     * 
+     * Available as soon as the VBO is constructed from a mesh, before the
+     * context loads it.
+     * 
+     * @return Bounding box in model space
+     */
+    const BoundingBox &getBoundingBox() const;
+    
+    /**
+     * @brief Gets the geometry arena storing the vertices
+     * 
+     * @return Geometry arena or null if the VBO is not loaded
+     */
+    GeometryArena *getArena() const;
+    
+    /**
+     * @brief Gets the location of the vertices in the geometry arena
+     * 
+     * The VBO must be loaded.
+     * 
+     * @param level Level of detail
+     * 
+     * @return Vertex and index ranges
+     */
+    const GeometryRange &getRange(uint32_t level=0) const;
+    
+    /**
+     * @brief Gets the number of levels of detail
+     * 
+     * @return Number of levels or zero if the VBO is not loaded
+     */
+    uint32_t getLevelCount() const;
+    
+    /**
+     * @brief Gets the geometric error of a level of detail
+     * 
+     * @param level Level of detail
+     * 
+     * @return Deviation from the exact surface in model space
+     */
+    float getLevelError(uint32_t level) const;
+    
+    /**
+     * @brief Picks the coarsest level of detail within an error
+     * 
+     * A coarser level than the current one is only taken if its error
+     * is clearly below the limit, so that objects near the boundary do
+     * not flicker between two levels.
+     * 
+     * @param maxError Largest error allowed in model space
+     * @param current Level drawn in the previous frame
+     * 
+     * @return Level of detail
+     */
+    uint32_t selectLevel(float maxError, uint32_t current) const;
+    
+    /**
+     * @brief Checks if the vertices are stored in the compressed format
+     * 
+     * Normals of the compressed format are octahedral encoded and have to
+     * be decoded by the shader.
+     * 
+     * @return True if the vertices are compressed
+     */
+    bool isCompressed() const;
+    
+    /**
+     * @brief Gets the offset of the quantized positions
+     * 
+     * The shader gets the model space position by the offset plus the
+     * scale times the value of the position attribute.
+     * 
+     * @return Position of the quantized value zero in model space
+     */
+    const Vec3 &getPositionOffset() const;
+    
+    /**
+     * @brief Gets the scale of the quantized positions
+     * 
+     * @return Model space size of the quantized value range
+     */
+    const Vec3 &getPositionScale() const;
+    
+    /**
+     * @brief Gets the matrix converting the quantized positions into model
+     *        space
+     * 
+     * @return Translation and scale matrix
+     */
+    Mat4 getPositionMatrix() const;
+    
+    /**
+     * @brief Gets the triangles of the most detailed level for the ray
+     *        queries
+     * 
+     * The bounding volume hierarchy of the triangles is built by its first
+     * ray query.
+     * 
+     * @return Triangle BVH or null if the VBO is not loaded
+     */
+    MeshBVH *getMeshBVH() const;
+    
     /**
      * @brief Draws the VBO using a shader program
+     * 
+     * @param level Level of detail
+     */
+    void draw(uint32_t level=0) const;
+    
+    /**
+     * @brief Draws the VBO binding the position stream only
+     * 
+     * Used by the depth-only passes whose shaders read the positions
+     * only.
+     * 
+     * @param level Level of detail
+     */
+    void drawPositions(uint32_t level=0) const;
+    
+    /**
+     * @brief Binds the vertex array of the VBO
+     * 
+     * The vertex array is shared by the VBOs of the same geometry arena.
+     * Per-instance attributes are set up on the vertex array after this
+     * call and before drawInstanced().
+     */
+    void bind() const;
+    
+    /**
+     * @brief Draws multiple instances of the VBO in a single draw call
+     * 
+     * The VBO must be bound first.
+     * 
+     * @param count Number of instances
+     * @param level Level of detail
      */
-    void draw() const;
+    void drawInstanced(uint32_t count, uint32_t level=0) const;
 };
 
 }}
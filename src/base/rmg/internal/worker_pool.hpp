@@ -0,0 +1,106 @@
+/**
+ * @file worker_pool.hpp
+ * @brief Group of background threads running queued jobs
+ * 
+ * Keeps the slow CPU work like file decoding away from the rendering
+ * thread.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#pragma once
+#ifndef __RMG_WORKER_POOL_H__
+#define __RMG_WORKER_POOL_H__
+
+#ifndef RMG_API
+#ifdef _WIN32
+#ifdef RMG_EXPORT
+#define RMG_API __declspec(dllexport)
+#else
+#define RMG_API __declspec(dllimport)
+#endif
+#else
+#define RMG_API
+#endif
+#endif
+
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+
+namespace rmg {
+namespace internal {
+
+/**
+ * @brief Group of background threads running queued jobs
+ * 
+ * The threads are started on the first job so that a pool which is never
+ * used costs nothing. Jobs still in the queue at destruction are dropped
+ * after the running ones finish.
+ */
+class RMG_API WorkerPool {
+  private:
+    std::vector<std::thread> threads;
+    std::queue<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable condition;
+    uint32_t threadCount;
+    bool stopping;
+    
+    void run();
+    
+  public:
+    /**
+     * @brief Constructor
+     * 
+     * @param n Number of threads. Zero picks one less than the number of
+     *          hardware threads so that the rendering thread has a core.
+     */
+    WorkerPool(uint32_t n=0);
+    
+    /**
+     * @brief Destructor waits for the running jobs and stops the threads
+     */
+    ~WorkerPool();
+    
+    /**
+     * @brief Copy constructor (deleted)
+     * 
+     * @param pool Source
+     */
+    WorkerPool(const WorkerPool& pool) = delete;
+    
+    /**
+     * @brief Copy assignment (deleted)
+     * 
+     * @param pool Source
+     */
+    WorkerPool& operator=(const WorkerPool& pool) = delete;
+    
+    /**
+     * @brief Queues a job to be run by one of the threads
+     * 
+     * @param job Function to run
+     */
+    void push(std::function<void()> job);
+    
+    /**
+     * @brief Gets the number of threads of the pool
+     * 
+     * @return Thread count
+     */
+    uint32_t getThreadCount() const;
+};
+
+}}
+
+#endif
@@ -0,0 +1,107 @@
+/**
+ * @file bounding_box.hpp
+ * @brief Axis-aligned box enclosing a set of points in 3D space
+ * 
+ * Used as the bounding volume of meshes for visibility tests.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#pragma once
+#ifndef __RMG_BOUNDING_BOX_H__
+#define __RMG_BOUNDING_BOX_H__
+
+#ifndef RMG_API
+#ifdef _WIN32
+#ifdef RMG_EXPORT
+#define RMG_API __declspec(dllexport)
+#else
+#define RMG_API __declspec(dllimport)
+#endif
+#else
+#define RMG_API
+#endif
+#endif
+
+
+#include "mat4.hpp"
+#include "vec3.hpp"
+
+
+namespace rmg {
+
+/**
+ * @brief Axis-aligned box enclosing a set of points in 3D space
+ * 
+ * Used as the bounding volume of meshes for visibility tests.
+ */
+struct RMG_API BoundingBox {
+    Vec3 min; ///< Corner with the smallest coordinates
+    Vec3 max; ///< Corner with the largest coordinates
+    
+    /**
+     * @brief Default constructor makes an empty box
+     */
+    BoundingBox();
+    
+    /**
+     * @brief Constructor
+     * 
+     * @param min Corner with the smallest coordinates
+     * @param max Corner with the largest coordinates
+     */
+    BoundingBox(const Vec3 &min, const Vec3 &max);
+    
+    /**
+     * @brief Checks if the box encloses nothing
+     * 
+     * @return True if no point has been added to the box
+     */
+    bool isEmpty() const;
+    
+    /**
+     * @brief Grows the box to enclose a point
+     * 
+     * @param p Point in space
+     */
+    void extend(const Vec3 &p);
+    
+    /**
+     * @brief Grows the box to enclose another box
+     * 
+     * @param box Another bounding box
+     */
+    void extend(const BoundingBox &box);
+    
+    /**
+     * @brief Gets the center of the box
+     * 
+     * @return Center point
+     */
+    Vec3 getCenter() const;
+    
+    /**
+     * @brief Gets the radius of the sphere enclosing the box
+     * 
+     * @return Half of the diagonal length
+     */
+    float getRadius() const;
+    
+    /**
+     * @brief Transforms the box into another coordinate system
+     * 
+     * The result is the axis-aligned box enclosing the transformed box.
+     * 
+     * @param M Transformation matrix like the model matrix of an object
+     * 
+     * @return Bounding box in the new coordinate system
+     */
+    BoundingBox transform(const Mat4 &M) const;
+};
+
+}
+
+#endif
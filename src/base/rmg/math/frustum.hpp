@@ -0,0 +1,101 @@
+/**
+ * @file frustum.hpp
+ * @brief Viewing volume of a camera bounded by 6 planes
+ * 
+ * Tests whether bounding volumes are visible to the camera so that the
+ * invisible objects can be skipped before drawing.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#pragma once
+#ifndef __RMG_FRUSTUM_H__
+#define __RMG_FRUSTUM_H__
+
+#ifndef RMG_API
+#ifdef _WIN32
+#ifdef RMG_EXPORT
+#define RMG_API __declspec(dllexport)
+#else
+#define RMG_API __declspec(dllimport)
+#endif
+#else
+#define RMG_API
+#endif
+#endif
+
+
+#include "bounding_box.hpp"
+#include "mat4.hpp"
+#include "vec3.hpp"
+#include "vec4.hpp"
+
+
+namespace rmg {
+
+/**
+ * @brief Viewing volume of a camera bounded by 6 planes
+ * 
+ * Tests whether bounding volumes are visible to the camera so that the
+ * invisible objects can be skipped before drawing.
+ */
+struct RMG_API Frustum {
+    /**
+     * @brief Clipping planes (left, right, bottom, top, near, far)
+     * 
+     * Each plane is stored as (a, b, c, d) of the equation
+     * ax + by + cz + d = 0 whose normal points into the volume.
+     */
+    Vec4 planes[6];
+    
+    /**
+     * @brief Default constructor
+     */
+    Frustum() = default;
+    
+    /**
+     * @brief Extracts the clipping planes from a view-projection matrix
+     * 
+     * @param VP View-projection matrix of a camera
+     */
+    Frustum(const Mat4 &VP);
+    
+    /**
+     * @brief Checks if a sphere is inside or intersects the volume
+     * 
+     * @param center Center of the sphere
+     * @param radius Radius of the sphere
+     * 
+     * @return False if the sphere is completely outside
+     */
+    bool intersects(const Vec3 &center, float radius) const;
+    
+    /**
+     * @brief Checks if a box is inside or intersects the volume
+     * 
+     * @param box Axis-aligned bounding box
+     * 
+     * @return False if the box is completely outside
+     */
+    bool intersects(const BoundingBox &box) const;
+    
+    /**
+     * @brief Checks if a transformed box is inside or intersects the volume
+     * 
+     * Rejects the box with its bounding sphere first and tests the box in
+     * world space afterwards.
+     * 
+     * @param box Bounding box in model space
+     * @param M Model matrix
+     * 
+     * @return False if the box is completely outside
+     */
+    bool intersects(const BoundingBox &box, const Mat4 &M) const;
+};
+
+}
+
+#endif
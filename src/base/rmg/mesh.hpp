@@ -25,27 +25,85 @@
 #endif
 
 
+#include <vector>
+
+#include "math/bounding_box.hpp"
 #include "math/vec.hpp"
 
 
 namespace rmg {
 
+namespace internal {
+
+class MappedFile;
+class MeshBVH;
+class VBOLoad;
+
+}
+
+
 /**
  * @brief Structural build of a 3D model consisting of polygons
  */
 class RMG_API Mesh {
   private:
+    // Arrays of a level of detail in the layout of the GPU buffers
+    struct EncodedLevel {
+        const void* positions = nullptr;
+        const void* attributes = nullptr;
+        const void* indices = nullptr;
+        uint32_t positionSize = 0;
+        uint32_t attributeSize = 0;
+        uint32_t indexSize = 0;
+        uint32_t vertexCount = 0;
+        uint32_t indexCount = 0;
+    };
+    
+    // Vertex format and quantization shared by the levels
+    struct Encoding {
+        uint32_t format = 0;
+        Vec3 offset;
+        Vec3 scale;
+        std::vector<EncodedLevel> levels;
+    };
+    
+    // Size and modification time of the file a cache is built from
+    struct SourceStamp {
+        uint64_t size = 0;
+        uint64_t time = 0;
+    };
+    
     void swap(Mesh& mesh) noexcept;
     
     void buildNormals(bool smooth=true);
     void buildNormals1();
     void buildNormals2();
     
+    static void buildCornerNormals(const Vec3* positions,
+                                   uint32_t positionCount,
+                                   const uint32_t* ids, uint32_t cornerCount,
+                                   bool smooth, Vec3* normals);
+    
     void removeIndices();
     
     void buildIndices();
-    void buildIndices1();
-    void buildIndices2();
+    static void weldPositions(const Vec3* positions, uint32_t count,
+                              uint32_t* ids);
+    
+    static Mesh loadOBJ(const char* file, bool smooth);
+    
+    bool save(const char* file, const std::vector<Mesh> &levels,
+              const std::vector<float> &errors, const Encoding* encoding,
+              const SourceStamp* source) const;
+    static Mesh loadMapped(const char* file, std::vector<Mesh> *levels,
+                           std::vector<float> *errors, Encoding* encoding,
+                           SourceStamp* source);
+    
+    internal::MappedFile* mapping = nullptr;
+    BoundingBox mappedBounds;
+    
+    friend class internal::MeshBVH;
+    friend class internal::VBOLoad;
     
   protected:
     Vec3* vertices = nullptr; ///< Coordinate in 3D space
@@ -156,6 +214,102 @@ class RMG_API Mesh {
      * @return Number of triangles or quads constituting the model
      */
     uint32_t getPolygonCount() const;
+    
+    /**
+     * @brief Gets the axis-aligned box enclosing the vertices
+     * 
+     * @return Bounding box in model space
+     */
+    BoundingBox getBoundingBox() const;
+    
+    /**
+     * @brief Hashes the vertex arrays and indices
+     * 
+     * Identical meshes have the same hash, so the 3D objects use it to
+     * share a single VBO.
+     * 
+     * @return 64-bit hash of the mesh data
+     */
+    uint64_t getHash() const;
+    
+    /**
+     * @brief Reorders the triangles and vertices for the GPU vertex cache
+     * 
+     * Meshes built from vertex arrays and 3D model files are optimized
+     * already. Use this for meshes constructed from custom indices.
+     * 
+     * @param cacheSize Number of vertices the post-transform cache holds
+     */
+    void optimize(uint32_t cacheSize=16);
+    
+    /**
+     * @brief Gets the average cache miss ratio of the triangle order
+     * 
+     * Simulates a FIFO post-transform vertex cache. The ratio is the number
+     * of vertices transformed per triangle which lies between 0.5 and 3 and
+     * the lower the better.
+     * 
+     * @param cacheSize Number of vertices the post-transform cache holds
+     * 
+     * @return Average cache miss ratio (ACMR)
+     */
+    float getACMR(uint32_t cacheSize=16) const;
+    
+    /**
+     * @brief Reduces the number of triangles by collapsing the edges
+     * 
+     * The edges are collapsed in the order of their quadric errors. The
+     * vertices on the open borders and the seams, where the normals or the
+     * texture coordinates split, do not move so that the outline and the
+     * texture mapping are preserved. The result may keep more triangles than
+     * the target if the locked vertices or fold-overs prevent the collapses.
+     * 
+     * @param targetRatio Fraction of the triangles to keep
+     * 
+     * @return Root mean square distance of the removed vertices from the
+     *         simplified surface
+     */
+    float simplify(float targetRatio);
+    
+    /**
+     * @brief Loads a mesh from a 3D model file
+     * 
+     * @param file 3D model file (.obj, .rmgmesh)
+     * @param smooth Generate smooth surface normals if the 3D model does not
+     *               contain preprocessed vertex normals
+     * 
+     * @return Loaded mesh or an invalid mesh if the file fails to load
+     */
+    static Mesh loadFromFile(const char* file, bool smooth=true);
+    
+    /**
+     * @brief Saves the mesh in the binary mesh file format (.rmgmesh)
+     * 
+     * The arrays are stored in the layout of the GPU buffers so that
+     * loadMapped() can hand them to the GPU without parsing. The file is
+     * written under a temporary name first and then renamed, so readers
+     * never see a partially written file.
+     * 
+     * @param file Path for the mesh file
+     * 
+     * @return True if the file is written
+     */
+    bool save(const char* file) const;
+    
+    /**
+     * @brief Maps a binary mesh file (.rmgmesh) into the memory
+     * 
+     * The arrays of the returned mesh point into the mapped file and are
+     * read-only. The file stays mapped until the mesh is destroyed.
+     * Copies of the mesh own ordinary arrays.
+     * 
+     * @param file Path to the mesh file
+     * 
+     * @return Loaded mesh or an invalid mesh if the file is missing, was
+     *         written by another version, is truncated or has indices out
+     *         of the vertices
+     */
+    static Mesh loadMapped(const char* file);
 };
 
 }
@@ -195,7 +195,7 @@ class RMG_API Object {
      * 
      * @param hide Hide flag
      */
-    void setHidden(bool hide);
+    virtual void setHidden(bool hide);
     
     /**
      * @brief Whether the object is hidden or not
@@ -1,7 +1,7 @@
 /**
  * @file object3d.hpp
  * @brief 3D object whose model and appearance can be controlled quickly
- *
+ * 
  * The constructor builds a vertex buffer object to load into the GPU and
  * keeps the address to that resource. The model matrix and material
  * properties like color, diffusion and specularity coefficient are passed
@@ -31,6 +31,10 @@
 #endif
 
 
+#include <cstdint>
+#include <functional>
+#include <vector>
+
 #include "object.hpp"
 #include "math/euler.hpp"
 #include "math/mat3.hpp"
@@ -47,6 +51,7 @@ class Material;
 
 namespace internal {
 
+class SceneBVH;
 class Texture;
 class VBO;
 
@@ -55,7 +60,7 @@ class VBO;
 
 /**
  * @brief 3D object whose model and appearance can be controlled quickly
- *
+ * 
  * The constructor builds a vertex buffer object to load into the GPU and
  * keeps the address to that resource. The model matrix and material
  * properties like color, diffusion and specularity coefficient are passed
@@ -66,6 +71,7 @@ class RMG_API Object3D: public Object {
   private:
     Mat4 modelMatrix;
     Vec3 scale;
+    Vec3 meshScale;
     
     Material* material = nullptr;
     float metalness;
@@ -75,25 +81,78 @@ class RMG_API Object3D: public Object {
     internal::VBO* vbo = nullptr;
     uint32_t* vboShareCount = nullptr;
     internal::Pending vboLoad;
+    uint32_t lod = 0;
     
     internal::Texture* texture = nullptr;
     uint32_t* texShareCount = nullptr;
     internal::Pending texLoad;
     
-    void loadOBJ(const char* file, bool smooth=true);
+    internal::SceneBVH* bvh = nullptr;
+    uint32_t bvhProxy = 0;
+    
+    void markBoundsDirty();
+    
+    void loadMesh(const Mesh& mesh);
+    
+    void loadMesh(const std::vector<internal::LevelOfDetail>& lods);
+    
+    void shareVBO(uint64_t key, const std::function<void()> &load);
     
     void dereferenceVBO();
     
     void dereferenceTexture();
     
+    friend class internal::SceneBVH;
+    
   protected:
     /**
      * @brief Sets the mesh of the 3D object
      * 
+     * The objects of a context setting identical meshes share a single
+     * VBO. The meshes are compared by the hash of their data.
+     * 
      * @param mesh 3D Mesh containing vertex coordinates
      */
     void setMesh(const Mesh& mesh);
     
+    /**
+     * @brief Sets a mesh shared by the objects of the same key
+     * 
+     * The mesh is generated only if no other object of the context has
+     * used the key. This way the primitive shapes are built once for all
+     * the objects of the same parameters.
+     * 
+     * @param key Hash of the parameters generating the mesh
+     * @param create Function generating the mesh
+     */
+    void setMesh(uint64_t key, const std::function<Mesh()> &create);
+    
+    /**
+     * @brief Sets the levels of detail shared by the objects of the same
+     *        key
+     * 
+     * The renderer draws the coarsest level whose error is invisible at
+     * the distance of the object.
+     * 
+     * @param key Hash of the parameters generating the meshes
+     * @param create Function generating the levels from the most detailed
+     */
+    void setMeshLevels(
+        uint64_t key,
+        const std::function<std::vector<internal::LevelOfDetail>()> &create
+    );
+    
+    /**
+     * @brief Sets the scale applied to the mesh before the object's scale
+     * 
+     * Lets the shapes of different dimensions share a mesh of unit size.
+     * 
+     * @param x Scaling factor in x-component
+     * @param y Scaling factor in y-component
+     * @param z Scaling factor in z-component
+     */
+    void setMeshScale(float x, float y, float z);
+    
     /**
      * @brief Swaps the values of member variables between two objects
      * 
@@ -117,8 +176,11 @@ class RMG_API Object3D: public Object {
     /**
      * @brief Constructor loads 3D model from file.
      * 
+     * The parsed model is cached in a binary mesh file (.rmgmesh) next to
+     * the model file, which is mapped by the later runs instead.
+     * 
      * @param ctx Container context
-     * @param file 3D model file (.obj)
+     * @param file 3D model file (.obj, .rmgmesh)
      * @param smooth Generate smooth surface normals if the 3D model does not
      *               contain an option about vertex normals
      */
@@ -282,6 +344,26 @@ class RMG_API Object3D: public Object {
      */
     Vec3 getScale() const;
     
+    /**
+     * @brief Gets the scale applied to the mesh before the object's scale
+     * 
+     * The primitive shapes keep their dimensions here as their meshes are
+     * of unit size.
+     * 
+     * @return Scaling factors in x, y and z components
+     */
+    Vec3 getMeshScale() const;
+    
+    /**
+     * @brief Sets object visibility
+     * 
+     * The shadows drawn from the previous frames are drawn again with or
+     * without the object.
+     * 
+     * @param hide Hide flag
+     */
+    void setHidden(bool hide) override;
+    
     /**
      * @brief Sets the material texture
      * 
@@ -388,6 +470,25 @@ class RMG_API Object3D: public Object {
      */
     const internal::VBO *getVBO() const;
     
+    /**
+     * @brief Picks the level of detail to draw
+     * 
+     * Called by the renderer every frame. The level stays the same unless
+     * the error is clearly different from the limit.
+     * 
+     * @param maxError Largest error allowed in model space
+     * 
+     * @return Level of detail
+     */
+    uint32_t selectLOD(float maxError);
+    
+    /**
+     * @brief Gets the level of detail drawn
+     * 
+     * @return Level of detail, zero for the most detailed mesh
+     */
+    uint32_t getLOD() const;
+    
     /**
      * @brief Gets the pointer to the texture
      * 
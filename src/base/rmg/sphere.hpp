@@ -49,7 +49,8 @@ class RMG_API Sphere3D: public Object3D {
   private:
     float diameter;
     
-    Mesh createMesh();
+    static std::vector<internal::LevelOfDetail> createLevels();
+    static Mesh createMesh(int n);
     
   public:
     /**
@@ -16,9 +16,12 @@
 
 #include "rmg/sphere.hpp"
 
+#include <cmath>
 #include <iostream>
+#include <vector>
 
 #include "rmg/context.hpp"
+#include "rmg/internal/mesh_cache.hpp"
 
 
 namespace rmg {
@@ -38,18 +41,32 @@ Sphere3D::Sphere3D() {
  */
 Sphere3D::Sphere3D(Context* ctx, float d): Object3D(ctx) {    
     diameter = d;
-    setMesh(createMesh());
+    // All the spheres share a mesh of unit diameter
+    setMeshScale(d, d, d);
+    setMeshLevels(internal::MeshCache::hash("Sphere3D", 8), createLevels);
 }
 
-Mesh Sphere3D::createMesh() {
-    #define FRAGMENT_COUNT 8
-    
-    Vec3 vertices[6][FRAGMENT_COUNT+1][FRAGMENT_COUNT+1];
-    Vec3 normals[6][FRAGMENT_COUNT+1][FRAGMENT_COUNT+1];
-    Vec2 texCoords[6][FRAGMENT_COUNT+1][FRAGMENT_COUNT+1];
-    uint32_t indecies[6][FRAGMENT_COUNT][FRAGMENT_COUNT][6];
+std::vector<internal::LevelOfDetail> Sphere3D::createLevels() {
+    // Fragments per cube face of each level
+    const int fragments[] = {16, 8, 4, 2};
+    std::vector<internal::LevelOfDetail> lods;
+    for(int f : fragments) {
+        // Sagitta of the widest face of the mesh
+        float error = 0.5f * (1 - cos(atan(M_SQRT2 / f)));
+        lods.push_back({createMesh(f), error});
+    }
+    return lods;
+}
+
+Mesh Sphere3D::createMesh(int n) {
+    uint32_t side = n + 1;
+    std::vector<Vec3> vertices = std::vector<Vec3>(6 * side * side);
+    std::vector<Vec3> normals = std::vector<Vec3>(6 * side * side);
+    std::vector<Vec2> texCoords = std::vector<Vec2>(6 * side * side);
+    std::vector<uint32_t> indices;
+    indices.reserve(6 * n * n * 6);
     
-    float radius = diameter/2.0f;
+    float radius = 0.5f;
     
     for(int k=0; k<6; k++) {
         Vec3 s0, u, v;
@@ -84,53 +101,37 @@ Mesh Sphere3D::createMesh() {
             v = Vec3(0, 1, 0);
         }
         
-        for(int i=0; i<FRAGMENT_COUNT+1; i++) {
-            for(int j=0; j<FRAGMENT_COUNT+1; j++) {
-                Vec3 du = 2.0f * ((float)j/FRAGMENT_COUNT) * u;
-                Vec3 dv = 2.0f * ((float)i/FRAGMENT_COUNT) * v;
-                Vec3 n = s0 + du + dv;
-                n = n.normalize();
-                vertices[k][i][j] = radius*n;
-                normals[k][i][j] = n;
-                if(i<FRAGMENT_COUNT && j<FRAGMENT_COUNT) {
-                    indecies[k][i][j][0] =
-                        k * (FRAGMENT_COUNT+1) * (FRAGMENT_COUNT+1) +
-                        i * (FRAGMENT_COUNT+1) +
-                        j;
-                    indecies[k][i][j][1] =
-                        k * (FRAGMENT_COUNT+1) * (FRAGMENT_COUNT+1) +
-                        i * (FRAGMENT_COUNT+1) +
-                        j+1;
-                    indecies[k][i][j][2] =
-                        k * (FRAGMENT_COUNT+1) * (FRAGMENT_COUNT+1) +
-                        (i+1) * (FRAGMENT_COUNT+1) +
-                        j+1;
-                    indecies[k][i][j][3] =
-                        k * (FRAGMENT_COUNT+1) * (FRAGMENT_COUNT+1) +
-                        (i+1) * (FRAGMENT_COUNT+1) +
-                        j+1;
-                    indecies[k][i][j][4] =
-                        k * (FRAGMENT_COUNT+1) * (FRAGMENT_COUNT+1) +
-                        (i+1) * (FRAGMENT_COUNT+1) +
-                        j;
-                    indecies[k][i][j][5] =
-                        k * (FRAGMENT_COUNT+1) * (FRAGMENT_COUNT+1) +
-                        i * (FRAGMENT_COUNT+1) +
-                        j;
+        uint32_t face = k * side * side;
+        for(int i=0; i<n+1; i++) {
+            for(int j=0; j<n+1; j++) {
+                Vec3 du = 2.0f * ((float)j/n) * u;
+                Vec3 dv = 2.0f * ((float)i/n) * v;
+                Vec3 p = s0 + du + dv;
+                p = p.normalize();
+                uint32_t id = face + i*side + j;
+                vertices[id] = radius*p;
+                normals[id] = p;
+                texCoords[id] = Vec2((float)j/n, (float)i/n);
+                if(i<n && j<n) {
+                    indices.push_back(id);
+                    indices.push_back(id + 1);
+                    indices.push_back(id + side + 1);
+                    indices.push_back(id + side + 1);
+                    indices.push_back(id + side);
+                    indices.push_back(id);
                 }
             }
         }
     }
     
     return Mesh(
-        &vertices[0][0][0],
-        &normals[0][0][0],
-        &texCoords[0][0][0],
-        6 * (FRAGMENT_COUNT+1) * (FRAGMENT_COUNT+1),
-        &indecies[0][0][0][0],
-        6 * FRAGMENT_COUNT * FRAGMENT_COUNT * 6
+        vertices.data(),
+        normals.data(),
+        texCoords.data(),
+        vertices.size(),
+        indices.data(),
+        indices.size()
     );
-    #undef FRAGMENT_COUNT
 }
 
 /**
@@ -149,10 +150,8 @@ float Sphere3D::getDiameter() const { return diameter; }
  * @param mat Predefined material
  */
 void Sphere3D::setMaterial(Material* mat) {
-    Material *prev = getMaterial();
+    // The mesh does not depend on the material
     Object3D::setMaterial(mat);
-    if(prev == nullptr)
-        setMesh(createMesh());
 }
 
 }
@@ -30,10 +30,9 @@ namespace rmg {
  * @param img Image file (supports the same format Texture class does)
  */
 Sprite2D::Sprite2D(Context* ctx, const char* img)
-         :Sprite2D(ctx, img, Vec2())
+         :Sprite2D(ctx, Bitmap::loadFromFile(img))
 {
-    internal::SpriteLoad *load = (internal::SpriteLoad*) texLoad.getData();
-    setSize(load->getWidth(), load->getHeight());
+    // Decoded right away since the size of the sprite comes from the image
 }
 
 /**
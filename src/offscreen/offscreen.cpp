@@ -0,0 +1,264 @@
+/**
+ * @file offscreen.cpp
+ * @brief Headless graphical context rendering into an offscreen framebuffer
+ * 
+ * Uses a surfaceless EGL context so that the 2D/3D graphics can be rendered
+ * without a window system, e.g. on CI machines or render servers. Each frame
+ * is read back into a bitmap instead of being presented on a screen.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#define RMG_OFFSCREEN_EXPORT
+
+
+#include "rmg/offscreen.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+
+using namespace rmg::internal;
+
+
+static double getSteadyTime() {
+    auto t = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration<double>(t).count();
+}
+
+static EGLDisplay getSurfacelessDisplay() {
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+                              eglGetProcAddress("eglGetPlatformDisplayEXT");
+    EGLDisplay display = EGL_NO_DISPLAY;
+    if(getPlatformDisplay != NULL) {
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+                                     EGL_DEFAULT_DISPLAY, NULL);
+    }
+    if(display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    return display;
+}
+
+static void printError(const char *msg) {
+    #ifdef _WIN32
+    printf("error: %s\n", msg);
+    #else
+    printf("\033[0;1;31merror:\033[0m %s\n", msg);
+    #endif
+}
+
+
+namespace rmg {
+
+/**
+ * @brief Constructs a headless context of a given resolution
+ * 
+ * @param w Width of the framebuffer
+ * @param h Height of the framebuffer
+ */
+OffscreenContext::OffscreenContext(uint16_t w, uint16_t h) {
+    eglDisplay = EGL_NO_DISPLAY;
+    eglContext = EGL_NO_CONTEXT;
+    fbo = 0;
+    colorRBO = 0;
+    depthRBO = 0;
+    fboWidth = 0;
+    fboHeight = 0;
+    startTime = getSteadyTime();
+    setContextSize(w, h);
+    
+    EGLDisplay display = getSurfacelessDisplay();
+    if(display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL)) {
+        setErrorCode(503);
+        printError("Failed to initialize EGL display");
+        destroy();
+        return;
+    }
+    eglDisplay = display;
+    if(!eglBindAPI(EGL_OPENGL_API)) {
+        setErrorCode(503);
+        printError("EGL does not support desktop OpenGL");
+        destroy();
+        return;
+    }
+    
+    // The surfaceless platform may expose no configs at all in which case
+    // the context is created without one (EGL_KHR_no_config_context)
+    const EGLint configAttribs[] = {
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLConfig config = EGL_NO_CONFIG_KHR;
+    EGLint configCount = 0;
+    eglChooseConfig(display, configAttribs, &config, 1, &configCount);
+    if(configCount == 0)
+        config = EGL_NO_CONFIG_KHR;
+    
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    eglContext = eglCreateContext(display, config, EGL_NO_CONTEXT,
+                                  contextAttribs);
+    if(eglContext == EGL_NO_CONTEXT) {
+        setErrorCode(503);
+        printError("Failed to create a surfaceless OpenGL 3.3 context");
+        destroy();
+        return;
+    }
+}
+
+/**
+ * @brief Destructor cleans up context resources
+ */
+OffscreenContext::~OffscreenContext() {
+    destroy();
+}
+
+/**
+ * @brief Cleans up context resources
+ */
+void OffscreenContext::destroy() {
+    if(isDestroyed())
+        return;
+    if(eglContext != EGL_NO_CONTEXT) {
+        setCurrent();
+        deleteFramebuffer();
+    }
+    Context::destroy();
+    if(eglDisplay != EGL_NO_DISPLAY) {
+        eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                       EGL_NO_CONTEXT);
+        if(eglContext != EGL_NO_CONTEXT)
+            eglDestroyContext(eglDisplay, eglContext);
+    }
+    eglContext = EGL_NO_CONTEXT;
+    eglDisplay = EGL_NO_DISPLAY;
+}
+
+void OffscreenContext::deleteFramebuffer() {
+    if(fbo == 0)
+        return;
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteRenderbuffers(1, &colorRBO);
+    glDeleteRenderbuffers(1, &depthRBO);
+    fbo = 0;
+    colorRBO = 0;
+    depthRBO = 0;
+    fboWidth = 0;
+    fboHeight = 0;
+}
+
+/**
+ * @brief Gets the running time of the context
+ * 
+ * @return Running time in seconds
+ */
+float OffscreenContext::getTime() const {
+    return (float)(getSteadyTime() - startTime);
+}
+
+/**
+ * @brief Makes OpenGL rederer focuses on this context
+ * 
+ * Whenever functions regarding OpenGL resources is intended to be
+ * called, the function needs to be called first especially when working
+ * with multiple contexts.
+ */
+void OffscreenContext::setCurrent() {
+    if(eglContext == EGL_NO_CONTEXT)
+        return;
+    eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext);
+    Context::setCurrent();
+}
+
+/**
+ * @brief Gets the framebuffer the context draws its final image into
+ * 
+ * The framebuffer object is created or resized to match the context
+ * size on demand.
+ * 
+ * @return OpenGL framebuffer object ID
+ */
+uint32_t OffscreenContext::getFramebuffer() {
+    Rect size = getContextSize();
+    uint16_t w = size.x;
+    uint16_t h = size.y;
+    if(fbo != 0 && fboWidth == w && fboHeight == h)
+        return fbo;
+    
+    deleteFramebuffer();
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glGenRenderbuffers(1, &colorRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                              GL_RENDERBUFFER, colorRBO);
+    glGenRenderbuffers(1, &depthRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, w, h);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                              GL_RENDERBUFFER, depthRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        setErrorCode(503);
+        printError("Offscreen framebuffer is incomplete");
+    }
+    fboWidth = w;
+    fboHeight = h;
+    frame = Bitmap(w, h, 3);
+    return fbo;
+}
+
+/**
+ * @brief Reads the drawn graphics back from the framebuffer
+ * 
+ * The result is accessible with getFrame().
+ */
+void OffscreenContext::flush() {
+    if(fbo == 0)
+        return;
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, fboWidth, fboHeight, GL_RGB, GL_UNSIGNED_BYTE,
+                 frame.getPointer());
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    
+    // OpenGL returns the bottom row first
+    uint8_t *ptr = frame.getPointer();
+    size_t stride = (size_t) fboWidth * 3;
+    uint8_t *tmp = new uint8_t[stride];
+    for(uint16_t i=0; i<fboHeight/2; i++) {
+        uint8_t *top = ptr + i*stride;
+        uint8_t *bottom = ptr + (fboHeight-1-i)*stride;
+        memcpy(tmp, top, stride);
+        memcpy(top, bottom, stride);
+        memcpy(bottom, tmp, stride);
+    }
+    delete[] tmp;
+}
+
+/**
+ * @brief Gets the last rendered frame
+ * 
+ * The bitmap is in RGB format with the first row at the top of the
+ * image. It is updated on every call to render().
+ * 
+ * @return Bitmap of the context size
+ */
+const Bitmap &OffscreenContext::getFrame() const { return frame; }
+
+}
@@ -0,0 +1,127 @@
+/**
+ * @file offscreen.hpp
+ * @brief Headless graphical context rendering into an offscreen framebuffer
+ * 
+ * Uses a surfaceless EGL context so that the 2D/3D graphics can be rendered
+ * without a window system, e.g. on CI machines or render servers. Each frame
+ * is read back into a bitmap instead of being presented on a screen.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#pragma once
+#ifndef __RMG_OFFSCREEN_H__
+#define __RMG_OFFSCREEN_H__
+
+#ifndef RMG_OFFSCREEN_API
+#ifdef _WIN32
+#ifdef RMG_OFFSCREEN_EXPORT
+#define RMG_OFFSCREEN_API __declspec(dllexport)
+#else
+#define RMG_OFFSCREEN_API __declspec(dllimport)
+#endif
+#else
+#define RMG_OFFSCREEN_API
+#endif
+#endif
+
+
+#include <rmg/bitmap.hpp>
+#include <rmg/context.hpp>
+
+
+namespace rmg {
+
+/**
+ * @brief Headless graphical context rendering into an offscreen framebuffer
+ * 
+ * The context creates its own OpenGL context through EGL without any window
+ * or surface. Rendering passes draw into a framebuffer object of the context
+ * size and every call to render() reads the result back into a bitmap.
+ * No vertical synchronization or frame rate limiting is involved so that
+ * frames are produced as fast as the GPU permits.
+ */
+class RMG_OFFSCREEN_API OffscreenContext: public Context {
+  private:
+    void *eglDisplay;
+    void *eglContext;
+    uint32_t fbo;
+    uint32_t colorRBO;
+    uint32_t depthRBO;
+    uint16_t fboWidth;
+    uint16_t fboHeight;
+    Bitmap frame;
+    double startTime;
+    
+    void deleteFramebuffer();
+    
+  protected:
+    /**
+     * @brief Cleans up GPU resources
+     */
+    virtual void destroy();
+    
+  public:
+    /**
+     * @brief Constructs a headless context of a given resolution
+     * 
+     * @param w Width of the framebuffer
+     * @param h Height of the framebuffer
+     */
+    OffscreenContext(uint16_t w, uint16_t h);
+    
+    /**
+     * @brief Destructor cleans up context resources
+     */
+    virtual ~OffscreenContext();
+    
+    /**
+     * @brief Gets the running time of the context
+     * 
+     * @return Running time in seconds
+     */
+    float getTime() const override;
+    
+    /**
+     * @brief Makes OpenGL rederer focuses on this context
+     * 
+     * Whenever functions regarding OpenGL resources is intended to be
+     * called, the function needs to be called first especially when working
+     * with multiple contexts.
+     */
+    void setCurrent() override;
+    
+    /**
+     * @brief Reads the drawn graphics back from the framebuffer
+     * 
+     * The result is accessible with getFrame().
+     */
+    void flush() override;
+    
+    /**
+     * @brief Gets the framebuffer the context draws its final image into
+     * 
+     * The framebuffer object is created or resized to match the context
+     * size on demand.
+     * 
+     * @return OpenGL framebuffer object ID
+     */
+    uint32_t getFramebuffer() override;
+    
+    /**
+     * @brief Gets the last rendered frame
+     * 
+     * The bitmap is in RGB format with the first row at the top of the
+     * image. It is updated on every call to render().
+     * 
+     * @return Bitmap of the context size
+     */
+    const Bitmap &getFrame() const;
+};
+
+}
+
+#endif
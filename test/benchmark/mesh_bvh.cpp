@@ -0,0 +1,90 @@
+/**
+ * @file mesh_bvh.cpp
+ * @brief Measures the ray queries of picking on a large mesh
+ * 
+ * A wavy terrain of 2 million triangles is queried by rays from random
+ * points above it. The build of the triangle hierarchy is measured
+ * separately as it is only done by the first pick of a mesh.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#include <rmg/internal/mesh_bvh.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+using namespace rmg;
+using rmg::internal::MeshBVH;
+
+
+#define TERRAIN_SIZE 1024
+
+
+static void createTerrain(std::vector<Vec3> &vertices,
+                          std::vector<uint32_t> &indices)
+{
+    const int n = TERRAIN_SIZE;
+    for(int y=0; y<=n; y++) {
+        for(int x=0; x<=n; x++) {
+            float z = 0.05f * sinf(x * 0.1f) * cosf(y * 0.07f);
+            vertices.push_back(Vec3((float)x/n, (float)y/n, z));
+        }
+    }
+    for(int y=0; y<n; y++) {
+        for(int x=0; x<n; x++) {
+            uint32_t a = y*(n+1) + x;
+            uint32_t b = a + n + 1;
+            uint32_t quad[6] = {a, a+1, b+1, a, b+1, b};
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+}
+
+
+static void BM_MeshBVHBuild(benchmark::State& state) {
+    std::vector<Vec3> vertices;
+    std::vector<uint32_t> indices;
+    createTerrain(vertices, indices);
+    for(auto _ : state) {
+        MeshBVH bvh = MeshBVH(vertices.data(), vertices.size(),
+                              indices.data(), indices.size());
+        bvh.build();
+        benchmark::DoNotOptimize(bvh);
+    }
+    state.counters["triangles"] = indices.size() / 3;
+}
+BENCHMARK(BM_MeshBVHBuild)->Unit(benchmark::kMillisecond);
+
+
+static void BM_MeshBVHRaycast(benchmark::State& state) {
+    std::vector<Vec3> vertices;
+    std::vector<uint32_t> indices;
+    createTerrain(vertices, indices);
+    MeshBVH bvh = MeshBVH(vertices.data(), vertices.size(), indices.data(),
+                          indices.size());
+    bvh.build();
+    
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> dist(0, 1);
+    uint64_t hits = 0;
+    for(auto _ : state) {
+        LineEq ray = LineEq(Vec3(dist(rng), dist(rng), 1),
+                            Vec3(dist(rng) - 0.5f, dist(rng) - 0.5f, -1));
+        float t;
+        if(bvh.raycast(ray, 10, &t))
+            hits++;
+    }
+    state.counters["triangles"] = indices.size() / 3;
+    state.counters["hit_rate"] = (double) hits / state.iterations();
+}
+BENCHMARK(BM_MeshBVHRaycast)->Unit(benchmark::kMicrosecond);
+
+
+BENCHMARK_MAIN();
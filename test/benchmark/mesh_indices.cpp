@@ -0,0 +1,156 @@
+/**
+ * @file mesh_indices.cpp
+ * @brief Compares the vertex welding with the previous unordered_map welding
+ * 
+ * Run with the bundled models under share/models. The meshes are expanded
+ * into one vertex per triangle corner, which is what the Mesh constructors
+ * index.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#include <rmg/mesh.hpp>
+
+#include <cstring>
+#include <functional>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <rmg/config.h>
+
+using namespace rmg;
+
+
+struct FlatArrays {
+    std::vector<Vec3> vertices;
+    std::vector<Vec3> normals;
+    std::vector<Vec2> texCoords;
+};
+
+
+class MeshExpander: public Mesh {
+  public:
+    MeshExpander(Mesh&& mesh): Mesh(std::move(mesh)) {}
+    
+    FlatArrays expand() const {
+        FlatArrays arr;
+        for(uint32_t i=0; i<index_count; i++) {
+            Vec3 v = vertices[indices[i]];
+            arr.vertices.push_back(v);
+            arr.normals.push_back(normals[indices[i]]);
+            arr.texCoords.push_back(Vec2(v.x, v.y));
+        }
+        return arr;
+    }
+};
+
+
+
+// The welding before the open addressing table, kept as the baseline
+
+template <typename T>
+static void combineHash(size_t& seed, const T& key) {
+    seed ^= std::hash<T>{}(key) + 0x9e3779b9 + (seed<<6) + (seed>>2);
+}
+
+
+static uint32_t buildIndicesLegacy(const FlatArrays &arr,
+                                   std::vector<uint32_t> &indices)
+{
+    auto hash = [](const std::tuple<Vec3,Vec3,Vec2>& k) {
+        size_t seed = 0;
+        combineHash(seed, std::get<0>(k));
+        combineHash(seed, std::get<1>(k));
+        combineHash(seed, std::get<2>(k));
+        return seed;
+    };
+    
+    auto equal = [](const std::tuple<Vec3,Vec3,Vec2>& a,
+                    const std::tuple<Vec3,Vec3,Vec2>& b)
+    {
+        return (std::get<0>(a) == std::get<0>(b)) &&
+               (std::get<1>(a) == std::get<1>(b)) &&
+               (std::get<2>(a) == std::get<2>(b));
+    };
+    
+    std::unordered_map
+        <std::tuple<Vec3,Vec3,Vec2>, uint32_t,
+         decltype(hash), decltype(equal)> table(65536, hash, equal);
+    
+    uint32_t count = arr.vertices.size();
+    indices.resize(count);
+    std::vector<Vec3> vertices = std::vector<Vec3>(count);
+    std::vector<Vec3> normals = std::vector<Vec3>(count);
+    std::vector<Vec2> texCoords = std::vector<Vec2>(count);
+    for(uint32_t i=0; i<count; i++) {
+        auto key = std::make_tuple(arr.vertices[i], arr.normals[i],
+                                   arr.texCoords[i]);
+        auto res = table.find(key);
+        if(res == table.end()) {
+            uint32_t k = table.size();
+            vertices[k] = arr.vertices[i];
+            normals[k] = arr.normals[i];
+            texCoords[k] = arr.texCoords[i];
+            indices[i] = k;
+            table.insert(std::make_pair(key, k));
+        }
+        else {
+            indices[i] = res->second;
+        }
+    }
+    return table.size();
+}
+
+
+
+static const char* models[] = {
+    RMG_RESOURCE_PATH "/models/dragon.obj",
+    RMG_RESOURCE_PATH "/models/happy_buddha.obj"
+};
+
+
+static FlatArrays loadFlatArrays(int model) {
+    return MeshExpander(Mesh::loadFromFile(models[model])).expand();
+}
+
+
+static void BM_BuildIndices_Legacy(benchmark::State& state) {
+    const char* file = models[state.range(0)];
+    state.SetLabel(strrchr(file, '/') + 1);
+    FlatArrays arr = loadFlatArrays(state.range(0));
+    std::vector<uint32_t> indices;
+    for(auto _ : state) {
+        uint32_t count = buildIndicesLegacy(arr, indices);
+        benchmark::DoNotOptimize(count);
+    }
+}
+BENCHMARK(BM_BuildIndices_Legacy)
+    ->DenseRange(0, 1)
+    ->Unit(benchmark::kMillisecond);
+
+
+static void BM_BuildIndices(benchmark::State& state) {
+    const char* file = models[state.range(0)];
+    state.SetLabel(strrchr(file, '/') + 1);
+    FlatArrays arr = loadFlatArrays(state.range(0));
+    for(auto _ : state) {
+        Mesh mesh = Mesh(
+            &arr.vertices[0],
+            &arr.normals[0],
+            &arr.texCoords[0],
+            arr.vertices.size()
+        );
+        benchmark::DoNotOptimize(mesh.getVertexCount());
+    }
+}
+BENCHMARK(BM_BuildIndices)->DenseRange(0, 1)->Unit(benchmark::kMillisecond);
+
+
+BENCHMARK_MAIN();
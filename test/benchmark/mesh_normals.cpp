@@ -0,0 +1,140 @@
+/**
+ * @file mesh_normals.cpp
+ * @brief Compares the smooth normal generation with the previous multimap
+ *        based generation
+ * 
+ * Run with the bundled models under share/models. The meshes are expanded
+ * into one vertex per triangle corner and both versions index the result
+ * the same way, so only the normal generation differs.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#include <rmg/mesh.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <rmg/config.h>
+
+using namespace rmg;
+
+
+class MeshExpander: public Mesh {
+  public:
+    MeshExpander(Mesh&& mesh): Mesh(std::move(mesh)) {}
+    
+    std::vector<Vec3> expand() const {
+        std::vector<Vec3> arr;
+        for(uint32_t i=0; i<index_count; i++)
+            arr.push_back(vertices[indices[i]]);
+        return arr;
+    }
+};
+
+
+
+// The generation before the position grouping, kept as the baseline
+
+static void buildNormalsLegacy(const std::vector<Vec3> &vertices,
+                               std::vector<Vec3> &normals)
+{
+    uint32_t vertex_count = vertices.size();
+    normals.resize(vertex_count);
+    uint32_t polygon_count = vertex_count / 3;
+    std::vector<Vec3> faceNormals = std::vector<Vec3>(polygon_count);
+    std::vector<float> angles = std::vector<float>(vertex_count);
+    std::unordered_multimap<Vec3, uint32_t> table;
+    
+    for(uint32_t i=0; i<polygon_count; i++) {
+        Vec3 p01 = vertices[i*3 + 1] - vertices[i*3];
+        Vec3 p02 = vertices[i*3 + 2] - vertices[i*3];
+        Vec3 p12 = vertices[i*3 + 2] - vertices[i*3 + 1];
+        
+        faceNormals[i] = (p01 * p02).normalize();
+        
+        float cosT0, cosT1, cosT2;
+        cosT0 = Vec3::dot( p01,  p02) / (p01.magnitude() * p02.magnitude());
+        cosT1 = Vec3::dot( p12, -p01) / (p12.magnitude() * p01.magnitude());
+        cosT2 = Vec3::dot(-p02, -p12) / (p02.magnitude() * p12.magnitude());
+        angles[i*3 + 0] = acos(cosT0);
+        angles[i*3 + 1] = acos(cosT1);
+        angles[i*3 + 2] = acos(cosT2);
+        
+        table.insert(std::make_pair(vertices[i*3 + 0], i*3));
+        table.insert(std::make_pair(vertices[i*3 + 1], i*3 + 1));
+        table.insert(std::make_pair(vertices[i*3 + 2], i*3 + 2));
+    }
+    
+    for(uint32_t i=0; i<vertex_count; i++) {
+        auto range = table.equal_range(vertices[i]);
+        int count = std::distance(range.first, range.second);
+        
+        if(count > 1) {
+            Vec3 n;
+            Vec3 n1 = faceNormals[i/3];
+            for(auto it=range.first; it!=range.second; it++) {
+                Vec3 n2 = faceNormals[it->second/3];
+                float cosT = Vec3::dot(n1, n2);
+                if(cosT > 0.866025f) // 30 degrees
+                    n += n2 * angles[it->second];
+            }
+            normals[i] = n.normalize();
+        }
+        else {
+            normals[i] = faceNormals[i/3];
+        }
+    }
+}
+
+
+
+static const char* models[] = {
+    RMG_RESOURCE_PATH "/models/dragon.obj",
+    RMG_RESOURCE_PATH "/models/happy_buddha.obj"
+};
+
+
+static std::vector<Vec3> loadFlatVertices(int model) {
+    return MeshExpander(Mesh::loadFromFile(models[model])).expand();
+}
+
+
+static void BM_BuildNormals_Legacy(benchmark::State& state) {
+    const char* file = models[state.range(0)];
+    state.SetLabel(strrchr(file, '/') + 1);
+    std::vector<Vec3> vertices = loadFlatVertices(state.range(0));
+    std::vector<Vec3> normals;
+    for(auto _ : state) {
+        buildNormalsLegacy(vertices, normals);
+        Mesh mesh = Mesh(&vertices[0], &normals[0], nullptr, vertices.size());
+        benchmark::DoNotOptimize(mesh.getVertexCount());
+    }
+}
+BENCHMARK(BM_BuildNormals_Legacy)
+    ->DenseRange(0, 1)
+    ->Unit(benchmark::kMillisecond);
+
+
+static void BM_BuildNormals(benchmark::State& state) {
+    const char* file = models[state.range(0)];
+    state.SetLabel(strrchr(file, '/') + 1);
+    std::vector<Vec3> vertices = loadFlatVertices(state.range(0));
+    for(auto _ : state) {
+        Mesh mesh = Mesh(&vertices[0], vertices.size(), true);
+        benchmark::DoNotOptimize(mesh.getVertexCount());
+    }
+}
+BENCHMARK(BM_BuildNormals)->DenseRange(0, 1)->Unit(benchmark::kMillisecond);
+
+
+BENCHMARK_MAIN();
@@ -1,48 +1,44 @@
 /**
- * @file object3d_obj.cpp
- * @brief Loads and constructs 3D objects from .OBJ files
+ * @file mesh_obj.cpp
+ * @brief Compares the .OBJ loader with the previous fscanf based loader
  * 
- * @copyright Copyright (c) 2020 Khant Kyaw Khaung
+ * Run with the bundled models under share/models.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
  * 
  * @license{This project is released under the MIT License.}
  */
 
 
-#define RMG_EXPORT
-
-
-#include "rmg/object3d.hpp"
+#include <rmg/mesh.hpp>
 
 #include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <vector>
 
+#include <benchmark/benchmark.h>
 
-namespace rmg {
+#include <rmg/config.h>
 
-static void printLoadError(const char *file) {
-    #ifdef _WIN32
-    printf("error: Failed to load 3D model `%s`\n", file);
-    #else
-    printf("\033[0;1;31merror: \033[0m"
-           "Failed to load 3D model \033[1m'%s'\033[0m\n", file);
-    #endif
-}
+using namespace rmg;
 
 
+// The loader before the memory-mapped parser, kept as the baseline
+
 #define SAFE_PUSH(VEC, I) \
     if(std::max(I[0], std::max(I[1], I[2])) - 1 >= temp_ ## VEC.size()) { \
         printf("Vertex index out of bounds exception\n"); \
-        printLoadError(file); \
-        return; \
+        printf("Failed to load %s\n", file); \
+        fclose(fp); \
+        return Mesh(); \
     } \
     VEC.push_back(temp_ ## VEC [I[0] - 1]); \
     VEC.push_back(temp_ ## VEC [I[1] - 1]); \
     VEC.push_back(temp_ ## VEC [I[2] - 1]); \
 
 
-void Object3D::loadOBJ(const char* file, bool smooth) {
+static Mesh loadOBJLegacy(const char* file, bool smooth) {
     FILE *fp = fopen(file, "r");
     if(fp == NULL) {
         #ifdef _WIN32
@@ -52,7 +48,7 @@ void Object3D::loadOBJ(const char* file, bool smooth) {
                "File \033[1m'%s'\033[0m "
                "could not be opened\n", file);
         #endif
-        return;
+        return Mesh();
     }
     
     std::vector<Vec3> vertices;
@@ -126,8 +122,9 @@ void Object3D::loadOBJ(const char* file, bool smooth) {
                     &normalIndices[2]
                 );
                 if(matches != 9) {
-                    printLoadError(file);
-                    return;
+                    printf("Failed to load %s\n", file);
+                    fclose(fp);
+                    return Mesh();
                 }
                 SAFE_PUSH(vertices, vertexIndices);
                 SAFE_PUSH(normals, normalIndices);
@@ -149,8 +146,9 @@ void Object3D::loadOBJ(const char* file, bool smooth) {
                     &normalIndices[2]
                 );
                 if(matches != 6) {
-                    printLoadError(file);
-                    return;
+                    printf("Failed to load %s\n", file);
+                    fclose(fp);
+                    return Mesh();
                 }
                 SAFE_PUSH(vertices, vertexIndices);
                 SAFE_PUSH(normals, normalIndices);
@@ -171,8 +169,9 @@ void Object3D::loadOBJ(const char* file, bool smooth) {
                     &texCoordIndices[2]
                 );
                 if(matches != 6) {
-                    printLoadError(file);
-                    return;
+                    printf("Failed to load %s\n", file);
+                    fclose(fp);
+                    return Mesh();
                 }
                 SAFE_PUSH(vertices, vertexIndices);
                 SAFE_PUSH(texCoords, texCoordIndices);
@@ -188,55 +187,86 @@ void Object3D::loadOBJ(const char* file, bool smooth) {
                     &vertexIndices[2]
                 );
                 if(matches != 3) {
-                    printLoadError(file);
-                    return;
+                    printf("Failed to load %s\n", file);
+                    fclose(fp);
+                    return Mesh();
                 }
                 SAFE_PUSH(vertices, vertexIndices);
             }
             
             else {
-                printLoadError(file);
-                return;
+                printf("Failed to load %s\n", file);
+                fclose(fp);
+                return Mesh();
             }
         }
     }
     
+    fclose(fp);
+    
     // Completes the mesh
     if(vertices.size() > 0 && normals.size() > 0 && texCoords.size() > 0) {
-        Mesh mesh = Mesh(
+        return Mesh(
             &vertices[0],
             &normals[0],
             &texCoords[0],
             vertices.size()
         );
-        setMesh(mesh);
     }
     else if(vertices.size() > 0 && normals.size() > 0) {
-        Mesh mesh = Mesh(
+        return Mesh(
             &vertices[0],
             &normals[0],
             nullptr,
             vertices.size()
         );
-        setMesh(mesh);
     }
     else if(vertices.size() > 0 && texCoords.size() > 0) {
-        Mesh mesh = Mesh(
+        return Mesh(
             &vertices[0],
             &texCoords[0],
             vertices.size(),
             smooth
         );
-        setMesh(mesh);
     }
     else if(vertices.size() > 0) {
-        Mesh mesh = Mesh(
+        return Mesh(
             &vertices[0],
             vertices.size(),
             smooth
         );
-        setMesh(mesh);
+    }
+    return Mesh();
+}
+
+
+
+static const char* models[] = {
+    RMG_RESOURCE_PATH "/models/teapot.obj",
+    RMG_RESOURCE_PATH "/models/dragon.obj",
+    RMG_RESOURCE_PATH "/models/happy_buddha.obj"
+};
+
+
+static void BM_LoadOBJ_Legacy(benchmark::State& state) {
+    const char* file = models[state.range(0)];
+    state.SetLabel(strrchr(file, '/') + 1);
+    for(auto _ : state) {
+        Mesh mesh = loadOBJLegacy(file, true);
+        benchmark::DoNotOptimize(mesh.getVertexCount());
     }
 }
+BENCHMARK(BM_LoadOBJ_Legacy)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
 
+static void BM_LoadOBJ(benchmark::State& state) {
+    const char* file = models[state.range(0)];
+    state.SetLabel(strrchr(file, '/') + 1);
+    for(auto _ : state) {
+        Mesh mesh = Mesh::loadFromFile(file);
+        benchmark::DoNotOptimize(mesh.getVertexCount());
+    }
 }
+BENCHMARK(BM_LoadOBJ)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+
+
+BENCHMARK_MAIN();
@@ -0,0 +1,77 @@
+/**
+ * @file mesh_optimize.cpp
+ * @brief Measures the vertex cache optimization of the bundled models
+ * 
+ * The triangles are read in the order of the .OBJ file and the average
+ * cache miss ratio (ACMR) is reported before and after Mesh::optimize().
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#include <rmg/mesh.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <rmg/config.h>
+
+using namespace rmg;
+
+
+static const char* models[] = {
+    RMG_RESOURCE_PATH "/models/dragon.obj",
+    RMG_RESOURCE_PATH "/models/happy_buddha.obj"
+};
+
+
+// Reads the triangles in the file order without welding or reordering
+static Mesh loadInFileOrder(const char* file) {
+    std::vector<Vec3> vertices;
+    std::vector<uint32_t> indices;
+    FILE* fp = fopen(file, "r");
+    if(fp == NULL)
+        return Mesh();
+    char line[256];
+    while(fgets(line, sizeof(line), fp) != NULL) {
+        Vec3 v;
+        uint32_t i[3];
+        if(sscanf(line, "v %f %f %f", &v.x, &v.y, &v.z) == 3) {
+            vertices.push_back(v);
+        }
+        else if(sscanf(line, "f %u %u %u", &i[0], &i[1], &i[2]) == 3) {
+            indices.push_back(i[0] - 1);
+            indices.push_back(i[1] - 1);
+            indices.push_back(i[2] - 1);
+        }
+    }
+    fclose(fp);
+    std::vector<Vec3> normals = std::vector<Vec3>(vertices.size());
+    return Mesh(&vertices[0], &normals[0], nullptr, vertices.size(),
+                &indices[0], indices.size());
+}
+
+
+static void BM_Optimize(benchmark::State& state) {
+    const char* file = models[state.range(0)];
+    state.SetLabel(strrchr(file, '/') + 1);
+    Mesh original = loadInFileOrder(file);
+    Mesh mesh;
+    for(auto _ : state) {
+        state.PauseTiming();
+        mesh = original;
+        state.ResumeTiming();
+        mesh.optimize();
+    }
+    state.counters["ACMR_before"] = original.getACMR();
+    state.counters["ACMR_after"] = mesh.getACMR();
+}
+BENCHMARK(BM_Optimize)->DenseRange(0, 1)->Unit(benchmark::kMillisecond);
+
+
+BENCHMARK_MAIN();
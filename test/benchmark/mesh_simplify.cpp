@@ -0,0 +1,52 @@
+/**
+ * @file mesh_simplify.cpp
+ * @brief Measures the simplification of the bundled models
+ * 
+ * Each model is reduced to a quarter and to a sixteenth of its triangles.
+ * The remaining triangles and the reported error are given as counters.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#include <rmg/mesh.hpp>
+
+#include <cstring>
+
+#include <benchmark/benchmark.h>
+
+#include <rmg/config.h>
+
+using namespace rmg;
+
+
+static const char* models[] = {
+    RMG_RESOURCE_PATH "/models/dragon.obj",
+    RMG_RESOURCE_PATH "/models/happy_buddha.obj"
+};
+
+
+static void BM_Simplify(benchmark::State& state) {
+    const char* file = models[state.range(0)];
+    float ratio = 1.0f / state.range(1);
+    state.SetLabel(strrchr(file, '/') + 1);
+    Mesh original = Mesh::loadFromFile(file);
+    Mesh mesh;
+    float error = 0;
+    for(auto _ : state) {
+        state.PauseTiming();
+        mesh = original;
+        state.ResumeTiming();
+        error = mesh.simplify(ratio);
+    }
+    state.counters["triangles_before"] = original.getPolygonCount();
+    state.counters["triangles_after"] = mesh.getPolygonCount();
+    state.counters["error"] = error;
+}
+BENCHMARK(BM_Simplify)->ArgsProduct({{0, 1}, {4, 16}})
+                      ->Unit(benchmark::kMillisecond);
+
+
+BENCHMARK_MAIN();
@@ -0,0 +1,80 @@
+/**
+ * @file shadow_kernel.cpp
+ * @brief Measures the fill rate cost of the shadow filter kernels
+ * 
+ * A floor filling the whole frame receives the shadows of a grid of boxes
+ * and is drawn offscreen for each kernel. The shadow map is kept from the
+ * first frame so that the frames only differ by the shading of the
+ * fragments. The frame size is the second argument.
+ * 
+ * @copyright Copyright (c) 2022 Khant Kyaw Khaung
+ * 
+ * @license{This project is released under the MIT License.}
+ */
+
+
+#include <rmg/offscreen.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <rmg/cube.hpp>
+
+using namespace rmg;
+
+
+static const ShadowKernel kernels[] = {
+    ShadowKernel::Single,
+    ShadowKernel::Box4,
+    ShadowKernel::Poisson9,
+    ShadowKernel::RotatedPoisson16
+};
+
+
+static void BM_ShadowKernel(benchmark::State& state) {
+    uint16_t height = state.range(1);
+    uint16_t width = height * 16 / 9;
+    OffscreenContext *ctx = new OffscreenContext(width, height);
+    if(ctx->getErrorCode() != 0) {
+        state.SkipWithError("Offscreen context could not be created");
+        delete ctx;
+        return;
+    }
+    
+    // Looks down at the floor so that every pixel samples the shadow map
+    ctx->setCameraTranslation(0, 0, 12);
+    ctx->setCameraRotation(Euler(0, radian(90), 0));
+    ctx->setPerspectiveProjection(radian(60), 1.0f, 30.0f);
+    ctx->setDirectionalLightAngles(Euler(0, 0.9f, 0.5f));
+    Object3D *floor = new Cube3D(ctx, 40, 40, 1);
+    floor->setTranslation(0, 0, -0.5f);
+    ctx->addObject(floor);
+    for(int i=0; i<8; i++) {
+        for(int j=0; j<8; j++) {
+            Object3D *box = new Cube3D(ctx, 0.8f, 0.8f, 2);
+            box->setTranslation(-7 + 2*i, -7 + 2*j, 1);
+            ctx->addObject(box);
+        }
+    }
+    ctx->setShadowKernel(kernels[state.range(0)]);
+    ctx->waitForLoads();
+    ctx->render();
+    
+    float gpuTime = 0;
+    for(auto _ : state) {
+        ctx->render();
+        gpuTime += ctx->getFrameStats().passes[(int)RenderPass::General]
+                   .gpuTime;
+    }
+    state.counters["general_gpu_ms"] = gpuTime / state.iterations();
+    state.counters["pixels"] = benchmark::Counter(
+        (double) width * height,
+        benchmark::Counter::kIsIterationInvariantRate
+    );
+    delete ctx;
+}
+BENCHMARK(BM_ShadowKernel)
+    ->ArgsProduct({{0, 1, 2, 3}, {1080, 2160}})
+    ->Unit(benchmark::kMillisecond);
+
+
+BENCHMARK_MAIN();
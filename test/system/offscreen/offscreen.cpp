@@ -0,0 +1,156 @@
+#include <rmg/offscreen.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+#include <rmg/config.h>
+#include <rmg/cube.hpp>
+#include <rmg/cylinder.hpp>
+#include <rmg/sphere.hpp>
+#include <rmg/text2d.hpp>
+
+#include "../../testconf.h"
+
+using namespace rmg;
+
+
+class TestOffscreen: public OffscreenContext {
+  private:
+    Object3D *floor, *cube, *cylinder, *sphere, *model;
+    
+  public:
+    TestOffscreen(uint16_t w, uint16_t h): OffscreenContext(w, h) {
+        setBackgroundColor(0.847f, 0.949f, 1.0f);
+        setCameraTranslation(-13.3606f, 6.3603f, 9.8690f);
+        setCameraRotation(Euler(0.0f, 0.5472f, -0.4640f));
+        setDirectionalLightAngles(Euler(0.0f, 0.87f, 0.52f));
+        setPerspectiveProjection(radian(45), 1.0f, 30.0f);
+        setDirectionalLightColor(1, 1, 1, 2);
+        
+        floor = new Cube3D(this, 15, 15, 1);
+        floor->setColor(0.3f, 0.3f, 0.4f);
+        floor->setRoughness(0.7f);
+        floor->setTranslation(0, 0, -0.5f);
+        cube = new Cube3D(this, 2, 3, 2);
+        cube->setColor(1.0f, 0, 0);
+        cube->setRoughness(0.5f);
+        cube->setTranslation(-4, 0, 2);
+        cylinder = new Cylinder3D(this, 2.4f, 3.0f);
+        cylinder->setColor(1.0f, 0, 0.8f);
+        cylinder->setRoughness(0.35f);
+        cylinder->setTranslation(2, -3.464f, 3);
+        sphere = new Sphere3D(this, 2.2f);
+        sphere->setColor(1.0f, 1.0f, 0);
+        sphere->setRoughness(0.7f);
+        sphere->setTranslation(-0.5f, -0.5f, 3);
+        model = new Object3D(this, RMG_RESOURCE_PATH "/models/dragon.obj");
+        model->setColor(0, 1.0f, 0.3f);
+        model->setRoughness(0.25f);
+        model->setTranslation(2, 3.464f, 3);
+        model->setScale(2.5f);
+        addObject(floor);
+        addObject(cube);
+        addObject(cylinder);
+        addObject(sphere);
+        addObject(model);
+        
+        // Markers sharing the same VBO are drawn as instances
+        Object3D *marker = new Sphere3D(this, 0.3f);
+        marker->setColor(0, 0.6f, 1.0f);
+        marker->setRoughness(0.5f);
+        for(int i=0; i<10; i++) {
+            for(int j=0; j<10; j++) {
+                Object3D *obj = (i+j == 0) ? marker : new Object3D(*marker);
+                obj->setTranslation(-6.75f + 1.5f*i, -6.75f + 1.5f*j, 0.3f);
+                addObject(obj);
+            }
+        }
+        
+        Font* ft = new Font(this, RMG_DEFAULT_FONT, 32);
+        addFont(ft);
+        addObject(new Text2D(this, ft, "Robot Monitor Graphics"));
+    }
+    
+    void update() override {
+        float t = getTime();
+        cube->setRotation(0.3f*t, -0.9f*t, -1.1f*t);
+        cylinder->setRotation(-0.5f, -0.9f*t, 1.8f*t);
+        sphere->setRotation(-1.0f, 0.8f*t, -1.2f*t);
+        model->setRotation(0, 0, 0.4f*t);
+    }
+};
+
+
+int main(int argc, char** argv) {
+    int frames = 100;
+    if(argc > 1)
+        frames = atoi(argv[1]);
+    
+    TestOffscreen *ctx = new TestOffscreen(768, 432);
+    if(ctx->getErrorCode() != 0) {
+        delete ctx;
+        exit(1);
+    }
+    
+    float t0 = 0;
+    try {
+        ctx->waitForLoads();
+        ctx->render();
+        t0 = ctx->getTime();
+        for(int i=1; i<frames; i++)
+            ctx->render();
+    }
+    catch(std::runtime_error& e) {
+        printf("%s", e.what());
+        delete ctx;
+        exit(1);
+    }
+    float dt = ctx->getTime() - t0;
+    if(frames > 1) {
+        printf("Rendered %d frames in %.3f s (%.2f ms/frame)\n",
+               frames-1, dt, 1000.0f*dt/(frames-1));
+    }
+    const char *passNames[RMG_RENDER_PASS_COUNT] = {
+        "Shadow map", "Picking", "Line 3D", "General", "Particle", "Object 2D"
+    };
+    const FrameStats &stats = ctx->getFrameStats();
+    for(int i=0; i<RMG_RENDER_PASS_COUNT; i++) {
+        const PassStats &pass = stats.passes[i];
+        printf("%-12s cpu %7.3f ms  gpu %7.3f ms  draws %4u  uniforms %5u\n",
+               passNames[i], pass.cpuTime, pass.gpuTime, pass.drawCalls,
+               pass.uniformUploads);
+    }
+    printf("Frame time p50 %.3f ms  p95 %.3f ms  p99 %.3f ms\n",
+           stats.p50, stats.p95, stats.p99);
+    ctx->getFrame().saveFile("offscreen.png");
+    
+    // Picks the yellow sphere under the screen point of its center
+    Rect s = ctx->worldToScreen(-0.5f, -0.5f, 3);
+    Vec3 p;
+    float t1 = ctx->getTime();
+    Object3D *obj = ctx->pick(s, &p);
+    float t2 = ctx->getTime();
+    if(obj != nullptr) {
+        printf("Picked (%u, %u) at (%.3f, %.3f, %.3f) in %.3f ms\n",
+               s.x, s.y, p.x, p.y, p.z, 1000.0f*(t2-t1));
+    }
+    
+    // The same point and the whole frame picked on the GPU. The results
+    // are read back by the frames after.
+    std::vector<Object*> objects;
+    ctx->requestPick(s);
+    for(int i=0; i<3 && !ctx->getPickResult(&objects); i++)
+        ctx->render();
+    if(objects.size() == 1 && objects[0] == obj)
+        printf("Picked (%u, %u) on the GPU\n", s.x, s.y);
+    ctx->requestPick(Rect(0, 0), Rect(767, 431));
+    for(int i=0; i<3 && !ctx->getPickResult(&objects); i++)
+        ctx->render();
+    printf("Box-selected %zu objects on the GPU\n", objects.size());
+    
+    int err = ctx->getErrorCode();
+    delete ctx;
+    exit(err);
+}
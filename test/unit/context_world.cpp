@@ -82,3 +82,31 @@ TEST(Context, directionalLightAngles) {
     EXPECT_NEAR(radian( 38.13f), rot.pitch, 0.0001f);
     EXPECT_NEAR(radian(120.33f), rot.yaw, 0.0001f);
 }
+
+
+
+
+/**
+ * @brief Screen to world coordinate test
+ * 
+ * The ray under the screen point of a world point passes through it and
+ * spans the camera's view from the near plane to the far plane.
+ */
+TEST(Context, screenToWorld) {
+    Context ctx = Context();
+    ctx.setContextSize(800, 600);
+    ctx.setCameraTranslation(-6, 2, 3);
+    ctx.setCameraRotation(0, 20, -15, AngleUnit::Degree);
+    
+    Vec3 p = Vec3(1.5f, 0.8f, 0.4f);
+    Rect s = ctx.worldToScreen(p);
+    LineEq ray = ctx.screenToWorld(s);
+    Vec3 d = ray.v * (1 / ray.v.magnitude());
+    Vec3 q = ray.P + Vec3::dot(p - ray.P, d) * d;
+    EXPECT_LT((p - q).magnitude(), 0.05f);
+    
+    Vec4 A = ctx.getCamera().getVPMatrix() * Vec4(ray.P, 1);
+    Vec4 B = ctx.getCamera().getVPMatrix() * Vec4(ray.P + ray.v, 1);
+    EXPECT_NEAR(-1, A.z / A.w, 0.001f);
+    EXPECT_NEAR(1, B.z / B.w, 0.001f);
+}
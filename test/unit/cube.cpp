@@ -19,3 +19,24 @@ TEST(Cube3D, constructor) {
     EXPECT_EQ(6.33f, dim.y);
     EXPECT_EQ(2.08f, dim.z);
 }
+
+
+/**
+ * @brief Cube3D mesh sharing test
+ */
+TEST(Cube3D, sharedMesh) {
+    Context ctx = Context();
+    Cube3D cube1 = Cube3D(&ctx, 1.0f, 2.0f, 4.0f);
+    Cube3D cube2 = Cube3D(&ctx, 0.5f, 1.0f, 2.0f);
+    Cube3D cube3 = Cube3D(&ctx, 1.0f, 1.0f, 1.0f);
+    EXPECT_EQ(cube1.getVBO(), cube2.getVBO());
+    EXPECT_NE(cube1.getVBO(), cube3.getVBO());
+    Vec3 scale = cube2.getScale();
+    EXPECT_EQ(1, scale.x);
+    EXPECT_EQ(1, scale.y);
+    EXPECT_EQ(1, scale.z);
+    Mat4 M = cube2.getModelMatrix();
+    EXPECT_EQ(0.5f, M[0][0]);
+    EXPECT_EQ(1.0f, M[1][1]);
+    EXPECT_EQ(2.0f, M[2][2]);
+}
@@ -1,6 +1,9 @@
 #include <rmg/internal/context_load.hpp>
 
+#include <chrono>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -21,6 +24,36 @@ class TestContextLoad: public ContextLoad {
 int TestContextLoad::loadedCount = 0;
 
 
+class TestSizedLoad: public ContextLoad {
+  public:
+    TestSizedLoad(int i, std::vector<int> *l): id(i), loaded(l) {}
+    ~TestSizedLoad() {}
+    
+    int id;
+    std::vector<int> *loaded;
+    
+    void load() override { loaded->push_back(id); }
+    uint64_t getUploadSize() const override { return 100; }
+};
+
+
+class TestFileLoad: public ContextLoad {
+  public:
+    TestFileLoad(): ContextLoad(false) {}
+    ~TestFileLoad() {}
+    
+    bool decoded = false;
+    bool loaded = false;
+    
+    void prepare() override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        decoded = true;
+    }
+    
+    void load() override { loaded = decoded; }
+};
+
+
 /**
  * @brief Context loader pending instance constructor test
  */
@@ -146,3 +179,101 @@ TEST(ContextLoader, load_empty) {
         ".*"
     );
 }
+
+
+
+
+/**
+ * @brief Context loader asynchronous preparation test
+ */
+TEST(ContextLoader, prepare) {
+    TestFileLoad *load1 = new TestFileLoad();
+    TestFileLoad *load2 = new TestFileLoad();
+    ContextLoad *load3 = new TestContextLoad();
+    ASSERT_FALSE(load1->isPrepared());
+    ASSERT_TRUE(load3->isPrepared());
+    
+    Pending p1 = Pending(load1);
+    Pending p2 = Pending(load2);
+    Pending p3 = Pending(load3);
+    
+    ContextLoader loader;
+    ASSERT_FLOAT_EQ(1.0f, loader.getProgress());
+    loader.push(p1);
+    loader.push(p2);
+    loader.push(p3);
+    ASSERT_EQ(3, loader.getLoadCount());
+    
+    // Loads being prepared stay in the list
+    loader.load();
+    ASSERT_LE(1, loader.getLoadCount());
+    ASSERT_GE(2, loader.getLoadCount());
+    ASSERT_LT(0.0f, loader.getProgress());
+    
+    loader.wait();
+    ASSERT_TRUE(load1->isPrepared());
+    ASSERT_TRUE(load2->isPrepared());
+    loader.load();
+    ASSERT_EQ(0, loader.getLoadCount());
+    ASSERT_FLOAT_EQ(1.0f, loader.getProgress());
+    ASSERT_TRUE(load1->loaded);
+    ASSERT_TRUE(load2->loaded);
+}
+
+
+
+
+/**
+ * @brief Context loader discarding unprepared loads test
+ */
+TEST(ContextLoader, prepare_discard) {
+    ContextLoader loader;
+    for(int i=0; i<16; i++) {
+        Pending p = Pending(new TestFileLoad());
+        loader.push(p);
+    }
+    ASSERT_EQ(16, loader.getLoadCount());
+    
+    // Every load is discarded once no worker thread is using it
+    for(int i=0; i<100 && loader.getLoadCount() > 0; i++) {
+        loader.load();
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    ASSERT_EQ(0, loader.getLoadCount());
+}
+
+
+
+
+/**
+ * @brief Context loader upload budget test
+ */
+TEST(ContextLoader, budget) {
+    std::vector<int> loaded;
+    std::vector<Pending> pendings;
+    ContextLoader loader;
+    for(int i=0; i<10; i++) {
+        pendings.push_back(Pending(new TestSizedLoad(i, &loaded)));
+        loader.push(pendings.back());
+    }
+    
+    // 3 loads of 100 bytes fit in the budget
+    loader.setBudget(0, 350);
+    loader.load();
+    ASSERT_EQ(7, loader.getLoadCount());
+    ASSERT_FLOAT_EQ(0.3f, loader.getProgress());
+    
+    // At least one load is done even if it exceeds the budget
+    loader.setBudget(0, 50);
+    loader.load();
+    ASSERT_EQ(6, loader.getLoadCount());
+    
+    loader.setBudget(0, 0);
+    loader.load();
+    ASSERT_EQ(0, loader.getLoadCount());
+    
+    // Loads are done in the order they are pushed
+    ASSERT_EQ(10, loaded.size());
+    for(int i=0; i<10; i++)
+        ASSERT_EQ(i, loaded[i]);
+}
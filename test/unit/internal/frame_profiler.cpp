@@ -0,0 +1,65 @@
+#include <rmg/internal/frame_profiler.hpp>
+
+#include <gtest/gtest.h>
+
+#include <rmg/internal/glcontext.hpp>
+
+using namespace rmg;
+using namespace rmg::internal;
+
+
+/**
+ * @brief Frame profiler counter test
+ * 
+ * Draw calls and uniform uploads are attributed to the pass they are made
+ * in and summed up for the whole frame.
+ */
+TEST(FrameProfiler, counters) {
+    FrameProfiler profiler;
+    profiler.beginFrame();
+    profiler.beginPass(RenderPass::ShadowMap);
+    drawCallCount += 3;
+    uniformUploadCount += 3;
+    profiler.endPass();
+    profiler.beginPass(RenderPass::General);
+    drawCallCount += 3;
+    uniformUploadCount += 27;
+    profiler.endPass();
+    profiler.beginPass(RenderPass::Object2D);
+    drawCallCount += 1;
+    profiler.endPass();
+    profiler.endFrame();
+    
+    const FrameStats &stats = profiler.getStats();
+    ASSERT_EQ(3, stats[RenderPass::ShadowMap].drawCalls);
+    ASSERT_EQ(3, stats[RenderPass::ShadowMap].uniformUploads);
+    ASSERT_EQ(3, stats[RenderPass::General].drawCalls);
+    ASSERT_EQ(27, stats[RenderPass::General].uniformUploads);
+    ASSERT_EQ(0, stats[RenderPass::Line3D].drawCalls);
+    ASSERT_EQ(1, stats[RenderPass::Object2D].drawCalls);
+    ASSERT_EQ(7, stats.drawCalls);
+    ASSERT_EQ(30, stats.uniformUploads);
+    ASSERT_EQ(1, stats.frameCount);
+    
+    // The counters are reset on the next frame
+    profiler.beginFrame();
+    ASSERT_EQ(0, stats.drawCalls);
+    ASSERT_EQ(0, stats[RenderPass::General].uniformUploads);
+}
+
+
+/**
+ * @brief Frame time percentile test
+ */
+TEST(FrameProfiler, percentiles) {
+    FrameProfiler profiler;
+    for(int i=0; i<50; i++) {
+        profiler.beginFrame();
+        profiler.endFrame();
+    }
+    const FrameStats &stats = profiler.getStats();
+    ASSERT_EQ(50, stats.frameCount);
+    ASSERT_LE(0.0f, stats.p50);
+    ASSERT_LE(stats.p50, stats.p95);
+    ASSERT_LE(stats.p95, stats.p99);
+}
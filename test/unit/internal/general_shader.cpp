@@ -6,13 +6,17 @@
 #include <rmg/config.h>
 #include <rmg/context.hpp>
 #include <rmg/cube.hpp>
+#include <rmg/internal/scene_bvh.hpp>
 
 using namespace rmg;
 using rmg::internal::glDeleteProgram;
 using rmg::internal::glDeleteShader;
 using rmg::internal::ContextLoader;
 using rmg::internal::GLContext;
+using rmg::internal::SceneBVH;
 using rmg::internal::Shader;
+using rmg::internal::ShaderPermutation;
+using rmg::internal::ShaderPermutations;
 
 
 class GeneralShader: public ::testing::Test {
@@ -63,6 +67,24 @@ TEST_F(GeneralShader, compileFrag) {
     glDeleteShader(id);
 }
 
+TEST_F(GeneralShader, compileShadowKernels) {
+    const char *defines[] = {
+        "#define SHADOW\n#define SHADOW_TAPS 1\n",
+        "#define SHADOW\n#define SHADOW_TAPS 4\n",
+        "#define SHADOW\n#define SHADOW_TAPS 9\n",
+        "#define SHADOW\n#define SHADOW_TAPS 16\n"
+    };
+    for(int i=0; i<4; i++) {
+        uint32_t id = Shader::compileShader(
+            GL_FRAGMENT_SHADER,
+            RMG_RESOURCE_PATH "/shaders/general.fs.glsl",
+            defines[i]
+        );
+        ASSERT_NE(0, id);
+        glDeleteShader(id);
+    }
+}
+
 TEST_F(GeneralShader, link) {
     uint32_t id = Shader::compileShaderProgram(
         RMG_RESOURCE_PATH "/shaders/general.vs.glsl",
@@ -72,6 +94,36 @@ TEST_F(GeneralShader, link) {
     glDeleteProgram(id);
 }
 
+TEST_F(GeneralShader, linkPermutations) {
+    ShaderPermutations programs = ShaderPermutations(
+        RMG_RESOURCE_PATH "/shaders/general.vs.glsl",
+        RMG_RESOURCE_PATH "/shaders/general.fs.glsl",
+        {"SHADOW", "TEXTURED", "COMPRESSED_NORMAL"},
+        {"V", "shadowVP"}
+    );
+    programs.setDefinitions("#define SHADOW_TAPS 9\n");
+    for(uint32_t key=0; key<8; key++) {
+        const ShaderPermutation &perm = programs.get(key);
+        ASSERT_NE(0, perm.program);
+        ASSERT_EQ(2, perm.uniforms.size());
+        EXPECT_NE(-1, perm.uniforms[0]);
+        if(key & 1)
+            EXPECT_NE(-1, perm.uniforms[1]);
+        else
+            EXPECT_EQ(-1, perm.uniforms[1]);
+    }
+    EXPECT_EQ(8, programs.getProgramCount());
+    
+    // Cached until the shared definitions change
+    uint32_t id = programs.get(1).program;
+    EXPECT_EQ(id, programs.get(1).program);
+    EXPECT_EQ(8, programs.getProgramCount());
+    programs.setDefinitions("#define SHADOW_TAPS 9\n");
+    EXPECT_EQ(8, programs.getProgramCount());
+    programs.setDefinitions("#define SHADOW_TAPS 4\n");
+    EXPECT_EQ(0, programs.getProgramCount());
+}
+
 
 /**
  * @brief General shader runtime test
@@ -93,12 +145,15 @@ TEST_F(GeneralShader, runtime) {
     loader.push(obj2->getVBOLoad());
     loader.push(obj3->getVBOLoad());
     loader.load();
-    ObjectList list;
-    list.push_front(obj1);
-    list.push_front(obj2);
-    list.push_front(obj3);
+    SceneBVH bvh;
+    bvh.insert(obj1);
+    bvh.insert(obj2);
+    bvh.insert(obj3);
+    bvh.update();
     
-    shader.render(Mat4(), Mat4(), Mat4(), Vec3(), Color(), 0, list);
+    Mat4 S[1];
+    shader.render(Mat4(), Mat4(), S, 1, Vec3(), Color(), 0, bvh);
+    EXPECT_LE(1, shader.getProgramCount());
     glfwSwapBuffers(window);
     glfwPollEvents();
     delete obj1;
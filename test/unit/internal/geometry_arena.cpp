@@ -0,0 +1,71 @@
+#include <rmg/internal/geometry_arena.hpp>
+
+#include <gtest/gtest.h>
+
+
+using rmg::internal::FreeList;
+
+
+/**
+ * @brief Free list allocation test
+ * 
+ * Allocations take the first range large enough.
+ */
+TEST(FreeList, allocate) {
+    FreeList list;
+    list.reset(100);
+    uint32_t a, b, c;
+    ASSERT_TRUE(list.allocate(30, &a));
+    ASSERT_TRUE(list.allocate(50, &b));
+    EXPECT_EQ(0, a);
+    EXPECT_EQ(30, b);
+    EXPECT_EQ(20, list.getFreeCount());
+    EXPECT_FALSE(list.allocate(21, &c));
+    ASSERT_TRUE(list.allocate(20, &c));
+    EXPECT_EQ(80, c);
+    EXPECT_EQ(0, list.getFreeCount());
+    EXPECT_EQ(0, list.getLargestBlock());
+}
+
+/**
+ * @brief Free list release test
+ * 
+ * Released ranges merge with the free ranges next to them.
+ */
+TEST(FreeList, release) {
+    FreeList list;
+    list.reset(100);
+    uint32_t a, b, c, d;
+    list.allocate(25, &a);
+    list.allocate(25, &b);
+    list.allocate(25, &c);
+    list.allocate(25, &d);
+    list.release(a, 25);
+    list.release(c, 25);
+    EXPECT_EQ(50, list.getFreeCount());
+    EXPECT_EQ(25, list.getLargestBlock());
+    EXPECT_FALSE(list.allocate(40, &a));
+    
+    list.release(b, 25);
+    EXPECT_EQ(75, list.getLargestBlock());
+    ASSERT_TRUE(list.allocate(75, &a));
+    EXPECT_EQ(0, a);
+}
+
+/**
+ * @brief Free list growth test
+ * 
+ * The new space merges with the free range at the end.
+ */
+TEST(FreeList, grow) {
+    FreeList list;
+    list.reset(100);
+    uint32_t a, b;
+    list.allocate(90, &a);
+    list.grow(200);
+    EXPECT_EQ(200, list.getCapacity());
+    EXPECT_EQ(110, list.getFreeCount());
+    EXPECT_EQ(110, list.getLargestBlock());
+    ASSERT_TRUE(list.allocate(110, &b));
+    EXPECT_EQ(90, b);
+}
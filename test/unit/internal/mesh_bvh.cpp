@@ -0,0 +1,108 @@
+#include <rmg/internal/mesh_bvh.hpp>
+
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+
+using rmg::LineEq;
+using rmg::Vec3;
+using rmg::internal::MeshBVH;
+
+
+/**
+ * @brief Triangle BVH ray query test
+ * 
+ * A stack of 64x64 grids at the heights 0, 1 and 2. Rays from above hit
+ * the top grid and rays from below hit the bottom one.
+ */
+TEST(MeshBVH, raycast) {
+    std::vector<Vec3> vertices;
+    std::vector<uint32_t> indices;
+    for(int z=0; z<3; z++) {
+        uint32_t base = vertices.size();
+        for(int y=0; y<=64; y++) {
+            for(int x=0; x<=64; x++)
+                vertices.push_back(Vec3(x, y, z));
+        }
+        for(int y=0; y<64; y++) {
+            for(int x=0; x<64; x++) {
+                uint32_t a = base + y*65 + x;
+                uint32_t b = a + 65;
+                uint32_t quad[6] = {a, a+1, b+1, a, b+1, b};
+                indices.insert(indices.end(), quad, quad + 6);
+            }
+        }
+    }
+    MeshBVH bvh = MeshBVH(vertices.data(), vertices.size(), indices.data(),
+                          indices.size());
+    EXPECT_FALSE(bvh.isBuilt());
+    EXPECT_EQ(3*64*64*2, bvh.getTriangleCount());
+    
+    float t;
+    ASSERT_TRUE(bvh.raycast(LineEq(Vec3(10.3f, 20.7f, 5), Vec3(0, 0, -1)),
+                            100, &t));
+    EXPECT_TRUE(bvh.isBuilt());
+    EXPECT_FLOAT_EQ(3, t);
+    ASSERT_TRUE(bvh.raycast(LineEq(Vec3(50.5f, 3.2f, -2), Vec3(0, 0, 2)),
+                            100, &t));
+    EXPECT_FLOAT_EQ(1, t);
+    
+    // Slanted ray through the middle grid from between the others
+    ASSERT_TRUE(bvh.raycast(LineEq(Vec3(30, 30, 1.5f), Vec3(1, 1, -1)),
+                            100, &t));
+    EXPECT_FLOAT_EQ(0.5f, t);
+    
+    // Beyond the limit, outside the grids and parallel to them
+    EXPECT_FALSE(bvh.raycast(LineEq(Vec3(10, 10, 5), Vec3(0, 0, -1)),
+                             2, &t));
+    EXPECT_FALSE(bvh.raycast(LineEq(Vec3(70, 10, 5), Vec3(0, 0, -1)),
+                             100, &t));
+    EXPECT_FALSE(bvh.raycast(LineEq(Vec3(-5, 10, 0.5f), Vec3(1, 0, 0)),
+                             100, &t));
+}
+
+/**
+ * @brief Triangle BVH of unindexed vertices test
+ * 
+ * Every three vertices form a triangle.
+ */
+TEST(MeshBVH, unindexed) {
+    Vec3 vertices[] = {
+        Vec3(0, 0, 0), Vec3(1, 0, 0), Vec3(0, 1, 0),
+        Vec3(0, 0, 4), Vec3(1, 0, 4), Vec3(0, 1, 4)
+    };
+    MeshBVH bvh = MeshBVH(vertices, 6, nullptr, 0);
+    EXPECT_EQ(2, bvh.getTriangleCount());
+    float t;
+    ASSERT_TRUE(bvh.raycast(LineEq(Vec3(0.2f, 0.2f, 10), Vec3(0, 0, -1)),
+                            100, &t));
+    EXPECT_FLOAT_EQ(6, t);
+    EXPECT_FALSE(bvh.raycast(LineEq(Vec3(0.8f, 0.8f, 10), Vec3(0, 0, -1)),
+                             100, &t));
+}
+
+/**
+ * @brief Triangle BVH taking over a mesh test
+ * 
+ * The triangles are taken out of the mesh by the first ray query.
+ */
+TEST(MeshBVH, mesh) {
+    Vec3 vertices[] = {
+        Vec3(0, 0, 0), Vec3(1, 0, 0), Vec3(0, 1, 0), Vec3(1, 1, 0)
+    };
+    Vec3 normals[] = {
+        Vec3(0, 0, 1), Vec3(0, 0, 1), Vec3(0, 0, 1), Vec3(0, 0, 1)
+    };
+    uint32_t indices[] = {0, 1, 3, 0, 3, 2};
+    rmg::Mesh mesh = rmg::Mesh(vertices, normals, nullptr, 4, indices, 6);
+    MeshBVH bvh = MeshBVH(std::move(mesh));
+    EXPECT_EQ(2, bvh.getTriangleCount());
+    float t;
+    ASSERT_TRUE(bvh.raycast(LineEq(Vec3(0.8f, 0.6f, 2), Vec3(0, 0, -1)),
+                            100, &t));
+    EXPECT_TRUE(bvh.isBuilt());
+    EXPECT_FLOAT_EQ(2, t);
+    EXPECT_EQ(2, bvh.getTriangleCount());
+}
@@ -0,0 +1,56 @@
+#include <rmg/internal/parallel_for.hpp>
+
+#include <atomic>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+
+using namespace rmg::internal;
+
+
+/**
+ * @brief Parallel loop range splitting test
+ * 
+ * Every iteration runs exactly once whatever the number of threads is.
+ */
+TEST(ParallelFor, ranges) {
+    std::vector<std::atomic<int>> visits(1000);
+    parallelFor(1000, 10, [&visits](size_t b, size_t e) {
+        for(size_t i=b; i<e; i++)
+            visits[i]++;
+    });
+    for(size_t i=0; i<1000; i++)
+        ASSERT_EQ(1, visits[i]);
+    
+    int calls = 0;
+    parallelFor(5, 100, [&calls](size_t b, size_t e) {
+        ASSERT_EQ(0, b);
+        ASSERT_EQ(5, e);
+        calls++;
+    });
+    ASSERT_EQ(1, calls);
+    
+    parallelFor(0, 1, [&calls](size_t b, size_t e) { calls++; });
+    ASSERT_EQ(1, calls);
+}
+
+/**
+ * @brief Nested parallel loop test
+ * 
+ * Loops run inside the ranges of another loop finish even when all the
+ * threads of the pool are busy with the outer loop.
+ */
+TEST(ParallelFor, nested) {
+    std::vector<std::atomic<int>> visits(64 * 1000);
+    parallelFor(64, 1, [&visits](size_t b, size_t e) {
+        for(size_t i=b; i<e; i++) {
+            parallelFor(1000, 10, [&visits, i](size_t b2, size_t e2) {
+                for(size_t j=b2; j<e2; j++)
+                    visits[i*1000 + j]++;
+            });
+        }
+    });
+    for(size_t i=0; i<visits.size(); i++)
+        ASSERT_EQ(1, visits[i]);
+}
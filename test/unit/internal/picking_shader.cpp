@@ -0,0 +1,155 @@
+#include <rmg/internal/picking_shader.hpp>
+
+#include <GLFW/glfw3.h>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <rmg/config.h>
+#include <rmg/context.hpp>
+#include <rmg/cube.hpp>
+#include <rmg/line3d.hpp>
+#include <rmg/internal/line3d_shader.hpp>
+#include <rmg/internal/particle_shader.hpp>
+#include <rmg/internal/scene_bvh.hpp>
+
+using namespace rmg;
+using rmg::internal::glDeleteProgram;
+using rmg::internal::glDeleteShader;
+using rmg::internal::ContextLoader;
+using rmg::internal::GLContext;
+using rmg::internal::SceneBVH;
+using rmg::internal::Shader;
+
+
+class PickingShader: public ::testing::Test {
+  protected:
+    GLFWwindow* window;
+    GLContext glContext;
+    
+    virtual void SetUp() {
+        if(!glfwInit())
+            return;
+        glfwWindowHint(GLFW_SAMPLES, 4);
+        window = glfwCreateWindow(300, 200, "Context", NULL, NULL);
+        if(!window)
+            return;
+        glfwMakeContextCurrent(window);
+        if(glContext.init() != 0) {
+            glfwDestroyWindow(window);
+            return;
+        }
+    }
+    
+    virtual void TearDown() {
+        glfwTerminate();
+    }
+};
+
+
+/**
+ * @brief Picking shader compilation and linking test
+ * 
+ * Checks compile timer error
+ */
+TEST_F(PickingShader, compileVertex) {
+    uint32_t id = Shader::compileShader(
+        GL_VERTEX_SHADER,
+        RMG_RESOURCE_PATH "/shaders/picking.vs.glsl"
+    );
+    ASSERT_NE(0, id);
+    glDeleteShader(id);
+}
+
+TEST_F(PickingShader, compileFrag) {
+    uint32_t id = Shader::compileShader(
+        GL_FRAGMENT_SHADER,
+        RMG_RESOURCE_PATH "/shaders/picking.fs.glsl"
+    );
+    ASSERT_NE(0, id);
+    glDeleteShader(id);
+}
+
+TEST_F(PickingShader, link) {
+    uint32_t id = Shader::compileShaderProgram(
+        RMG_RESOURCE_PATH "/shaders/picking.vs.glsl",
+        RMG_RESOURCE_PATH "/shaders/picking.fs.glsl"
+    );
+    ASSERT_NE(0, id);
+    glDeleteProgram(id);
+    id = Shader::compileShaderProgram(
+        RMG_RESOURCE_PATH "/shaders/particle.vs.glsl",
+        RMG_RESOURCE_PATH "/shaders/picking.fs.glsl"
+    );
+    ASSERT_NE(0, id);
+    glDeleteProgram(id);
+}
+
+
+/**
+ * @brief Picking shader readback test
+ * 
+ * A cube covers the center of the screen and a line lies across its left
+ * side. The IDs are read back by one of the renders after the request. A
+ * request outside the screen gives no IDs.
+ */
+TEST_F(PickingShader, readback) {
+    auto shader = rmg::internal::PickingShader();
+    auto lineShader = rmg::internal::Line3DShader();
+    auto particleShader = rmg::internal::ParticleShader();
+    shader.load();
+    lineShader.load();
+    particleShader.load();
+    
+    Context ctx;
+    ContextLoader loader;
+    Object3D *cube = new Cube3D(&ctx, 1, 1, 1);
+    loader.push(cube->getVBOLoad());
+    loader.load();
+    SceneBVH bvh;
+    bvh.insert(cube);
+    bvh.update();
+    Line3D *line = new Line3D(&ctx, 0.1f);
+    line->setPoints(Vec3(-0.75f, -0.9f, 0), Vec3(-0.75f, 0.9f, 0));
+    ObjectList lines;
+    lines.push_front(line);
+    ObjectList particles;
+    
+    std::vector<uint64_t> ids;
+    auto render = [&]() {
+        for(int i=0; i<10 && !shader.getResult(&ids); i++) {
+            shader.render(Mat4(), Mat4(), 300, 200, bvh, lines, particles,
+                          lineShader, particleShader);
+            glFinish();
+        }
+    };
+    
+    shader.request(150, 100, 1, 1);
+    EXPECT_TRUE(shader.isRequested());
+    render();
+    EXPECT_FALSE(shader.isRequested());
+    ASSERT_EQ(1, ids.size());
+    EXPECT_EQ(cube->getID(), ids[0]);
+    
+    // Box over the line and the cube
+    shader.request(0, 0, 300, 200);
+    render();
+    ASSERT_EQ(2, ids.size());
+    EXPECT_EQ(cube->getID(), ids[0]);
+    EXPECT_EQ(line->getID(), ids[1]);
+    
+    // Nothing in the corner
+    shader.request(0, 0, 10, 10);
+    render();
+    EXPECT_EQ(0, ids.size());
+    
+    // Outside the screen
+    ids.push_back(cube->getID());
+    shader.request(300, 50, 1, 1);
+    render();
+    EXPECT_FALSE(shader.isRequested());
+    EXPECT_EQ(0, ids.size());
+    
+    delete cube;
+    delete line;
+}
@@ -0,0 +1,111 @@
+#include <rmg/internal/program_cache.hpp>
+
+#include <GLFW/glfw3.h>
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+
+#include <rmg/config.h>
+#include <rmg/internal/shader.hpp>
+
+#include "../../testconf.h"
+
+using rmg::internal::glDeleteProgram;
+using rmg::internal::GLContext;
+using rmg::internal::Shader;
+using rmg::internal::ShaderProgramBuild;
+
+
+#define VERTEX_SHADER RMG_RESOURCE_PATH "/shaders/line3d.vs.glsl"
+#define FRAGMENT_SHADER RMG_RESOURCE_PATH "/shaders/line3d.fs.glsl"
+
+
+class ProgramCache: public ::testing::Test {
+  protected:
+    GLFWwindow* window;
+    GLContext glContext;
+    
+    virtual void SetUp() {
+        if(!glfwInit())
+            return;
+        window = glfwCreateWindow(300, 200, "Context", NULL, NULL);
+        if(!window)
+            return;
+        glfwMakeContextCurrent(window);
+        if(glContext.init() != 0) {
+            glfwDestroyWindow(window);
+            return;
+        }
+        rmg::internal::ProgramCache::setDirectory(
+            RMGTEST_OUTPUT_PATH "/program_cache"
+        );
+    }
+    
+    virtual void TearDown() {
+        rmg::internal::ProgramCache::setDirectory("");
+        glfwTerminate();
+    }
+};
+
+
+/**
+ * @brief Program key test
+ * 
+ * The key changes with the sources and the definitions.
+ */
+TEST_F(ProgramCache, key) {
+    using rmg::internal::ProgramCache;
+    uint64_t key = ProgramCache::getKey("vert", "frag", nullptr);
+    EXPECT_EQ(key, ProgramCache::getKey("vert", "frag", nullptr));
+    EXPECT_NE(key, ProgramCache::getKey("vert", "frag", "#define A\n"));
+    EXPECT_NE(key, ProgramCache::getKey("vert", "frag2", nullptr));
+    EXPECT_NE(key, ProgramCache::getKey("verf", "rag", nullptr));
+}
+
+
+/**
+ * @brief Storing and loading program binaries test
+ * 
+ * A program linked once is loaded from its binary the next time. A broken
+ * binary is deleted and the program is compiled again.
+ */
+TEST_F(ProgramCache, storeLoad) {
+    using rmg::internal::ProgramCache;
+    if(!ProgramCache::isSupported())
+        return;
+    
+    ShaderProgramBuild build = Shader::beginShaderProgram(VERTEX_SHADER,
+                                                          FRAGMENT_SHADER);
+    uint32_t id = Shader::finishShaderProgram(build);
+    ASSERT_NE(0, id);
+    glDeleteProgram(id);
+    
+    build = Shader::beginShaderProgram(VERTEX_SHADER, FRAGMENT_SHADER);
+    EXPECT_EQ(0, build.vertexShader);
+    id = Shader::finishShaderProgram(build);
+    ASSERT_NE(0, id);
+    glDeleteProgram(id);
+    
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.bin",
+             (unsigned long long) build.key);
+    std::string file = ProgramCache::getDirectory() + name;
+    FILE* fp = fopen(file.c_str(), "r+b");
+    ASSERT_NE(nullptr, fp);
+    fseek(fp, 24, SEEK_SET);
+    for(int i=0; i<64; i++)
+        fputc(0xAA, fp);
+    fclose(fp);
+    EXPECT_EQ(0, ProgramCache::load(build.key));
+    
+    build = Shader::beginShaderProgram(VERTEX_SHADER, FRAGMENT_SHADER);
+    EXPECT_NE(0, build.vertexShader);
+    id = Shader::finishShaderProgram(build);
+    ASSERT_NE(0, id);
+    glDeleteProgram(id);
+    EXPECT_NE(0, ProgramCache::load(build.key));
+    
+    ProgramCache::setDirectory("");
+    EXPECT_FALSE(ProgramCache::isSupported());
+}
@@ -0,0 +1,211 @@
+#include <rmg/internal/scene_bvh.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <rmg/cube.hpp>
+
+
+using rmg::BVHQuality;
+using rmg::Cube3D;
+using rmg::Frustum;
+using rmg::LineEq;
+using rmg::Mat4;
+using rmg::Object3D;
+using rmg::Vec3;
+using rmg::internal::SceneBVH;
+
+
+class SceneBVHTest: public ::testing::Test {
+  protected:
+    std::vector<Object3D*> objects;
+    
+    virtual void SetUp() {
+        // A row of unit cubes along the x-axis at every 3 units
+        for(int i=0; i<16; i++) {
+            Object3D *obj = new Cube3D(nullptr, 1, 1, 1);
+            obj->setTranslation(3.0f * i, 0, 0);
+            objects.push_back(obj);
+        }
+    }
+    
+    virtual void TearDown() {
+        for(auto it=objects.begin(); it!=objects.end(); it++)
+            delete *it;
+    }
+    
+    static std::vector<Object3D*> query(const SceneBVH &bvh,
+                                        const Frustum &frustum)
+    {
+        std::vector<Object3D*> res;
+        bvh.query(frustum, [&](Object3D *obj) { res.push_back(obj); });
+        std::sort(res.begin(), res.end());
+        return res;
+    }
+};
+
+
+/**
+ * @brief Scene BVH frustum query test
+ * 
+ * The identity matrix bounds the cube of -1 to 1 which only contains the
+ * first object.
+ */
+TEST_F(SceneBVHTest, query) {
+    SceneBVH bvh;
+    for(auto it=objects.begin(); it!=objects.end(); it++)
+        bvh.insert(*it);
+    EXPECT_EQ(0, bvh.getObjectCount());
+    bvh.update();
+    EXPECT_EQ(16, bvh.getObjectCount());
+    
+    auto res = query(bvh, Frustum(Mat4()));
+    ASSERT_EQ(1, res.size());
+    EXPECT_EQ(objects[0], res[0]);
+}
+
+/**
+ * @brief Scene BVH refit test
+ * 
+ * Moving an object updates its place in the tree by the next update.
+ */
+TEST_F(SceneBVHTest, refit) {
+    SceneBVH bvh;
+    for(auto it=objects.begin(); it!=objects.end(); it++)
+        bvh.insert(*it);
+    bvh.update();
+    
+    objects[0]->setTranslation(100, 0, 0);
+    objects[5]->setTranslation(0.5f, 0, 0);
+    bvh.update();
+    auto res = query(bvh, Frustum(Mat4()));
+    ASSERT_EQ(1, res.size());
+    EXPECT_EQ(objects[5], res[0]);
+    
+    objects[1]->setScale(10);
+    bvh.update();
+    res = query(bvh, Frustum(Mat4()));
+    EXPECT_EQ(2, res.size());
+}
+
+/**
+ * @brief Scene BVH removal test
+ * 
+ * The deleted objects leave the tree.
+ */
+TEST_F(SceneBVHTest, remove) {
+    SceneBVH bvh;
+    for(auto it=objects.begin(); it!=objects.end(); it++)
+        bvh.insert(*it);
+    bvh.update();
+    
+    bvh.remove(objects[0]);
+    delete objects[1];
+    objects.erase(objects.begin() + 1);
+    bvh.update();
+    EXPECT_EQ(14, bvh.getObjectCount());
+    EXPECT_EQ(0, query(bvh, Frustum(Mat4())).size());
+    
+    bvh.insert(objects[0]);
+    bvh.update();
+    EXPECT_EQ(15, bvh.getObjectCount());
+    EXPECT_EQ(1, query(bvh, Frustum(Mat4())).size());
+}
+
+/**
+ * @brief Scene BVH ray query test
+ * 
+ * The objects are visited from the nearest and the hit distance returned
+ * stops the query.
+ */
+TEST_F(SceneBVHTest, raycast) {
+    SceneBVH bvh;
+    for(auto it=objects.begin(); it!=objects.end(); it++)
+        bvh.insert(*it);
+    bvh.update();
+    
+    LineEq ray;
+    ray.P = Vec3(-10, 0, 0);
+    ray.v = Vec3(1, 0, 0);
+    std::vector<Object3D*> hits;
+    bvh.raycast(ray, 1000, [&](Object3D *obj, float t) {
+        hits.push_back(obj);
+        return 1000.0f;
+    });
+    ASSERT_EQ(16, hits.size());
+    for(int i=0; i<16; i++)
+        EXPECT_EQ(objects[i], hits[i]);
+    
+    // Stops at the first hit
+    hits.clear();
+    bvh.raycast(ray, 1000, [&](Object3D *obj, float t) {
+        hits.push_back(obj);
+        return t;
+    });
+    ASSERT_EQ(1, hits.size());
+    EXPECT_EQ(objects[0], hits[0]);
+    
+    // Misses the row
+    ray.P = Vec3(-10, 5, 0);
+    hits.clear();
+    bvh.raycast(ray, 1000, [&](Object3D *obj, float t) {
+        hits.push_back(obj);
+        return 1000.0f;
+    });
+    EXPECT_EQ(0, hits.size());
+}
+
+/**
+ * @brief Scene BVH rebuild test
+ * 
+ * Every build quality gives the same query results.
+ */
+TEST_F(SceneBVHTest, rebuild) {
+    BVHQuality qualities[] = {
+        BVHQuality::Fast, BVHQuality::Medium, BVHQuality::High
+    };
+    for(int i=0; i<3; i++) {
+        SceneBVH bvh;
+        bvh.setQuality(qualities[i]);
+        for(auto it=objects.begin(); it!=objects.end(); it++)
+            bvh.insert(*it);
+        bvh.update();
+        bvh.rebuild();
+        EXPECT_EQ(16, bvh.getObjectCount());
+        EXPECT_GT(bvh.getCost(), 0);
+        auto res = query(bvh, Frustum(Mat4()));
+        ASSERT_EQ(1, res.size());
+        EXPECT_EQ(objects[0], res[0]);
+    }
+}
+
+/**
+ * @brief Scene BVH revision test
+ * 
+ * The revision stays the same through the updates without any change to
+ * the objects.
+ */
+TEST_F(SceneBVHTest, revision) {
+    SceneBVH bvh;
+    for(auto it=objects.begin(); it!=objects.end(); it++)
+        bvh.insert(*it);
+    bvh.update();
+    uint64_t rev = bvh.getRevision();
+    bvh.update();
+    EXPECT_EQ(rev, bvh.getRevision());
+    
+    objects[2]->setTranslation(0, 5, 0);
+    bvh.update();
+    EXPECT_NE(rev, bvh.getRevision());
+    rev = bvh.getRevision();
+    
+    objects[3]->setHidden(true);
+    bvh.update();
+    EXPECT_NE(rev, bvh.getRevision());
+    rev = bvh.getRevision();
+    
+    bvh.remove(objects[4]);
+    EXPECT_NE(rev, bvh.getRevision());
+}
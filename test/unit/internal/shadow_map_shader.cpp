@@ -6,12 +6,14 @@
 #include <rmg/config.h>
 #include <rmg/context.hpp>
 #include <rmg/cube.hpp>
+#include <rmg/internal/scene_bvh.hpp>
 
 using namespace rmg;
 using rmg::internal::glDeleteProgram;
 using rmg::internal::glDeleteShader;
 using rmg::internal::ContextLoader;
 using rmg::internal::GLContext;
+using rmg::internal::SceneBVH;
 using rmg::internal::Shader;
 
 
@@ -93,16 +95,78 @@ TEST_F(ShadowMapShader, runtime) {
     loader.push(obj2->getVBOLoad());
     loader.push(obj3->getVBOLoad());
     loader.load();
-    ObjectList list;
-    list.push_front(obj1);
-    list.push_front(obj2);
-    list.push_front(obj3);
+    SceneBVH bvh;
+    bvh.insert(obj1);
+    bvh.insert(obj2);
+    bvh.insert(obj3);
+    bvh.update();
     
-    uint32_t res = shader.createShadowMap(list);
-    EXPECT_NE(0, res);
+    Camera camera;
+    camera.setTranslation(-8, 0, 2);
+    camera.setPerspectiveProjection(1.0f, 1.0f, 40.0f);
+    for(uint32_t n=1; n<=RMG_SHADOW_CASCADE_MAX; n++) {
+        shader.setCascadeCount(n);
+        uint32_t res = shader.createShadowMap(camera, bvh);
+        EXPECT_NE(0, res);
+    }
+    // Kept while nothing has changed
+    uint32_t res = shader.createShadowMap(camera, bvh);
+    EXPECT_EQ(res, shader.createShadowMap(camera, bvh));
     glfwSwapBuffers(window);
     glfwPollEvents();
     delete obj1;
     delete obj2;
     delete obj3;
 }
+
+
+/**
+ * @brief Deferred upload test
+ * 
+ * The objects placed in the tree before their uploads change the revision
+ * when they are uploaded so that the shadow map is drawn again with them.
+ */
+TEST_F(ShadowMapShader, deferredUpload) {
+    Context ctx;
+    ContextLoader loader;
+    loader.setBudget(0, 1);
+    Object3D *obj1 = new Cube3D(&ctx, 1, 1, 1);
+    Object3D *obj2 = new Cube3D(&ctx, 2.2f, 1.5f, 1.5f);
+    loader.push(obj1->getVBOLoad());
+    loader.push(obj2->getVBOLoad());
+    SceneBVH bvh;
+    bvh.insert(obj1);
+    bvh.insert(obj2);
+    bvh.update();
+    EXPECT_EQ(2, bvh.getObjectCount());
+    
+    uint64_t rev = bvh.getRevision();
+    bvh.update();
+    EXPECT_EQ(rev, bvh.getRevision());
+    for(int i=0; i<2; i++) {
+        loader.load();
+        bvh.update();
+        EXPECT_NE(rev, bvh.getRevision());
+        rev = bvh.getRevision();
+    }
+    bvh.update();
+    EXPECT_EQ(rev, bvh.getRevision());
+    delete obj1;
+    delete obj2;
+}
+
+
+/**
+ * @brief Shadow map settings test
+ * 
+ * The number of cascades is kept within the limits.
+ */
+TEST_F(ShadowMapShader, settings) {
+    auto shader = rmg::internal::ShadowMapShader();
+    shader.setResolution(512);
+    EXPECT_EQ(512, shader.getResolution());
+    shader.setCascadeCount(0);
+    EXPECT_EQ(1, shader.getCascadeCount());
+    shader.setCascadeCount(RMG_SHADOW_CASCADE_MAX + 2);
+    EXPECT_EQ(RMG_SHADOW_CASCADE_MAX, shader.getCascadeCount());
+}
@@ -2,14 +2,21 @@
 
 #include <rmg/internal/glcontext.hpp>
 
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
 #include <GLFW/glfw3.h>
 
 #include <gtest/gtest.h>
 
+#include "../../testconf.h"
+
 
 using rmg::Mesh;
 using rmg::Vec3;
 using rmg::Vec2;
+using rmg::internal::GeometryPool;
 using rmg::internal::GLContext;
 
 
@@ -17,6 +24,7 @@ class VBO: public ::testing::Test {
   protected:
     GLFWwindow* window;
     GLContext glContext;
+    GeometryPool geometry;
     Mesh mesh1;
     Mesh mesh2;
     
@@ -42,6 +50,7 @@ class VBO: public ::testing::Test {
     }
     
     virtual void TearDown() {
+        geometry.clear();
         glfwTerminate();
     }
 };
@@ -106,8 +115,8 @@ const uint32_t VBO::indices[24] = {
 TEST_F(VBO, load) {
     ASSERT_NE(nullptr, window);
     rmg::internal::VBO vbo1, vbo2;
-    rmg::internal::VBOLoad vboLoad1(&vbo1, mesh1);
-    rmg::internal::VBOLoad vboLoad2(&vbo2, mesh2);
+    rmg::internal::VBOLoad vboLoad1(&vbo1, &geometry, mesh1);
+    rmg::internal::VBOLoad vboLoad2(&vbo2, &geometry, mesh2);
     vboLoad1.load();
     vboLoad2.load();
     EXPECT_EQ(rmg::internal::VBOMode::Default, vbo1.getMode());
@@ -120,8 +129,8 @@ TEST_F(VBO, load) {
 TEST_F(VBO, draw) {
     ASSERT_NE(nullptr, window);
     rmg::internal::VBO vbo1, vbo2;
-    rmg::internal::VBOLoad vboLoad1(&vbo1, mesh1);
-    rmg::internal::VBOLoad vboLoad2(&vbo2, mesh2);
+    rmg::internal::VBOLoad vboLoad1(&vbo1, &geometry, mesh1);
+    rmg::internal::VBOLoad vboLoad2(&vbo2, &geometry, mesh2);
     vboLoad1.load();
     vboLoad2.load();
     vbo1.draw();
@@ -130,3 +139,200 @@ TEST_F(VBO, draw) {
     glfwPollEvents();
     glfwDestroyWindow(window);
 }
+
+TEST_F(VBO, uploadSize) {
+    ASSERT_NE(nullptr, window);
+    rmg::internal::VBO vbo1, vbo2;
+    rmg::internal::VBOLoad vboLoad1(&vbo1, &geometry, mesh2, true);
+    rmg::internal::VBOLoad vboLoad2(&vbo2, &geometry, mesh2, false);
+    EXPECT_EQ((uint64_t)(8*16 + 8*16 + 2*24), vboLoad1.getUploadSize());
+    EXPECT_EQ((uint64_t)(12*16 + 20*16 + 2*24), vboLoad2.getUploadSize());
+    glfwDestroyWindow(window);
+}
+
+TEST_F(VBO, compressed) {
+    ASSERT_NE(nullptr, window);
+    rmg::internal::VBO vbo1, vbo2;
+    rmg::internal::VBOLoad vboLoad1(&vbo1, &geometry, mesh2, true);
+    rmg::internal::VBOLoad vboLoad2(&vbo2, &geometry, mesh2, false);
+    vboLoad1.load();
+    vboLoad2.load();
+    EXPECT_TRUE(vbo1.isCompressed());
+    EXPECT_FALSE(vbo2.isCompressed());
+    EXPECT_EQ(Vec3(-0.5f, -0.5f, -0.5f), vbo1.getPositionOffset());
+    EXPECT_EQ(Vec3(1, 1, 1), vbo1.getPositionScale());
+    EXPECT_EQ(Vec3(0, 0, 0), vbo2.getPositionOffset());
+    EXPECT_EQ(Vec3(1, 1, 1), vbo2.getPositionScale());
+    
+    rmg::Mat4 M = vbo1.getPositionMatrix();
+    EXPECT_FLOAT_EQ(1.0f, M[0][0]);
+    EXPECT_FLOAT_EQ(-0.5f, M[0][3]);
+    EXPECT_FLOAT_EQ(-0.5f, M[2][3]);
+    vbo1.drawPositions();
+    vbo2.drawPositions();
+    glfwSwapBuffers(window);
+    glfwPollEvents();
+    glfwDestroyWindow(window);
+}
+
+TEST_F(VBO, sharedArena) {
+    ASSERT_NE(nullptr, window);
+    rmg::internal::VBO vbo1, vbo2, vbo3;
+    rmg::internal::VBOLoad vboLoad1(&vbo1, &geometry, mesh1);
+    rmg::internal::VBOLoad vboLoad2(&vbo2, &geometry, mesh1);
+    rmg::internal::VBOLoad vboLoad3(&vbo3, &geometry, mesh2);
+    vboLoad1.load();
+    vboLoad2.load();
+    vboLoad3.load();
+    EXPECT_EQ(vbo1.getArena(), vbo2.getArena());
+    EXPECT_NE(vbo1.getArena(), vbo3.getArena());
+    EXPECT_EQ(0, vbo1.getRange().vertexOffset);
+    EXPECT_EQ(16, vbo2.getRange().vertexOffset);
+    EXPECT_EQ(24, vbo2.getRange().indexOffset);
+    vbo1.draw();
+    vbo2.draw();
+    glfwSwapBuffers(window);
+    glfwPollEvents();
+    glfwDestroyWindow(window);
+}
+
+TEST_F(VBO, levelsOfDetail) {
+    ASSERT_NE(nullptr, window);
+    rmg::internal::VBO vbo;
+    std::vector<rmg::internal::LevelOfDetail> lods = {
+        {mesh2, 0.0f},
+        {mesh2, 0.1f},
+        {mesh2, 0.4f}
+    };
+    rmg::internal::VBOLoad vboLoad(&vbo, &geometry, lods);
+    vboLoad.load();
+    EXPECT_EQ(3, vbo.getLevelCount());
+    EXPECT_FLOAT_EQ(0.4f, vbo.getLevelError(2));
+    EXPECT_EQ(0, vbo.selectLevel(0.05f, 0));
+    EXPECT_EQ(1, vbo.selectLevel(0.2f, 0));
+    EXPECT_EQ(2, vbo.selectLevel(1.0f, 0));
+    
+    // A level is kept until the error is well below the limit
+    EXPECT_EQ(1, vbo.selectLevel(0.5f, 1));
+    EXPECT_EQ(1, vbo.selectLevel(0.12f, 1));
+    EXPECT_EQ(0, vbo.selectLevel(0.09f, 1));
+    vbo.draw(2);
+    vbo.drawPositions(1);
+    glfwSwapBuffers(window);
+    glfwPollEvents();
+    glfwDestroyWindow(window);
+}
+
+
+/**
+ * @brief Cached levels of detail test
+ * 
+ * The levels simplified from a detailed model are kept in its binary mesh
+ * file with their encoded streams and read back by the later loads. The
+ * loads of another vertex format encode the levels again.
+ */
+TEST_F(VBO, cachedLevels) {
+    ASSERT_NE(nullptr, window);
+    const char* file = RMGTEST_OUTPUT_PATH "/vbo_sphere.obj";
+    remove(RMGTEST_OUTPUT_PATH "/vbo_sphere.obj.rmgmesh");
+    FILE* fp = fopen(file, "w");
+    ASSERT_NE(nullptr, fp);
+    
+    // A sphere of 64 slices and 40 stacks has 4992 triangles
+    const int slices = 64;
+    const int stacks = 40;
+    fprintf(fp, "v 0 0 1\n");
+    for(int i=1; i<stacks; i++) {
+        float t = 3.14159265f * i / stacks;
+        for(int j=0; j<slices; j++) {
+            float p = 6.28318531f * j / slices;
+            fprintf(fp, "v %f %f %f\n", sinf(t)*cosf(p), sinf(t)*sinf(p),
+                    cosf(t));
+        }
+    }
+    fprintf(fp, "v 0 0 -1\n");
+    int bottom = 2 + (stacks-1) * slices;
+    for(int j=0; j<slices; j++) {
+        int k = (j+1) % slices;
+        fprintf(fp, "f 1 %d %d\n", 2+j, 2+k);
+        for(int i=1; i<stacks-1; i++) {
+            int a = 2 + (i-1)*slices + j;
+            int b = 2 + (i-1)*slices + k;
+            fprintf(fp, "f %d %d %d\n", a, a+slices, b+slices);
+            fprintf(fp, "f %d %d %d\n", a, b+slices, b);
+        }
+        fprintf(fp, "f %d %d %d\n", bottom-slices+j, bottom, bottom-slices+k);
+    }
+    fclose(fp);
+    
+    rmg::internal::VBO vbo1;
+    rmg::internal::VBOLoad load1(&vbo1, &geometry, file);
+    load1.prepare();
+    uint64_t size = load1.getUploadSize();
+    load1.load();
+    ASSERT_LT(1, vbo1.getLevelCount());
+    
+    // Read from the binary mesh file
+    rmg::internal::VBO vbo2;
+    rmg::internal::VBOLoad load2(&vbo2, &geometry, file);
+    load2.prepare();
+    EXPECT_EQ(size, load2.getUploadSize());
+    load2.load();
+    ASSERT_EQ(vbo1.getLevelCount(), vbo2.getLevelCount());
+    for(uint32_t i=0; i<vbo1.getLevelCount(); i++) {
+        EXPECT_EQ(vbo1.getRange(i).indexCount, vbo2.getRange(i).indexCount);
+        EXPECT_FLOAT_EQ(vbo1.getLevelError(i), vbo2.getLevelError(i));
+    }
+    EXPECT_TRUE(vbo2.isCompressed());
+    EXPECT_EQ(vbo1.getPositionOffset(), vbo2.getPositionOffset());
+    EXPECT_EQ(vbo1.getPositionScale(), vbo2.getPositionScale());
+    
+    rmg::internal::VBO vbo3;
+    rmg::internal::VBOLoad load3(&vbo3, &geometry, file, true, false);
+    load3.prepare();
+    EXPECT_LT(size, load3.getUploadSize());
+    load3.load();
+    ASSERT_EQ(vbo1.getLevelCount(), vbo3.getLevelCount());
+    EXPECT_FALSE(vbo3.isCompressed());
+    for(uint32_t i=0; i<vbo1.getLevelCount(); i++)
+        EXPECT_EQ(vbo1.getRange(i).indexCount, vbo3.getRange(i).indexCount);
+    vbo3.draw(vbo3.getLevelCount() - 1);
+    glfwSwapBuffers(window);
+    glfwPollEvents();
+    glfwDestroyWindow(window);
+}
+
+
+/**
+ * @brief Stale cache test
+ * 
+ * A model rewritten right after its binary mesh file is parsed again even
+ * though the file times may fall in the same second.
+ */
+TEST_F(VBO, staleCache) {
+    ASSERT_NE(nullptr, window);
+    const char* file = RMGTEST_OUTPUT_PATH "/vbo_stale.obj";
+    remove(RMGTEST_OUTPUT_PATH "/vbo_stale.obj.rmgmesh");
+    FILE* fp = fopen(file, "w");
+    ASSERT_NE(nullptr, fp);
+    fprintf(fp, "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n");
+    fclose(fp);
+    rmg::internal::VBO vbo1;
+    rmg::internal::VBOLoad load1(&vbo1, &geometry, file);
+    load1.prepare();
+    load1.load();
+    EXPECT_EQ(3, vbo1.getRange().indexCount);
+    
+    fp = fopen(file, "w");
+    ASSERT_NE(nullptr, fp);
+    fprintf(fp, "v 0 0 0\nv 1 0 0\nv 0 1 0\nv 1 1 0\nf 1 2 3\nf 2 4 3\n");
+    fclose(fp);
+    rmg::internal::VBO vbo2;
+    rmg::internal::VBOLoad load2(&vbo2, &geometry, file);
+    load2.prepare();
+    load2.load();
+    EXPECT_EQ(6, vbo2.getRange().indexCount);
+    glfwSwapBuffers(window);
+    glfwPollEvents();
+    glfwDestroyWindow(window);
+}
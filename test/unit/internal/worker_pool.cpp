@@ -0,0 +1,30 @@
+#include <rmg/internal/worker_pool.hpp>
+
+#include <atomic>
+#include <chrono>
+
+#include <gtest/gtest.h>
+
+
+using namespace rmg::internal;
+
+
+/**
+ * @brief Worker pool job execution test
+ */
+TEST(WorkerPool, push) {
+    std::atomic<int> count(0);
+    {
+        WorkerPool pool(3);
+        ASSERT_EQ(3, pool.getThreadCount());
+        for(int i=0; i<50; i++)
+            pool.push([&count] { count++; });
+        
+        for(int i=0; i<1000 && count < 50; i++)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        ASSERT_EQ(50, count);
+    }
+    
+    WorkerPool pool;
+    ASSERT_LE(1, pool.getThreadCount());
+}
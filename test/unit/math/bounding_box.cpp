@@ -0,0 +1,65 @@
+#include <rmg/math/bounding_box.hpp>
+
+#include <gtest/gtest.h>
+
+using namespace rmg;
+
+
+/**
+ * @brief Bounding box extension test
+ */
+TEST(BoundingBox, extend) {
+    BoundingBox box;
+    ASSERT_TRUE(box.isEmpty());
+    
+    box.extend(Vec3(1, -2, 3));
+    ASSERT_FALSE(box.isEmpty());
+    ASSERT_EQ(Vec3(1, -2, 3), box.min);
+    ASSERT_EQ(Vec3(1, -2, 3), box.max);
+    
+    box.extend(Vec3(-1, 4, 0));
+    ASSERT_EQ(Vec3(-1, -2, 0), box.min);
+    ASSERT_EQ(Vec3( 1,  4, 3), box.max);
+    ASSERT_EQ(Vec3(0, 1, 1.5f), box.getCenter());
+    ASSERT_NEAR(3.5f, box.getRadius(), 0.0001f);
+    
+    box.extend(BoundingBox());
+    ASSERT_EQ(Vec3(-1, -2, 0), box.min);
+    ASSERT_EQ(Vec3( 1,  4, 3), box.max);
+}
+
+
+
+
+/**
+ * @brief Bounding box transformation test
+ */
+TEST(BoundingBox, transform) {
+    BoundingBox box = BoundingBox(Vec3(-1, -1, -1), Vec3(1, 1, 1));
+    
+    Mat4 M1 = {
+        {2, 0, 0,  5},
+        {0, 1, 0,  0},
+        {0, 0, 3, -1},
+        {0, 0, 0,  1}
+    };
+    BoundingBox box1 = box.transform(M1);
+    ASSERT_EQ(Vec3(3, -1, -4), box1.min);
+    ASSERT_EQ(Vec3(7,  1,  2), box1.max);
+    
+    // 45 degree rotation about the z-axis
+    float c = 0.70710678f;
+    Mat4 M2 = {
+        {c, -c, 0, 0},
+        {c,  c, 0, 0},
+        {0,  0, 1, 0},
+        {0,  0, 0, 1}
+    };
+    BoundingBox box2 = box.transform(M2);
+    ASSERT_NEAR(-2*c, box2.min.x, 0.0001f);
+    ASSERT_NEAR(-2*c, box2.min.y, 0.0001f);
+    ASSERT_NEAR(  -1, box2.min.z, 0.0001f);
+    ASSERT_NEAR( 2*c, box2.max.x, 0.0001f);
+    ASSERT_NEAR( 2*c, box2.max.y, 0.0001f);
+    ASSERT_NEAR(   1, box2.max.z, 0.0001f);
+}
@@ -0,0 +1,77 @@
+#include <rmg/math/frustum.hpp>
+
+#include <gtest/gtest.h>
+
+using namespace rmg;
+
+
+// Perspective projection with 90 degree field of view looking at -z.
+// Near plane is at 1 and far plane is at 10.
+static const Mat4 projection1 = {
+    {1, 0,            0,            0},
+    {0, 1,            0,            0},
+    {0, 0, -11.0f/9.0f, -20.0f/9.0f},
+    {0, 0,           -1,            0}
+};
+
+
+/**
+ * @brief Frustum plane extraction test
+ */
+TEST(Frustum, constructor) {
+    Frustum frustum = Frustum(Mat4());
+    for(int i=0; i<6; i++) {
+        const Vec4 &p = frustum.planes[i];
+        ASSERT_NEAR(1.0f, Vec3(p.x, p.y, p.z).magnitude(), 0.0001f);
+        ASSERT_NEAR(1.0f, p.w, 0.0001f);
+    }
+    ASSERT_EQ(Vec4( 1, 0, 0, 1), frustum.planes[0]);
+    ASSERT_EQ(Vec4(-1, 0, 0, 1), frustum.planes[1]);
+}
+
+
+
+
+/**
+ * @brief Frustum sphere test
+ */
+TEST(Frustum, sphere) {
+    Frustum frustum = Frustum(projection1);
+    ASSERT_TRUE(frustum.intersects(Vec3(0, 0, -5), 0.5f));
+    ASSERT_FALSE(frustum.intersects(Vec3(0, 0, 5), 0.5f));
+    ASSERT_FALSE(frustum.intersects(Vec3(0, 0, -20), 0.5f));
+    ASSERT_TRUE(frustum.intersects(Vec3(0, 0, -10.2f), 0.5f));
+    ASSERT_FALSE(frustum.intersects(Vec3(8, 0, -5), 0.5f));
+    ASSERT_TRUE(frustum.intersects(Vec3(5.5f, 0, -5), 0.5f));
+}
+
+
+
+
+/**
+ * @brief Frustum box test
+ */
+TEST(Frustum, box) {
+    Frustum frustum = Frustum(projection1);
+    BoundingBox unit = BoundingBox(Vec3(-0.5f, -0.5f, -0.5f),
+                                   Vec3( 0.5f,  0.5f,  0.5f));
+    ASSERT_FALSE(frustum.intersects(BoundingBox()));
+    
+    Mat4 M = Mat4();
+    M[2][3] = -5;
+    ASSERT_TRUE(frustum.intersects(unit, M));
+    M[2][3] = 5;
+    ASSERT_FALSE(frustum.intersects(unit, M));
+    M[2][3] = -20;
+    ASSERT_FALSE(frustum.intersects(unit, M));
+    
+    M[2][3] = -5;
+    M[1][3] = 8;
+    ASSERT_FALSE(frustum.intersects(unit, M));
+    
+    // Scaled up to reach the visible volume
+    M[0][0] = 8;
+    M[1][1] = 8;
+    M[2][2] = 8;
+    ASSERT_TRUE(frustum.intersects(unit, M));
+}
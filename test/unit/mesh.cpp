@@ -1,9 +1,15 @@
 #include <rmg/mesh.hpp>
 
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <utility>
+#include <vector>
 
 #include <gtest/gtest.h>
 
+#include "../testconf.h"
+
 using namespace rmg;
 
 
@@ -25,7 +31,7 @@ static const Vec3 vertices1[16] = {
     {-0.5f, -0.5f,  0.5f},
     {-0.5f,  0.5f,  0.5f}
 };
-    
+
 static const Vec3 normals1[16] = {
     { 0, -1, 0},
     { 0, -1, 0},
@@ -86,3 +92,343 @@ TEST(Mesh, constructor) {
     ASSERT_FALSE(mesh3.isValid());
     ASSERT_TRUE(mesh5.isValid());
 }
+
+
+
+
+/**
+ * @brief Mesh bounding box test
+ */
+TEST(Mesh, boundingBox) {
+    Mesh mesh1 = Mesh(vertices1, normals1, texCoords1, 16, indices1, 24);
+    BoundingBox box = mesh1.getBoundingBox();
+    ASSERT_EQ(Vec3(-0.5f, -0.5f, -0.5f), box.min);
+    ASSERT_EQ(Vec3( 0.5f,  0.5f,  0.5f), box.max);
+    
+    Mesh mesh2;
+    ASSERT_TRUE(mesh2.getBoundingBox().isEmpty());
+}
+
+
+
+
+/**
+ * @brief Smooth normal generation test
+ * 
+ * Coplanar triangles share the vertices of their common edge while the
+ * edges sharper than 30 degrees keep separate vertices.
+ */
+TEST(Mesh, smoothNormals) {
+    const Vec3 flat[6] = {
+        Vec3(0, 0, 0), Vec3(1, 0, 0), Vec3(1, 1, 0),
+        Vec3(1, 1, 0), Vec3(0, 1, 0), Vec3(0, 0, 0)
+    };
+    Mesh mesh1 = Mesh(flat, 6, true);
+    ASSERT_TRUE(mesh1.isValid());
+    ASSERT_EQ(4, mesh1.getVertexCount());
+    
+    const Vec3 folded[6] = {
+        Vec3(0, 0, 0), Vec3(1, 0, 0), Vec3(1, 1, 0),
+        Vec3(1, 1, 0), Vec3(1, 0, 0), Vec3(1, 1, -1)
+    };
+    Mesh mesh2 = Mesh(folded, 6, true);
+    ASSERT_TRUE(mesh2.isValid());
+    ASSERT_EQ(6, mesh2.getVertexCount());
+}
+
+
+
+
+/**
+ * @brief Vertex cache optimization test
+ * 
+ * The triangles of a grid are given in a scattered order.
+ */
+TEST(Mesh, optimize) {
+    std::vector<Vec3> vertices;
+    std::vector<uint32_t> indices;
+    for(int y=0; y<=16; y++) {
+        for(int x=0; x<=16; x++)
+            vertices.push_back(Vec3(x, y, 0));
+    }
+    for(int i=0; i<256; i++) {
+        int q = (i * 97) % 256;
+        uint32_t k = (q / 16) * 17 + q % 16;
+        uint32_t quad[6] = { k, k+1, k+18, k+18, k+17, k };
+        indices.insert(indices.end(), quad, quad + 6);
+    }
+    std::vector<Vec3> normals = std::vector<Vec3>(vertices.size());
+    Mesh mesh = Mesh(&vertices[0], &normals[0], nullptr, vertices.size(),
+                     &indices[0], indices.size());
+    float before = mesh.getACMR();
+    mesh.optimize();
+    ASSERT_TRUE(mesh.isValid());
+    ASSERT_EQ(512, mesh.getPolygonCount());
+    ASSERT_EQ(289, mesh.getVertexCount());
+    ASSERT_LT(mesh.getACMR(), before);
+    ASSERT_LT(mesh.getACMR(), 1.0f);
+    BoundingBox box = mesh.getBoundingBox();
+    ASSERT_EQ(Vec3(0, 0, 0), box.min);
+    ASSERT_EQ(Vec3(16, 16, 0), box.max);
+}
+
+
+
+
+/**
+ * @brief Loading polygons from .OBJ file test
+ * 
+ * Quads and n-gons are split into triangles. Faces in different index
+ * layouts may be mixed.
+ */
+TEST(Mesh, loadOBJ_polygons) {
+    Mesh mesh = Mesh::loadFromFile(RMGTEST_RESOURCE_PATH "/mesh_polygons.obj");
+    ASSERT_TRUE(mesh.isValid());
+    ASSERT_EQ(5, mesh.getPolygonCount());
+    BoundingBox box = mesh.getBoundingBox();
+    ASSERT_EQ(Vec3(0, 0, 0), box.min);
+    ASSERT_EQ(Vec3(1, 1.5f, 0), box.max);
+}
+
+
+
+
+/**
+ * @brief Loading .OBJ file with relative indices test
+ */
+TEST(Mesh, loadOBJ_negative) {
+    Mesh mesh = Mesh::loadFromFile(RMGTEST_RESOURCE_PATH "/mesh_negative.obj");
+    ASSERT_TRUE(mesh.isValid());
+    ASSERT_EQ(3, mesh.getPolygonCount());
+    BoundingBox box = mesh.getBoundingBox();
+    ASSERT_EQ(Vec3(0, 0, 0), box.min);
+    ASSERT_EQ(Vec3(2, 1, 0), box.max);
+}
+
+
+
+
+/**
+ * @brief Loading invalid .OBJ files test
+ */
+TEST(Mesh, loadOBJ_invalid) {
+    Mesh mesh1 = Mesh::loadFromFile(
+        RMGTEST_RESOURCE_PATH "/mesh_out_of_bounds.obj"
+    );
+    ASSERT_FALSE(mesh1.isValid());
+    
+    Mesh mesh2 = Mesh::loadFromFile(RMGTEST_RESOURCE_PATH "/missing.obj");
+    ASSERT_FALSE(mesh2.isValid());
+    
+    Mesh mesh3 = Mesh::loadFromFile(RMGTEST_RESOURCE_PATH "/open_png_rgb.png");
+    ASSERT_FALSE(mesh3.isValid());
+}
+
+
+
+
+class MeshArrays: public Mesh {
+  public:
+    MeshArrays(Mesh&& mesh): Mesh(std::move(mesh)) {}
+    
+    const Vec3* getVertices() const { return vertices; }
+    const Vec2* getTexCoords() const { return texCoords; }
+    const uint32_t* getIndices() const { return indices; }
+    
+    bool operator ==(const MeshArrays& mesh) const {
+        if(vertex_count != mesh.vertex_count)
+            return false;
+        if(index_count != mesh.index_count)
+            return false;
+        if((texCoords == nullptr) != (mesh.texCoords == nullptr))
+            return false;
+        uint32_t n = vertex_count;
+        if(texCoords != nullptr &&
+           memcmp(texCoords, mesh.texCoords, n*sizeof(Vec2)) != 0)
+            return false;
+        return memcmp(vertices, mesh.vertices, n*sizeof(Vec3)) == 0 &&
+               memcmp(normals, mesh.normals, n*sizeof(Vec3)) == 0 &&
+               memcmp(indices, mesh.indices, index_count*4) == 0;
+    }
+};
+
+
+/**
+ * @brief Saving and mapping binary mesh files test
+ */
+TEST(Mesh, saveLoadMapped) {
+    const char* file = RMGTEST_OUTPUT_PATH "/save_mesh.rmgmesh";
+    remove(file);
+    ASSERT_FALSE(Mesh::loadMapped(file).isValid());
+    
+    Mesh mesh1 = Mesh(vertices1, normals1, texCoords1, 16, indices1, 24);
+    ASSERT_TRUE(mesh1.save(file));
+    MeshArrays mapped1 = MeshArrays(Mesh::loadMapped(file));
+    ASSERT_TRUE(mapped1.isValid());
+    ASSERT_TRUE(MeshArrays(Mesh(mesh1)) == mapped1);
+    BoundingBox box = mapped1.getBoundingBox();
+    ASSERT_EQ(Vec3(-0.5f, -0.5f, -0.5f), box.min);
+    ASSERT_EQ(Vec3( 0.5f,  0.5f,  0.5f), box.max);
+    
+    // Copies of a mapped mesh own their arrays
+    Mesh copy = mapped1;
+    ASSERT_TRUE(MeshArrays(std::move(copy)) == mapped1);
+    
+    Mesh mesh2 = Mesh(vertices1, normals1, nullptr, 16, indices1, 24);
+    ASSERT_TRUE(mesh2.save(file));
+    MeshArrays mapped2 = MeshArrays(Mesh::loadFromFile(file));
+    ASSERT_TRUE(mapped2.isValid());
+    ASSERT_TRUE(MeshArrays(std::move(mesh2)) == mapped2);
+    
+    // The cache of a model file keeps the model extension in its name
+    const char* cache = RMGTEST_OUTPUT_PATH "/save_mesh.obj.rmgmesh";
+    ASSERT_TRUE(mesh1.save(cache));
+    ASSERT_TRUE(Mesh::loadFromFile(cache).isValid());
+    remove(cache);
+    
+    ASSERT_FALSE(Mesh().save(file));
+    
+    // An index out of the vertices
+    ASSERT_TRUE(mesh1.save(file));
+    FILE* fp = fopen(file, "r+b");
+    ASSERT_NE(nullptr, fp);
+    uint32_t index = 16;
+    fseek(fp, -(long) sizeof(index), SEEK_END);
+    fwrite(&index, sizeof(index), 1, fp);
+    fclose(fp);
+    ASSERT_FALSE(Mesh::loadMapped(file).isValid());
+    Mesh mesh3 = Mesh::loadMapped(RMGTEST_RESOURCE_PATH "/mesh_negative.obj");
+    ASSERT_FALSE(mesh3.isValid());
+}
+
+
+
+
+/**
+ * @brief Indexing meshes from .OBJ face indices test
+ * 
+ * Corners with the same attribute indices share a vertex. Repeated
+ * positions are welded when the normals are generated.
+ */
+TEST(Mesh, loadOBJ_indexed) {
+    Mesh mesh1 = Mesh::loadFromFile(RMGTEST_RESOURCE_PATH "/mesh_polygons.obj");
+    ASSERT_EQ(9, mesh1.getVertexCount());
+    
+    Mesh mesh2 = Mesh::loadFromFile(RMGTEST_RESOURCE_PATH "/mesh_seam.obj");
+    ASSERT_TRUE(mesh2.isValid());
+    ASSERT_EQ(4, mesh2.getPolygonCount());
+    ASSERT_EQ(6, mesh2.getVertexCount());
+    
+    Mesh mesh3 = Mesh::loadFromFile(
+        RMGTEST_RESOURCE_PATH "/mesh_seam.obj",
+        false
+    );
+    ASSERT_EQ(6, mesh3.getVertexCount());
+}
+
+
+/**
+ * @brief Mesh simplification test
+ * 
+ * A flat grid has no error to collapse its inner vertices or to slide the
+ * vertices along its borders. The outline and the texture seam down the
+ * middle are kept.
+ */
+TEST(Mesh, simplify) {
+    std::vector<Vec3> vertices;
+    std::vector<Vec3> normals;
+    std::vector<Vec2> texCoords;
+    std::vector<uint32_t> indices;
+    for(int side=0; side<2; side++) {
+        for(int y=0; y<=16; y++) {
+            for(int x=side*8; x<=side*8+8; x++) {
+                vertices.push_back(Vec3(x, y, 0));
+                normals.push_back(Vec3(0, 0, 1));
+                texCoords.push_back(Vec2(x/16.0f + side, y/16.0f));
+            }
+        }
+        for(int y=0; y<16; y++) {
+            for(int x=0; x<8; x++) {
+                uint32_t k = side*153 + y*9 + x;
+                uint32_t quad[6] = { k, k+1, k+10, k+10, k+9, k };
+                indices.insert(indices.end(), quad, quad + 6);
+            }
+        }
+    }
+    Mesh mesh = Mesh(&vertices[0], &normals[0], &texCoords[0],
+                     vertices.size(), &indices[0], indices.size());
+    float error = mesh.simplify(0.25f);
+    ASSERT_TRUE(mesh.isValid());
+    ASSERT_LE(mesh.getPolygonCount(), 128);
+    ASSERT_NEAR(0, error, 1e-4f);
+    BoundingBox box = mesh.getBoundingBox();
+    ASSERT_EQ(Vec3(0, 0, 0), box.min);
+    ASSERT_EQ(Vec3(16, 16, 0), box.max);
+    
+    // No triangle crosses the seam
+    MeshArrays arrays = MeshArrays(std::move(mesh));
+    const Vec3* v = arrays.getVertices();
+    const Vec2* t = arrays.getTexCoords();
+    const uint32_t* i = arrays.getIndices();
+    for(uint32_t j=0; j<arrays.getPolygonCount()*3; j++) {
+        uint32_t a = i[j];
+        uint32_t b = i[j/3*3];
+        ASSERT_NEAR(t[a].x - v[a].x/16, t[b].x - v[b].x/16, 1e-4f);
+        if(v[a].x != 8) {
+            ASSERT_NEAR(t[a].x - v[a].x/16, (v[a].x < 8) ? 0 : 1, 1e-4f);
+        }
+    }
+}
+
+
+/**
+ * @brief Closed mesh simplification test
+ * 
+ * Nothing on a closed surface keeps the vertices from collapsing, so every
+ * target ratio is reached.
+ */
+TEST(Mesh, simplify_closed) {
+    // A sphere of 64 slices and 40 stacks has 4992 triangles
+    const uint32_t slices = 64;
+    const uint32_t stacks = 40;
+    std::vector<Vec3> vertices;
+    std::vector<uint32_t> indices;
+    vertices.push_back(Vec3(0, 0, 1));
+    for(uint32_t i=1; i<stacks; i++) {
+        float t = 3.14159265f * i / stacks;
+        for(uint32_t j=0; j<slices; j++) {
+            float p = 6.28318531f * j / slices;
+            vertices.push_back(Vec3(sinf(t)*cosf(p), sinf(t)*sinf(p),
+                                    cosf(t)));
+        }
+    }
+    vertices.push_back(Vec3(0, 0, -1));
+    // The normals of a unit sphere are its positions
+    std::vector<Vec3> normals = vertices;
+    uint32_t bottom = vertices.size() - 1;
+    for(uint32_t j=0; j<slices; j++) {
+        uint32_t k = (j+1) % slices;
+        uint32_t top[3] = { 0, 1+j, 1+k };
+        indices.insert(indices.end(), top, top + 3);
+        for(uint32_t i=0; i+2<stacks; i++) {
+            uint32_t a = 1 + i*slices + j;
+            uint32_t b = 1 + i*slices + k;
+            uint32_t quad[6] = { a, a+slices, b+slices, a, b+slices, b };
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+        uint32_t end[3] = { bottom-slices+j, bottom, bottom-slices+k };
+        indices.insert(indices.end(), end, end + 3);
+    }
+    Mesh mesh = Mesh(&vertices[0], &normals[0], nullptr, vertices.size(),
+                     &indices[0], indices.size());
+    ASSERT_EQ(4992, mesh.getPolygonCount());
+    
+    const float ratios[3] = { 1/4.0f, 1/16.0f, 1/64.0f };
+    for(int i=0; i<3; i++) {
+        Mesh lod = mesh;
+        float error = lod.simplify(ratios[i]);
+        ASSERT_TRUE(lod.isValid());
+        EXPECT_LE(lod.getPolygonCount(), (uint32_t)(4992 * ratios[i]));
+        EXPECT_LT(error, 0.5f);
+    }
+}
@@ -16,3 +16,21 @@ TEST(Sphere3D, constructor) {
     EXPECT_EQ(&ctx, ball.getContext());
     EXPECT_EQ(5.73f, ball.getDiameter());
 }
+
+
+/**
+ * @brief Sphere3D mesh sharing test
+ */
+TEST(Sphere3D, sharedMesh) {
+    Context ctx = Context();
+    Sphere3D ball1 = Sphere3D(&ctx, 5.73f);
+    Sphere3D ball2 = Sphere3D(&ctx, 0.3f);
+    EXPECT_NE(nullptr, ball1.getVBO());
+    EXPECT_EQ(ball1.getVBO(), ball2.getVBO());
+    EXPECT_EQ(1, ctx.getMeshCache()->getSize());
+    Vec3 scale = ball2.getMeshScale();
+    EXPECT_EQ(0.3f, scale.x);
+    EXPECT_EQ(0.3f, scale.y);
+    EXPECT_EQ(0.3f, scale.z);
+    EXPECT_EQ(0.3f, ball2.getModelMatrix()[0][0]);
+}